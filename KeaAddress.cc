@@ -0,0 +1,546 @@
+#include "KeaAddress.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+// The vector parsers need GCC or Clang on x86; the CPU is checked at
+// run time, so the build needs no -m flags.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KEA_X86_PARSER 1
+#include <immintrin.h>
+#else
+#define KEA_X86_PARSER 0
+#endif
+
+namespace KeaGenerator
+{
+namespace
+{
+// Decimal text of one octet, left aligned and followed by the dot
+// that separates it from the next one: "7.", "42.", "255.".
+struct OctetText
+{
+    char text[4];
+    unsigned char length; // Digits, without the dot.
+};
+
+constexpr std::array<OctetText, 256>
+make_octet_table ()
+{
+    std::array<OctetText, 256> table{};
+    for (unsigned v = 0; v < 256; ++v)
+    {
+        OctetText &o = table[v];
+        unsigned n = 0;
+        if (v >= 100)
+        {
+            o.text[n++] = static_cast<char> ('0' + v / 100);
+        }
+        if (v >= 10)
+        {
+            o.text[n++] = static_cast<char> ('0' + v / 10 % 10);
+        }
+        o.text[n++] = static_cast<char> ('0' + v % 10);
+        o.length = static_cast<unsigned char> (n);
+        for (; n < 4; ++n)
+        {
+            o.text[n] = '.';
+        }
+    }
+    return table;
+}
+
+constexpr std::array<OctetText, 256> kOctets = make_octet_table ();
+
+#if KEA_X86_PARSER
+// --- Vector parsers ---
+// An address is loaded into a 16-byte lane. The digit and dot masks
+// give the octet lengths; a shuffle then moves the digits of each
+// octet into its own 32-bit slot and two multiply-adds turn them
+// into the four octet values at once.
+
+// Shuffle masks placing the digits of octet k right aligned in bytes
+// 4k..4k+2; 0x80 clears the other bytes. Indexed by the digit counts
+// of the four octets (1..3 each) read as a base-3 number.
+struct OctetLayout
+{
+    unsigned char shuffle[16];
+};
+
+constexpr std::array<OctetLayout, 81>
+make_layouts ()
+{
+    const unsigned place[4] = { 27, 9, 3, 1 };
+    std::array<OctetLayout, 81> table{};
+    for (unsigned i = 0; i < 81; ++i)
+    {
+        unsigned start = 0;
+        for (unsigned k = 0; k < 4; ++k)
+        {
+            unsigned len = i / place[k] % 3 + 1;
+            unsigned char *slot = table[i].shuffle + 4 * k;
+            for (unsigned b = 0; b < 4; ++b)
+            {
+                slot[b] = 0x80;
+            }
+            for (unsigned j = 0; j < len; ++j)
+            {
+                slot[3 - len + j]
+                    = static_cast<unsigned char> (start + j);
+            }
+            start += len + 1;
+        }
+    }
+    return table;
+}
+
+constexpr std::array<OctetLayout, 81> kLayouts = make_layouts ();
+
+// Weights of the hundreds, tens and units bytes of each slot.
+constexpr int kOctetWeights = 0x00010a64; // 100, 10, 1, 0
+
+// Checks the shape of one address of length n, 7..15, from the
+// masks of its digits, dots and '0' characters (bit i for byte i).
+// The same rules as the scalar parser: four octets of 1-3 digits
+// without leading zeros. Returns the index of its layout in
+// kLayouts, or -1.
+inline int
+layout_index (unsigned n, unsigned digits, unsigned dots,
+              unsigned zeros)
+{
+    if ((digits | dots) != (1u << n) - 1)
+    {
+        return -1;
+    }
+    // A '0' starting an octet must be the whole octet.
+    unsigned starts = 1 | dots << 1;
+    if ((zeros & starts & digits >> 1) != 0)
+    {
+        return -1;
+    }
+    // Exactly three dots, with 1-3 digits around each.
+    if (dots == 0)
+    {
+        return -1;
+    }
+    unsigned d0 = static_cast<unsigned> (__builtin_ctz (dots));
+    dots &= dots - 1;
+    if (dots == 0)
+    {
+        return -1;
+    }
+    unsigned d1 = static_cast<unsigned> (__builtin_ctz (dots));
+    dots &= dots - 1;
+    if (dots == 0)
+    {
+        return -1;
+    }
+    unsigned d2 = static_cast<unsigned> (__builtin_ctz (dots));
+    if ((dots & (dots - 1)) != 0)
+    {
+        return -1;
+    }
+    // Digit counts less one; a count of 0 wraps to a large value.
+    unsigned l0 = d0 - 1, l1 = d1 - d0 - 2, l2 = d2 - d1 - 2,
+             l3 = n - d2 - 2;
+    if ((l0 > 2) | (l1 > 2) | (l2 > 2) | (l3 > 2))
+    {
+        return -1;
+    }
+    return static_cast<int> (((l0 * 3 + l1) * 3 + l2) * 3 + l3);
+}
+
+// Loads 7..15 bytes of text as the two halves of a zero-padded
+// 16-byte block, without reading past the text. The halves are built
+// in registers: storing the text to memory and reloading it as one
+// vector stalls on store forwarding.
+inline void
+load_block (std::string_view text, uint64_t &lo, uint64_t &hi)
+{
+    const char *p = text.data ();
+    std::size_t n = text.size ();
+    if (n >= 9)
+    {
+        std::memcpy (&lo, p, 8);
+        std::memcpy (&hi, p + n - 8, 8);
+        hi >>= 8 * (16 - n); // Drop the bytes lo already has.
+        return;
+    }
+    // 7 or 8 bytes: two overlapping 4-byte loads.
+    uint32_t first, last;
+    std::memcpy (&first, p, 4);
+    std::memcpy (&last, p + n - 4, 4);
+    lo = first | uint64_t (last) << (8 * (n - 4));
+    hi = 0;
+}
+
+__attribute__ ((target ("sse4.1"))) bool
+parse_ipv4_sse41 (std::string_view text, uint32_t &addr)
+{
+    std::size_t n = text.size ();
+    if (n < 7 || n > kIpv4Width)
+    {
+        return false;
+    }
+    uint64_t lo, hi;
+    load_block (text, lo, hi);
+
+    __m128i v = _mm_set_epi64x (static_cast<long long> (hi),
+                                static_cast<long long> (lo));
+    __m128i d = _mm_sub_epi8 (v, _mm_set1_epi8 ('0'));
+    __m128i digit
+        = _mm_cmpeq_epi8 (_mm_min_epu8 (d, _mm_set1_epi8 (9)), d);
+    __m128i dot = _mm_cmpeq_epi8 (v, _mm_set1_epi8 ('.'));
+    __m128i zero = _mm_cmpeq_epi8 (v, _mm_set1_epi8 ('0'));
+    // Lambdas do not inherit the target attribute, hence the casts.
+    int layout = layout_index (
+        static_cast<unsigned> (n),
+        static_cast<unsigned> (_mm_movemask_epi8 (digit)),
+        static_cast<unsigned> (_mm_movemask_epi8 (dot)),
+        static_cast<unsigned> (_mm_movemask_epi8 (zero)));
+    if (layout < 0)
+    {
+        return false;
+    }
+
+    __m128i shuffle = _mm_loadu_si128 (
+        reinterpret_cast<const __m128i *> (kLayouts[layout].shuffle));
+    __m128i slots = _mm_shuffle_epi8 (d, shuffle);
+    __m128i octets = _mm_madd_epi16 (
+        _mm_maddubs_epi16 (slots, _mm_set1_epi32 (kOctetWeights)),
+        _mm_set1_epi16 (1));
+    __m128i over = _mm_cmpgt_epi32 (octets, _mm_set1_epi32 (255));
+    if (_mm_movemask_epi8 (over) != 0)
+    {
+        return false;
+    }
+    __m128i bytes = _mm_packus_epi16 (
+        _mm_packus_epi32 (octets, octets), octets);
+    addr = __builtin_bswap32 (
+        static_cast<uint32_t> (_mm_cvtsi128_si32 (bytes)));
+    return true;
+}
+
+// Two addresses at once, one per 128-bit lane.
+__attribute__ ((target ("avx2"))) bool
+parse_ipv4_pair_avx2 (std::string_view a, std::string_view b,
+                      uint32_t &x, uint32_t &y)
+{
+    if (a.size () < 7 || a.size () > kIpv4Width || b.size () < 7
+        || b.size () > kIpv4Width)
+    {
+        return false;
+    }
+    uint64_t a_lo, a_hi, b_lo, b_hi;
+    load_block (a, a_lo, a_hi);
+    load_block (b, b_lo, b_hi);
+
+    auto q = [] (uint64_t x) { return static_cast<long long> (x); };
+    __m256i v = _mm256_set_epi64x (q (b_hi), q (b_lo), q (a_hi),
+                                   q (a_lo));
+    __m256i d = _mm256_sub_epi8 (v, _mm256_set1_epi8 ('0'));
+    __m256i digit = _mm256_cmpeq_epi8 (
+        _mm256_min_epu8 (d, _mm256_set1_epi8 (9)), d);
+    __m256i dot = _mm256_cmpeq_epi8 (v, _mm256_set1_epi8 ('.'));
+    __m256i zero = _mm256_cmpeq_epi8 (v, _mm256_set1_epi8 ('0'));
+    // Bits 0-15 describe `a`, bits 16-31 `b`.
+    auto digits
+        = static_cast<uint32_t> (_mm256_movemask_epi8 (digit));
+    auto dots = static_cast<uint32_t> (_mm256_movemask_epi8 (dot));
+    auto zeros = static_cast<uint32_t> (_mm256_movemask_epi8 (zero));
+    int la = layout_index (static_cast<unsigned> (a.size ()),
+                           digits & 0xffff, dots & 0xffff,
+                           zeros & 0xffff);
+    int lb = layout_index (static_cast<unsigned> (b.size ()),
+                           digits >> 16, dots >> 16, zeros >> 16);
+    if (la < 0 || lb < 0)
+    {
+        return false;
+    }
+
+    __m128i shuffle_a = _mm_loadu_si128 (
+        reinterpret_cast<const __m128i *> (kLayouts[la].shuffle));
+    __m128i shuffle_b = _mm_loadu_si128 (
+        reinterpret_cast<const __m128i *> (kLayouts[lb].shuffle));
+    __m256i shuffle = _mm256_inserti128_si256 (
+        _mm256_castsi128_si256 (shuffle_a), shuffle_b, 1);
+    __m256i slots = _mm256_shuffle_epi8 (d, shuffle);
+    __m256i weights = _mm256_set1_epi32 (kOctetWeights);
+    __m256i octets = _mm256_madd_epi16 (
+        _mm256_maddubs_epi16 (slots, weights), _mm256_set1_epi16 (1));
+    __m256i over
+        = _mm256_cmpgt_epi32 (octets, _mm256_set1_epi32 (255));
+    if (_mm256_movemask_epi8 (over) != 0)
+    {
+        return false;
+    }
+    __m256i bytes = _mm256_packus_epi16 (
+        _mm256_packus_epi32 (octets, octets), octets);
+    x = __builtin_bswap32 (
+        static_cast<uint32_t> (_mm256_extract_epi32 (bytes, 0)));
+    y = __builtin_bswap32 (
+        static_cast<uint32_t> (_mm256_extract_epi32 (bytes, 4)));
+    return true;
+}
+
+struct CpuFeatures
+{
+    bool sse41;
+    bool avx2;
+};
+
+const CpuFeatures &
+cpu_features ()
+{
+    static const CpuFeatures features = [] {
+        __builtin_cpu_init ();
+        return CpuFeatures{ __builtin_cpu_supports ("sse4.1") != 0,
+                            __builtin_cpu_supports ("avx2") != 0 };
+    }();
+    return features;
+}
+#endif
+} // namespace
+
+bool
+parse_ipv4 (std::string_view text, uint32_t &addr)
+{
+#if KEA_X86_PARSER
+    if (cpu_features ().sse41)
+    {
+        return parse_ipv4_sse41 (text, addr);
+    }
+#endif
+    return parse_ipv4_scalar (text, addr);
+}
+
+bool
+parse_ipv4_pair (std::string_view a, std::string_view b, uint32_t &x,
+                 uint32_t &y)
+{
+#if KEA_X86_PARSER
+    if (cpu_features ().avx2)
+    {
+        return parse_ipv4_pair_avx2 (a, b, x, y);
+    }
+#endif
+    uint32_t first, second;
+    if (!parse_ipv4 (a, first) || !parse_ipv4 (b, second))
+    {
+        return false;
+    }
+    x = first;
+    y = second;
+    return true;
+}
+
+bool
+parse_ipv4_scalar (std::string_view text, uint32_t &addr)
+{
+    uint32_t result = 0;
+    std::size_t i = 0;
+    for (int octet = 0; octet < 4; ++octet)
+    {
+        if (octet > 0)
+        {
+            if (i >= text.size () || text[i] != '.')
+            {
+                return false;
+            }
+            ++i;
+        }
+
+        std::size_t start = i;
+        unsigned value = 0;
+        while (i < text.size () && i - start < 3 && text[i] >= '0'
+               && text[i] <= '9')
+        {
+            value = value * 10
+                    + static_cast<unsigned> (text[i] - '0');
+            ++i;
+        }
+        std::size_t digits = i - start;
+        if (digits == 0 || value > 255
+            || (digits > 1 && text[start] == '0'))
+        {
+            return false;
+        }
+        result = (result << 8) | value;
+    }
+    if (i != text.size ())
+    {
+        return false;
+    }
+    addr = result;
+    return true;
+}
+
+bool
+parse_cidr (std::string_view text, Ipv4Prefix &prefix)
+{
+    std::size_t slash = text.find ('/');
+    if (slash == std::string_view::npos)
+    {
+        return false;
+    }
+
+    uint32_t addr;
+    if (!parse_ipv4 (text.substr (0, slash), addr))
+    {
+        return false;
+    }
+
+    std::string_view len_text = text.substr (slash + 1);
+    if (len_text.empty () || len_text.size () > 2
+        || (len_text.size () > 1 && len_text[0] == '0'))
+    {
+        return false;
+    }
+    unsigned length = 0;
+    for (char c : len_text)
+    {
+        if (c < '0' || c > '9')
+        {
+            return false;
+        }
+        length = length * 10 + static_cast<unsigned> (c - '0');
+    }
+    if (length > 32)
+    {
+        return false;
+    }
+
+    prefix.base = addr & prefix_mask (length);
+    prefix.length = length;
+    return true;
+}
+
+bool
+parse_pool_range (std::string_view text, uint32_t &low,
+                  uint32_t &high)
+{
+    std::size_t dash = text.find (" - ");
+    if (dash == std::string_view::npos)
+    {
+        return false;
+    }
+    uint32_t a, b;
+    std::string_view first = text.substr (0, dash);
+    std::string_view second = text.substr (dash + 3);
+    if (!parse_ipv4_pair (first, second, a, b) || a > b)
+    {
+        return false;
+    }
+    low = a;
+    high = b;
+    return true;
+}
+
+char *
+write_ipv4 (char *out, uint32_t addr)
+{
+    // The first three octets are copied with their dot as four
+    // bytes; the cursor then moves past the digits and the dot only.
+    for (int shift = 24; shift > 0; shift -= 8)
+    {
+        const OctetText &o = kOctets[(addr >> shift) & 0xff];
+        std::memcpy (out, o.text, 4);
+        out += o.length + 1;
+    }
+    const OctetText &o = kOctets[addr & 0xff];
+    std::memcpy (out, o.text, 3);
+    return out + o.length;
+}
+
+char *
+write_pool_range (char *out, uint32_t low, uint32_t high)
+{
+    out = write_ipv4 (out, low);
+    std::memcpy (out, " - ", 3);
+    return write_ipv4 (out + 3, high);
+}
+
+std::string
+format_ipv4 (uint32_t addr)
+{
+    char buf[kIpv4Width];
+    return std::string (buf, write_ipv4 (buf, addr));
+}
+
+std::string
+format_cidr (const Ipv4Prefix &prefix)
+{
+    char buf[kIpv4Width + 3];
+    char *end = write_ipv4 (buf, prefix.base);
+    *end++ = '/';
+    if (prefix.length >= 10)
+    {
+        *end++ = static_cast<char> ('0' + prefix.length / 10);
+    }
+    *end++ = static_cast<char> ('0' + prefix.length % 10);
+    return std::string (buf, end);
+}
+
+std::string
+format_pool_range (uint32_t low, uint32_t high)
+{
+    char buf[kPoolRangeWidth];
+    return std::string (buf, write_pool_range (buf, low, high));
+}
+
+void
+normalize_ranges (AddressRanges &ranges)
+{
+    std::sort (ranges.begin (), ranges.end ());
+    AddressRanges merged;
+    for (const AddressRange &r : ranges)
+    {
+        if (!merged.empty ()
+            && uint64_t (r.first)
+                   <= uint64_t (merged.back ().second) + 1)
+        {
+            merged.back ().second
+                = std::max (merged.back ().second, r.second);
+        }
+        else
+        {
+            merged.push_back (r);
+        }
+    }
+    ranges.swap (merged);
+}
+
+uint64_t
+count_addresses (const AddressRanges &ranges)
+{
+    uint64_t n = 0;
+    for (const AddressRange &r : ranges)
+    {
+        n += uint64_t (r.second) - r.first + 1;
+    }
+    return n;
+}
+
+AddressRanges
+complement_ranges (const AddressRanges &used, uint32_t low,
+                   uint32_t high)
+{
+    AddressRanges out;
+    uint64_t next = low;
+    for (const AddressRange &r : used)
+    {
+        if (r.first > next)
+        {
+            out.emplace_back (static_cast<uint32_t> (next),
+                              r.first - 1);
+        }
+        next = std::max<uint64_t> (next, uint64_t (r.second) + 1);
+    }
+    if (next <= high)
+    {
+        out.emplace_back (static_cast<uint32_t> (next), high);
+    }
+    return out;
+}
+} // namespace KeaGenerator
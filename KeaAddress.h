@@ -0,0 +1,119 @@
+// File: KeaAddress.h
+#ifndef KEA_ADDRESS_H
+#define KEA_ADDRESS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace KeaGenerator
+{
+// --- IPv4 helpers ---
+// Addresses are handled as host-order 32-bit integers, so that
+// "10.0.0.1" is 0x0a000001 and ranges compare numerically.
+
+// An IPv4 prefix, e.g. 192.168.1.0/24.
+struct Ipv4Prefix
+{
+    uint32_t base;   // First address of the prefix.
+    unsigned length; // Prefix length, 0..32.
+
+    // Number of addresses covered by the prefix.
+    uint64_t
+    size () const
+    {
+        return uint64_t (1) << (32 - length);
+    }
+
+    // Last address covered by the prefix.
+    uint32_t
+    last () const
+    {
+        return static_cast<uint32_t> (base + size () - 1);
+    }
+
+    bool
+    operator== (const Ipv4Prefix &rhs) const
+    {
+        return base == rhs.base && length == rhs.length;
+    }
+};
+
+// An inclusive address range [first, second].
+using AddressRange = std::pair<uint32_t, uint32_t>;
+using AddressRanges = std::vector<AddressRange>;
+
+// Network mask for a prefix length (0..32).
+inline uint32_t
+prefix_mask (unsigned length)
+{
+    return length == 0 ? 0 : ~uint32_t (0) << (32 - length);
+}
+
+// Parses a dotted-quad address ("a.b.c.d"). Each octet is 1-3
+// decimal digits without leading zeros and at most 255; nothing may
+// precede or follow the address. Returns false on malformed input.
+// Uses SSE4.1 when the CPU has it.
+bool parse_ipv4 (std::string_view text, uint32_t &addr);
+
+// Parses two addresses, with AVX2 when the CPU has it. Neither output
+// is set unless both parse.
+bool parse_ipv4_pair (std::string_view a, std::string_view b,
+                      uint32_t &x, uint32_t &y);
+
+// The portable parser behind parse_ipv4. The vector parsers accept
+// and reject exactly the same input.
+bool parse_ipv4_scalar (std::string_view text, uint32_t &addr);
+
+// Parses "a.b.c.d/len". Host bits below the prefix length are
+// cleared, so "10.1.2.3/8" yields 10.0.0.0/8. Returns false on
+// malformed input.
+bool parse_cidr (std::string_view text, Ipv4Prefix &prefix);
+
+// Parses a pool range string ("low - high") as produced by
+// Subnet4::add_pool_for_cfg. Returns false if either address is
+// malformed or low > high.
+bool parse_pool_range (std::string_view text, uint32_t &low,
+                       uint32_t &high);
+
+// Longest outputs of write_ipv4 and write_pool_range.
+constexpr std::size_t kIpv4Width = 15;          // 255.255.255.255
+constexpr std::size_t kPoolRangeWidth = 3 + 2 * kIpv4Width;
+
+// Writes an address as a dotted quad to `out`, which must have room
+// for kIpv4Width characters, and returns the end of the output. No
+// terminating NUL is written. Octets are copied from a lookup table.
+char *write_ipv4 (char *out, uint32_t addr);
+
+// Writes "low - high" to `out` (kPoolRangeWidth characters) and
+// returns the end of the output.
+char *write_pool_range (char *out, uint32_t low, uint32_t high);
+
+// Formats an address as a dotted quad.
+std::string format_ipv4 (uint32_t addr);
+
+// Formats a prefix as "a.b.c.d/len".
+std::string format_cidr (const Ipv4Prefix &prefix);
+
+// Formats a pool range string ("low - high").
+std::string format_pool_range (uint32_t low, uint32_t high);
+
+// --- Address ranges ---
+
+// Sorts `ranges` and merges overlapping or adjacent ones, leaving
+// disjoint, non-adjacent ranges in ascending order.
+void normalize_ranges (AddressRanges &ranges);
+
+// Number of addresses in normalized ranges.
+uint64_t count_addresses (const AddressRanges &ranges);
+
+// The ranges of [low, high] not covered by normalized `used`.
+AddressRanges complement_ranges (const AddressRanges &used,
+                                 uint32_t low, uint32_t high);
+
+} // namespace KeaGenerator
+
+#endif // KEA_ADDRESS_H
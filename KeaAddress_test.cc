@@ -0,0 +1,142 @@
+#include "KeaAddress.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace KeaGenerator;
+
+// Test dotted-quad parsing and formatting
+TEST (KeaAddressTest, Ipv4)
+{
+    uint32_t a = 0;
+    ASSERT_TRUE (parse_ipv4 ("10.0.0.1", a));
+    EXPECT_EQ (a, 0x0a000001u);
+    ASSERT_TRUE (parse_ipv4 ("255.255.255.255", a));
+    EXPECT_EQ (a, 0xffffffffu);
+    EXPECT_EQ (format_ipv4 (0xc0a80164u), "192.168.1.100");
+    EXPECT_EQ (format_ipv4 (0), "0.0.0.0");
+
+    EXPECT_FALSE (parse_ipv4 ("", a));
+    EXPECT_FALSE (parse_ipv4 ("10.0.0", a));
+    EXPECT_FALSE (parse_ipv4 ("10.0.0.256", a));
+    EXPECT_FALSE (parse_ipv4 ("10.0.0.01", a));
+    EXPECT_FALSE (parse_ipv4 ("10.0.0.1 ", a));
+    EXPECT_FALSE (parse_ipv4 ("10..0.1", a));
+    EXPECT_FALSE (parse_ipv4 ("10.0.0.1000", a));
+}
+
+// Test prefix and pool range parsing
+TEST (KeaAddressTest, CidrAndRange)
+{
+    Ipv4Prefix p{};
+    ASSERT_TRUE (parse_cidr ("10.1.2.3/8", p));
+    EXPECT_EQ (p, (Ipv4Prefix{ 0x0a000000u, 8 }));
+    EXPECT_EQ (p.last (), 0x0affffffu);
+    EXPECT_EQ (format_cidr (p), "10.0.0.0/8");
+    ASSERT_TRUE (parse_cidr ("0.0.0.0/0", p));
+    EXPECT_EQ (p.size (), uint64_t (1) << 32);
+
+    EXPECT_FALSE (parse_cidr ("10.0.0.0", p));
+    EXPECT_FALSE (parse_cidr ("10.0.0.0/33", p));
+    EXPECT_FALSE (parse_cidr ("10.0.0.0/08", p));
+    EXPECT_FALSE (parse_cidr ("10.0.0.0/", p));
+
+    uint32_t low = 0, high = 0;
+    ASSERT_TRUE (
+        parse_pool_range ("10.0.0.10 - 10.0.0.20", low, high));
+    EXPECT_EQ (high - low, 10u);
+    EXPECT_FALSE (
+        parse_pool_range ("10.0.0.20 - 10.0.0.10", low, high));
+    EXPECT_FALSE (
+        parse_pool_range ("10.0.0.10-10.0.0.20", low, high));
+}
+
+// Test the buffer formatters against the parser for every octet
+TEST (KeaAddressTest, WriteIpv4)
+{
+    char buf[kPoolRangeWidth];
+    for (uint32_t v = 0; v < 256; ++v)
+    {
+        uint32_t addr = v << 24 | (255 - v) << 16 | v / 10 << 8 | v;
+        std::string text (buf, write_ipv4 (buf, addr));
+        uint32_t back = 0;
+        ASSERT_TRUE (parse_ipv4 (text, back)) << text;
+        EXPECT_EQ (back, addr) << text;
+    }
+    EXPECT_EQ (write_ipv4 (buf, 0xffffffffu) - buf, 15);
+
+    EXPECT_EQ (std::string (buf, write_pool_range (buf, 0xffffffffu,
+                                                   0xffffffffu)),
+               "255.255.255.255 - 255.255.255.255");
+    EXPECT_EQ (format_pool_range (0x0a000005u, 0x0a0000c8u),
+               "10.0.0.5 - 10.0.0.200");
+    EXPECT_EQ (format_cidr ({ 0xc0a80000u, 16 }), "192.168.0.0/16");
+    EXPECT_EQ (format_cidr ({ 0, 0 }), "0.0.0.0/0");
+}
+
+// Test that the vector parsers agree with the scalar one
+TEST (KeaAddressTest, ParsersAgree)
+{
+    std::vector<std::string> inputs = {
+        "0.0.0.0",         "255.255.255.255", "1.2.3.4",
+        "01.2.3.4",        "1.2.3.04",        "1.2.3.256",
+        "999.1.1.1",       "1.2.3",           "1.2.3.4.",
+        ".1.2.3.4",        "1..2.3",          "1.2.3.4/8",
+        "1.2.3.4 ",        "1234.1.1.1",      "12.34.56.789",
+        "10.0.0.1\n",      "255.255.255.2555", "",
+        "1.2.3.-4",        "a.b.c.d",
+    };
+    inputs.emplace_back ("1.2.3.4\0", 8);
+    // Random strings over the characters that matter, and random
+    // addresses with one character replaced half of the time
+    uint32_t seed = 12345;
+    auto next = [&seed] () {
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 8;
+    };
+    const char alphabet[] = "0123456789.. ";
+    for (int i = 0; i < 100000; ++i)
+    {
+        std::string s (7 + next () % 10, '0');
+        for (char &c : s)
+        {
+            c = alphabet[next () % (sizeof (alphabet) - 1)];
+        }
+        inputs.push_back (s);
+
+        std::string a = format_ipv4 (next () * 2654435761u);
+        if (next () % 2)
+        {
+            a[next () % a.size ()]
+                = alphabet[next () % (sizeof (alphabet) - 1)];
+        }
+        inputs.push_back (a);
+    }
+
+    std::size_t valid = 0;
+    for (std::size_t i = 0; i < inputs.size (); ++i)
+    {
+        const std::string &s = inputs[i];
+        uint32_t scalar = 1, vector = 2;
+        bool ok = parse_ipv4_scalar (s, scalar);
+        ASSERT_EQ (parse_ipv4 (s, vector), ok) << s;
+        if (ok)
+        {
+            ++valid;
+            EXPECT_EQ (vector, scalar) << s;
+        }
+
+        const std::string &t = inputs[(i * 7919) % inputs.size ()];
+        uint32_t x = 0, y = 0, tx = 0;
+        bool both = ok && parse_ipv4_scalar (t, tx);
+        ASSERT_EQ (parse_ipv4_pair (s, t, x, y), both)
+            << s << ' ' << t;
+        if (both)
+        {
+            EXPECT_EQ (x, scalar);
+            EXPECT_EQ (y, tx);
+        }
+    }
+    // The random inputs must exercise the accepting paths too
+    EXPECT_GT (valid, 1000u);
+}
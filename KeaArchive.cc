@@ -0,0 +1,1003 @@
+#include "KeaArchive.h"
+#include "KeaStream.h"
+
+#include <algorithm>
+#include <string_view>
+#include <utility>
+
+namespace KeaGenerator
+{
+namespace
+{
+// --- Encoding ---
+// Numbers are LEB128 varints and strings are a length and their
+// bytes. A version is encoded as the delta from the version before
+// it; a snapshot is the delta from an empty configuration.
+//
+// Addresses in their canonical text form are stored as numbers, and
+// those of pools and reservations relative to the subnet address:
+//   subnet        0, text | length + 1, address
+//   pool range    0, text | low - subnet + 1, high - low
+//   ip address    0, text | address - subnet + 1
+//   hw address    0 (u8), text | 1 (u8), six bytes
+// Anything else, say "10.0.0.01", is kept as text, so every version
+// is rebuilt exactly.
+//
+//   flags (u8)         1 valid-lifetime, 2 interfaces, 4 lease db
+//   [valid-lifetime]   number
+//   [interfaces]       count, names
+//   [lease-database]   type, persist (u8), name
+//   max_id             number
+//   removed subnets    count, ids
+//   set subnets        count, then per subnet its id, a kind (u8)
+//                      and, for kind
+//     0 (new)          subnet, pools (count, ranges), reservations
+//                      (count, (hw address, ip address, hostname))
+//     1 (edit)         removed pools, added pools, removed
+//                      reservations (count, hw addresses), set
+//                      reservations
+//     2 (edit)         subnet, then as kind 1
+//   removed options    count, names
+//   set options        count, (name, data, always-send (u8))
+//
+// Subnet ids ascend and are stored as the difference to the id
+// before them.
+
+enum : uint8_t
+{
+    kLifetime = 1,
+    kInterfaces = 2,
+    kLeaseDatabase = 4,
+};
+
+enum : uint8_t
+{
+    kNew = 0,
+    kEdit = 1,
+    kEditAddress = 2,
+};
+
+using Cfg = Subnet4::Cfg;
+using Pool = Subnet4::Pool;
+using Reservation = Subnet4::Reservation;
+using Option = OptionData::Option;
+
+// The address pools and reservations are stored relative to.
+uint32_t
+subnet_base (std::string_view subnet)
+{
+    Ipv4Prefix prefix;
+    return parse_cidr (subnet, prefix) ? prefix.base : 0;
+}
+
+int
+hex_digit (char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+const char kHex[] = "0123456789abcdef";
+
+class Encoder
+{
+  public:
+    explicit Encoder (std::string &out) : out_ (out) {}
+
+    void
+    byte (uint8_t b)
+    {
+        out_.push_back (static_cast<char> (b));
+    }
+
+    void
+    number (uint64_t n)
+    {
+        for (; n >= 0x80; n >>= 7)
+        {
+            byte (static_cast<uint8_t> (n | 0x80));
+        }
+        byte (static_cast<uint8_t> (n));
+    }
+
+    void
+    string (std::string_view s)
+    {
+        number (s.size ());
+        out_.append (s.data (), s.size ());
+    }
+
+    void
+    subnet (const std::string &text)
+    {
+        Ipv4Prefix p;
+        if (parse_cidr (text, p) && format_cidr (p) == text)
+        {
+            number (p.length + 1);
+            number (p.base);
+            return;
+        }
+        number (0);
+        string (text);
+    }
+
+    void
+    range (uint32_t base, const std::string &text)
+    {
+        uint32_t low, high;
+        char buf[kPoolRangeWidth];
+        if (parse_pool_range (text, low, high) && low >= base
+            && text.compare (0, std::string::npos, buf,
+                             write_pool_range (buf, low, high) - buf)
+                   == 0)
+        {
+            number (uint64_t (low - base) + 1);
+            number (high - low);
+            return;
+        }
+        number (0);
+        string (text);
+    }
+
+    void
+    address (uint32_t base, const std::string &text)
+    {
+        uint32_t addr;
+        char buf[kIpv4Width];
+        if (parse_ipv4 (text, addr) && addr >= base
+            && text.compare (0, std::string::npos, buf,
+                             write_ipv4 (buf, addr) - buf)
+                   == 0)
+        {
+            number (uint64_t (addr - base) + 1);
+            return;
+        }
+        number (0);
+        string (text);
+    }
+
+    // Lower case "xx:xx:xx:xx:xx:xx" is stored as six bytes.
+    void
+    hw_address (const std::string &text)
+    {
+        bool canonical = text.size () == 17;
+        for (std::size_t i = 0; canonical && i < 17; ++i)
+        {
+            canonical = i % 3 == 2 ? text[i] == ':'
+                                   : hex_digit (text[i]) >= 0;
+        }
+        if (!canonical)
+        {
+            byte (0);
+            string (text);
+            return;
+        }
+        byte (1);
+        for (std::size_t i = 0; i < 17; i += 3)
+        {
+            byte (static_cast<uint8_t> (hex_digit (text[i]) * 16
+                                        + hex_digit (text[i + 1])));
+        }
+    }
+
+    void
+    reservation (uint32_t base, const Reservation &r)
+    {
+        hw_address (r.hw_address);
+        address (base, r.ip_address);
+        string (r.hostname);
+    }
+
+    void
+    option (const Option &o)
+    {
+        string (o.name);
+        string (o.data);
+        byte (o.always_send);
+    }
+
+  private:
+    std::string &out_;
+};
+
+// Reads what Encoder wrote. Every read fails past the end.
+class Decoder
+{
+  public:
+    explicit Decoder (std::string_view in) : in_ (in) {}
+
+    bool
+    byte (uint8_t &b)
+    {
+        if (pos_ == in_.size ())
+        {
+            return false;
+        }
+        b = static_cast<uint8_t> (in_[pos_++]);
+        return true;
+    }
+
+    bool
+    flag (bool &f)
+    {
+        uint8_t b;
+        if (!byte (b) || b > 1)
+        {
+            return false;
+        }
+        f = b != 0;
+        return true;
+    }
+
+    bool
+    number (uint64_t &n)
+    {
+        n = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t b;
+            if (!byte (b))
+            {
+                return false;
+            }
+            n |= uint64_t (b & 0x7f) << shift;
+            if ((b & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool
+    string (std::string &s)
+    {
+        uint64_t n;
+        if (!number (n) || n > in_.size () - pos_)
+        {
+            return false;
+        }
+        s.assign (in_.data () + pos_, n);
+        pos_ += n;
+        return true;
+    }
+
+    bool
+    subnet (std::string &text)
+    {
+        uint64_t form, base;
+        if (!number (form) || form > 33)
+        {
+            return false;
+        }
+        if (form == 0)
+        {
+            return string (text);
+        }
+        if (!number (base) || base > 0xffffffff)
+        {
+            return false;
+        }
+        text = format_cidr ({ static_cast<uint32_t> (base),
+                              static_cast<unsigned> (form - 1) });
+        return true;
+    }
+
+    bool
+    range (uint32_t base, std::string &text)
+    {
+        uint64_t form, span;
+        if (!number (form))
+        {
+            return false;
+        }
+        if (form == 0)
+        {
+            return string (text);
+        }
+        uint64_t low = base + form - 1;
+        if (!number (span) || low + span > 0xffffffff)
+        {
+            return false;
+        }
+        char buf[kPoolRangeWidth];
+        text.assign (buf, write_pool_range (buf, uint32_t (low),
+                                            uint32_t (low + span)));
+        return true;
+    }
+
+    bool
+    address (uint32_t base, std::string &text)
+    {
+        uint64_t form;
+        if (!number (form))
+        {
+            return false;
+        }
+        if (form == 0)
+        {
+            return string (text);
+        }
+        uint64_t addr = base + form - 1;
+        if (addr > 0xffffffff)
+        {
+            return false;
+        }
+        char buf[kIpv4Width];
+        text.assign (buf, write_ipv4 (buf, uint32_t (addr)));
+        return true;
+    }
+
+    bool
+    hw_address (std::string &text)
+    {
+        uint8_t form;
+        if (!byte (form) || form > 1)
+        {
+            return false;
+        }
+        if (form == 0)
+        {
+            return string (text);
+        }
+        text.assign (17, ':');
+        for (std::size_t i = 0; i < 17; i += 3)
+        {
+            uint8_t b;
+            if (!byte (b))
+            {
+                return false;
+            }
+            text[i] = kHex[b >> 4];
+            text[i + 1] = kHex[b & 15];
+        }
+        return true;
+    }
+
+    bool
+    reservation (uint32_t base, Reservation &r)
+    {
+        return hw_address (r.hw_address)
+               && address (base, r.ip_address) && string (r.hostname);
+    }
+
+    bool
+    option (Option &o)
+    {
+        return string (o.name) && string (o.data)
+               && flag (o.always_send);
+    }
+
+    bool
+    done () const
+    {
+        return pos_ == in_.size ();
+    }
+
+  private:
+    std::string_view in_;
+    std::size_t pos_ = 0;
+};
+
+// Walks the sorted ranges [a, a_end) and [b, b_end) by key (),
+// calling gone (x) for elements only in the first, came (y) for
+// those only in the second and both (x, y) for the others.
+template <class It, class Key, class Gone, class Came, class Both>
+void
+merge (It a, It a_end, It b, It b_end, Key key, Gone gone, Came came,
+       Both both)
+{
+    while (a != a_end || b != b_end)
+    {
+        if (b == b_end || (a != a_end && key (*a) < key (*b)))
+        {
+            gone (*a++);
+        }
+        else if (a == a_end || key (*b) < key (*a))
+        {
+            came (*b++);
+        }
+        else
+        {
+            both (*a++, *b++);
+        }
+    }
+}
+
+bool
+same_reservation (const Reservation &a, const Reservation &b)
+{
+    return a.hw_address == b.hw_address
+           && a.ip_address == b.ip_address
+           && a.hostname == b.hostname;
+}
+
+bool
+same_cfg (const Cfg &a, const Cfg &b)
+{
+    auto same_pool = [] (const Pool &x, const Pool &y) {
+        return x.range == y.range;
+    };
+    return a.subnet == b.subnet
+           && std::equal (a.pools.begin (), a.pools.end (),
+                          b.pools.begin (), b.pools.end (), same_pool)
+           && std::equal (a.reservations.begin (),
+                          a.reservations.end (),
+                          b.reservations.begin (),
+                          b.reservations.end (), same_reservation);
+}
+
+void
+encode_cfg (Encoder &e, const Cfg &c)
+{
+    e.subnet (c.subnet);
+    uint32_t base = subnet_base (c.subnet);
+    e.number (c.pools.size ());
+    for (const Pool &p : c.pools)
+    {
+        e.range (base, p.range);
+    }
+    e.number (c.reservations.size ());
+    for (const Reservation &r : c.reservations)
+    {
+        e.reservation (base, r);
+    }
+}
+
+// The pools and reservations that differ between two versions of a
+// subnet.
+void
+encode_edit (Encoder &e, const Cfg &a, const Cfg &b)
+{
+    uint32_t base = subnet_base (b.subnet);
+    std::vector<const Pool *> removed, added;
+    merge (
+        a.pools.begin (), a.pools.end (), b.pools.begin (),
+        b.pools.end (), [] (const Pool &p) -> const std::string & {
+            return p.range;
+        },
+        [&] (const Pool &p) { removed.push_back (&p); },
+        [&] (const Pool &p) { added.push_back (&p); },
+        [] (const Pool &, const Pool &) {});
+    for (const auto *list : { &removed, &added })
+    {
+        e.number (list->size ());
+        for (const Pool *p : *list)
+        {
+            e.range (base, p->range);
+        }
+    }
+
+    std::vector<const Reservation *> gone, set;
+    merge (
+        a.reservations.begin (), a.reservations.end (),
+        b.reservations.begin (), b.reservations.end (),
+        [] (const Reservation &r) -> const std::string & {
+            return r.hw_address;
+        },
+        [&] (const Reservation &r) { gone.push_back (&r); },
+        [&] (const Reservation &r) { set.push_back (&r); },
+        [&] (const Reservation &x, const Reservation &y) {
+            if (!same_reservation (x, y))
+            {
+                set.push_back (&y);
+            }
+        });
+    e.number (gone.size ());
+    for (const Reservation *r : gone)
+    {
+        e.hw_address (r->hw_address);
+    }
+    e.number (set.size ());
+    for (const Reservation *r : set)
+    {
+        e.reservation (base, *r);
+    }
+}
+
+void
+encode_delta (const KeaConfig &from, const KeaConfig &to,
+              std::string &out)
+{
+    Encoder e (out);
+    const Dhcp4 &a = from.dhcp4;
+    const Dhcp4 &b = to.dhcp4;
+    const LeaseDatabase &la = a.lease_database;
+    const LeaseDatabase &lb = b.lease_database;
+
+    uint8_t flags = 0;
+    if (a.valid_lifetime != b.valid_lifetime)
+    {
+        flags |= kLifetime;
+    }
+    const auto &ia = a.interface_config.interfaces;
+    const auto &ib = b.interface_config.interfaces;
+    if (ia != ib)
+    {
+        flags |= kInterfaces;
+    }
+    if (la.type != lb.type || la.persist != lb.persist
+        || la.name != lb.name)
+    {
+        flags |= kLeaseDatabase;
+    }
+    e.byte (flags);
+    if (flags & kLifetime)
+    {
+        e.number (b.valid_lifetime);
+    }
+    if (flags & kInterfaces)
+    {
+        e.number (ib.size ());
+        for (const std::string &name : ib)
+        {
+            e.string (name);
+        }
+    }
+    if (flags & kLeaseDatabase)
+    {
+        e.string (lb.type);
+        e.byte (lb.persist);
+        e.string (lb.name);
+    }
+    e.number (b.subnet4.max_id);
+
+    std::vector<const Cfg *> x = sorted_cfgs (a.subnet4);
+    std::vector<const Cfg *> y = sorted_cfgs (b.subnet4);
+    std::vector<uint64_t> removed;
+    // (previous version or nullptr, new version)
+    std::vector<std::pair<const Cfg *, const Cfg *> > set;
+    merge (
+        x.begin (), x.end (), y.begin (), y.end (),
+        [] (const Cfg *c) { return c->id; },
+        [&] (const Cfg *c) { removed.push_back (c->id); },
+        [&] (const Cfg *c) { set.emplace_back (nullptr, c); },
+        [&] (const Cfg *c, const Cfg *d) {
+            if (!same_cfg (*c, *d))
+            {
+                set.emplace_back (c, d);
+            }
+        });
+    e.number (removed.size ());
+    uint64_t previous = 0;
+    for (uint64_t id : removed)
+    {
+        e.number (id - previous);
+        previous = id;
+    }
+    e.number (set.size ());
+    previous = 0;
+    for (const auto &change : set)
+    {
+        const Cfg &c = *change.second;
+        e.number (c.id - previous);
+        previous = c.id;
+        if (change.first == nullptr)
+        {
+            e.byte (kNew);
+            encode_cfg (e, c);
+        }
+        else if (change.first->subnet != c.subnet)
+        {
+            e.byte (kEditAddress);
+            e.subnet (c.subnet);
+            encode_edit (e, *change.first, c);
+        }
+        else
+        {
+            e.byte (kEdit);
+            encode_edit (e, *change.first, c);
+        }
+    }
+
+    std::vector<const Option *> gone, changed;
+    const OptionData &oa = a.option_data;
+    const OptionData &ob = b.option_data;
+    merge (
+        oa.options.begin (), oa.options.end (), ob.options.begin (),
+        ob.options.end (),
+        [] (const Option &o) -> const std::string & {
+            return o.name;
+        },
+        [&] (const Option &o) { gone.push_back (&o); },
+        [&] (const Option &o) { changed.push_back (&o); },
+        [&] (const Option &o, const Option &p) {
+            if (o.data != p.data || o.always_send != p.always_send)
+            {
+                changed.push_back (&p);
+            }
+        });
+    e.number (gone.size ());
+    for (const Option *o : gone)
+    {
+        e.string (o->name);
+    }
+    e.number (changed.size ());
+    for (const Option *o : changed)
+    {
+        e.option (*o);
+    }
+}
+
+bool
+decode_cfg (Decoder &d, Cfg &c)
+{
+    uint64_t n;
+    if (!d.subnet (c.subnet) || !d.number (n))
+    {
+        return false;
+    }
+    uint32_t base = subnet_base (c.subnet);
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        Pool p;
+        if (!d.range (base, p.range) || !c.pools.insert (p).second)
+        {
+            return false;
+        }
+    }
+    if (!d.number (n))
+    {
+        return false;
+    }
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        Reservation r;
+        if (!d.reservation (base, r)
+            || !c.reservations.insert (r).second)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+decode_edit (Decoder &d, Cfg &c)
+{
+    uint32_t base = subnet_base (c.subnet);
+    uint64_t n;
+    Pool p;
+    if (!d.number (n))
+    {
+        return false;
+    }
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        if (!d.range (base, p.range) || c.pools.erase (p) == 0)
+        {
+            return false;
+        }
+    }
+    if (!d.number (n))
+    {
+        return false;
+    }
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        if (!d.range (base, p.range) || !c.pools.insert (p).second)
+        {
+            return false;
+        }
+    }
+
+    Reservation r;
+    if (!d.number (n))
+    {
+        return false;
+    }
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        if (!d.hw_address (r.hw_address)
+            || c.reservations.erase (r) == 0)
+        {
+            return false;
+        }
+    }
+    if (!d.number (n))
+    {
+        return false;
+    }
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        if (!d.reservation (base, r))
+        {
+            return false;
+        }
+        c.reservations.erase (r);
+        c.reservations.insert (r);
+    }
+    return true;
+}
+
+// Applies one encoded version to `config`, which must be the
+// version before it (or empty for a snapshot). Returns false on
+// malformed data, leaving `config` partly updated.
+bool
+apply_delta (std::string_view data, KeaConfig &config)
+{
+    Decoder d (data);
+    Dhcp4 &c = config.dhcp4;
+    uint64_t n;
+
+    uint8_t flags;
+    if (!d.byte (flags)
+        || (flags & ~(kLifetime | kInterfaces | kLeaseDatabase)) != 0)
+    {
+        return false;
+    }
+    if ((flags & kLifetime) && !d.number (c.valid_lifetime))
+    {
+        return false;
+    }
+    if (flags & kInterfaces)
+    {
+        std::vector<std::string> names;
+        if (!d.number (n))
+        {
+            return false;
+        }
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            std::string name;
+            if (!d.string (name))
+            {
+                return false;
+            }
+            names.push_back (std::move (name));
+        }
+        c.interface_config.interfaces = std::move (names);
+    }
+    if (flags & kLeaseDatabase)
+    {
+        LeaseDatabase &l = c.lease_database;
+        if (!d.string (l.type) || !d.flag (l.persist)
+            || !d.string (l.name))
+        {
+            return false;
+        }
+    }
+
+    Subnet4 &s = c.subnet4;
+    uint64_t id = 0, step;
+    if (!d.number (s.max_id) || !d.number (n))
+    {
+        return false;
+    }
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        if (!d.number (step) || s.cfgs.erase (id += step) == 0)
+        {
+            return false;
+        }
+    }
+    if (!d.number (n))
+    {
+        return false;
+    }
+    id = 0;
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        uint8_t kind;
+        if (!d.number (step) || !d.byte (kind))
+        {
+            return false;
+        }
+        id += step;
+        if (kind == kNew)
+        {
+            Cfg cfg{ id, {}, {}, {} };
+            if (!decode_cfg (d, cfg))
+            {
+                return false;
+            }
+            s.cfgs[id] = std::move (cfg);
+            continue;
+        }
+        auto it = s.cfgs.find (id);
+        if (it == s.cfgs.end () || kind > kEditAddress
+            || (kind == kEditAddress && !d.subnet (it->second.subnet))
+            || !decode_edit (d, it->second))
+        {
+            return false;
+        }
+    }
+
+    auto &options = c.option_data.options;
+    Option o;
+    if (!d.number (n))
+    {
+        return false;
+    }
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        if (!d.string (o.name) || options.erase (o) == 0)
+        {
+            return false;
+        }
+    }
+    if (!d.number (n))
+    {
+        return false;
+    }
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        if (!d.option (o))
+        {
+            return false;
+        }
+        options.erase (o);
+        options.insert (o);
+    }
+    return d.done ();
+}
+
+KeaConfig
+empty_config ()
+{
+    return KeaConfig (Dhcp4 ());
+}
+
+// Fixed-width little-endian integers for the container.
+void
+put_le (std::ostream &out, uint64_t v, int bytes)
+{
+    char buf[8];
+    for (int i = 0; i < bytes; ++i)
+    {
+        buf[i] = static_cast<char> (v >> (8 * i));
+    }
+    out.write (buf, bytes);
+}
+
+bool
+get_le (std::istream &in, uint64_t &v, int bytes)
+{
+    unsigned char buf[8];
+    if (!in.read (reinterpret_cast<char *> (buf), bytes))
+    {
+        return false;
+    }
+    v = 0;
+    for (int i = 0; i < bytes; ++i)
+    {
+        v |= uint64_t (buf[i]) << (8 * i);
+    }
+    return true;
+}
+} // namespace
+
+ConfigArchive::ConfigArchive (std::size_t snapshot_interval)
+    : interval_ (std::max<std::size_t> (snapshot_interval, 1)),
+      last_ (empty_config ())
+{
+}
+
+std::size_t
+ConfigArchive::append (const KeaConfig &config)
+{
+    std::string data;
+    if (versions_.size () % interval_ == 0)
+    {
+        encode_delta (empty_config (), config, data);
+    }
+    else
+    {
+        encode_delta (last_, config, data);
+    }
+    versions_.push_back (std::move (data));
+    last_ = config;
+    return versions_.size () - 1;
+}
+
+bool
+ConfigArchive::get (std::size_t version, KeaConfig &config) const
+{
+    if (version >= versions_.size ())
+    {
+        return false;
+    }
+    if (version + 1 == versions_.size ())
+    {
+        config = last_;
+        return true;
+    }
+    KeaConfig result = empty_config ();
+    for (std::size_t v = version - version % interval_; v <= version;
+         ++v)
+    {
+        if (!apply_delta (versions_[v], result))
+        {
+            return false;
+        }
+    }
+    // The deltas edit cfgs directly.
+    result.dhcp4.subnet4.reindex ();
+    config = std::move (result);
+    return true;
+}
+
+uint64_t
+ConfigArchive::stored_bytes () const
+{
+    uint64_t bytes = 0;
+    for (const std::string &v : versions_)
+    {
+        bytes += v.size ();
+    }
+    return bytes;
+}
+
+void
+ConfigArchive::serialize (std::ostream &out) const
+{
+    out.write ("KAR1", 4);
+    put_le (out, interval_, 4);
+    put_le (out, versions_.size (), 4);
+    for (const std::string &v : versions_)
+    {
+        put_le (out, v.size (), 8);
+        out.write (v.data (),
+                   static_cast<std::streamsize> (v.size ()));
+    }
+}
+
+bool
+ConfigArchive::deserialize (std::istream &in, ConfigArchive &archive)
+{
+    char magic[4];
+    uint64_t interval, count;
+    if (!in.read (magic, 4) || std::string (magic, 4) != "KAR1"
+        || !get_le (in, interval, 4) || interval == 0
+        || !get_le (in, count, 4))
+    {
+        return false;
+    }
+
+    ConfigArchive result (interval);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        uint64_t size;
+        if (!get_le (in, size, 8))
+        {
+            return false;
+        }
+        // Read in pieces so a corrupt size fails at the end of the
+        // stream instead of allocating it up front.
+        std::string data;
+        char buf[65536];
+        while (data.size () < size)
+        {
+            uint64_t left = size - data.size ();
+            auto n = static_cast<std::streamsize> (
+                std::min<uint64_t> (left, sizeof (buf)));
+            if (!in.read (buf, n))
+            {
+                return false;
+            }
+            data.append (buf, static_cast<std::size_t> (n));
+        }
+        // Replays every version once, which checks them all and
+        // leaves the latest in last_.
+        if (i % interval == 0)
+        {
+            result.last_ = empty_config ();
+        }
+        if (!apply_delta (data, result.last_))
+        {
+            return false;
+        }
+        result.versions_.push_back (std::move (data));
+    }
+    result.last_.dhcp4.subnet4.reindex ();
+    archive = std::move (result);
+    return true;
+}
+} // namespace KeaGenerator
@@ -0,0 +1,66 @@
+// File: KeaArchive.h
+#ifndef KEA_ARCHIVE_H
+#define KEA_ARCHIVE_H
+
+#include "KeaGenerator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace KeaGenerator
+{
+// --- Version archive ---
+// Keeps every version of a configuration compactly. Every
+// `snapshot_interval`-th version is stored in full; the others hold
+// only what changed since the version before. Those deltas are
+// structural: subnets added, removed or edited (their address,
+// single pools, single reservations), options set or removed, and
+// the top-level fields that changed. A version that edits a few
+// subnets of a large configuration takes a few bytes per edit.
+//
+// Reading a version decodes the snapshot at or before it and
+// replays at most snapshot_interval - 1 deltas onto it.
+class ConfigArchive
+{
+  public:
+    explicit ConfigArchive (std::size_t snapshot_interval = 32);
+
+    // Appends the next version and returns its number; the first is
+    // version 0. The archive keeps a copy of the latest version to
+    // compute the next delta.
+    std::size_t append (const KeaConfig &config);
+
+    // Number of versions.
+    std::size_t
+    size () const
+    {
+        return versions_.size ();
+    }
+
+    // Rebuilds `version` into `config`. Returns false if there is no
+    // such version or its data is malformed.
+    bool get (std::size_t version, KeaConfig &config) const;
+
+    // Bytes taken by the encoded snapshots and deltas.
+    uint64_t stored_bytes () const;
+
+    // Binary form: "KAR1", the snapshot interval, the version count,
+    // then each encoded version prefixed with its length.
+    void serialize (std::ostream &out) const;
+    // Reads what serialize() wrote. Returns false on malformed input.
+    static bool deserialize (std::istream &in,
+                             ConfigArchive &archive);
+
+  private:
+    std::size_t interval_;
+    std::vector<std::string> versions_;
+    KeaConfig last_; // The latest version.
+};
+
+} // namespace KeaGenerator
+
+#endif // KEA_ARCHIVE_H
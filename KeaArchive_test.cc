@@ -0,0 +1,210 @@
+#include "KeaArchive.h"
+#include "KeaStream.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace KeaGenerator;
+
+static std::string
+Render (const KeaConfig &config)
+{
+    std::ostringstream out;
+    write_json (out, config);
+    return out.str ();
+}
+
+static std::string
+Net (uint64_t n)
+{
+    return "10." + std::to_string (n / 256 % 256) + "."
+           + std::to_string (n % 256) + ".";
+}
+
+// Changes a few random parts of `config`, touching every kind of
+// element the archive tracks.
+static void
+Mutate (KeaConfig &config, std::mt19937 &rng)
+{
+    Dhcp4 &d = config.dhcp4;
+    Subnet4 &s = d.subnet4;
+    for (int i = 0; i < 6; ++i)
+    {
+        auto it = s.cfgs.begin ();
+        std::advance (it, rng () % s.cfgs.size ());
+        Subnet4::Cfg &c = it->second;
+        std::string net
+            = c.subnet.substr (0, c.subnet.rfind ('.') + 1);
+        switch (rng () % 7)
+        {
+        case 0:
+            s.add_config (Net (s.max_id) + "0/24");
+            break;
+        case 1:
+            if (s.cfgs.size () > 2)
+            {
+                s.cfgs.erase (it);
+            }
+            break;
+        case 2:
+            c.pools.clear ();
+            s.add_pool_for_cfg (c.id,
+                                net + std::to_string (rng () % 50),
+                                net + "100");
+            break;
+        case 3:
+            s.add_reservation_for_cfg (
+                c.id,
+                "aa:00:00:00:00:" + std::to_string (rng () % 90),
+                net + std::to_string (rng () % 250),
+                rng () % 2 ? "host" : "");
+            break;
+        case 4:
+            if (!c.reservations.empty ())
+            {
+                Subnet4::Reservation r = *c.reservations.begin ();
+                c.reservations.erase (c.reservations.begin ());
+                r.ip_address = net + "9";
+                c.reservations.insert (r);
+            }
+            break;
+        case 5:
+            c.subnet = Net (c.id + 1000) + "0/24";
+            break;
+        case 6:
+            d.option_data.options.clear ();
+            d.option_data.add_option ("routers", net + "1",
+                                      rng () % 2);
+            if (rng () % 2)
+            {
+                d.option_data.add_option_always ("domain-name",
+                                                 "example.org");
+            }
+            break;
+        }
+    }
+    switch (rng () % 6)
+    {
+    case 0:
+        d.valid_lifetime = rng () % 10000;
+        break;
+    case 1:
+        d.interface_config.interfaces = { "eth" + std::to_string (
+            rng () % 3) };
+        break;
+    case 2:
+        d.lease_database.persist = !d.lease_database.persist;
+        break;
+    }
+}
+
+TEST (KeaArchiveTest, ReplaysEveryVersion)
+{
+    std::mt19937 rng (7);
+    KeaConfig config;
+    for (uint64_t i = 0; i < 40; ++i)
+    {
+        Subnet4 &s = config.dhcp4.subnet4;
+        uint64_t id = s.add_config (Net (i) + "0/24");
+        s.add_pool_for_cfg (id, Net (i) + "10", Net (i) + "20");
+    }
+    // Forms the archive keeps as text.
+    Subnet4 &s = config.dhcp4.subnet4;
+    uint64_t odd = s.add_config ("10.200.0.7/24");
+    s.cfgs[odd].pools.insert ({ "10.200.0.010 - 10.200.0.20" });
+    s.cfgs[odd].pools.insert ({ "10.0.0.1 - 10.0.0.2" });
+    s.add_reservation_for_cfg (odd, "AA:BB:CC:DD:EE:FF", "10.1.0.1");
+    s.add_reservation_for_cfg (odd, "01-02", "10.200.0.9");
+
+    ConfigArchive archive (8);
+    std::vector<std::string> expected;
+    for (std::size_t v = 0; v < 50; ++v)
+    {
+        EXPECT_EQ (archive.append (config), v);
+        expected.push_back (Render (config));
+        Mutate (config, rng);
+    }
+    ASSERT_EQ (archive.size (), expected.size ());
+
+    std::stringstream stored;
+    archive.serialize (stored);
+    ConfigArchive loaded;
+    ASSERT_TRUE (ConfigArchive::deserialize (stored, loaded));
+    EXPECT_EQ (loaded.stored_bytes (), archive.stored_bytes ());
+
+    KeaConfig out;
+    for (std::size_t v = 0; v < expected.size (); ++v)
+    {
+        ASSERT_TRUE (archive.get (v, out));
+        EXPECT_EQ (Render (out), expected[v]) << "version " << v;
+        ASSERT_TRUE (loaded.get (v, out));
+        EXPECT_EQ (Render (out), expected[v]) << "version " << v;
+    }
+    EXPECT_FALSE (archive.get (expected.size (), out));
+    // Rebuilt versions have a working prefix index
+    ASSERT_TRUE (archive.get (0, out));
+    EXPECT_EQ (out.dhcp4.subnet4.find_by_prefix ("10.200.0.0/24"),
+               odd);
+
+    // The loaded archive continues from its latest version.
+    loaded.append (config);
+    ASSERT_TRUE (loaded.get (expected.size () - 1, out));
+    EXPECT_EQ (Render (out), expected.back ());
+    ASSERT_TRUE (loaded.get (expected.size (), out));
+    EXPECT_EQ (Render (out), Render (config));
+}
+
+TEST (KeaArchiveTest, SmallDeltas)
+{
+    KeaConfig config;
+    Subnet4 &s = config.dhcp4.subnet4;
+    for (uint64_t i = 0; i < 2000; ++i)
+    {
+        uint64_t id = s.add_config (Net (i) + "0/24");
+        s.add_pool_for_cfg (id, Net (i) + "10", Net (i) + "200");
+        s.add_reservation_for_cfg (id, "1a:1b:1c:1d:1e:1f",
+                                   Net (i) + "5", "printer");
+    }
+
+    ConfigArchive archive (50);
+    uint64_t rendered = 0;
+    for (uint64_t v = 0; v < 50; ++v)
+    {
+        Subnet4::Cfg &c = s.cfgs[1 + v * 37 % 2000];
+        c.pools.clear ();
+        s.add_pool_for_cfg (c.id, Net (c.id - 1) + "20",
+                            Net (c.id - 1) + "220");
+        archive.append (config);
+        rendered += Render (config).size ();
+    }
+    // One snapshot, in a form about as large as the JSON, and 49
+    // deltas of one pool each.
+    EXPECT_LT (archive.stored_bytes (), rendered / 40);
+}
+
+TEST (KeaArchiveTest, RejectsMalformedInput)
+{
+    KeaConfig config;
+    config.dhcp4.subnet4.add_config ("10.0.0.0/24");
+    ConfigArchive archive (4);
+    for (int v = 0; v < 6; ++v)
+    {
+        config.dhcp4.valid_lifetime = 100 + v;
+        archive.append (config);
+    }
+    std::stringstream out;
+    archive.serialize (out);
+    std::string data = out.str ();
+
+    ConfigArchive loaded;
+    std::istringstream empty ("");
+    EXPECT_FALSE (ConfigArchive::deserialize (empty, loaded));
+    std::istringstream truncated (data.substr (0, data.size () - 1));
+    EXPECT_FALSE (ConfigArchive::deserialize (truncated, loaded));
+    std::string bad = data;
+    bad.back () ^= 0x7f;
+    std::istringstream corrupt (bad);
+    EXPECT_FALSE (ConfigArchive::deserialize (corrupt, loaded));
+    EXPECT_EQ (loaded.size (), 0u);
+}
@@ -0,0 +1,337 @@
+#include "KeaBatch.h"
+#include "KeaStream.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace KeaGenerator
+{
+namespace
+{
+// Kinds of edit a batch line can describe.
+enum class CommandKind
+{
+    add_config,
+    add_pool,
+    add_option
+};
+
+// A parsed and validated batch line.
+struct Command
+{
+    CommandKind kind;
+    std::size_t line;              // 1-based source line.
+    std::vector<std::string> args; // Arguments after the verb.
+    // Subnet group the command belongs to. Group 0 holds commands
+    // that do not touch a subnet (options); groups 1.. are numbered
+    // in order of first appearance of their subnet.
+    std::size_t group;
+    // Id of an already existing configuration targeted by a pool
+    // command, 0 if the target is created by this batch.
+    uint64_t cfg_id;
+};
+
+// Splits a line into whitespace separated tokens. Double quotes group
+// a token containing spaces; inside quotes, backslash escapes the
+// next character. An unquoted '#' at the start of a token ends the
+// line. Returns false if a quote is left open.
+bool
+tokenize (const std::string &line, std::vector<std::string> &tokens)
+{
+    std::size_t i = 0;
+    const std::size_t n = line.size ();
+    while (i < n)
+    {
+        if (line[i] == ' ' || line[i] == '\t' || line[i] == '\r')
+        {
+            ++i;
+            continue;
+        }
+        if (line[i] == '#')
+        {
+            break;
+        }
+
+        std::string token;
+        if (line[i] == '"')
+        {
+            ++i;
+            bool closed = false;
+            while (i < n)
+            {
+                char c = line[i++];
+                if (c == '"')
+                {
+                    closed = true;
+                    break;
+                }
+                if (c == '\\' && i < n)
+                {
+                    c = line[i++];
+                }
+                token.push_back (c);
+            }
+            if (!closed)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            while (i < n && line[i] != ' ' && line[i] != '\t'
+                   && line[i] != '\r')
+            {
+                token.push_back (line[i++]);
+            }
+        }
+        tokens.push_back (std::move (token));
+    }
+    return true;
+}
+
+// Returns true if the token is a non-empty run of decimal digits.
+bool
+is_number (const std::string &token)
+{
+    return !token.empty ()
+           && std::all_of (token.begin (), token.end (),
+                           [] (char c) {
+                               return c >= '0' && c <= '9';
+                           });
+}
+
+// Parses "true"/"false" into `value`. Returns false otherwise.
+bool
+parse_bool (const std::string &token, bool &value)
+{
+    if (token == "true")
+    {
+        value = true;
+        return true;
+    }
+    if (token == "false")
+    {
+        value = false;
+        return true;
+    }
+    return false;
+}
+
+// Records the first error of a batch and returns the result.
+BatchResult
+fail (BatchResult result, std::size_t line, std::string error)
+{
+    result.applied = false;
+    result.error_line = line;
+    result.error = std::move (error);
+    return result;
+}
+} // namespace
+
+BatchResult
+apply_batch (KeaConfig &config, std::istream &commands)
+{
+    BatchResult result;
+    Subnet4 &subnet4 = config.dhcp4.subnet4;
+
+    // Group numbers of subnets created by this batch, keyed by
+    // Subnet4::prefix_key, and of existing configurations touched by
+    // it. Existing subnets are found through the prefix index.
+    std::unordered_map<uint64_t, std::size_t> new_groups;
+    std::unordered_map<uint64_t, std::size_t> existing_groups;
+    std::size_t groups = 0;
+
+    // --- Parse and validate every line before touching the config.
+    std::vector<Command> parsed;
+    std::vector<std::string> tokens;
+    std::string line;
+    std::size_t line_no = 0;
+    while (std::getline (commands, line))
+    {
+        ++line_no;
+        tokens.clear ();
+        if (!tokenize (line, tokens))
+        {
+            return fail (result, line_no, "unterminated quote");
+        }
+        if (tokens.empty ())
+        {
+            continue;
+        }
+
+        const std::string verb = tokens.front ();
+        Command cmd{ CommandKind::add_option, line_no,
+                     std::vector<std::string> (tokens.begin () + 1,
+                                               tokens.end ()),
+                     0, 0 };
+        const std::size_t argc = cmd.args.size ();
+
+        if (verb == "add_config")
+        {
+            if (argc != 1)
+            {
+                return fail (result, line_no,
+                             "add_config expects <subnet>");
+            }
+            const std::string &subnet = cmd.args[0];
+            Ipv4Prefix prefix;
+            if (!parse_cidr (subnet, prefix))
+            {
+                return fail (result, line_no,
+                             "invalid subnet " + subnet);
+            }
+            uint64_t key = Subnet4::prefix_key (prefix);
+            if (new_groups.count (key)
+                || subnet4.find_by_prefix (subnet) != 0)
+            {
+                return fail (result, line_no,
+                             "subnet " + subnet + " already defined");
+            }
+            cmd.kind = CommandKind::add_config;
+            cmd.group = ++groups;
+            new_groups.emplace (key, cmd.group);
+        }
+        else if (verb == "add_pool_for_cfg")
+        {
+            if (argc != 3)
+            {
+                return fail (result, line_no,
+                             "add_pool_for_cfg expects <subnet|id> "
+                             "<low> <high>");
+            }
+            const std::string &target = cmd.args[0];
+            cmd.kind = CommandKind::add_pool;
+            uint32_t low, high;
+            if (!parse_ipv4_pair (cmd.args[1], cmd.args[2], low, high)
+                || low > high)
+            {
+                return fail (result, line_no,
+                             "invalid pool " + cmd.args[1] + " - "
+                                 + cmd.args[2]);
+            }
+
+            Ipv4Prefix prefix;
+            auto batch_it
+                = parse_cidr (target, prefix)
+                      ? new_groups.find (Subnet4::prefix_key (prefix))
+                      : new_groups.end ();
+            if (batch_it != new_groups.end ())
+            {
+                cmd.group = batch_it->second;
+            }
+            else
+            {
+                uint64_t id = UINT64_MAX;
+                if (is_number (target) && target.size () < 20)
+                {
+                    id = std::stoull (target);
+                    if (subnet4.cfgs.find (id) == subnet4.cfgs.end ())
+                    {
+                        id = UINT64_MAX;
+                    }
+                }
+                else
+                {
+                    id = subnet4.find_by_prefix (target);
+                    if (id == 0)
+                    {
+                        id = UINT64_MAX;
+                    }
+                }
+                if (id == UINT64_MAX)
+                {
+                    return fail (result, line_no,
+                                 "unknown subnet " + target);
+                }
+                auto ins = existing_groups.emplace (id, groups + 1);
+                if (ins.second)
+                {
+                    ++groups;
+                }
+                cmd.group = ins.first->second;
+                cmd.cfg_id = id;
+            }
+        }
+        else if (verb == "add_option")
+        {
+            bool always_send = false;
+            if (argc != 3 || !parse_bool (cmd.args[2], always_send))
+            {
+                return fail (result, line_no,
+                             "add_option expects <name> <data> "
+                             "<true|false>");
+            }
+        }
+        else if (verb == "add_option_always")
+        {
+            if (argc != 2)
+            {
+                return fail (result, line_no,
+                             "add_option_always expects <name> "
+                             "<data>");
+            }
+            cmd.args.emplace_back ("true");
+        }
+        else
+        {
+            return fail (result, line_no,
+                         "unknown command " + verb);
+        }
+
+        parsed.push_back (std::move (cmd));
+    }
+    result.commands = parsed.size ();
+
+    // --- Apply, grouped by subnet. The sort is stable and add_config
+    // lines open their own group, so ids are handed out in the same
+    // order as a line-by-line application would.
+    std::stable_sort (parsed.begin (), parsed.end (),
+                      [] (const Command &a, const Command &b) {
+                          return a.group < b.group;
+                      });
+
+    std::vector<uint64_t> group_ids (groups + 1, 0);
+    for (Command &cmd : parsed)
+    {
+        switch (cmd.kind)
+        {
+        case CommandKind::add_config:
+            group_ids[cmd.group]
+                = subnet4.add_config (std::move (cmd.args[0]));
+            break;
+        case CommandKind::add_pool:
+            subnet4.add_pool_for_cfg (cmd.cfg_id != 0
+                                          ? cmd.cfg_id
+                                          : group_ids[cmd.group],
+                                      std::move (cmd.args[1]),
+                                      std::move (cmd.args[2]));
+            break;
+        case CommandKind::add_option:
+            config.dhcp4.option_data.add_option (
+                std::move (cmd.args[0]), std::move (cmd.args[1]),
+                cmd.args[2] == "true");
+            break;
+        }
+    }
+
+    result.applied = true;
+    return result;
+}
+
+BatchResult
+run_batch (KeaConfig &config, std::istream &commands,
+           std::ostream &out)
+{
+    BatchResult result = apply_batch (config, commands);
+    if (result.applied)
+    {
+        // Single render of the final state.
+        write_json (out, config);
+        out << '\n';
+    }
+    return result;
+}
+} // namespace KeaGenerator
@@ -0,0 +1,54 @@
+// File: KeaBatch.h
+#ifndef KEA_BATCH_H
+#define KEA_BATCH_H
+
+#include "KeaGenerator.h"
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace KeaGenerator
+{
+// --- Batch command processing ---
+// Applies a newline-delimited stream of edit commands to a KeaConfig
+// in one transaction. Supported commands (one per line, tokens
+// separated by whitespace, double quotes group a token that contains
+// spaces, '#' starts a comment):
+//
+//   add_config <subnet>
+//   add_pool_for_cfg <subnet|id> <low> <high>
+//   add_option <name> <data> <true|false>
+//   add_option_always <name> <data>
+//
+// A pool command refers to its subnet either by its prefix, as in an
+// add_config line earlier in the batch or a subnet already present in
+// the config (host bits may differ), or by the numeric id of an
+// existing configuration. A prefix cannot be added twice.
+
+// Outcome of a batch run.
+struct BatchResult
+{
+    bool applied = false;       // True if every command was applied.
+    std::size_t commands = 0;   // Number of commands read.
+    std::size_t error_line = 0; // 1-based line of the first error.
+    std::string error;          // Description of the first error.
+};
+
+// Parses and validates the whole command stream, then applies it to
+// the config. Commands are grouped by subnet before being applied, so
+// all edits to one subnet configuration happen together; subnet ids
+// are still assigned in the order the add_config lines appear.
+// If any line fails validation nothing is applied and the result
+// describes the first error.
+BatchResult apply_batch (KeaConfig &config, std::istream &commands);
+
+// Same as apply_batch, then renders the resulting configuration to
+// `out` once. Nothing is written if the batch was rejected.
+BatchResult run_batch (KeaConfig &config, std::istream &commands,
+                       std::ostream &out);
+
+} // namespace KeaGenerator
+
+#endif // KEA_BATCH_H
@@ -0,0 +1,154 @@
+#include "KeaBatch.h"
+#include "KeaJson.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+using namespace KeaGenerator;
+using json = nlohmann::json;
+
+class KeaBatchTest : public ::testing::Test
+{
+  protected:
+    // Runs a batch given as a string against `config`.
+    BatchResult
+    Apply (const std::string &text)
+    {
+        std::istringstream in (text);
+        return apply_batch (config, in);
+    }
+
+    KeaConfig config;
+};
+
+// Test that a well-formed batch is applied in full
+TEST_F (KeaBatchTest, AppliesAllCommands)
+{
+    BatchResult r = Apply (
+        "# new site\n"
+        "add_config 192.168.1.0/24\n"
+        "add_config 10.0.0.0/8\n"
+        "add_pool_for_cfg 192.168.1.0/24 192.168.1.10 192.168.1.20\n"
+        "\n"
+        "add_pool_for_cfg 10.0.0.0/8 10.1.0.1 10.1.0.9\n"
+        "add_pool_for_cfg 192.168.1.0/24 192.168.1.50 192.168.1.60\n"
+        "add_option routers 192.168.1.1 false\n"
+        "add_option_always domain-name-servers "
+        "\"8.8.8.8, 1.1.1.1\"\n");
+
+    ASSERT_TRUE (r.applied) << r.error;
+    EXPECT_EQ (r.commands, 7);
+
+    const Subnet4 &s4 = config.dhcp4.subnet4;
+    ASSERT_EQ (s4.cfgs.size (), 2);
+    // Ids follow the order of the add_config lines
+    EXPECT_EQ (s4.cfgs.at (1).subnet, "192.168.1.0/24");
+    EXPECT_EQ (s4.cfgs.at (2).subnet, "10.0.0.0/8");
+    EXPECT_EQ (s4.cfgs.at (1).pools.size (), 2);
+    EXPECT_EQ (s4.cfgs.at (2).pools.size (), 1);
+
+    const OptionData &od = config.dhcp4.option_data;
+    ASSERT_EQ (od.options.size (), 2);
+    auto it = od.options.find ({ "domain-name-servers", "", false });
+    ASSERT_NE (it, od.options.end ());
+    EXPECT_EQ (it->data, "8.8.8.8, 1.1.1.1");
+    EXPECT_TRUE (it->always_send);
+}
+
+// Test that pools can target configurations that already exist
+TEST_F (KeaBatchTest, TargetsExistingConfigs)
+{
+    uint64_t id = config.dhcp4.subnet4.add_config ("172.16.0.0/16");
+
+    BatchResult r = Apply ("add_pool_for_cfg 172.16.0.0/16 "
+                           "172.16.1.1 172.16.1.9\n"
+                           "add_pool_for_cfg "
+                           + std::to_string (id)
+                           + " 172.16.2.1 172.16.2.9\n");
+
+    ASSERT_TRUE (r.applied) << r.error;
+    EXPECT_EQ (config.dhcp4.subnet4.cfgs.at (id).pools.size (), 2);
+
+    // Prefixes match in any spelling, so the subnet cannot be added
+    // again with its host bits set
+    r = Apply ("add_pool_for_cfg 172.16.9.9/16 172.16.3.1 "
+               "172.16.3.9\n");
+    ASSERT_TRUE (r.applied) << r.error;
+    EXPECT_EQ (config.dhcp4.subnet4.cfgs.at (id).pools.size (), 3);
+    EXPECT_EQ (Apply ("add_config 172.16.0.1/16\n").error_line, 1);
+    EXPECT_EQ (Apply ("add_config 10.0.0.0/8\n"
+                      "add_config 10.1.0.0/8\n")
+                   .error_line,
+               2);
+}
+
+// Test that a bad line rejects the whole batch
+TEST_F (KeaBatchTest, RejectsWholeBatchOnError)
+{
+    BatchResult r = Apply ("add_config 192.168.1.0/24\n"
+                           "add_option routers 192.168.1.1 false\n"
+                           "add_pool_for_cfg 10.9.9.0/24 10.9.9.1 "
+                           "10.9.9.2\n");
+
+    EXPECT_FALSE (r.applied);
+    EXPECT_EQ (r.error_line, 3);
+    EXPECT_TRUE (config.dhcp4.subnet4.empty ());
+    EXPECT_TRUE (config.dhcp4.option_data.empty ());
+}
+
+// Test the individual validation rules
+TEST_F (KeaBatchTest, ValidationErrors)
+{
+    // Unknown verb
+    EXPECT_EQ (Apply ("remove_config 1\n").error_line, 1);
+    // Wrong arity
+    EXPECT_EQ (Apply ("add_config\n").error_line, 1);
+    // Bad boolean
+    EXPECT_EQ (Apply ("add_option a b maybe\n").error_line, 1);
+    // Unterminated quote
+    EXPECT_EQ (Apply ("add_option_always a \"b\n").error_line, 1);
+    // Duplicate subnet within the batch
+    EXPECT_EQ (Apply ("add_config 10.0.0.0/8\n"
+                      "add_config 10.0.0.0/8\n")
+                   .error_line,
+               2);
+    // Pool before its subnet is defined
+    EXPECT_EQ (Apply ("add_pool_for_cfg 10.0.0.0/8 10.0.0.1 "
+                      "10.0.0.2\n"
+                      "add_config 10.0.0.0/8\n")
+                   .error_line,
+               1);
+    // Unknown numeric id
+    EXPECT_EQ (Apply ("add_pool_for_cfg 42 10.0.0.1 10.0.0.2\n")
+                   .error_line,
+               1);
+    // Malformed subnet and pool
+    EXPECT_EQ (Apply ("add_config 10.0.0.0/33\n").error_line, 1);
+    EXPECT_EQ (Apply ("add_config 10.0.0.0/8\n"
+                      "add_pool_for_cfg 10.0.0.0/8 10.0.0.9 "
+                      "10.0.0.01\n")
+                   .error_line,
+               2);
+
+    EXPECT_TRUE (config.dhcp4.subnet4.empty ());
+}
+
+// Test that run_batch renders the result once
+TEST_F (KeaBatchTest, RunBatchRenders)
+{
+    std::istringstream in ("add_config 10.0.1.0/24\n"
+                           "add_pool_for_cfg 10.0.1.0/24 10.0.1.100 "
+                           "10.0.1.150\n");
+    std::ostringstream out;
+    BatchResult r = run_batch (config, in, out);
+    ASSERT_TRUE (r.applied) << r.error;
+
+    json rendered = json::parse (out.str ());
+    EXPECT_EQ (rendered, json (config));
+
+    // A rejected batch renders nothing
+    std::istringstream bad ("add_config\n");
+    std::ostringstream none;
+    EXPECT_FALSE (run_batch (config, bad, none).applied);
+    EXPECT_TRUE (none.str ().empty ());
+}
@@ -0,0 +1,336 @@
+#include "KeaControl.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <system_error>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace KeaGenerator
+{
+namespace
+{
+// Size of the buffer between the serializer and the socket.
+constexpr std::size_t kSendBufferSize = 64 * 1024;
+// Read granularity for responses; the response string grows as
+// needed, so large answers (e.g. subnet4-list) are not truncated.
+constexpr std::size_t kReceiveChunkSize = 64 * 1024;
+
+// Throws std::system_error for the current errno.
+[[noreturn]] void
+throw_errno (const std::string &what)
+{
+    throw std::system_error (errno, std::generic_category (), what);
+}
+
+// Owns a connected socket descriptor.
+class Socket
+{
+  public:
+    explicit Socket (const std::string &path)
+        : fd_ (::socket (AF_UNIX, SOCK_STREAM, 0))
+    {
+        if (fd_ < 0)
+        {
+            throw_errno ("socket");
+        }
+
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path.size () >= sizeof (addr.sun_path))
+        {
+            ::close (fd_);
+            throw std::system_error (
+                std::make_error_code (std::errc::filename_too_long),
+                path);
+        }
+        std::memcpy (addr.sun_path, path.c_str (), path.size () + 1);
+
+        if (::connect (fd_, reinterpret_cast<sockaddr *> (&addr),
+                       sizeof (addr))
+            < 0)
+        {
+            int saved = errno;
+            ::close (fd_);
+            errno = saved;
+            throw_errno ("connect " + path);
+        }
+    }
+
+    ~Socket () { ::close (fd_); }
+
+    Socket (const Socket &) = delete;
+    Socket &operator= (const Socket &) = delete;
+
+    int
+    fd () const
+    {
+        return fd_;
+    }
+
+  private:
+    int fd_;
+};
+
+// Output stream buffer writing straight to a socket. Any failed
+// write is remembered in `error` and turns the stream bad.
+class SocketBuf : public std::streambuf
+{
+  public:
+    explicit SocketBuf (int fd) : fd_ (fd)
+    {
+        setp (buffer_, buffer_ + sizeof (buffer_));
+    }
+
+    // errno of the first failed write, 0 if none.
+    int error = 0;
+
+  protected:
+    int_type
+    overflow (int_type ch) override
+    {
+        if (!drain ())
+        {
+            return traits_type::eof ();
+        }
+        if (!traits_type::eq_int_type (ch, traits_type::eof ()))
+        {
+            *pptr () = traits_type::to_char_type (ch);
+            pbump (1);
+        }
+        return traits_type::not_eof (ch);
+    }
+
+    int
+    sync () override
+    {
+        return drain () ? 0 : -1;
+    }
+
+  private:
+    // Sends the buffered bytes, retrying on partial writes.
+    bool
+    drain ()
+    {
+        const char *p = pbase ();
+        while (p < pptr ())
+        {
+            ssize_t n = ::send (fd_, p, pptr () - p, MSG_NOSIGNAL);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                error = errno;
+                return false;
+            }
+            p += n;
+        }
+        setp (buffer_, buffer_ + sizeof (buffer_));
+        return true;
+    }
+
+    int fd_;
+    char buffer_[kSendBufferSize];
+};
+
+// Reads the whole response until the server closes the connection.
+std::string
+receive_all (int fd)
+{
+    std::string response;
+    std::size_t used = 0;
+    for (;;)
+    {
+        if (response.size () - used < kReceiveChunkSize)
+        {
+            response.resize (used + kReceiveChunkSize);
+        }
+        ssize_t n = ::recv (fd, &response[used],
+                            response.size () - used, 0);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw_errno ("recv");
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        used += static_cast<std::size_t> (n);
+    }
+    response.resize (used);
+    return response;
+}
+
+// Converts Kea's answer into a ControlResponse. The Control Agent
+// wraps answers in an array (one per service); the first is used.
+ControlResponse
+parse_response (const std::string &text)
+{
+    nlohmann::json answer
+        = nlohmann::json::parse (text, nullptr, false);
+    if (answer.is_discarded ())
+    {
+        throw std::runtime_error (
+            "malformed control channel response");
+    }
+    if (answer.is_array ())
+    {
+        if (answer.empty ())
+        {
+            throw std::runtime_error (
+                "empty control channel response");
+        }
+        answer = std::move (answer.front ());
+    }
+    if (!answer.is_object () || !answer.contains ("result")
+        || !answer["result"].is_number_integer ())
+    {
+        throw std::runtime_error (
+            "control channel response without result");
+    }
+
+    ControlResponse response;
+    response.result = answer["result"].get<int> ();
+    if (answer.contains ("text") && answer["text"].is_string ())
+    {
+        response.text = answer["text"].get<std::string> ();
+    }
+    if (answer.contains ("arguments"))
+    {
+        response.arguments = std::move (answer["arguments"]);
+    }
+    return response;
+}
+
+// Writes `{ "id": <id> }`.
+ControlClient::ArgumentWriter
+id_argument (uint64_t id)
+{
+    return [id] (JsonWriter &w) {
+        w.begin_object ();
+        w.key ("id");
+        w.number (id);
+        w.end_object ();
+    };
+}
+
+// Writes `{ "subnet4": [ <cfg> ] }`.
+ControlClient::ArgumentWriter
+subnet_argument (const Subnet4::Cfg &cfg)
+{
+    return [&cfg] (JsonWriter &w) {
+        w.begin_object ();
+        w.key ("subnet4");
+        w.begin_array ();
+        write_json (w, cfg);
+        w.end_array ();
+        w.end_object ();
+    };
+}
+} // namespace
+
+ControlResponse
+ControlClient::command (const std::string &name,
+                        const ArgumentWriter &arguments)
+{
+    Socket socket (socket_path_);
+
+    SocketBuf buf (socket.fd ());
+    std::ostream out (&buf);
+    JsonWriter w (out);
+    w.begin_object ();
+    w.key ("command");
+    w.string (name);
+    if (arguments)
+    {
+        w.key ("arguments");
+        arguments (w);
+    }
+    w.end_object ();
+    out.flush ();
+    if (!out)
+    {
+        errno = buf.error != 0 ? buf.error : EIO;
+        throw_errno ("send " + name);
+    }
+
+    // Signal the end of the request; Kea then answers and closes.
+    if (::shutdown (socket.fd (), SHUT_WR) < 0)
+    {
+        throw_errno ("shutdown");
+    }
+    return parse_response (receive_all (socket.fd ()));
+}
+
+ControlResponse
+ControlClient::config_test (const KeaConfig &config)
+{
+    return command ("config-test", [&config] (JsonWriter &w) {
+        write_json (w, config);
+    });
+}
+
+ControlResponse
+ControlClient::config_set (const KeaConfig &config)
+{
+    return command ("config-set", [&config] (JsonWriter &w) {
+        write_json (w, config);
+    });
+}
+
+ControlResponse
+ControlClient::config_write (const std::string &filename)
+{
+    if (filename.empty ())
+    {
+        return command ("config-write");
+    }
+    return command ("config-write", [&filename] (JsonWriter &w) {
+        w.begin_object ();
+        w.key ("filename");
+        w.string (filename);
+        w.end_object ();
+    });
+}
+
+ControlResponse
+ControlClient::subnet4_list ()
+{
+    return command ("subnet4-list");
+}
+
+ControlResponse
+ControlClient::subnet4_get (uint64_t id)
+{
+    return command ("subnet4-get", id_argument (id));
+}
+
+ControlResponse
+ControlClient::subnet4_add (const Subnet4::Cfg &cfg)
+{
+    return command ("subnet4-add", subnet_argument (cfg));
+}
+
+ControlResponse
+ControlClient::subnet4_update (const Subnet4::Cfg &cfg)
+{
+    return command ("subnet4-update", subnet_argument (cfg));
+}
+
+ControlResponse
+ControlClient::subnet4_del (uint64_t id)
+{
+    return command ("subnet4-del", id_argument (id));
+}
+} // namespace KeaGenerator
@@ -0,0 +1,86 @@
+// File: KeaControl.h
+#ifndef KEA_CONTROL_H
+#define KEA_CONTROL_H
+
+#include "KeaGenerator.h"
+#include "KeaStream.h"
+
+#include <cstdint>
+#include <functional>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <utility>
+
+namespace KeaGenerator
+{
+// --- ControlResponse ---
+// Answer of the Kea control channel to a single command.
+struct ControlResponse
+{
+    // Kea result code: 0 success, 1 error, 2 unsupported, 3 empty.
+    int result = 1;
+    // Optional human-readable status text.
+    std::string text;
+    // Optional "arguments" member (null when absent).
+    nlohmann::json arguments;
+
+    // Returns true if Kea reported success.
+    bool
+    ok () const
+    {
+        return result == 0;
+    }
+};
+
+// --- ControlClient ---
+// Client for Kea's Unix domain control socket. Each command opens a
+// new connection, as Kea answers one command per connection.
+// Request bodies, including whole configurations, are serialized
+// directly into the socket through a small fixed buffer.
+//
+// Socket errors are reported by throwing std::system_error; a
+// response that is not valid JSON throws std::runtime_error.
+class ControlClient
+{
+  public:
+    // Writes the "arguments" value of a command.
+    using ArgumentWriter = std::function<void (JsonWriter &)>;
+
+    explicit ControlClient (std::string socket_path)
+        : socket_path_ (std::move (socket_path))
+    {
+    }
+
+    // Asks Kea to check the configuration without applying it.
+    ControlResponse config_test (const KeaConfig &config);
+    // Replaces the running configuration.
+    ControlResponse config_set (const KeaConfig &config);
+    // Writes the running configuration to disk. An empty filename
+    // lets Kea use the file it was started with.
+    ControlResponse config_write (const std::string &filename = "");
+
+    // subnet_cmds hook library commands.
+    ControlResponse subnet4_list ();
+    ControlResponse subnet4_get (uint64_t id);
+    ControlResponse subnet4_add (const Subnet4::Cfg &cfg);
+    ControlResponse subnet4_update (const Subnet4::Cfg &cfg);
+    ControlResponse subnet4_del (uint64_t id);
+
+    // Sends an arbitrary command. `arguments` may be empty for
+    // commands without arguments.
+    ControlResponse command (const std::string &name,
+                             const ArgumentWriter &arguments = {});
+
+    const std::string &
+    socket_path () const
+    {
+        return socket_path_;
+    }
+
+  private:
+    std::string socket_path_;
+};
+
+} // namespace KeaGenerator
+
+#endif // KEA_CONTROL_H
@@ -0,0 +1,263 @@
+#include "KeaControl.h"
+#include "KeaJson.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace KeaGenerator;
+using json = nlohmann::json;
+
+// --- MockKeaServer ---
+// Minimal stand-in for Kea's control socket. Each connection is read
+// until the client half-closes it, parsed as a command, recorded,
+// and answered with whatever the handler returns.
+class MockKeaServer
+{
+  public:
+    using Handler = std::function<std::string (const json &)>;
+
+    MockKeaServer ()
+        : path_ ("/tmp/kea-mock-" + std::to_string (::getpid ())
+                 + "-" + std::to_string (counter_++) + ".sock")
+    {
+        ::unlink (path_.c_str ());
+        listen_fd_ = ::socket (AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy (addr.sun_path, path_.c_str (),
+                      sizeof (addr.sun_path) - 1);
+        if (::bind (listen_fd_, reinterpret_cast<sockaddr *> (&addr),
+                    sizeof (addr))
+                < 0
+            || ::listen (listen_fd_, 8) < 0)
+        {
+            throw std::system_error (errno, std::generic_category (),
+                                     "mock server");
+        }
+        thread_ = std::thread ([this] { run (); });
+    }
+
+    ~MockKeaServer ()
+    {
+        stop_ = true;
+        thread_.join ();
+        ::close (listen_fd_);
+        ::unlink (path_.c_str ());
+    }
+
+    const std::string &
+    path () const
+    {
+        return path_;
+    }
+
+    void
+    set_handler (Handler handler)
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        handler_ = std::move (handler);
+    }
+
+    // Commands received so far.
+    std::vector<json>
+    received ()
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        return received_;
+    }
+
+    // Size in bytes of the largest request received.
+    std::size_t
+    largest_request ()
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        return largest_;
+    }
+
+  private:
+    void
+    run ()
+    {
+        while (!stop_)
+        {
+            pollfd pfd{ listen_fd_, POLLIN, 0 };
+            if (::poll (&pfd, 1, 20) <= 0)
+            {
+                continue;
+            }
+            int fd = ::accept (listen_fd_, nullptr, nullptr);
+            if (fd < 0)
+            {
+                continue;
+            }
+            serve (fd);
+            ::close (fd);
+        }
+    }
+
+    void
+    serve (int fd)
+    {
+        std::string request;
+        char buf[65536];
+        ssize_t n;
+        while ((n = ::recv (fd, buf, sizeof (buf), 0)) > 0)
+        {
+            request.append (buf, n);
+        }
+
+        json command = json::parse (request, nullptr, false);
+        std::string answer;
+        {
+            std::lock_guard<std::mutex> lock (mutex_);
+            received_.push_back (command);
+            largest_ = std::max (largest_, request.size ());
+            answer = handler_ ? handler_ (command)
+                              : R"({ "result": 0, "text": "ok" })";
+        }
+
+        const char *p = answer.data ();
+        std::size_t left = answer.size ();
+        while (left > 0
+               && (n = ::send (fd, p, left, MSG_NOSIGNAL)) > 0)
+        {
+            p += n;
+            left -= static_cast<std::size_t> (n);
+        }
+    }
+
+    static inline int counter_ = 0;
+
+    std::string path_;
+    int listen_fd_ = -1;
+    std::atomic<bool> stop_{ false };
+    std::thread thread_;
+    std::mutex mutex_;
+    Handler handler_;
+    std::vector<json> received_;
+    std::size_t largest_ = 0;
+};
+
+class KeaControlTest : public ::testing::Test
+{
+  protected:
+    MockKeaServer server;
+};
+
+// Test that config-set carries the full configuration
+TEST_F (KeaControlTest, ConfigSetSendsConfig)
+{
+    KeaConfig config;
+    uint64_t id = config.dhcp4.subnet4.add_config ("10.0.0.0/24");
+    config.dhcp4.subnet4.add_pool_for_cfg (id, "10.0.0.10",
+                                           "10.0.0.20");
+
+    ControlClient client (server.path ());
+    ControlResponse r = client.config_set (config);
+    EXPECT_TRUE (r.ok ());
+    EXPECT_EQ (r.text, "ok");
+
+    auto received = server.received ();
+    ASSERT_EQ (received.size (), 1);
+    EXPECT_EQ (received[0]["command"], "config-set");
+    EXPECT_EQ (received[0]["arguments"], json (config));
+}
+
+// Test the argument layout of the other commands
+TEST_F (KeaControlTest, CommandArguments)
+{
+    Subnet4 s4;
+    uint64_t id = s4.add_config ("192.168.5.0/24");
+
+    ControlClient client (server.path ());
+    client.config_test (KeaConfig ());
+    client.config_write ("/etc/kea/kea-dhcp4.conf");
+    client.config_write ();
+    client.subnet4_list ();
+    client.subnet4_get (7);
+    client.subnet4_add (s4.cfgs.at (id));
+    client.subnet4_del (7);
+
+    auto received = server.received ();
+    ASSERT_EQ (received.size (), 7);
+    EXPECT_EQ (received[0]["command"], "config-test");
+    EXPECT_EQ (received[1]["arguments"]["filename"],
+               "/etc/kea/kea-dhcp4.conf");
+    EXPECT_FALSE (received[2].contains ("arguments"));
+    EXPECT_EQ (received[3]["command"], "subnet4-list");
+    EXPECT_EQ (received[4]["arguments"]["id"], 7);
+    EXPECT_EQ (received[5]["arguments"]["subnet4"][0]["subnet"],
+               "192.168.5.0/24");
+    EXPECT_EQ (received[6]["command"], "subnet4-del");
+}
+
+// Test error answers and Control Agent style array responses
+TEST_F (KeaControlTest, ResponseParsing)
+{
+    ControlClient client (server.path ());
+
+    server.set_handler ([] (const json &) {
+        return std::string (
+            R"([ { "result": 1, "text": "bad config" } ])");
+    });
+    ControlResponse r = client.config_test (KeaConfig ());
+    EXPECT_FALSE (r.ok ());
+    EXPECT_EQ (r.text, "bad config");
+
+    server.set_handler (
+        [] (const json &) { return std::string ("not json"); });
+    EXPECT_THROW (client.subnet4_list (), std::runtime_error);
+}
+
+// Test that large requests and responses pass through intact
+TEST_F (KeaControlTest, LargeTransfers)
+{
+    KeaConfig config;
+    for (int i = 0; i < 20000; ++i)
+    {
+        uint64_t id = config.dhcp4.subnet4.add_config (
+            "10." + std::to_string (i / 256) + "."
+            + std::to_string (i % 256) + ".0/24");
+        config.dhcp4.subnet4.add_pool_for_cfg (id, "10.0.0.1",
+                                               "10.0.0.254");
+    }
+
+    json subnets = json::array ();
+    for (int i = 0; i < 20000; ++i)
+    {
+        subnets.push_back ({ { "id", i }, { "subnet", "x" } });
+    }
+    std::string answer
+        = json{ { "result", 0 },
+                { "arguments", { { "subnets", subnets } } } }
+              .dump ();
+    server.set_handler ([&answer] (const json &) { return answer; });
+
+    ControlClient client (server.path ());
+    ControlResponse r = client.config_set (config);
+    EXPECT_TRUE (r.ok ());
+    EXPECT_EQ (r.arguments["subnets"].size (), 20000);
+    EXPECT_GT (server.largest_request (), 1000000);
+    json sent = server.received ()[0]["arguments"];
+    EXPECT_EQ (sent["Dhcp4"]["subnet4"].size (), 20000);
+}
+
+// Test that a missing socket is reported as a system error
+TEST (KeaControlErrorTest, ConnectFailure)
+{
+    ControlClient client ("/tmp/kea-mock-does-not-exist.sock");
+    EXPECT_THROW (client.subnet4_list (), std::system_error);
+}
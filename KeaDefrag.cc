@@ -0,0 +1,263 @@
+#include "KeaDefrag.h"
+#include "KeaParallel.h"
+#include "KeaStream.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace KeaGenerator
+{
+namespace
+{
+// Parses the pools of `cfg` in their stored order.
+bool
+parse_pools (const Subnet4::Cfg &cfg, AddressRanges &pools)
+{
+    pools.clear ();
+    pools.reserve (cfg.pools.size ());
+    for (const Subnet4::Pool &p : cfg.pools)
+    {
+        uint32_t low, high;
+        if (!parse_pool_range (p.range, low, high))
+        {
+            return false;
+        }
+        pools.emplace_back (low, high);
+    }
+    return true;
+}
+
+// Sorted reserved addresses of `cfg`; unparsable ones are skipped.
+std::vector<uint32_t>
+reserved_addresses (const Subnet4::Cfg &cfg)
+{
+    std::vector<uint32_t> out;
+    for (const Subnet4::Reservation &r : cfg.reservations)
+    {
+        uint32_t a;
+        if (parse_ipv4 (r.ip_address, a))
+        {
+            out.push_back (a);
+        }
+    }
+    std::sort (out.begin (), out.end ());
+    out.erase (std::unique (out.begin (), out.end ()), out.end ());
+    return out;
+}
+
+// Metrics and minimal ranges from already parsed pools.
+void
+analyze (const Subnet4::Cfg &cfg, AddressRanges pools,
+         PoolFragmentation &m, AddressRanges &minimal)
+{
+    m.id = cfg.id;
+    m.pools = pools.size ();
+
+    std::sort (pools.begin (), pools.end ());
+    uint64_t reach = 0; // One past the highest address seen so far.
+    for (std::size_t i = 0; i < pools.size (); ++i)
+    {
+        if (i > 0 && pools[i].first < reach)
+        {
+            ++m.overlapping;
+        }
+        reach = std::max (reach, uint64_t (pools[i].second) + 1);
+    }
+
+    AddressRanges merged = pools;
+    normalize_ranges (merged);
+    m.runs = merged.size ();
+    m.addresses = count_addresses (merged);
+    for (const AddressRange &r : merged)
+    {
+        uint64_t size = uint64_t (r.second) - r.first + 1;
+        m.largest_run = std::max (m.largest_run, size);
+    }
+    if (!merged.empty ())
+    {
+        m.span = uint64_t (merged.back ().second)
+                 - merged.front ().first + 1;
+        m.fragmentation
+            = 1.0 - double (m.largest_run) / double (m.addresses);
+    }
+
+    // Cut the reserved addresses out of the merged runs.
+    std::vector<uint32_t> reserved = reserved_addresses (cfg);
+    minimal.clear ();
+    auto res = reserved.begin ();
+    for (const AddressRange &r : merged)
+    {
+        uint64_t next = r.first;
+        res = std::lower_bound (res, reserved.end (), r.first);
+        for (; res != reserved.end () && *res <= r.second; ++res)
+        {
+            ++m.reserved;
+            if (*res > next)
+            {
+                minimal.emplace_back (static_cast<uint32_t> (next),
+                                      *res - 1);
+            }
+            next = uint64_t (*res) + 1;
+        }
+        if (next <= r.second)
+        {
+            minimal.emplace_back (static_cast<uint32_t> (next),
+                                  r.second);
+        }
+    }
+}
+
+// Fills `change` with the difference between the stored pools and
+// `minimal`. Returns false if they are the same.
+bool
+diff_pools (const Subnet4::Cfg &cfg, const AddressRanges &minimal,
+            PoolChange &change)
+{
+    std::vector<std::string> wanted;
+    wanted.reserve (minimal.size ());
+    for (const AddressRange &r : minimal)
+    {
+        wanted.push_back (format_pool_range (r.first, r.second));
+    }
+    std::sort (wanted.begin (), wanted.end ());
+
+    // Both sides are sorted by range string, like the pool set.
+    auto w = wanted.begin ();
+    for (const Subnet4::Pool &p : cfg.pools)
+    {
+        while (w != wanted.end () && *w < p.range)
+        {
+            change.added.push_back (*w++);
+        }
+        if (w != wanted.end () && *w == p.range)
+        {
+            ++w;
+            continue;
+        }
+        change.removed.push_back (p.range);
+    }
+    change.added.insert (change.added.end (), w, wanted.end ());
+
+    if (change.added.empty () && change.removed.empty ())
+    {
+        return false;
+    }
+    change.id = cfg.id;
+    change.subnet = cfg.subnet;
+    return true;
+}
+} // namespace
+
+PoolFragmentation
+analyze_pools (const Subnet4::Cfg &cfg)
+{
+    PoolFragmentation m;
+    AddressRanges pools, minimal;
+    if (!parse_pools (cfg, pools))
+    {
+        m.id = cfg.id;
+        m.parsed = false;
+        m.pools = cfg.pools.size ();
+        return m;
+    }
+    analyze (cfg, std::move (pools), m, minimal);
+    return m;
+}
+
+bool
+defragmented_pools (const Subnet4::Cfg &cfg, AddressRanges &out)
+{
+    AddressRanges pools;
+    if (!parse_pools (cfg, pools))
+    {
+        return false;
+    }
+    PoolFragmentation m;
+    analyze (cfg, std::move (pools), m, out);
+    return true;
+}
+
+DefragPlan
+plan_defrag (const Subnet4 &s, unsigned threads)
+{
+    std::vector<const Subnet4::Cfg *> cfgs = sorted_cfgs (s);
+
+    DefragPlan plan;
+    plan.metrics.resize (cfgs.size ());
+    // Changes are collected per slice and concatenated in order.
+    unsigned workers = worker_count (threads);
+    std::vector<std::vector<PoolChange> > changes (workers);
+
+    auto work = [&] (unsigned slice, std::size_t begin,
+                     std::size_t end) {
+        AddressRanges pools, minimal;
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            const Subnet4::Cfg &cfg = *cfgs[i];
+            PoolFragmentation &m = plan.metrics[i];
+            if (!parse_pools (cfg, pools))
+            {
+                m.id = cfg.id;
+                m.parsed = false;
+                m.pools = cfg.pools.size ();
+                continue;
+            }
+            analyze (cfg, pools, m, minimal);
+            PoolChange change;
+            if (diff_pools (cfg, minimal, change))
+            {
+                changes[slice].push_back (std::move (change));
+            }
+        }
+    };
+    parallel_slices (cfgs.size (), workers, work);
+
+    for (auto &slice : changes)
+    {
+        std::move (slice.begin (), slice.end (),
+                   std::back_inserter (plan.changes));
+    }
+    return plan;
+}
+
+void
+write_defrag_diff (std::ostream &out, const DefragPlan &plan)
+{
+    for (const PoolChange &c : plan.changes)
+    {
+        out << "@@ subnet " << c.id << ' ' << c.subnet << " @@\n";
+        for (const std::string &r : c.removed)
+        {
+            out << '-' << r << '\n';
+        }
+        for (const std::string &r : c.added)
+        {
+            out << '+' << r << '\n';
+        }
+    }
+}
+
+std::size_t
+apply_defrag (Subnet4 &s, const DefragPlan &plan)
+{
+    std::size_t applied = 0;
+    for (const PoolChange &c : plan.changes)
+    {
+        auto it = s.cfgs.find (c.id);
+        if (it == s.cfgs.end ())
+        {
+            continue;
+        }
+        for (const std::string &r : c.removed)
+        {
+            it->second.pools.erase ({ r });
+        }
+        for (const std::string &r : c.added)
+        {
+            it->second.pools.insert ({ r });
+        }
+        ++applied;
+    }
+    return applied;
+}
+} // namespace KeaGenerator
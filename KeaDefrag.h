@@ -0,0 +1,79 @@
+// File: KeaDefrag.h
+#ifndef KEA_DEFRAG_H
+#define KEA_DEFRAG_H
+
+#include "KeaAddress.h"
+#include "KeaGenerator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace KeaGenerator
+{
+// --- Pool fragmentation ---
+// Metrics over the pools of one Subnet4::Cfg.
+struct PoolFragmentation
+{
+    uint64_t id = 0;
+    bool parsed = true;          // False if a pool is malformed.
+    std::size_t pools = 0;       // Pool entries.
+    std::size_t runs = 0;        // Contiguous ranges they cover.
+    std::size_t overlapping = 0; // Pools overlapping another pool.
+    std::size_t reserved = 0;    // Reservations inside the pools.
+    uint64_t addresses = 0;      // Distinct pooled addresses.
+    uint64_t largest_run = 0;    // Largest contiguous range.
+    uint64_t span = 0;           // Lowest to highest pooled address.
+    // 1 - largest_run / addresses: 0 for one contiguous range,
+    // approaching 1 when the addresses are spread over many ranges.
+    double fragmentation = 0;
+};
+
+// The pool edit proposed for one subnet.
+struct PoolChange
+{
+    uint64_t id = 0;
+    std::string subnet;
+    std::vector<std::string> removed; // Pool ranges to delete.
+    std::vector<std::string> added;   // Pool ranges to add.
+};
+
+struct DefragPlan
+{
+    // Every subnet, in ascending id order.
+    std::vector<PoolFragmentation> metrics;
+    // Subnets whose pools change, in ascending id order.
+    std::vector<PoolChange> changes;
+};
+
+// Computes the metrics of one subnet's pools.
+PoolFragmentation analyze_pools (const Subnet4::Cfg &cfg);
+
+// Computes the smallest set of ranges covering the pooled addresses
+// of `cfg` minus its reserved addresses: the maximal contiguous runs
+// of that set. Returns false if a pool cannot be parsed.
+bool defragmented_pools (const Subnet4::Cfg &cfg, AddressRanges &out);
+
+// Analyzes every subnet of `s` and proposes the defragmented pools,
+// splitting the subnets across `threads` workers (0 uses one per
+// hardware thread). Subnets with unparsable pools get metrics with
+// parsed == false and no change.
+DefragPlan plan_defrag (const Subnet4 &s, unsigned threads = 0);
+
+// Writes the changes as a diff, one hunk per subnet:
+//
+//   @@ subnet 7 10.0.0.0/24 @@
+//   -10.0.0.10 - 10.0.0.19
+//   -10.0.0.20 - 10.0.0.29
+//   +10.0.0.10 - 10.0.0.29
+void write_defrag_diff (std::ostream &out, const DefragPlan &plan);
+
+// Applies the changes of `plan` to `s`. Returns the number of
+// subnets changed; changes for ids not in `s` are skipped.
+std::size_t apply_defrag (Subnet4 &s, const DefragPlan &plan);
+
+} // namespace KeaGenerator
+
+#endif // KEA_DEFRAG_H
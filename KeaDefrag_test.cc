@@ -0,0 +1,106 @@
+#include "KeaDefrag.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+using namespace KeaGenerator;
+
+class KeaDefragTest : public ::testing::Test
+{
+  protected:
+    void
+    SetUp () override
+    {
+        scattered = s.add_config ("10.0.0.0/24");
+        s.add_pool_for_cfg (scattered, "10.0.0.10", "10.0.0.19");
+        s.add_pool_for_cfg (scattered, "10.0.0.20", "10.0.0.29");
+        s.add_pool_for_cfg (scattered, "10.0.0.25", "10.0.0.40");
+        s.add_pool_for_cfg (scattered, "10.0.0.100", "10.0.0.109");
+        s.add_reservation_for_cfg (scattered, "1a:1b:1c:1d:1e:1f",
+                                   "10.0.0.15");
+        s.add_reservation_for_cfg (scattered, "2a:2b:2c:2d:2e:2f",
+                                   "10.0.0.200");
+
+        tidy = s.add_config ("10.1.0.0/24");
+        s.add_pool_for_cfg (tidy, "10.1.0.10", "10.1.0.200");
+
+        broken = s.add_config ("10.2.0.0/24");
+        s.cfgs[broken].pools.insert ({ "10.2.0.10-10.2.0.20" });
+    }
+
+    Subnet4 s;
+    uint64_t scattered = 0;
+    uint64_t tidy = 0;
+    uint64_t broken = 0;
+};
+
+// Test the metrics of a fragmented subnet
+TEST_F (KeaDefragTest, Metrics)
+{
+    PoolFragmentation m = analyze_pools (s.cfgs[scattered]);
+    EXPECT_TRUE (m.parsed);
+    EXPECT_EQ (m.pools, 4u);
+    EXPECT_EQ (m.runs, 2u);
+    EXPECT_EQ (m.overlapping, 1u);
+    EXPECT_EQ (m.reserved, 1u);
+    EXPECT_EQ (m.addresses, 41u);
+    EXPECT_EQ (m.largest_run, 31u);
+    EXPECT_EQ (m.span, 100u);
+    EXPECT_DOUBLE_EQ (m.fragmentation, 1.0 - 31.0 / 41.0);
+
+    PoolFragmentation t = analyze_pools (s.cfgs[tidy]);
+    EXPECT_EQ (t.runs, 1u);
+    EXPECT_DOUBLE_EQ (t.fragmentation, 0.0);
+    EXPECT_FALSE (analyze_pools (s.cfgs[broken]).parsed);
+}
+
+// Test the plan, its diff and applying it
+TEST_F (KeaDefragTest, PlanDiffAndApply)
+{
+    DefragPlan plan = plan_defrag (s, 2);
+    ASSERT_EQ (plan.metrics.size (), 3u);
+    EXPECT_EQ (plan.metrics[0].id, scattered);
+    EXPECT_FALSE (plan.metrics[2].parsed);
+    ASSERT_EQ (plan.changes.size (), 1u);
+
+    std::ostringstream diff;
+    write_defrag_diff (diff, plan);
+    EXPECT_EQ (diff.str (), "@@ subnet 1 10.0.0.0/24 @@\n"
+                            "-10.0.0.10 - 10.0.0.19\n"
+                            "-10.0.0.20 - 10.0.0.29\n"
+                            "-10.0.0.25 - 10.0.0.40\n"
+                            "+10.0.0.10 - 10.0.0.14\n"
+                            "+10.0.0.16 - 10.0.0.40\n");
+
+    EXPECT_EQ (apply_defrag (s, plan), 1u);
+    EXPECT_EQ (s.cfgs[scattered].pools.size (), 3u);
+    EXPECT_TRUE (plan_defrag (s).changes.empty ());
+}
+
+// Test that the plan does not depend on the number of workers
+TEST_F (KeaDefragTest, ParallelMatchesSerial)
+{
+    Subnet4 many;
+    for (int n = 0; n < 20000; ++n)
+    {
+        std::string net = "10." + std::to_string (n / 256) + "."
+                          + std::to_string (n % 256) + ".";
+        uint64_t id = many.add_config (net + "0/24");
+        for (int p = 0; p < 10; ++p)
+        {
+            // Every other subnet has adjacent pools to merge
+            int low = 10 + p * (n % 2 ? 20 : 21);
+            many.add_pool_for_cfg (id, net + std::to_string (low),
+                                   net + std::to_string (low + 19));
+        }
+    }
+
+    DefragPlan serial = plan_defrag (many, 1);
+    DefragPlan parallel = plan_defrag (many, 8);
+    EXPECT_EQ (serial.changes.size (), 10000u);
+    ASSERT_EQ (parallel.changes.size (), serial.changes.size ());
+    std::ostringstream a, b;
+    write_defrag_diff (a, serial);
+    write_defrag_diff (b, parallel);
+    EXPECT_EQ (a.str (), b.str ());
+}
@@ -0,0 +1,1156 @@
+#include "KeaDhcpd.h"
+#include "KeaAddress.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace KeaGenerator
+{
+namespace
+{
+using Option = OptionData::Option;
+
+constexpr std::size_t kNoSubnet = ~std::size_t (0);
+
+enum class Tok
+{
+    word, // Name, number, address or anything else unquoted.
+    string,
+    open,
+    close,
+    semicolon,
+    comma,
+    equals,
+    end,
+    bad, // Lexical error; text holds the message.
+};
+
+struct Token
+{
+    Tok kind;
+    std::string_view text; // Without the quotes for strings.
+    std::size_t line;
+    bool escaped; // A string holding backslash escapes.
+};
+
+// Splits dhcpd.conf text into tokens that point into the text.
+// Comments run from '#' to the end of the line.
+class Lexer
+{
+  public:
+    explicit Lexer (std::string_view text) : text_ (text) {}
+
+    Token
+    next ()
+    {
+        for (;;)
+        {
+            while (pos_ < text_.size ()
+                   && (text_[pos_] == ' ' || text_[pos_] == '\t'
+                       || text_[pos_] == '\r' || text_[pos_] == '\n'))
+            {
+                line_ += text_[pos_++] == '\n';
+            }
+            if (pos_ == text_.size () || text_[pos_] != '#')
+            {
+                break;
+            }
+            std::size_t eol = text_.find ('\n', pos_);
+            pos_ = eol == std::string_view::npos ? text_.size ()
+                                                 : eol;
+        }
+        if (pos_ == text_.size ())
+        {
+            return { Tok::end, {}, line_, false };
+        }
+
+        std::size_t begin = pos_;
+        switch (text_[pos_])
+        {
+        case '{':
+            return single (Tok::open);
+        case '}':
+            return single (Tok::close);
+        case ';':
+            return single (Tok::semicolon);
+        case ',':
+            return single (Tok::comma);
+        case '=':
+            return single (Tok::equals);
+        case '"':
+            return string ();
+        default:
+            while (pos_ < text_.size () && !delimiter (text_[pos_]))
+            {
+                ++pos_;
+            }
+            return { Tok::word, text_.substr (begin, pos_ - begin),
+                     line_, false };
+        }
+    }
+
+  private:
+    static bool
+    delimiter (char c)
+    {
+        switch (c)
+        {
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+        case '{':
+        case '}':
+        case ';':
+        case ',':
+        case '=':
+        case '"':
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    Token
+    single (Tok kind)
+    {
+        return { kind, text_.substr (pos_++, 1), line_, false };
+    }
+
+    Token
+    string ()
+    {
+        std::size_t line = line_;
+        std::size_t begin = ++pos_;
+        bool escaped = false;
+        while (pos_ < text_.size () && text_[pos_] != '"')
+        {
+            if (text_[pos_] == '\\')
+            {
+                escaped = true;
+                ++pos_;
+            }
+            else if (text_[pos_] == '\n')
+            {
+                ++line_;
+            }
+            ++pos_;
+        }
+        if (pos_ >= text_.size ())
+        {
+            return { Tok::bad, "unterminated string", line, false };
+        }
+        return { Tok::string, text_.substr (begin, pos_++ - begin),
+                 line, escaped };
+    }
+
+    std::string_view text_;
+    std::size_t pos_ = 0;
+    std::size_t line_ = 1;
+};
+
+// Decodes the escapes dhcpd accepts in strings: \t, \r, \n, \b,
+// \xHH, octal \NNN, and a backslash before any other character.
+std::string
+unescape (std::string_view s)
+{
+    std::string out;
+    out.reserve (s.size ());
+    for (std::size_t i = 0; i < s.size (); ++i)
+    {
+        if (s[i] != '\\' || i + 1 == s.size ())
+        {
+            out += s[i];
+            continue;
+        }
+        char c = s[++i];
+        unsigned value = 0;
+        int digits = 0;
+        switch (c)
+        {
+        case 't':
+            out += '\t';
+            break;
+        case 'r':
+            out += '\r';
+            break;
+        case 'n':
+            out += '\n';
+            break;
+        case 'b':
+            out += '\b';
+            break;
+        case 'x':
+            while (digits < 2 && i + 1 < s.size ()
+                   && std::isxdigit (
+                       static_cast<unsigned char> (s[i + 1])))
+            {
+                char h = s[++i];
+                value = value * 16
+                        + unsigned (h <= '9' ? h - '0'
+                                             : (h | 0x20) - 'a' + 10);
+                ++digits;
+            }
+            out += digits > 0 ? char (value) : 'x';
+            break;
+        default:
+            if (c < '0' || c > '7')
+            {
+                out += c;
+                break;
+            }
+            --i;
+            while (digits < 3 && i + 1 < s.size () && s[i + 1] >= '0'
+                   && s[i + 1] <= '7')
+            {
+                value = value * 8 + unsigned (s[++i] - '0');
+                ++digits;
+            }
+            out += char (value);
+            break;
+        }
+    }
+    return out;
+}
+
+// Normalizes a hardware ethernet address to the lowercase,
+// two-digit octets Kea uses ("1:a:ff" becomes "01:0a:ff"). Returns
+// false if it is not 1 to 16 colon-separated octets.
+bool
+normalize_hw_address (std::string_view text, std::string &out)
+{
+    out.clear ();
+    std::size_t octets = 0;
+    std::size_t pos = 0;
+    for (;;)
+    {
+        std::size_t colon = text.find (':', pos);
+        std::string_view octet
+            = text.substr (pos, colon == std::string_view::npos
+                                    ? colon
+                                    : colon - pos);
+        if (octet.empty () || octet.size () > 2 || ++octets > 16)
+        {
+            return false;
+        }
+        for (char c : octet)
+        {
+            if (!std::isxdigit (static_cast<unsigned char> (c)))
+            {
+                return false;
+            }
+        }
+        if (!out.empty ())
+        {
+            out += ':';
+        }
+        if (octet.size () == 1)
+        {
+            out += '0';
+        }
+        for (char c : octet)
+        {
+            out += char (
+                std::tolower (static_cast<unsigned char> (c)));
+        }
+        if (colon == std::string_view::npos)
+        {
+            return true;
+        }
+        pos = colon + 1;
+    }
+}
+
+enum class Scope
+{
+    global,
+    shared_network,
+    subnet,
+    pool,
+    group,
+};
+
+const char *
+scope_name (Scope scope)
+{
+    switch (scope)
+    {
+    case Scope::shared_network:
+        return "shared-network";
+    case Scope::subnet:
+        return "subnet";
+    case Scope::pool:
+        return "pool";
+    case Scope::group:
+        return "group";
+    default:
+        return "global scope";
+    }
+}
+
+struct StagedSubnet
+{
+    std::size_t line;
+    Ipv4Prefix prefix;
+    Subnet4::Cfg cfg;
+};
+
+// A range outside any subnet block, placed by its addresses.
+struct StagedRange
+{
+    std::size_t line;
+    uint32_t low, high;
+};
+
+struct StagedHost
+{
+    std::size_t line;
+    std::string hw_address;
+    uint32_t address;
+    std::string hostname;
+};
+
+// Recursive-descent parser with one token of lookahead. Everything
+// is staged; apply() moves it into the configuration once the whole
+// file has been read.
+class Parser
+{
+  public:
+    Parser (std::string_view text, const KeaConfig &config,
+            DhcpdImportResult &result)
+        : lexer_ (text), config_ (config), result_ (result)
+    {
+        advance ();
+    }
+
+    bool
+    parse ()
+    {
+        return statements (Scope::global, kNoSubnet, 0);
+    }
+
+    // Places staged ranges and hosts, then applies everything.
+    bool
+    apply (KeaConfig &config)
+    {
+        index_subnets ();
+        for (const StagedRange &r : ranges_)
+        {
+            std::size_t i = find_subnet (r.low);
+            if (i == kNoSubnet || r.high > last_address (i))
+            {
+                std::string range = format_pool_range (r.low, r.high);
+                return fail_at (r.line, "range " + range
+                                            + " is outside every"
+                                              " subnet");
+            }
+            subnets_[i].cfg.pools.insert (
+                { format_pool_range (r.low, r.high) });
+            ++result_.pools;
+        }
+        for (StagedHost &h : hosts_)
+        {
+            std::size_t i = find_subnet (h.address);
+            if (i == kNoSubnet)
+            {
+                skip ("host outside every subnet");
+                continue;
+            }
+            Subnet4::Cfg &cfg = subnets_[i].cfg;
+            if (!cfg.reservations
+                     .insert ({ h.hw_address, format_ipv4 (h.address),
+                                std::move (h.hostname) })
+                     .second)
+            {
+                return fail_at (h.line, "hardware ethernet "
+                                            + h.hw_address
+                                            + " is reserved twice in "
+                                            + cfg.subnet);
+            }
+            ++result_.reservations;
+        }
+
+        Subnet4 &s = config.dhcp4.subnet4;
+        s.cfgs.reserve (s.cfgs.size () + subnets_.size ());
+        s.by_prefix.reserve (s.by_prefix.size () + subnets_.size ());
+        for (StagedSubnet &sub : subnets_)
+        {
+            s.insert_config (std::move (sub.cfg));
+        }
+        result_.subnets = subnets_.size ();
+        // Options already in the configuration are kept.
+        for (Option &o : options_)
+        {
+            std::string what = "option " + o.name + " already set";
+            if (config.dhcp4.option_data.add_option (
+                    std::move (o.name), std::move (o.data), false))
+            {
+                ++result_.options;
+            }
+            else
+            {
+                skip (std::move (what));
+            }
+        }
+        if (lifetime_line_ != 0)
+        {
+            config.dhcp4.valid_lifetime = lifetime_;
+        }
+        return true;
+    }
+
+  private:
+    static constexpr int kMaxDepth = 64;
+
+    void
+    advance ()
+    {
+        tok_ = lexer_.next ();
+    }
+
+    bool
+    fail_at (std::size_t line, std::string error)
+    {
+        result_.error_line = line;
+        result_.error = std::move (error);
+        return false;
+    }
+
+    // Fails at the current token; a lexical error wins over `error`.
+    bool
+    fail (std::string error)
+    {
+        if (tok_.kind == Tok::bad)
+        {
+            error.assign (tok_.text);
+        }
+        return fail_at (tok_.line, std::move (error));
+    }
+
+    std::string
+    found () const
+    {
+        switch (tok_.kind)
+        {
+        case Tok::end:
+            return "end of file";
+        case Tok::word:
+        case Tok::string:
+            return "\"" + std::string (tok_.text) + "\"";
+        default:
+            return "'" + std::string (tok_.text) + "'";
+        }
+    }
+
+    bool
+    expect (Tok kind, const char *what)
+    {
+        if (tok_.kind != kind)
+        {
+            return fail (std::string ("expected ") + what + ", found "
+                         + found ());
+        }
+        advance ();
+        return true;
+    }
+
+    // Reads a word into `out`.
+    bool
+    word (std::string_view &out, const char *what)
+    {
+        out = tok_.text;
+        return expect (Tok::word, what);
+    }
+
+    // Reads an address into `addr`.
+    bool
+    address (uint32_t &addr, const char *what)
+    {
+        std::string_view text;
+        std::size_t line = tok_.line;
+        if (!word (text, what))
+        {
+            return false;
+        }
+        if (!parse_ipv4 (text, addr))
+        {
+            return fail_at (line, std::string ("malformed ") + what
+                                      + " \"" + std::string (text)
+                                      + "\"");
+        }
+        return true;
+    }
+
+    void
+    skip (std::string what)
+    {
+        auto ins = skipped_.emplace (what, result_.skipped.size ());
+        if (ins.second)
+        {
+            result_.skipped.emplace_back (std::move (what), 0);
+        }
+        ++result_.skipped[ins.first->second].second;
+    }
+
+    // Statements up to the '}' closing the current block, or the end
+    // of the file at the global scope.
+    bool
+    statements (Scope scope, std::size_t subnet, int depth)
+    {
+        for (;;)
+        {
+            switch (tok_.kind)
+            {
+            case Tok::word:
+                if (!statement (scope, subnet, depth))
+                {
+                    return false;
+                }
+                break;
+            case Tok::semicolon:
+                advance ();
+                break;
+            case Tok::close:
+                return scope != Scope::global
+                       || fail ("unexpected '}'");
+            case Tok::end:
+                return scope == Scope::global
+                       || fail ("expected '}', found end of file");
+            default:
+                return fail ("expected a statement, found "
+                             + found ());
+            }
+        }
+    }
+
+    bool
+    block (Scope scope, std::size_t subnet, int depth)
+    {
+        if (depth >= kMaxDepth)
+        {
+            return fail ("blocks nested too deeply");
+        }
+        return expect (Tok::open, "'{'")
+               && statements (scope, subnet, depth + 1)
+               && expect (Tok::close, "'}'");
+    }
+
+    bool
+    statement (Scope scope, std::size_t subnet, int depth)
+    {
+        std::string_view keyword = tok_.text;
+        std::size_t line = tok_.line;
+        advance ();
+        if (keyword == "subnet")
+        {
+            return subnet_decl (scope, subnet, line, depth);
+        }
+        if (keyword == "range")
+        {
+            return range_decl (subnet);
+        }
+        if (keyword == "host")
+        {
+            return host_decl (depth);
+        }
+        if (keyword == "option")
+        {
+            Option o{ "", "", false };
+            if (!option (o))
+            {
+                return false;
+            }
+            if (o.name.empty ())
+            {
+                return true; // A definition, already counted.
+            }
+            if (scope != Scope::global)
+            {
+                skip ("option " + o.name + " in "
+                      + scope_name (scope));
+                return true;
+            }
+            auto ins
+                = option_index_.emplace (o.name, options_.size ());
+            if (ins.second)
+            {
+                options_.push_back (std::move (o));
+            }
+            else
+            {
+                options_[ins.first->second] = std::move (o);
+            }
+            return true;
+        }
+        if (keyword == "default-lease-time")
+        {
+            return lease_time (scope, line);
+        }
+        if (keyword == "pool")
+        {
+            return block (Scope::pool, subnet, depth);
+        }
+        if (keyword == "shared-network" || keyword == "group")
+        {
+            // The name is required for shared-network, optional for
+            // group.
+            if (keyword[0] == 's' || tok_.kind != Tok::open)
+            {
+                if (tok_.kind != Tok::word
+                    && tok_.kind != Tok::string)
+                {
+                    return fail ("expected a name, found "
+                                 + found ());
+                }
+                advance ();
+            }
+            return block (keyword[0] == 's' ? Scope::shared_network
+                                            : Scope::group,
+                          keyword[0] == 's' ? kNoSubnet : subnet,
+                          depth);
+        }
+        skip (std::string (keyword));
+        return skip_statement ();
+    }
+
+    // subnet ADDRESS netmask MASK { ... }
+    bool
+    subnet_decl (Scope scope, std::size_t outer, std::size_t line,
+                 int depth)
+    {
+        uint32_t base, mask;
+        std::string_view netmask;
+        if (!address (base, "subnet address")
+            || !word (netmask, "\"netmask\""))
+        {
+            return false;
+        }
+        if (netmask != "netmask")
+        {
+            return fail_at (line, "expected \"netmask\", found \""
+                                      + std::string (netmask) + "\"");
+        }
+        std::size_t mask_line = tok_.line;
+        if (!address (mask, "netmask"))
+        {
+            return false;
+        }
+        uint32_t host = ~mask;
+        if ((host & (host + 1)) != 0)
+        {
+            return fail_at (mask_line, "malformed netmask \""
+                                           + format_ipv4 (mask)
+                                           + "\"");
+        }
+        if (outer != kNoSubnet)
+        {
+            return fail_at (line, "subnet inside subnet "
+                                      + subnets_[outer].cfg.subnet);
+        }
+        if (scope == Scope::pool)
+        {
+            return fail_at (line, "subnet inside a pool");
+        }
+
+        Ipv4Prefix prefix{
+            base & mask,
+            static_cast<unsigned> (__builtin_popcount (mask)) };
+        uint64_t key = Subnet4::prefix_key (prefix);
+        StagedSubnet staged{ line, prefix, Subnet4::Cfg{} };
+        staged.cfg.subnet = format_cidr (prefix);
+        if (config_.dhcp4.subnet4.by_prefix.count (key) > 0)
+        {
+            return fail_at (line, "subnet " + staged.cfg.subnet
+                                      + " is already configured");
+        }
+        auto ins = prefixes_.emplace (key, line);
+        if (!ins.second)
+        {
+            return fail_at (line, "subnet " + staged.cfg.subnet
+                                      + " repeats line "
+                                      + std::to_string (
+                                          ins.first->second));
+        }
+        subnets_.push_back (std::move (staged));
+        return block (Scope::subnet, subnets_.size () - 1, depth);
+    }
+
+    // range [dynamic-bootp] LOW [HIGH];
+    bool
+    range_decl (std::size_t subnet)
+    {
+        std::size_t line = tok_.line;
+        if (tok_.kind == Tok::word && tok_.text == "dynamic-bootp")
+        {
+            advance ();
+        }
+        uint32_t low, high;
+        if (!address (low, "range address"))
+        {
+            return false;
+        }
+        high = low;
+        if (tok_.kind == Tok::word
+            && !address (high, "range address"))
+        {
+            return false;
+        }
+        if (!expect (Tok::semicolon, "';'"))
+        {
+            return false;
+        }
+        if (low > high)
+        {
+            return fail_at (line, "range " + format_ipv4 (low) + " "
+                                      + format_ipv4 (high)
+                                      + " is reversed");
+        }
+        if (subnet == kNoSubnet)
+        {
+            ranges_.push_back ({ line, low, high });
+            return true;
+        }
+        StagedSubnet &s = subnets_[subnet];
+        uint32_t last
+            = s.prefix.base | ~prefix_mask (s.prefix.length);
+        if (low < s.prefix.base || high > last)
+        {
+            return fail_at (line, "range "
+                                      + format_pool_range (low, high)
+                                      + " is outside subnet "
+                                      + s.cfg.subnet);
+        }
+        s.cfg.pools.insert ({ format_pool_range (low, high) });
+        ++result_.pools;
+        return true;
+    }
+
+    // option NAME VALUE[, VALUE...]; with the values joined as Kea
+    // option data. Definitions (option space ...; option NAME code
+    // N = TYPE;) are skipped and leave the name empty.
+    bool
+    option (Option &o)
+    {
+        std::string_view name;
+        if (!word (name, "an option name"))
+        {
+            return false;
+        }
+        if (name == "space"
+            || (tok_.kind == Tok::word && tok_.text == "code"))
+        {
+            skip ("option definition");
+            return skip_statement ();
+        }
+        o.name.assign (name);
+        bool item = false; // The current item has a value.
+        for (;;)
+        {
+            switch (tok_.kind)
+            {
+            case Tok::word:
+            case Tok::string:
+                if (item)
+                {
+                    o.data += ' ';
+                }
+                if (tok_.kind == Tok::word || !tok_.escaped)
+                {
+                    append_value (o.data, tok_.text,
+                                  tok_.kind == Tok::string);
+                }
+                else
+                {
+                    append_value (o.data, unescape (tok_.text), true);
+                }
+                item = true;
+                break;
+            case Tok::comma:
+                o.data += ", ";
+                item = false;
+                break;
+            case Tok::semicolon:
+                advance ();
+                return true;
+            default:
+                return expect (Tok::semicolon, "';'");
+            }
+            advance ();
+        }
+    }
+
+    // Kea splits option data on commas; those inside a quoted string
+    // are escaped.
+    static void
+    append_value (std::string &data, std::string_view value,
+                  bool quoted)
+    {
+        if (!quoted)
+        {
+            data += value;
+            return;
+        }
+        for (char c : value)
+        {
+            if (c == ',')
+            {
+                data += '\\';
+            }
+            data += c;
+        }
+    }
+
+    bool
+    lease_time (Scope scope, std::size_t line)
+    {
+        std::string_view text;
+        if (!word (text, "a lease time")
+            || !expect (Tok::semicolon, "';'"))
+        {
+            return false;
+        }
+        uint64_t seconds;
+        const char *end = text.data () + text.size ();
+        auto r = std::from_chars (text.data (), end, seconds);
+        if (r.ec != std::errc () || r.ptr != end)
+        {
+            return fail_at (line, "malformed default-lease-time \""
+                                      + std::string (text) + "\"");
+        }
+        if (scope != Scope::global)
+        {
+            skip (std::string ("default-lease-time in ")
+                  + scope_name (scope));
+            return true;
+        }
+        lifetime_ = seconds;
+        lifetime_line_ = line;
+        return true;
+    }
+
+    // host NAME { hardware ethernet HW; fixed-address ADDRESS; ... }
+    bool
+    host_decl (int depth)
+    {
+        std::size_t line = tok_.line;
+        if (tok_.kind != Tok::word && tok_.kind != Tok::string)
+        {
+            return fail ("expected a host name, found " + found ());
+        }
+        advance ();
+        if (depth >= kMaxDepth)
+        {
+            return fail ("blocks nested too deeply");
+        }
+        if (!expect (Tok::open, "'{'"))
+        {
+            return false;
+        }
+
+        StagedHost h{ line, "", 0, "" };
+        bool have_address = false;
+        while (tok_.kind != Tok::close)
+        {
+            if (tok_.kind == Tok::semicolon)
+            {
+                advance ();
+                continue;
+            }
+            std::string_view keyword;
+            std::size_t at = tok_.line;
+            if (!word (keyword, "a statement"))
+            {
+                return false;
+            }
+            if (keyword == "hardware")
+            {
+                std::string_view type, hw;
+                if (!word (type, "a hardware type")
+                    || !word (hw, "a hardware address")
+                    || !expect (Tok::semicolon, "';'"))
+                {
+                    return false;
+                }
+                if (type != "ethernet")
+                {
+                    skip ("hardware " + std::string (type));
+                }
+                else if (!normalize_hw_address (hw, h.hw_address))
+                {
+                    return fail_at (at,
+                                    "malformed hardware ethernet \""
+                                        + std::string (hw) + "\"");
+                }
+            }
+            else if (keyword == "fixed-address")
+            {
+                // The first address; names would need DNS.
+                std::string_view first;
+                if (!word (first, "an address"))
+                {
+                    return false;
+                }
+                have_address = parse_ipv4 (first, h.address);
+                while (tok_.kind == Tok::comma)
+                {
+                    advance ();
+                    if (!word (first, "an address"))
+                    {
+                        return false;
+                    }
+                }
+                if (!expect (Tok::semicolon, "';'"))
+                {
+                    return false;
+                }
+            }
+            else if (keyword == "option")
+            {
+                Option o{ "", "", false };
+                if (!option (o))
+                {
+                    return false;
+                }
+                if (o.name == "host-name")
+                {
+                    h.hostname = std::move (o.data);
+                }
+                else if (!o.name.empty ())
+                {
+                    skip ("option " + o.name + " in host");
+                }
+            }
+            else
+            {
+                skip (std::string (keyword));
+                if (!skip_statement ())
+                {
+                    return false;
+                }
+            }
+        }
+        advance ();
+
+        if (h.hw_address.empty ())
+        {
+            skip ("host without hardware ethernet");
+        }
+        else if (!have_address)
+        {
+            skip ("host without an IPv4 fixed-address");
+        }
+        else
+        {
+            hosts_.push_back (std::move (h));
+        }
+        return true;
+    }
+
+    // Skips the rest of a statement the import has no use for: up to
+    // its ';', or past its block and any else/elsif blocks.
+    bool
+    skip_statement ()
+    {
+        int depth = 0;
+        for (;;)
+        {
+            switch (tok_.kind)
+            {
+            case Tok::semicolon:
+                advance ();
+                if (depth == 0)
+                {
+                    return true;
+                }
+                break;
+            case Tok::open:
+                advance ();
+                ++depth;
+                break;
+            case Tok::close:
+                if (depth == 0)
+                {
+                    return fail ("expected ';', found '}'");
+                }
+                advance ();
+                if (--depth == 0
+                    && !(tok_.kind == Tok::word
+                         && (tok_.text == "else"
+                             || tok_.text == "elsif")))
+                {
+                    return true;
+                }
+                break;
+            case Tok::end:
+            case Tok::bad:
+                return fail ("expected ';', found " + found ());
+            default:
+                advance ();
+                break;
+            }
+        }
+    }
+
+    uint32_t
+    last_address (std::size_t i) const
+    {
+        const Ipv4Prefix &p = subnets_[i].prefix;
+        return p.base | ~prefix_mask (p.length);
+    }
+
+    void
+    index_subnets ()
+    {
+        by_base_.resize (subnets_.size ());
+        for (std::size_t i = 0; i < subnets_.size (); ++i)
+        {
+            by_base_[i] = i;
+        }
+        std::sort (by_base_.begin (), by_base_.end (),
+                   [&] (std::size_t a, std::size_t b) {
+                       const Ipv4Prefix &pa = subnets_[a].prefix;
+                       const Ipv4Prefix &pb = subnets_[b].prefix;
+                       return pa.base != pb.base
+                                  ? pa.base < pb.base
+                                  : pa.length < pb.length;
+                   });
+
+        // Prefixes either nest or are disjoint, and a prefix sorts
+        // after every prefix containing it: the prefixes containing
+        // the current one are a stack.
+        parent_.assign (subnets_.size (), kNoSubnet);
+        std::vector<std::size_t> outer;
+        for (std::size_t i : by_base_)
+        {
+            while (!outer.empty ()
+                   && last_address (outer.back ())
+                          < subnets_[i].prefix.base)
+            {
+                outer.pop_back ();
+            }
+            if (!outer.empty ())
+            {
+                parent_[i] = outer.back ();
+            }
+            outer.push_back (i);
+        }
+    }
+
+    // The most specific subnet holding `addr`, or kNoSubnet. A subnet
+    // holding it also holds the last subnet based at or below it, so
+    // only that subnet and the ones containing it are tried: at most
+    // 33, however many subnets there are.
+    std::size_t
+    find_subnet (uint32_t addr) const
+    {
+        auto it = std::upper_bound (
+            by_base_.begin (), by_base_.end (), addr,
+            [&] (uint32_t a, std::size_t i) {
+                return a < subnets_[i].prefix.base;
+            });
+        if (it == by_base_.begin ())
+        {
+            return kNoSubnet;
+        }
+        std::size_t i = *--it;
+        while (i != kNoSubnet && addr > last_address (i))
+        {
+            i = parent_[i];
+        }
+        return i;
+    }
+
+    Lexer lexer_;
+    Token tok_;
+    const KeaConfig &config_;
+    DhcpdImportResult &result_;
+
+    std::vector<StagedSubnet> subnets_;
+    // Subnet4::prefix_key to line.
+    std::unordered_map<uint64_t, std::size_t> prefixes_;
+    std::vector<StagedRange> ranges_;
+    std::vector<StagedHost> hosts_;
+    std::vector<Option> options_;
+    std::unordered_map<std::string, std::size_t> option_index_;
+    uint64_t lifetime_ = 0;
+    std::size_t lifetime_line_ = 0;
+    std::unordered_map<std::string, std::size_t> skipped_;
+    std::vector<std::size_t> by_base_; // Subnets by base address.
+    // The smallest subnet containing each subnet, or kNoSubnet.
+    std::vector<std::size_t> parent_;
+};
+} // namespace
+
+DhcpdImportResult
+import_dhcpd_conf (KeaConfig &config, std::string_view text)
+{
+    auto start = std::chrono::steady_clock::now ();
+    DhcpdImportResult result;
+    Parser parser (text, config, result);
+    if (parser.parse () && parser.apply (config))
+    {
+        result.applied = true;
+    }
+    else
+    {
+        result.subnets = result.pools = result.reservations = 0;
+        result.options = 0;
+    }
+    std::chrono::duration<double> elapsed
+        = std::chrono::steady_clock::now () - start;
+    result.seconds = elapsed.count ();
+    return result;
+}
+
+DhcpdImportResult
+import_dhcpd_conf_file (KeaConfig &config, const std::string &path)
+{
+    DhcpdImportResult result;
+    int fd = ::open (path.c_str (), O_RDONLY);
+    if (fd < 0)
+    {
+        result.error = path + ": " + std::strerror (errno);
+        return result;
+    }
+    struct stat st;
+    if (::fstat (fd, &st) != 0)
+    {
+        result.error = path + ": " + std::strerror (errno);
+        ::close (fd);
+        return result;
+    }
+    if (st.st_size == 0)
+    {
+        ::close (fd);
+        return import_dhcpd_conf (config, std::string_view ());
+    }
+
+    std::size_t size = static_cast<std::size_t> (st.st_size);
+    void *data
+        = ::mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close (fd);
+    if (data == MAP_FAILED)
+    {
+        result.error = path + ": " + std::strerror (errno);
+        return result;
+    }
+    ::madvise (data, size, MADV_SEQUENTIAL);
+    result = import_dhcpd_conf (
+        config, std::string_view (static_cast<char *> (data), size));
+    ::munmap (data, size);
+    return result;
+}
+} // namespace KeaGenerator
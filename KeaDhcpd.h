@@ -0,0 +1,80 @@
+// File: KeaDhcpd.h
+#ifndef KEA_DHCPD_H
+#define KEA_DHCPD_H
+
+#include "KeaGenerator.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace KeaGenerator
+{
+// --- ISC dhcpd.conf import ---
+// Migrates the common part of an ISC DHCP server configuration:
+//
+//   default-lease-time 3600;
+//   option domain-name-servers 10.0.0.2, 10.0.0.3;
+//   shared-network campus {
+//       subnet 10.0.0.0 netmask 255.255.255.0 {
+//           range 10.0.0.10 10.0.0.99;
+//           pool { range 10.0.0.128 10.0.0.191; }
+//       }
+//   }
+//   group {
+//       host printer {
+//           hardware ethernet 1a:1b:1c:1d:1e:1f;
+//           fixed-address 10.0.0.5;
+//           option host-name "printer";
+//       }
+//   }
+//
+// Subnets become Subnet4 configurations, numbered in file order, and
+// ranges their pools. shared-network, group and pool blocks are
+// flattened. A range belongs to its subnet, or outside a subnet
+// (a pool in a shared-network) to the subnet holding its addresses.
+// A host with a hardware ethernet address and a fixed-address is
+// reserved in the subnet holding that address, with the host-name
+// option as hostname. Global options go to option-data and
+// default-lease-time to valid-lifetime. An option already in
+// option-data is kept, and the imported one skipped.
+//
+// Everything else has no place in KeaConfig and is skipped and
+// counted: options below the global scope, hosts without a fixed
+// address or outside every subnet, classes, failover, DDNS and other
+// statements. Syntax errors, malformed addresses and netmasks, ranges
+// outside their subnet and duplicate subnets reject the file, and
+// nothing is applied.
+//
+// The tokenizer hands out views into the input, so nothing is copied
+// until a value is stored in the model.
+
+struct DhcpdImportResult
+{
+    bool applied = false;
+    std::size_t subnets = 0;      // Subnets added.
+    std::size_t pools = 0;        // Ranges added as pools.
+    std::size_t reservations = 0; // Hosts reserved.
+    std::size_t options = 0;      // Global options added.
+    // What was skipped, e.g. "option routers in subnet", with its
+    // count, in order of first appearance.
+    std::vector<std::pair<std::string, std::size_t> > skipped;
+    std::size_t error_line = 0; // 1-based line of the first error.
+    std::string error;
+    double seconds = 0; // Parsing and applying.
+};
+
+// Imports dhcpd.conf text into `config`.
+DhcpdImportResult import_dhcpd_conf (KeaConfig &config,
+                                     std::string_view text);
+
+// Imports a dhcpd.conf file, which is memory-mapped. If the file
+// cannot be read, error names it and error_line is 0.
+DhcpdImportResult import_dhcpd_conf_file (KeaConfig &config,
+                                          const std::string &path);
+
+} // namespace KeaGenerator
+
+#endif // KEA_DHCPD_H
@@ -0,0 +1,293 @@
+#include "KeaDhcpd.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace KeaGenerator;
+
+namespace
+{
+const char *kConf = "# Campus DHCP\n"
+                    "authoritative;\n"
+                    "ddns-update-style none;\n"
+                    "default-lease-time 3600;\n"
+                    "max-lease-time 7200;\n"
+                    "option domain-name \"example.com, inc\";\n"
+                    "option domain-name-servers 10.0.0.2, 10.0.0.3;\n"
+                    "option space voip;\n"
+                    "option voip.server code 1 = ip-address;\n"
+                    "class \"phones\" {\n"
+                    "    match if substring (option vendor-class-"
+                    "identifier, 0, 4) = \"SIP/\";\n"
+                    "}\n"
+                    "shared-network campus {\n"
+                    "    option routers 10.0.0.1;\n"
+                    "    subnet 10.0.0.0 netmask 255.255.255.0 {\n"
+                    "        range 10.0.0.10 10.0.0.99;\n"
+                    "        range dynamic-bootp 10.0.0.100;\n"
+                    "        option routers 10.0.0.1;\n"
+                    "    }\n"
+                    "    subnet 10.0.1.7 netmask 255.255.255.0 { }\n"
+                    "    pool { range 10.0.1.128 10.0.1.191; }\n"
+                    "}\n"
+                    "group {\n"
+                    "    option domain-name \"lab\";\n"
+                    "    host printer {\n"
+                    "        hardware ethernet 1A:B:1c:1d:1e:1f;\n"
+                    "        fixed-address 10.0.0.5, printer.lab;\n"
+                    "        option host-name \"printer\";\n"
+                    "        if exists user-class {"
+                    " ddns-updates on; }\n"
+                    "        else { ddns-updates off; }\n"
+                    "    }\n"
+                    "    host laptop {"
+                    " hardware ethernet 2a:2b:2c:2d:2e:2f; }\n"
+                    "    host tv {"
+                    " hardware ethernet 3a:3b:3c:3d:3e:3f;"
+                    " fixed-address 192.168.7.7; }\n"
+                    "}\n"
+                    "host \"mac\" {"
+                    " hardware ethernet 4a:4b:4c:4d:4e:4f;"
+                    " fixed-address 10.0.1.200; }\n";
+} // namespace
+
+// Test an import with every kind of statement
+TEST (KeaDhcpdTest, Import)
+{
+    KeaConfig k;
+    DhcpdImportResult r = import_dhcpd_conf (k, kConf);
+    ASSERT_TRUE (r.applied) << r.error_line << ": " << r.error;
+    EXPECT_EQ (r.subnets, 2u);
+    EXPECT_EQ (r.pools, 3u);
+    EXPECT_EQ (r.reservations, 2u);
+    EXPECT_EQ (r.options, 2u);
+    EXPECT_EQ (k.dhcp4.valid_lifetime, 3600u);
+
+    const Subnet4 &s = k.dhcp4.subnet4;
+    ASSERT_EQ (s.cfgs.size (), 2u);
+    EXPECT_EQ (s.find_by_prefix ("10.0.0.0/24"), 1u);
+    // Host bits are cleared
+    EXPECT_EQ (s.find_by_prefix ("10.0.1.0/24"), 2u);
+    EXPECT_TRUE (s.has_pool (1, "10.0.0.10 - 10.0.0.99"));
+    EXPECT_TRUE (s.has_pool (1, "10.0.0.100 - 10.0.0.100"));
+    // The shared-network pool is placed by its addresses
+    EXPECT_TRUE (s.has_pool (2, "10.0.1.128 - 10.0.1.191"));
+
+    const Subnet4::Cfg &c = s.cfgs.at (1);
+    ASSERT_EQ (c.reservations.size (), 1u);
+    EXPECT_EQ (c.reservations.begin ()->hw_address,
+               "1a:0b:1c:1d:1e:1f");
+    EXPECT_EQ (c.reservations.begin ()->ip_address, "10.0.0.5");
+    EXPECT_EQ (c.reservations.begin ()->hostname, "printer");
+    ASSERT_EQ (s.cfgs.at (2).reservations.size (), 1u);
+
+    const OptionData &o = k.dhcp4.option_data;
+    ASSERT_NE (o.find_option ("domain-name"), nullptr);
+    EXPECT_EQ (o.find_option ("domain-name")->data,
+               "example.com\\, inc");
+    ASSERT_NE (o.find_option ("domain-name-servers"), nullptr);
+    EXPECT_EQ (o.find_option ("domain-name-servers")->data,
+               "10.0.0.2, 10.0.0.3");
+    EXPECT_EQ (o.find_option ("routers"), nullptr);
+
+    std::vector<std::pair<std::string, std::size_t> > skipped = {
+        { "authoritative", 1 },
+        { "ddns-update-style", 1 },
+        { "max-lease-time", 1 },
+        { "option definition", 2 },
+        { "class", 1 },
+        { "option routers in shared-network", 1 },
+        { "option routers in subnet", 1 },
+        { "option domain-name in group", 1 },
+        { "if", 1 },
+        { "host without an IPv4 fixed-address", 1 },
+        { "host outside every subnet", 1 },
+    };
+    EXPECT_EQ (r.skipped, skipped);
+}
+
+// Test that options already in the configuration are kept
+TEST (KeaDhcpdTest, ExistingOptions)
+{
+    KeaConfig k;
+    k.dhcp4.option_data.add_option ("domain-name", "corp", false);
+    DhcpdImportResult r = import_dhcpd_conf (
+        k, "option domain-name \"lab\";\n"
+           "option domain-name-servers 10.0.0.2;\n");
+    ASSERT_TRUE (r.applied) << r.error;
+    EXPECT_EQ (r.options, 1u);
+    EXPECT_EQ (k.dhcp4.option_data.find_option ("domain-name")->data,
+               "corp");
+    std::vector<std::pair<std::string, std::size_t> > skipped = {
+        { "option domain-name already set", 1 },
+    };
+    EXPECT_EQ (r.skipped, skipped);
+}
+
+// Test placing hosts and ranges in nested and distant subnets
+TEST (KeaDhcpdTest, NestedSubnets)
+{
+    KeaConfig k;
+    DhcpdImportResult r = import_dhcpd_conf (
+        k, "subnet 10.0.0.0 netmask 255.0.0.0 { }\n"
+           "subnet 10.1.0.0 netmask 255.255.0.0 { }\n"
+           "subnet 10.1.2.0 netmask 255.255.255.0 { }\n"
+           "subnet 10.1.3.0 netmask 255.255.255.0 { }\n"
+           "subnet 172.16.0.0 netmask 255.255.0.0 { }\n"
+           "shared-network n {\n"
+           "  range 10.1.4.1 10.1.4.9;\n"
+           "  range 10.2.0.1 10.2.0.9;\n"
+           "}\n"
+           "host a { hardware ethernet 1:1:1:1:1:1;"
+           " fixed-address 10.1.2.5; }\n"
+           "host b { hardware ethernet 2:2:2:2:2:2;"
+           " fixed-address 10.1.9.5; }\n"
+           "host c { hardware ethernet 3:3:3:3:3:3;"
+           " fixed-address 10.200.0.5; }\n"
+           "host d { hardware ethernet 4:4:4:4:4:4;"
+           " fixed-address 172.17.0.5; }\n");
+    ASSERT_TRUE (r.applied) << r.error_line << ": " << r.error;
+    const Subnet4 &s = k.dhcp4.subnet4;
+    EXPECT_TRUE (s.has_pool (2, "10.1.4.1 - 10.1.4.9"));
+    EXPECT_TRUE (s.has_pool (1, "10.2.0.1 - 10.2.0.9"));
+    EXPECT_EQ (s.cfgs.at (3).reservations.size (), 1u);
+    EXPECT_EQ (s.cfgs.at (2).reservations.size (), 1u);
+    EXPECT_EQ (s.cfgs.at (1).reservations.size (), 1u);
+    std::vector<std::pair<std::string, std::size_t> > skipped = {
+        { "host outside every subnet", 1 },
+    };
+    EXPECT_EQ (r.skipped, skipped);
+}
+
+// Test string escapes and a comment inside a statement
+TEST (KeaDhcpdTest, Strings)
+{
+    KeaConfig k;
+    DhcpdImportResult r = import_dhcpd_conf (
+        k, "option domain-name \"a\\\"b\\x41\\101\\\\\";\n"
+           "option domain-name-servers\n"
+           "    10.0.0.2 # primary\n"
+           "  , 10.0.0.3;\n");
+    ASSERT_TRUE (r.applied) << r.error;
+    EXPECT_EQ (k.dhcp4.option_data.find_option ("domain-name")->data,
+               "a\"bAA\\");
+    EXPECT_EQ (
+        k.dhcp4.option_data.find_option ("domain-name-servers")->data,
+        "10.0.0.2, 10.0.0.3");
+}
+
+// Test that a rejected file leaves the configuration unchanged
+TEST (KeaDhcpdTest, Errors)
+{
+    struct Case
+    {
+        const char *conf;
+        std::size_t line;
+        const char *error;
+    };
+    const Case cases[] = {
+        { "subnet 10.1.0.0 netmask 255.255.0.0 {\n"
+          "  range 10.1.0.1 10.1.0.9\n}",
+          3, "expected ';', found '}'" },
+        { "subnet 10.1.0.0 netmask 255.255.0.0 {", 1,
+          "expected '}', found end of file" },
+        { "}", 1, "unexpected '}'" },
+        { "{", 1, "expected a statement, found '{'" },
+        { "option domain-name \"x;\n", 1, "unterminated string" },
+        { "authoritative", 1, "expected ';', found end of file" },
+        { "subnet 10.1.0 netmask 255.255.0.0 { }", 1,
+          "malformed subnet address \"10.1.0\"" },
+        { "subnet 10.1.0.0 mask 255.255.0.0 { }", 1,
+          "expected \"netmask\", found \"mask\"" },
+        { "subnet 10.1.0.0 netmask\n255.0.255.0 { }", 2,
+          "malformed netmask \"255.0.255.0\"" },
+        { "subnet 10.1.0.0 netmask 255.255.0.0 {\n"
+          "  subnet 10.1.1.0 netmask 255.255.255.0 { } }",
+          2, "subnet inside subnet 10.1.0.0/16" },
+        { "subnet 10.1.0.0 netmask 255.255.0.0 {\n"
+          "  range 10.1.0.9 10.1.0.1; }",
+          2, "range 10.1.0.9 10.1.0.1 is reversed" },
+        { "subnet 10.1.0.0 netmask 255.255.0.0 {\n"
+          "  range 10.1.0.1 10.2.0.1; }",
+          2,
+          "range 10.1.0.1 - 10.2.0.1 is outside subnet 10.1.0.0/16" },
+        { "shared-network x {\n range 10.3.0.1 10.3.0.9;\n}", 2,
+          "range 10.3.0.1 - 10.3.0.9 is outside every subnet" },
+        { "subnet 10.1.0.0 netmask 255.255.0.0 { }\n"
+          "subnet 10.1.0.0 netmask 255.255.0.0 { }",
+          2, "subnet 10.1.0.0/16 repeats line 1" },
+        { "subnet 10.9.0.0 netmask 255.255.0.0 { }", 1,
+          "subnet 10.9.0.0/16 is already configured" },
+        { "default-lease-time 1h;", 1,
+          "malformed default-lease-time \"1h\"" },
+        { "host a {\n  hardware ethernet 1:2:3:4:5:xx;\n}", 2,
+          "malformed hardware ethernet \"1:2:3:4:5:xx\"" },
+        { "subnet 10.1.0.0 netmask 255.255.0.0 { }\n"
+          "host a { hardware ethernet 1:2:3:4:5:6;"
+          " fixed-address 10.1.0.1; }\n"
+          "host b { hardware ethernet 01:02:03:04:05:06;"
+          " fixed-address 10.1.0.2; }",
+          3,
+          "hardware ethernet 01:02:03:04:05:06 is reserved twice in "
+          "10.1.0.0/16" },
+    };
+    for (const Case &c : cases)
+    {
+        KeaConfig k;
+        k.dhcp4.subnet4.add_config ("10.9.0.0/16");
+        DhcpdImportResult r = import_dhcpd_conf (k, c.conf);
+        EXPECT_FALSE (r.applied) << c.conf;
+        EXPECT_EQ (r.error_line, c.line) << c.conf;
+        EXPECT_EQ (r.error, c.error) << c.conf;
+        EXPECT_EQ (r.subnets, 0u) << c.conf;
+        EXPECT_EQ (k.dhcp4.subnet4.cfgs.size (), 1u);
+    }
+
+    // Deep nesting is an error, not a stack overflow
+    KeaConfig k;
+    std::string deep;
+    for (int i = 0; i < 100000; ++i)
+    {
+        deep += "group {";
+    }
+    DhcpdImportResult r = import_dhcpd_conf (k, deep);
+    EXPECT_FALSE (r.applied);
+    EXPECT_EQ (r.error, "blocks nested too deeply");
+}
+
+// Test importing from a file
+TEST (KeaDhcpdTest, File)
+{
+    std::string path = ::testing::TempDir () + "kea_dhcpd.conf";
+    {
+        std::ofstream out (path);
+        for (int i = 0; i < 1000; ++i)
+        {
+            std::string net
+                = "10." + std::to_string (i / 256) + '.'
+                  + std::to_string (i % 256) + '.';
+            out << "subnet " << net << "0 netmask 255.255.255.0 {\n"
+                << "  range " << net << "10 " << net << "99;\n"
+                << "  host h" << i
+                << " { hardware ethernet 02:00:00:00:"
+                << std::hex << i / 256 << ':' << i % 256 << std::dec
+                << "; fixed-address "
+                << net << "5; }\n}\n";
+        }
+    }
+    KeaConfig k;
+    DhcpdImportResult r = import_dhcpd_conf_file (k, path);
+    EXPECT_TRUE (r.applied) << r.error_line << ": " << r.error;
+    EXPECT_EQ (r.reservations, 1000u);
+    EXPECT_EQ (k.dhcp4.subnet4.cfgs.size (), 1000u);
+    // Ids follow file order
+    EXPECT_EQ (k.dhcp4.subnet4.find_by_prefix ("10.3.231.0/24"),
+               1000u);
+    std::remove (path.c_str ());
+
+    r = import_dhcpd_conf_file (k, path);
+    EXPECT_FALSE (r.applied);
+    EXPECT_EQ (r.error_line, 0u);
+    EXPECT_EQ (r.error.find (path), 0u);
+}
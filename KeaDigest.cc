@@ -0,0 +1,335 @@
+#include "KeaDigest.h"
+
+#include <algorithm>
+#include <cstring>
+
+// As for the address parsers, the CPU is checked at run time.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KEA_X86_SHA 1
+#include <cpuid.h>
+#include <immintrin.h>
+#else
+#define KEA_X86_SHA 0
+#endif
+
+namespace KeaGenerator
+{
+namespace
+{
+const uint32_t kRound[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
+    0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01,
+    0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7,
+    0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152,
+    0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+    0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819,
+    0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08,
+    0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
+    0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+inline uint32_t
+rotr (uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+void
+compress_block (uint32_t *state, const unsigned char *block)
+{
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i)
+    {
+        w[i] = uint32_t (block[4 * i]) << 24
+               | uint32_t (block[4 * i + 1]) << 16
+               | uint32_t (block[4 * i + 2]) << 8
+               | uint32_t (block[4 * i + 3]);
+    }
+    for (int i = 16; i < 64; ++i)
+    {
+        uint32_t s0 = rotr (w[i - 15], 7) ^ rotr (w[i - 15], 18)
+                      ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr (w[i - 2], 17) ^ rotr (w[i - 2], 19)
+                      ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2],
+             d = state[3], e = state[4], f = state[5],
+             g = state[6], h = state[7];
+    for (int i = 0; i < 64; ++i)
+    {
+        uint32_t s1 = rotr (e, 6) ^ rotr (e, 11) ^ rotr (e, 25);
+        uint32_t ch = (e & f) ^ (~e & g);
+        uint32_t t1 = h + s1 + ch + kRound[i] + w[i];
+        uint32_t s0 = rotr (a, 2) ^ rotr (a, 13) ^ rotr (a, 22);
+        uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = s0 + maj;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+void
+compress_scalar (uint32_t *state, const unsigned char *data,
+                 std::size_t blocks)
+{
+    for (; blocks > 0; --blocks, data += 64)
+    {
+        compress_block (state, data);
+    }
+}
+
+#if KEA_X86_SHA
+__attribute__ ((target ("sha,sse4.1"))) void
+compress_sha_ni (uint32_t *state, const unsigned char *data,
+                 std::size_t blocks)
+{
+    // The instructions keep the state as ABEF and CDGH.
+    const __m128i swap = _mm_set_epi64x (0x0c0d0e0f08090a0bull,
+                                         0x0405060700010203ull);
+    __m128i dcba = _mm_loadu_si128 (
+        reinterpret_cast<const __m128i *> (state));
+    __m128i hgfe = _mm_loadu_si128 (
+        reinterpret_cast<const __m128i *> (state + 4));
+    __m128i cdab = _mm_shuffle_epi32 (dcba, 0xb1);
+    __m128i efgh = _mm_shuffle_epi32 (hgfe, 0x1b);
+    __m128i abef = _mm_alignr_epi8 (cdab, efgh, 8);
+    __m128i cdgh = _mm_blend_epi16 (efgh, cdab, 0xf0);
+
+    for (; blocks > 0; --blocks, data += 64)
+    {
+        __m128i abef_in = abef, cdgh_in = cdgh;
+        // w[i % 4] holds words 4i..4i+3 of the message schedule.
+        __m128i w[4];
+        auto in = reinterpret_cast<const __m128i *> (data);
+        for (int i = 0; i < 4; ++i)
+        {
+            w[i] = _mm_shuffle_epi8 (_mm_loadu_si128 (in + i), swap);
+        }
+        auto k = reinterpret_cast<const __m128i *> (kRound);
+        for (int i = 0; i < 16; ++i)
+        {
+            // Four rounds, two per instruction.
+            __m128i wk
+                = _mm_add_epi32 (w[i & 3], _mm_loadu_si128 (k + i));
+            cdgh = _mm_sha256rnds2_epu32 (cdgh, abef, wk);
+            wk = _mm_shuffle_epi32 (wk, 0x0e);
+            abef = _mm_sha256rnds2_epu32 (abef, cdgh, wk);
+            if (i < 12)
+            {
+                __m128i t = _mm_sha256msg1_epu32 (w[i & 3],
+                                                  w[(i + 1) & 3]);
+                t = _mm_add_epi32 (t, _mm_alignr_epi8 (w[(i + 3) & 3],
+                                                       w[(i + 2) & 3],
+                                                       4));
+                w[i & 3] = _mm_sha256msg2_epu32 (t, w[(i + 3) & 3]);
+            }
+        }
+        abef = _mm_add_epi32 (abef, abef_in);
+        cdgh = _mm_add_epi32 (cdgh, cdgh_in);
+    }
+
+    __m128i feba = _mm_shuffle_epi32 (abef, 0x1b);
+    __m128i dchg = _mm_shuffle_epi32 (cdgh, 0xb1);
+    _mm_storeu_si128 (reinterpret_cast<__m128i *> (state),
+                      _mm_blend_epi16 (feba, dchg, 0xf0));
+    _mm_storeu_si128 (reinterpret_cast<__m128i *> (state + 4),
+                      _mm_alignr_epi8 (dchg, feba, 8));
+}
+
+bool
+has_sha_extensions ()
+{
+    static const bool has = [] {
+        unsigned a, b, c, d;
+        if (!__get_cpuid_count (7, 0, &a, &b, &c, &d))
+        {
+            return false;
+        }
+        __builtin_cpu_init ();
+        return (b & (1u << 29)) != 0
+               && __builtin_cpu_supports ("sse4.1") != 0;
+    }();
+    return has;
+}
+#endif
+} // namespace
+
+void
+Sha256::reset ()
+{
+    static const uint32_t initial[8]
+        = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+            0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    std::memcpy (state_, initial, sizeof (state_));
+    length_ = 0;
+    used_ = 0;
+}
+
+void
+Sha256::compress (const unsigned char *data, std::size_t blocks)
+{
+#if KEA_X86_SHA
+    if (path_ == Path::best && has_sha_extensions ())
+    {
+        compress_sha_ni (state_, data, blocks);
+        return;
+    }
+#endif
+    compress_scalar (state_, data, blocks);
+}
+
+void
+Sha256::update (const void *data, std::size_t n)
+{
+    // data may be null when there is nothing to hash.
+    if (n == 0)
+    {
+        return;
+    }
+    auto p = static_cast<const unsigned char *> (data);
+    length_ += n;
+    if (used_ > 0)
+    {
+        std::size_t take = std::min (n, sizeof (block_) - used_);
+        std::memcpy (block_ + used_, p, take);
+        used_ += take;
+        p += take;
+        n -= take;
+        if (used_ < sizeof (block_))
+        {
+            return;
+        }
+        compress (block_, 1);
+        used_ = 0;
+    }
+    // Whole blocks are hashed in place.
+    std::size_t blocks = n / 64;
+    compress (p, blocks);
+    p += 64 * blocks;
+    n -= 64 * blocks;
+    std::memcpy (block_, p, n);
+    used_ = n;
+}
+
+Sha256::Digest
+Sha256::finish ()
+{
+    uint64_t bits = length_ * 8;
+    static const unsigned char pad[64] = { 0x80 };
+    update (pad, used_ < 56 ? 56 - used_ : 120 - used_);
+    unsigned char tail[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        tail[i] = static_cast<unsigned char> (bits >> (56 - 8 * i));
+    }
+    update (tail, sizeof (tail));
+
+    Digest digest;
+    for (int i = 0; i < 8; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            digest[4 * i + j]
+                = static_cast<uint8_t> (state_[i] >> (24 - 8 * j));
+        }
+    }
+    reset ();
+    return digest;
+}
+
+std::string
+to_hex (const Sha256::Digest &digest)
+{
+    static const char hex[] = "0123456789abcdef";
+    std::string s;
+    s.reserve (2 * digest.size ());
+    for (uint8_t b : digest)
+    {
+        s.push_back (hex[b >> 4]);
+        s.push_back (hex[b & 0xf]);
+    }
+    return s;
+}
+
+// --- DigestStreambuf ---
+
+DigestStreambuf::DigestStreambuf (std::streambuf *next) : next_ (next)
+{
+    setp (buf_, buf_ + sizeof (buf_));
+}
+
+DigestStreambuf::~DigestStreambuf ()
+{
+    drain ();
+}
+
+void
+DigestStreambuf::drain ()
+{
+    std::size_t n = static_cast<std::size_t> (pptr () - pbase ());
+    // The bytes are hashed while still in cache, right before they
+    // are handed on.
+    sha_.update (pbase (), n);
+    auto len = static_cast<std::streamsize> (n);
+    if (next_ != nullptr && good_
+        && next_->sputn (pbase (), len) != len)
+    {
+        good_ = false;
+    }
+    setp (buf_, buf_ + sizeof (buf_));
+}
+
+int
+DigestStreambuf::sync ()
+{
+    drain ();
+    if (next_ != nullptr && good_ && next_->pubsync () != 0)
+    {
+        good_ = false;
+    }
+    return good_ ? 0 : -1;
+}
+
+DigestStreambuf::int_type
+DigestStreambuf::overflow (int_type c)
+{
+    drain ();
+    if (!good_)
+    {
+        return traits_type::eof ();
+    }
+    if (!traits_type::eq_int_type (c, traits_type::eof ()))
+    {
+        *pptr () = traits_type::to_char_type (c);
+        pbump (1);
+    }
+    return traits_type::not_eof (c);
+}
+
+Sha256::Digest
+DigestStreambuf::finish ()
+{
+    drain ();
+    return sha_.finish ();
+}
+} // namespace KeaGenerator
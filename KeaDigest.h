@@ -0,0 +1,95 @@
+// File: KeaDigest.h
+#ifndef KEA_DIGEST_H
+#define KEA_DIGEST_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <streambuf>
+#include <string>
+
+namespace KeaGenerator
+{
+// --- SHA-256 ---
+// FIPS 180-4 SHA-256, for signing and comparing generated
+// configurations without a crypto library dependency. Uses the x86
+// SHA extensions where the CPU has them.
+class Sha256
+{
+  public:
+    using Digest = std::array<uint8_t, 32>;
+
+    // Compression code: the fastest the CPU supports, or the portable
+    // code, which runs everywhere.
+    enum class Path
+    {
+        best,
+        portable
+    };
+
+    explicit Sha256 (Path path = Path::best) : path_ (path)
+    {
+        reset ();
+    }
+
+    void reset ();
+    void update (const void *data, std::size_t n);
+    // Returns the digest of everything passed to update() and resets
+    // the hash for the next message.
+    Digest finish ();
+
+  private:
+    // Hashes `blocks` 64-byte blocks.
+    void compress (const unsigned char *data, std::size_t blocks);
+
+    Path path_;
+    uint32_t state_[8];
+    uint64_t length_;        // Bytes hashed so far.
+    unsigned char block_[64]; // Partial block.
+    std::size_t used_;       // Bytes in block_.
+};
+
+// Lower case hex form of a digest.
+std::string to_hex (const Sha256::Digest &digest);
+
+// --- DigestStreambuf ---
+// Hashes everything written through it and passes it on to `next`,
+// or only hashes it if `next` is null. Wrapping a stream's buffer
+// produces the digest of a document in the same pass that writes it.
+class DigestStreambuf : public std::streambuf
+{
+  public:
+    explicit DigestStreambuf (std::streambuf *next = nullptr);
+    ~DigestStreambuf () override;
+
+    DigestStreambuf (const DigestStreambuf &) = delete;
+    DigestStreambuf &operator= (const DigestStreambuf &) = delete;
+
+    // Flushes pending output and returns the digest of everything
+    // written so far; the next write starts a new message.
+    Sha256::Digest finish ();
+
+    // False once `next` has refused output.
+    bool
+    good () const
+    {
+        return good_;
+    }
+
+  protected:
+    int sync () override;
+    int_type overflow (int_type c) override;
+
+  private:
+    // Hashes and forwards the put area, then empties it.
+    void drain ();
+
+    std::streambuf *next_;
+    Sha256 sha_;
+    bool good_ = true;
+    char buf_[16384];
+};
+
+} // namespace KeaGenerator
+
+#endif // KEA_DIGEST_H
@@ -0,0 +1,91 @@
+#include "KeaDigest.h"
+#include <gtest/gtest.h>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+using namespace KeaGenerator;
+
+static std::string
+Sha (const std::string &s, Sha256::Path path = Sha256::Path::best)
+{
+    Sha256 sha (path);
+    sha.update (s.data (), s.size ());
+    return to_hex (sha.finish ());
+}
+
+// Runs the known answers on the CPU's compression code and on the
+// portable code, which the test host may otherwise never select.
+class KeaDigestPathTest
+    : public ::testing::TestWithParam<Sha256::Path>
+{
+  protected:
+    std::string
+    Sha (const std::string &s)
+    {
+        return ::Sha (s, GetParam ());
+    }
+};
+
+TEST_P (KeaDigestPathTest, KnownAnswers)
+{
+    EXPECT_EQ (Sha (""), "e3b0c44298fc1c149afbf4c8996fb924"
+                         "27ae41e4649b934ca495991b7852b855");
+    EXPECT_EQ (Sha ("abc"), "ba7816bf8f01cfea414140de5dae2223"
+                            "b00361a396177a9cb410ff61f20015ad");
+    EXPECT_EQ (Sha ("abcdbcdecdefdefgefghfghighijhijkijkljklm"
+                    "klmnlmnomnopnopq"),
+               "248d6a61d20638b8e5c026930c3e6039"
+               "a33ce45964ff2167f6ecedd419db06c1");
+    EXPECT_EQ (Sha (std::string (1000000, 'a')),
+               "cdc76e5c9914fb9281a1c7e284d73e67"
+               "f1809a48a497200e046d39ccc7112cd0");
+
+    // Fed in uneven pieces across block boundaries.
+    std::string text (1000, 'x');
+    for (std::size_t i = 0; i < text.size (); ++i)
+    {
+        text[i] = static_cast<char> ('a' + i * 7 % 26);
+    }
+    Sha256 sha (GetParam ());
+    for (std::size_t i = 0, step = 1; i < text.size (); i += step++)
+    {
+        sha.update (text.data () + i,
+                    std::min (step, text.size () - i));
+    }
+    EXPECT_EQ (to_hex (sha.finish ()), Sha (text));
+
+    // An empty update may pass a null pointer.
+    sha.update (nullptr, 0);
+    sha.update ("abc", 3);
+    sha.update (nullptr, 0);
+    EXPECT_EQ (to_hex (sha.finish ()), Sha ("abc"));
+}
+
+INSTANTIATE_TEST_SUITE_P (Paths, KeaDigestPathTest,
+                          ::testing::Values (Sha256::Path::best,
+                                             Sha256::Path::portable));
+
+TEST (KeaDigestTest, Streambuf)
+{
+    std::ostringstream out;
+    DigestStreambuf buf (out.rdbuf ());
+    std::ostream os (&buf);
+    std::string text;
+    for (int i = 0; i < 5000; ++i)
+    {
+        text += std::to_string (i) + ',';
+    }
+    os << text;
+    os.put ('!');
+    EXPECT_EQ (to_hex (buf.finish ()), Sha (text + '!'));
+    EXPECT_EQ (out.str (), text + '!');
+
+    // The next message starts after finish().
+    os << "abc";
+    EXPECT_EQ (to_hex (buf.finish ()), Sha ("abc"));
+
+    DigestStreambuf hash_only;
+    std::ostream(&hash_only) << text;
+    EXPECT_EQ (to_hex (hash_only.finish ()), Sha (text));
+}
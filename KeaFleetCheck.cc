@@ -0,0 +1,472 @@
+#include "KeaFleetCheck.h"
+#include "KeaAddress.h"
+#include "KeaParallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <tuple>
+#include <unordered_map>
+
+namespace KeaGenerator
+{
+namespace
+{
+// One subnet of one server.
+struct Entry
+{
+    uint64_t key;   // Subnet4Base::prefix_key.
+    uint64_t id;
+    uint64_t pools; // Hash of the pooled addresses.
+    uint32_t server;
+};
+
+using Group = std::vector<const Entry *>;
+
+// A distinct prefix and every server's entry for it.
+struct PrefixGroup
+{
+    uint64_t key;
+    const Group *entries;
+};
+
+uint64_t
+mix (uint64_t h, uint64_t v)
+{
+    h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h * 0xff51afd7ed558ccdull;
+}
+
+// Fibonacci hashing, as in KeaSubnetIds.cc, onto `parts`
+// partitions.
+unsigned
+partition (uint64_t key, unsigned parts)
+{
+    return static_cast<unsigned> (
+        ((key * 0x9e3779b97f4a7c15ull) >> 32) % parts);
+}
+
+// Hash of the addresses the pools of `cfg` cover. Pools that cannot
+// be parsed are hashed as written, so they only match pools written
+// the same way.
+uint64_t
+pool_hash (const Subnet4::Cfg &cfg)
+{
+    AddressRanges ranges;
+    ranges.reserve (cfg.pools.size ());
+    for (const Subnet4::Pool &p : cfg.pools)
+    {
+        uint32_t low, high;
+        if (!parse_pool_range (p.range, low, high))
+        {
+            uint64_t h = 1;
+            for (const Subnet4::Pool &q : cfg.pools)
+            {
+                for (char c : q.range)
+                {
+                    h = mix (h, static_cast<unsigned char> (c));
+                }
+                h = mix (h, 256);
+            }
+            return h;
+        }
+        ranges.emplace_back (low, high);
+    }
+    normalize_ranges (ranges);
+    uint64_t h = 0;
+    for (const AddressRange &r : ranges)
+    {
+        h = mix (h, uint64_t (r.first) << 32 | r.second);
+    }
+    return h;
+}
+
+Ipv4Prefix
+unpack (uint64_t key)
+{
+    return { static_cast<uint32_t> (key >> 6),
+             static_cast<unsigned> (key & 63) };
+}
+
+// Last address of a prefix.
+uint32_t
+last_address (const Ipv4Prefix &p)
+{
+    return p.length == 0 ? 0xffffffffu
+                         : p.base | (0xffffffffu >> p.length);
+}
+
+FleetIssue
+issue (FleetIssueKind kind, const Entry &e, uint32_t other)
+{
+    FleetIssue i;
+    i.kind = kind;
+    i.server = e.server;
+    i.other = other;
+    i.id = e.id;
+    i.prefix = format_cidr (unpack (e.key));
+    return i;
+}
+
+// The checks that need the HA groups.
+class Checker
+{
+  public:
+    explicit Checker (const std::vector<FleetServer> &servers);
+
+    // Checks the entries of one prefix, in server order.
+    void check_prefix (const Group &g,
+                       std::vector<FleetIssue> &out) const;
+    // Checks the entries of one subnet id, in server order.
+    void check_id (const Group &g,
+                   std::vector<FleetIssue> &out) const;
+    // Checks every prefix against the prefixes containing it.
+    void check_nesting (std::vector<PrefixGroup> &prefixes,
+                        std::vector<FleetIssue> &out) const;
+
+  private:
+    bool
+    related (uint32_t a, uint32_t b) const
+    {
+        return a == b
+               || (group_of_[a] >= 0 && group_of_[a] == group_of_[b]);
+    }
+
+    void check_peers (const Group &g,
+                      std::vector<FleetIssue> &out) const;
+
+    std::vector<int> group_of_; // HA group of each server, or -1.
+    std::vector<std::vector<uint32_t> > members_; // In server order.
+};
+
+Checker::Checker (const std::vector<FleetServer> &servers)
+    : group_of_ (servers.size (), -1)
+{
+    std::unordered_map<std::string, int> groups;
+    for (std::size_t i = 0; i < servers.size (); ++i)
+    {
+        const std::string &name = servers[i].ha_group;
+        if (name.empty ())
+        {
+            continue;
+        }
+        auto ins = groups.emplace (name, int (members_.size ()));
+        if (ins.second)
+        {
+            members_.emplace_back ();
+        }
+        group_of_[i] = ins.first->second;
+        members_[ins.first->second].push_back (uint32_t (i));
+    }
+}
+
+void
+Checker::check_prefix (const Group &g,
+                       std::vector<FleetIssue> &out) const
+{
+    const Entry &first = *g.front ();
+    for (std::size_t i = 1; i < g.size (); ++i)
+    {
+        const Entry &e = *g[i];
+        if (e.id != first.id)
+        {
+            out.push_back (
+                issue (FleetIssueKind::id_mismatch, e, first.server));
+        }
+        if (!related (e.server, first.server))
+        {
+            out.push_back (issue (FleetIssueKind::shared_prefix, e,
+                                  first.server));
+        }
+    }
+    check_peers (g, out);
+}
+
+void
+Checker::check_peers (const Group &g,
+                      std::vector<FleetIssue> &out) const
+{
+    std::vector<int> done;
+    for (std::size_t i = 0; i < g.size (); ++i)
+    {
+        const Entry &ref = *g[i];
+        int group = group_of_[ref.server];
+        if (group < 0
+            || std::find (done.begin (), done.end (), group)
+                   != done.end ())
+        {
+            continue;
+        }
+        done.push_back (group);
+
+        std::vector<uint32_t> have; // In server order, as `g`.
+        for (std::size_t j = i; j < g.size (); ++j)
+        {
+            const Entry &e = *g[j];
+            if (group_of_[e.server] != group)
+            {
+                continue;
+            }
+            have.push_back (e.server);
+            if (e.pools != ref.pools)
+            {
+                out.push_back (
+                    issue (FleetIssueKind::ha_pools, e, ref.server));
+            }
+        }
+        for (uint32_t member : members_[group])
+        {
+            if (!std::binary_search (have.begin (), have.end (),
+                                     member))
+            {
+                FleetIssue missing = issue (
+                    FleetIssueKind::ha_missing, ref, ref.server);
+                missing.server = member;
+                out.push_back (std::move (missing));
+            }
+        }
+    }
+}
+
+void
+Checker::check_id (const Group &g,
+                   std::vector<FleetIssue> &out) const
+{
+    const Entry &first = *g.front ();
+    for (std::size_t i = 1; i < g.size (); ++i)
+    {
+        if (g[i]->key != first.key)
+        {
+            out.push_back (issue (FleetIssueKind::prefix_mismatch,
+                                  *g[i], first.server));
+        }
+    }
+}
+
+void
+Checker::check_nesting (std::vector<PrefixGroup> &prefixes,
+                        std::vector<FleetIssue> &out) const
+{
+    // Keys sort by base address, then length, so a prefix comes
+    // after every prefix containing it. Prefixes either nest or are
+    // disjoint: the prefixes containing the current one are a stack.
+    std::sort (prefixes.begin (), prefixes.end (),
+               [] (const PrefixGroup &a, const PrefixGroup &b) {
+                   return a.key < b.key;
+               });
+    std::vector<std::pair<const PrefixGroup *, uint32_t> > outer;
+    for (const PrefixGroup &p : prefixes)
+    {
+        Ipv4Prefix prefix = unpack (p.key);
+        while (!outer.empty () && outer.back ().second < prefix.base)
+        {
+            outer.pop_back ();
+        }
+        for (const auto &o : outer)
+        {
+            for (const Entry *e : *p.entries)
+            {
+                for (const Entry *f : *o.first->entries)
+                {
+                    if (!related (e->server, f->server))
+                    {
+                        FleetIssue nested = issue (
+                            FleetIssueKind::nested_prefix, *e,
+                            f->server);
+                        nested.other_prefix
+                            = format_cidr (unpack (o.first->key));
+                        out.push_back (std::move (nested));
+                        break;
+                    }
+                }
+            }
+        }
+        outer.emplace_back (&p, last_address (prefix));
+    }
+}
+} // namespace
+
+FleetCheckResult
+check_fleet (const std::vector<FleetServer> &servers,
+             unsigned threads)
+{
+    auto start = std::chrono::steady_clock::now ();
+    FleetCheckResult result;
+    result.servers = servers.size ();
+    unsigned workers = worker_count (threads);
+    Checker checker (servers);
+
+    // Read every server's subnets, one list per slice. Each slice
+    // then buckets its entries by the partition of their prefix and
+    // of their id, so that a worker only visits its own.
+    std::vector<std::vector<Entry> > entries (workers);
+    std::vector<std::vector<Group> > by_prefix_part (
+        workers, std::vector<Group> (workers));
+    std::vector<std::vector<Group> > by_id_part (
+        workers, std::vector<Group> (workers));
+    std::vector<std::vector<FleetIssue> > found (workers);
+    parallel_slices (
+        servers.size (), workers,
+        [&] (unsigned slice, std::size_t begin, std::size_t end) {
+            KeaConfig loaded;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                const FleetServer &server = servers[i];
+                const KeaConfig *k = server.config;
+                if (k == nullptr && server.snapshot != nullptr
+                    && server.snapshot->size () > 0
+                    && server.snapshot->get (
+                        server.snapshot->size () - 1, loaded))
+                {
+                    k = &loaded;
+                }
+                if (k == nullptr)
+                {
+                    FleetIssue unreadable;
+                    unreadable.server = unreadable.other = i;
+                    found[slice].push_back (std::move (unreadable));
+                    continue;
+                }
+                for (const auto &pair : k->dhcp4.subnet4.cfgs)
+                {
+                    const Subnet4::Cfg &cfg = pair.second;
+                    Ipv4Prefix prefix;
+                    if (!parse_cidr (cfg.subnet, prefix))
+                    {
+                        FleetIssue invalid;
+                        invalid.kind = FleetIssueKind::invalid_subnet;
+                        invalid.server = invalid.other = i;
+                        invalid.id = pair.first;
+                        invalid.prefix = cfg.subnet;
+                        found[slice].push_back (std::move (invalid));
+                        continue;
+                    }
+                    entries[slice].push_back (
+                        { Subnet4::prefix_key (prefix), pair.first,
+                          pool_hash (cfg), uint32_t (i) });
+                }
+            }
+            for (const Entry &e : entries[slice])
+            {
+                by_prefix_part[slice][partition (e.key, workers)]
+                    .push_back (&e);
+                by_id_part[slice][partition (e.id, workers)]
+                    .push_back (&e);
+            }
+        });
+
+    // Each worker indexes and checks the prefixes and ids hashing to
+    // its partition. Taking its buckets in slice order keeps every
+    // group in server order.
+    std::vector<std::unordered_map<uint64_t, Group> > by_prefix (
+        workers);
+    std::vector<std::vector<PrefixGroup> > prefixes (workers);
+    run_parallel (workers, [&] (unsigned w) {
+        std::unordered_map<uint64_t, Group> by_id;
+        for (unsigned slice = 0; slice < workers; ++slice)
+        {
+            for (const Entry *e : by_prefix_part[slice][w])
+            {
+                by_prefix[w][e->key].push_back (e);
+            }
+            for (const Entry *e : by_id_part[slice][w])
+            {
+                by_id[e->id].push_back (e);
+            }
+        }
+        for (const auto &pair : by_prefix[w])
+        {
+            checker.check_prefix (pair.second, found[w]);
+            prefixes[w].push_back ({ pair.first, &pair.second });
+        }
+        for (const auto &pair : by_id)
+        {
+            checker.check_id (pair.second, found[w]);
+        }
+    });
+
+    std::vector<PrefixGroup> all;
+    for (std::size_t w = 0; w < workers; ++w)
+    {
+        all.insert (all.end (), prefixes[w].begin (),
+                    prefixes[w].end ());
+        result.subnets += entries[w].size ();
+    }
+    result.prefixes = all.size ();
+    checker.check_nesting (all, result.issues);
+
+    for (std::vector<FleetIssue> &part : found)
+    {
+        for (FleetIssue &i : part)
+        {
+            if (i.kind == FleetIssueKind::invalid_subnet)
+            {
+                ++result.subnets;
+            }
+            result.issues.push_back (std::move (i));
+        }
+    }
+    std::sort (result.issues.begin (), result.issues.end (),
+               [] (const FleetIssue &a, const FleetIssue &b) {
+                   return std::tie (a.server, a.kind, a.prefix,
+                                    a.other, a.other_prefix)
+                          < std::tie (b.server, b.kind, b.prefix,
+                                      b.other, b.other_prefix);
+               });
+
+    std::chrono::duration<double> elapsed
+        = std::chrono::steady_clock::now () - start;
+    result.seconds = elapsed.count ();
+    return result;
+}
+
+const char *
+to_string (FleetIssueKind kind)
+{
+    switch (kind)
+    {
+    case FleetIssueKind::unreadable:
+        return "unreadable";
+    case FleetIssueKind::invalid_subnet:
+        return "invalid-subnet";
+    case FleetIssueKind::id_mismatch:
+        return "id-mismatch";
+    case FleetIssueKind::prefix_mismatch:
+        return "prefix-mismatch";
+    case FleetIssueKind::ha_missing:
+        return "ha-missing";
+    case FleetIssueKind::ha_pools:
+        return "ha-pools";
+    case FleetIssueKind::shared_prefix:
+        return "shared-prefix";
+    case FleetIssueKind::nested_prefix:
+        return "nested-prefix";
+    }
+    return "unknown";
+}
+
+void
+write_fleet_report (std::ostream &out,
+                    const std::vector<FleetServer> &servers,
+                    const FleetCheckResult &result)
+{
+    for (const FleetIssue &i : result.issues)
+    {
+        out << servers[i.server].name << ": " << to_string (i.kind);
+        if (i.kind == FleetIssueKind::unreadable)
+        {
+            out << '\n';
+            continue;
+        }
+        out << ' ' << i.prefix << " id " << i.id;
+        if (i.kind == FleetIssueKind::nested_prefix)
+        {
+            out << " in " << i.other_prefix;
+        }
+        if (i.other != i.server)
+        {
+            out << " (" << servers[i.other].name << ')';
+        }
+        out << '\n';
+    }
+}
+} // namespace KeaGenerator
@@ -0,0 +1,118 @@
+// File: KeaFleetCheck.h
+#ifndef KEA_FLEET_CHECK_H
+#define KEA_FLEET_CHECK_H
+
+#include "KeaArchive.h"
+#include "KeaGenerator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace KeaGenerator
+{
+// --- Fleet consistency ---
+// Cross-checks the subnets of many servers' configurations:
+//
+//   - a prefix has the same subnet id on every server,
+//   - an id stands for the same prefix on every server,
+//   - HA peers carry the same subnets with the same pools,
+//   - no prefix, or prefix nested in it, is served by two servers
+//     that are not HA peers.
+//
+// Prefixes are compared after clearing host bits and pools as the
+// addresses they cover, so "10.0.0.1-10.0.0.9" and two pools
+// splitting that range are the same.
+//
+// The servers are read in parallel slices into per-slice subnet
+// lists. Each worker then owns a hash partition of the prefixes and
+// of the ids and indexes and checks it without locking, so the whole
+// fleet is checked in one pass.
+
+// One server of the fleet. Its configuration is `config` or, if that
+// is null, the latest version in `snapshot`.
+struct FleetServer
+{
+    std::string name;
+    // Servers with the same non-empty group are HA peers.
+    std::string ha_group;
+    const KeaConfig *config = nullptr;
+    const ConfigArchive *snapshot = nullptr;
+};
+
+enum class FleetIssueKind
+{
+    // No configuration, or its snapshot is malformed.
+    unreadable,
+    // A subnet prefix that cannot be parsed.
+    invalid_subnet,
+    // The prefix has another id on `other`.
+    id_mismatch,
+    // The id stands for another prefix on `other`.
+    prefix_mismatch,
+    // `other`, an HA peer, serves the prefix; this server does not.
+    ha_missing,
+    // The pools differ from those of HA peer `other`.
+    ha_pools,
+    // `other`, not an HA peer, serves the prefix too.
+    shared_prefix,
+    // `other`, not an HA peer, serves `other_prefix`, which contains
+    // the prefix.
+    nested_prefix,
+};
+
+// One inconsistency, reported against `server`; `other` is the
+// server it conflicts with. Servers are indices into the input.
+struct FleetIssue
+{
+    FleetIssueKind kind = FleetIssueKind::unreadable;
+    std::size_t server = 0;
+    std::size_t other = 0;
+    // Subnet id on `server`; for ha_missing, the id on `other`.
+    uint64_t id = 0;
+    // The subnet: canonical, or as configured for invalid_subnet.
+    std::string prefix;
+    // nested_prefix: the enclosing prefix.
+    std::string other_prefix;
+};
+
+struct FleetCheckResult
+{
+    std::size_t servers = 0;
+    std::size_t subnets = 0; // Subnets on all servers.
+    std::size_t prefixes = 0; // Distinct prefixes.
+    double seconds = 0;
+    // Ordered by server, then kind, prefix and other server. A
+    // conflict among several servers is reported against every
+    // server that disagrees with the first one (by index) serving
+    // the prefix or id.
+    std::vector<FleetIssue> issues;
+
+    bool
+    ok () const
+    {
+        return issues.empty ();
+    }
+};
+
+// Checks `servers` with `threads` workers (0 uses one per hardware
+// thread).
+FleetCheckResult check_fleet (const std::vector<FleetServer> &servers,
+                              unsigned threads = 0);
+
+// Name of an issue kind, e.g. "id-mismatch".
+const char *to_string (FleetIssueKind kind);
+
+// Writes one line per issue:
+//
+//   dhcp-a: id-mismatch 10.0.0.0/24 id 7 (dhcp-b)
+//   dhcp-c: nested-prefix 10.0.1.0/24 id 3 in 10.0.0.0/16 (dhcp-d)
+void write_fleet_report (std::ostream &out,
+                         const std::vector<FleetServer> &servers,
+                         const FleetCheckResult &result);
+
+} // namespace KeaGenerator
+
+#endif // KEA_FLEET_CHECK_H
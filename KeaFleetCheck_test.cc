@@ -0,0 +1,133 @@
+#include "KeaFleetCheck.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+using namespace KeaGenerator;
+
+class KeaFleetCheckTest : public ::testing::Test
+{
+  protected:
+    void
+    SetUp () override
+    {
+        // An HA pair and a standalone server, all consistent.
+        for (KeaConfig *k : { &a, &b })
+        {
+            Subnet4 &s = k->dhcp4.subnet4;
+            uint64_t id = s.add_config ("10.0.0.0/24");
+            s.add_pool_for_cfg (id, "10.0.0.10", "10.0.0.99");
+            s.add_config ("10.0.1.0/24");
+        }
+        c.dhcp4.subnet4.add_config_with_id (3, "10.1.0.0/16");
+
+        servers = { { "dhcp-a", "ha-1", &a, nullptr },
+                    { "dhcp-b", "ha-1", &b, nullptr },
+                    { "dhcp-c", "", &c, nullptr } };
+    }
+
+    std::string
+    report (const FleetCheckResult &r)
+    {
+        std::ostringstream out;
+        write_fleet_report (out, servers, r);
+        return out.str ();
+    }
+
+    KeaConfig a, b, c;
+    std::vector<FleetServer> servers;
+};
+
+// Test a consistent fleet
+TEST_F (KeaFleetCheckTest, Consistent)
+{
+    FleetCheckResult r = check_fleet (servers, 2);
+    EXPECT_TRUE (r.ok ()) << report (r);
+    EXPECT_EQ (r.servers, 3u);
+    EXPECT_EQ (r.subnets, 5u);
+    EXPECT_EQ (r.prefixes, 3u);
+
+    // Pools are compared by the addresses they cover.
+    Subnet4 &s = b.dhcp4.subnet4;
+    s.remove_pool_for_cfg (1, "10.0.0.10", "10.0.0.99");
+    s.add_pool_for_cfg (1, "10.0.0.10", "10.0.0.49");
+    s.add_pool_for_cfg (1, "10.0.0.50", "10.0.0.99");
+    EXPECT_TRUE (check_fleet (servers, 3).ok ());
+}
+
+// Test ids and prefixes that disagree between servers
+TEST_F (KeaFleetCheckTest, IdsAndPrefixes)
+{
+    // dhcp-b numbers its second subnet 7 and gives 2 to another
+    // prefix.
+    Subnet4 &s = b.dhcp4.subnet4;
+    s.remove_config (2);
+    s.add_config_with_id (7, "10.0.1.0/24");
+    s.add_config_with_id (2, "10.0.2.0/24");
+
+    FleetCheckResult r = check_fleet (servers, 4);
+    EXPECT_EQ (report (r),
+               "dhcp-a: ha-missing 10.0.2.0/24 id 2 (dhcp-b)\n"
+               "dhcp-b: id-mismatch 10.0.1.0/24 id 7 (dhcp-a)\n"
+               "dhcp-b: prefix-mismatch 10.0.2.0/24 id 2 (dhcp-a)\n");
+}
+
+// Test HA peers with different subnets or pools
+TEST_F (KeaFleetCheckTest, HaPeers)
+{
+    b.dhcp4.subnet4.add_pool_for_cfg (2, "10.0.1.10", "10.0.1.20");
+    b.dhcp4.subnet4.remove_config (1);
+    KeaConfig d = a;
+    d.dhcp4.subnet4.add_pool_for_cfg (1, "10.0.0.200", "10.0.0.209");
+    servers.push_back ({ "dhcp-d", "ha-1", &d, nullptr });
+
+    FleetCheckResult r = check_fleet (servers, 2);
+    ASSERT_EQ (r.issues.size (), 3u) << report (r);
+    EXPECT_EQ (r.issues[0].kind, FleetIssueKind::ha_missing);
+    EXPECT_EQ (r.issues[0].server, 1u);
+    EXPECT_EQ (r.issues[0].other, 0u);
+    EXPECT_EQ (r.issues[0].prefix, "10.0.0.0/24");
+    EXPECT_EQ (r.issues[1].kind, FleetIssueKind::ha_pools);
+    EXPECT_EQ (r.issues[1].prefix, "10.0.1.0/24");
+    EXPECT_EQ (r.issues[1].server, 1u);
+    EXPECT_EQ (r.issues[2].kind, FleetIssueKind::ha_pools);
+    EXPECT_EQ (r.issues[2].server, 3u);
+    EXPECT_EQ (r.issues[2].other, 0u);
+}
+
+// Test prefixes served by servers that are not peers
+TEST_F (KeaFleetCheckTest, SharedAndNestedPrefixes)
+{
+    Subnet4 &s = c.dhcp4.subnet4;
+    s.add_config_with_id (1, "10.0.0.7/24");
+    s.add_config_with_id (9, "10.0.0.128/25");
+    s.add_config_with_id (8, "10.1.2.0/24");
+
+    FleetCheckResult r = check_fleet (servers, 3);
+    EXPECT_EQ (report (r),
+               "dhcp-c: shared-prefix 10.0.0.0/24 id 1 (dhcp-a)\n"
+               "dhcp-c: nested-prefix 10.0.0.128/25 id 9 "
+               "in 10.0.0.0/24 (dhcp-a)\n");
+}
+
+// Test snapshots and unusable input
+TEST_F (KeaFleetCheckTest, SnapshotsAndErrors)
+{
+    ConfigArchive archive, empty;
+    KeaConfig old;
+    old.dhcp4.subnet4.add_config ("10.9.0.0/24");
+    archive.append (old);
+    archive.append (c);
+    servers[2] = { "dhcp-c", "", nullptr, &archive };
+    servers.push_back ({ "dhcp-d", "", nullptr, &empty });
+    KeaConfig e;
+    e.dhcp4.subnet4.cfgs[1].id = 1;
+    e.dhcp4.subnet4.cfgs[1].subnet = "10.2.0.0/33";
+    servers.push_back ({ "dhcp-e", "", &e, nullptr });
+
+    FleetCheckResult r = check_fleet (servers, 1);
+    EXPECT_EQ (r.subnets, 6u);
+    EXPECT_EQ (report (r),
+               "dhcp-d: unreadable\n"
+               "dhcp-e: invalid-subnet 10.2.0.0/33 id 1\n");
+}
@@ -0,0 +1,832 @@
+#include "KeaFleetWriter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <set>
+#include <stdexcept>
+#include <streambuf>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// The ring is driven through the kernel interface directly, so
+// liburing is not needed.
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define KEA_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#else
+#define KEA_HAVE_IO_URING 0
+#endif
+
+namespace KeaGenerator
+{
+namespace
+{
+// Throws std::system_error for the current errno.
+[[noreturn]] void
+throw_errno (const std::string &what)
+{
+    throw std::system_error (errno, std::generic_category (), what);
+}
+
+std::error_code
+errno_code (int err)
+{
+    return std::error_code (err, std::generic_category ());
+}
+
+// Appends what is written to it to a string, through a small buffer
+// so the writer does not make a virtual call per character.
+class StringSink : public std::streambuf
+{
+  public:
+    explicit StringSink (std::string &out) : out_ (out)
+    {
+        setp (buf_, buf_ + sizeof (buf_));
+    }
+
+  protected:
+    int
+    sync () override
+    {
+        out_.append (pbase (), static_cast<std::size_t> (pptr ()
+                                                         - pbase ()));
+        setp (buf_, buf_ + sizeof (buf_));
+        return 0;
+    }
+
+    int_type
+    overflow (int_type c) override
+    {
+        sync ();
+        if (!traits_type::eq_int_type (c, traits_type::eof ()))
+        {
+            *pptr () = traits_type::to_char_type (c);
+            pbump (1);
+        }
+        return traits_type::not_eof (c);
+    }
+
+  private:
+    std::string &out_;
+    char buf_[8192];
+};
+
+void
+render (const FleetJob &job, const JsonFormat &format,
+        std::string &out)
+{
+    out.clear ();
+    StringSink sink (out);
+    std::ostream os (&sink);
+    write_json (os, *job.config, format);
+    sink.pubsync ();
+}
+
+std::string
+temp_path (const std::string &path)
+{
+    return path + ".tmp";
+}
+
+std::string
+parent_dir (const std::string &path)
+{
+    std::size_t slash = path.rfind ('/');
+    if (slash == std::string::npos)
+    {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr (0, slash);
+}
+
+// What the backends report back to write_fleet.
+struct Outcome
+{
+    std::size_t files = 0;
+    uint64_t bytes = 0;
+    std::vector<std::pair<std::size_t, std::error_code> > failed;
+    std::set<std::string> dirs; // Directories of the renamed files.
+
+    void
+    written (const std::string &path, std::size_t size)
+    {
+        ++files;
+        bytes += size;
+        dirs.insert (parent_dir (path));
+    }
+};
+
+// Makes the renames durable. Best effort: the files themselves are
+// already complete.
+void
+sync_dirs (const std::set<std::string> &dirs)
+{
+    for (const std::string &dir : dirs)
+    {
+        int fd = ::open (dir.c_str (),
+                         O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd >= 0)
+        {
+            ::fsync (fd);
+            ::close (fd);
+        }
+    }
+}
+
+// --- Syscall backend ---
+
+// Writes one file through its temporary file. Returns an empty
+// error code on success.
+std::error_code
+write_file (const std::string &path, const std::string &data,
+            bool sync)
+{
+    std::string temp = temp_path (path);
+    int fd = ::open (temp.c_str (),
+                     O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return errno_code (errno);
+    }
+    std::error_code ec;
+    for (std::size_t done = 0; done < data.size () && !ec;)
+    {
+        ssize_t n = ::write (fd, data.data () + done,
+                             data.size () - done);
+        if (n >= 0)
+        {
+            done += static_cast<std::size_t> (n);
+        }
+        else if (errno != EINTR)
+        {
+            ec = errno_code (errno);
+        }
+    }
+    if (!ec && sync && ::fsync (fd) < 0)
+    {
+        ec = errno_code (errno);
+    }
+    if (::close (fd) < 0 && !ec)
+    {
+        ec = errno_code (errno);
+    }
+    if (!ec && ::rename (temp.c_str (), path.c_str ()) < 0)
+    {
+        ec = errno_code (errno);
+    }
+    if (ec)
+    {
+        ::unlink (temp.c_str ());
+    }
+    return ec;
+}
+
+// Renders on the calling thread and writes on a background thread,
+// with up to `queue_depth` rendered files waiting in between.
+void
+write_with_syscalls (const std::vector<FleetJob> &jobs,
+                     const FleetWriteOptions &options, Outcome &out)
+{
+    struct Rendered
+    {
+        std::size_t job;
+        std::string data;
+    };
+    std::mutex mutex;
+    std::condition_variable ready, space;
+    std::deque<Rendered> queue;
+    bool done = false;
+    const std::size_t depth = std::max (1u, options.queue_depth);
+
+    // `out` belongs to the I/O thread until it is joined.
+    std::thread io ([&] {
+        for (;;)
+        {
+            Rendered r;
+            {
+                std::unique_lock<std::mutex> lock (mutex);
+                ready.wait (lock,
+                            [&] { return done || !queue.empty (); });
+                if (queue.empty ())
+                {
+                    return;
+                }
+                r = std::move (queue.front ());
+                queue.pop_front ();
+            }
+            space.notify_one ();
+            const std::string &path = jobs[r.job].path;
+            std::error_code ec
+                = write_file (path, r.data, options.sync);
+            if (ec)
+            {
+                out.failed.emplace_back (r.job, ec);
+            }
+            else
+            {
+                out.written (path, r.data.size ());
+            }
+        }
+    });
+    auto finish = [&] {
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            done = true;
+        }
+        ready.notify_one ();
+        io.join ();
+    };
+
+    try
+    {
+        for (std::size_t i = 0; i < jobs.size (); ++i)
+        {
+            Rendered r{ i, {} };
+            render (jobs[i], options.format, r.data);
+            std::unique_lock<std::mutex> lock (mutex);
+            space.wait (lock, [&] { return queue.size () < depth; });
+            queue.push_back (std::move (r));
+            lock.unlock ();
+            ready.notify_one ();
+        }
+    }
+    catch (...)
+    {
+        finish ();
+        throw;
+    }
+    finish ();
+}
+
+#if KEA_HAVE_IO_URING
+// --- io_uring backend ---
+
+int
+io_uring_setup (unsigned entries, io_uring_params *params)
+{
+    return static_cast<int> (
+        ::syscall (__NR_io_uring_setup, entries, params));
+}
+
+int
+io_uring_enter (int fd, unsigned submit, unsigned wait,
+                unsigned flags)
+{
+    return static_cast<int> (::syscall (__NR_io_uring_enter, fd,
+                                        submit, wait, flags, nullptr,
+                                        0));
+}
+
+int
+io_uring_register (int fd, unsigned op, void *arg, unsigned n)
+{
+    return static_cast<int> (
+        ::syscall (__NR_io_uring_register, fd, op, arg, n));
+}
+
+// A submission and a completion queue shared with the kernel. Only
+// what the writer needs: no polling threads, no registered files.
+class Ring
+{
+  public:
+    // The kernel rejects more than IORING_MAX_ENTRIES with EINVAL;
+    // `entries` is then halved until it is accepted.
+    explicit Ring (unsigned entries)
+    {
+        io_uring_params p{};
+        while ((fd_ = io_uring_setup (entries, &p)) < 0
+               && errno == EINVAL && entries > 1)
+        {
+            entries /= 2;
+            p = io_uring_params{};
+        }
+        if (fd_ < 0)
+        {
+            throw_errno ("io_uring_setup");
+        }
+        try
+        {
+            map (p);
+        }
+        catch (...)
+        {
+            release ();
+            throw;
+        }
+    }
+
+    ~Ring ()
+    {
+        release ();
+    }
+
+    Ring (const Ring &) = delete;
+    Ring &operator= (const Ring &) = delete;
+
+    int
+    fd () const
+    {
+        return fd_;
+    }
+
+    // Submission entries, at least the number that was accepted.
+    unsigned
+    entries () const
+    {
+        return sq_entries_;
+    }
+
+    // A cleared submission entry, or nullptr if the queue is full.
+    io_uring_sqe *
+    get ()
+    {
+        unsigned head = __atomic_load_n (sq_head_, __ATOMIC_ACQUIRE);
+        if (tail_ - head >= sq_entries_)
+        {
+            return nullptr;
+        }
+        unsigned index = tail_ & sq_mask_;
+        io_uring_sqe *sqe = &sqes_[index];
+        std::memset (sqe, 0, sizeof (*sqe));
+        sq_array_[index] = index;
+        ++tail_;
+        return sqe;
+    }
+
+    // Hands the new entries to the kernel and waits until at least
+    // `wait` completions are available.
+    void
+    submit (unsigned wait)
+    {
+        __atomic_store_n (sq_tail_, tail_, __ATOMIC_RELEASE);
+        for (;;)
+        {
+            unsigned head
+                = __atomic_load_n (sq_head_, __ATOMIC_ACQUIRE);
+            unsigned pending = tail_ - head;
+            if (pending == 0 && wait == 0)
+            {
+                return;
+            }
+            unsigned flags = wait != 0 ? IORING_ENTER_GETEVENTS : 0;
+            if (io_uring_enter (fd_, pending, wait, flags) >= 0)
+            {
+                return;
+            }
+            if (errno != EINTR)
+            {
+                throw_errno ("io_uring_enter");
+            }
+        }
+    }
+
+    // Takes the next completion; false if there is none.
+    bool
+    pop (io_uring_cqe &cqe)
+    {
+        unsigned head = *cq_head_;
+        if (head == __atomic_load_n (cq_tail_, __ATOMIC_ACQUIRE))
+        {
+            return false;
+        }
+        cqe = cqes_[head & cq_mask_];
+        __atomic_store_n (cq_head_, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+  private:
+    void *
+    map_region (std::size_t size, off_t offset)
+    {
+        void *p = ::mmap (nullptr, size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, fd_, offset);
+        if (p == MAP_FAILED)
+        {
+            throw_errno ("mmap");
+        }
+        return p;
+    }
+
+    void
+    map (const io_uring_params &p)
+    {
+        sq_size_ = p.sq_off.array + p.sq_entries * sizeof (unsigned);
+        cq_size_ = p.cq_off.cqes
+                   + p.cq_entries * sizeof (io_uring_cqe);
+        bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single)
+        {
+            sq_size_ = cq_size_ = std::max (sq_size_, cq_size_);
+        }
+        sq_ring_ = map_region (sq_size_, IORING_OFF_SQ_RING);
+        cq_ring_ = single ? sq_ring_
+                          : map_region (cq_size_, IORING_OFF_CQ_RING);
+        sqes_size_ = p.sq_entries * sizeof (io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe *> (
+            map_region (sqes_size_, IORING_OFF_SQES));
+
+        char *sq = static_cast<char *> (sq_ring_);
+        sq_head_ = reinterpret_cast<unsigned *> (sq + p.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned *> (sq + p.sq_off.tail);
+        sq_mask_
+            = *reinterpret_cast<unsigned *> (sq + p.sq_off.ring_mask);
+        sq_array_
+            = reinterpret_cast<unsigned *> (sq + p.sq_off.array);
+        sq_entries_ = p.sq_entries;
+        tail_ = *sq_tail_;
+
+        char *cq = static_cast<char *> (cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned *> (cq + p.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned *> (cq + p.cq_off.tail);
+        cq_mask_
+            = *reinterpret_cast<unsigned *> (cq + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe *> (cq + p.cq_off.cqes);
+    }
+
+    void
+    release ()
+    {
+        if (sqes_ != nullptr)
+        {
+            ::munmap (sqes_, sqes_size_);
+        }
+        if (cq_ring_ != nullptr && cq_ring_ != sq_ring_)
+        {
+            ::munmap (cq_ring_, cq_size_);
+        }
+        if (sq_ring_ != nullptr)
+        {
+            ::munmap (sq_ring_, sq_size_);
+        }
+        if (fd_ >= 0)
+        {
+            ::close (fd_);
+        }
+    }
+
+    int fd_ = -1;
+    void *sq_ring_ = nullptr;
+    void *cq_ring_ = nullptr;
+    std::size_t sq_size_ = 0;
+    std::size_t cq_size_ = 0;
+    io_uring_sqe *sqes_ = nullptr;
+    std::size_t sqes_size_ = 0;
+
+    unsigned *sq_head_ = nullptr;
+    unsigned *sq_tail_ = nullptr;
+    unsigned *sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned tail_ = 0; // Local tail, published by submit.
+
+    unsigned *cq_head_ = nullptr;
+    unsigned *cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe *cqes_ = nullptr;
+};
+
+bool
+probe_io_uring ()
+{
+    Ring ring (2);
+    // io_uring_probe ends in a flexible array of operations.
+    constexpr unsigned kOps = 256;
+    std::vector<uint64_t> storage (
+        (sizeof (io_uring_probe) + kOps * sizeof (io_uring_probe_op))
+            / sizeof (uint64_t)
+        + 1);
+    auto *probe
+        = reinterpret_cast<io_uring_probe *> (storage.data ());
+    if (io_uring_register (ring.fd (), IORING_REGISTER_PROBE, probe,
+                           kOps)
+        < 0)
+    {
+        return false;
+    }
+    for (unsigned op : { IORING_OP_OPENAT, IORING_OP_WRITE,
+                         IORING_OP_FSYNC, IORING_OP_CLOSE,
+                         IORING_OP_RENAMEAT })
+    {
+        if (op > probe->last_op
+            || (probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The steps of one file, each a single ring operation.
+enum class Step
+{
+    open,
+    write,
+    fsync,
+    close,
+    rename,
+};
+
+struct Slot
+{
+    std::size_t job = 0;
+    std::string data;
+    std::string temp;
+    int fd = -1;
+    std::size_t written = 0;
+    Step step = Step::open;
+};
+
+// Keeps up to `queue_depth` files in flight, each with one operation
+// queued at a time, or fewer if the ring is smaller. A file's open is
+// submitted as soon as it is rendered, so the kernel works on it
+// while the next one renders. Returns false, before writing anything,
+// if the ring cannot be set up and the backend is automatic.
+bool
+write_with_io_uring (const std::vector<FleetJob> &jobs,
+                     const FleetWriteOptions &options, Outcome &out)
+{
+    unsigned depth = std::max (1u, options.queue_depth);
+    // Declared before the ring: in-flight operations point into the
+    // slots, and they must not outlive them.
+    std::vector<Slot> slots;
+    std::optional<Ring> engine;
+    try
+    {
+        engine.emplace (depth);
+    }
+    catch (const std::system_error &)
+    {
+        if (options.backend == IoBackend::automatic)
+        {
+            return false;
+        }
+        throw;
+    }
+    Ring &ring = *engine;
+    depth = std::min (depth, ring.entries ());
+    slots.resize (depth);
+    std::vector<unsigned> idle;
+    for (unsigned i = depth; i > 0; --i)
+    {
+        idle.push_back (i - 1);
+    }
+    std::size_t busy = 0;
+    bool abandon = false;
+
+    auto queue = [&] (unsigned index) {
+        Slot &s = slots[index];
+        const std::string &path = jobs[s.job].path;
+        // One entry per slot at most, so the queue has room.
+        io_uring_sqe *sqe = ring.get ();
+        sqe->user_data = index;
+        switch (s.step)
+        {
+        case Step::open:
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<uintptr_t> (s.temp.c_str ());
+            sqe->len = 0644;
+            sqe->open_flags
+                = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+            break;
+        case Step::write:
+            sqe->opcode = IORING_OP_WRITE;
+            sqe->fd = s.fd;
+            sqe->addr = reinterpret_cast<uintptr_t> (s.data.data ()
+                                                     + s.written);
+            sqe->len = static_cast<uint32_t> (
+                std::min<std::size_t> (s.data.size () - s.written,
+                                       1u << 30));
+            sqe->off = s.written;
+            break;
+        case Step::fsync:
+            sqe->opcode = IORING_OP_FSYNC;
+            sqe->fd = s.fd;
+            break;
+        case Step::close:
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->fd = s.fd;
+            break;
+        case Step::rename:
+            sqe->opcode = IORING_OP_RENAMEAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<uintptr_t> (s.temp.c_str ());
+            sqe->len = static_cast<uint32_t> (AT_FDCWD);
+            sqe->addr2 = reinterpret_cast<uintptr_t> (path.c_str ());
+            break;
+        }
+    };
+
+    auto finished = [&] (unsigned index) {
+        idle.push_back (index);
+        --busy;
+    };
+    auto fail = [&] (unsigned index, int err) {
+        Slot &s = slots[index];
+        // Rare; cleaned up synchronously.
+        if (s.fd >= 0)
+        {
+            ::close (s.fd);
+        }
+        ::unlink (s.temp.c_str ());
+        out.failed.emplace_back (s.job, errno_code (err));
+        finished (index);
+    };
+
+    auto complete = [&] (const io_uring_cqe &cqe) {
+        auto index = static_cast<unsigned> (cqe.user_data);
+        Slot &s = slots[index];
+        if (s.step == Step::close)
+        {
+            s.fd = -1; // Released even if close reports an error.
+        }
+        // A rename that completed has replaced the file; only the
+        // earlier steps are abandoned.
+        if (cqe.res < 0 || (abandon && s.step != Step::rename))
+        {
+            fail (index, cqe.res < 0 ? -cqe.res : ECANCELED);
+            return;
+        }
+        switch (s.step)
+        {
+        case Step::open:
+            s.fd = cqe.res;
+            s.step = s.data.empty () ? Step::close : Step::write;
+            break;
+        case Step::write:
+            if (cqe.res == 0)
+            {
+                fail (index, EIO);
+                return;
+            }
+            s.written += static_cast<std::size_t> (cqe.res);
+            if (s.written == s.data.size ())
+            {
+                s.step = options.sync ? Step::fsync : Step::close;
+            }
+            break;
+        case Step::fsync:
+            s.step = Step::close;
+            break;
+        case Step::close:
+            s.step = Step::rename;
+            break;
+        case Step::rename:
+            out.written (jobs[s.job].path, s.data.size ());
+            finished (index);
+            return;
+        }
+        queue (index);
+    };
+    auto reap = [&] {
+        io_uring_cqe cqe;
+        while (ring.pop (cqe))
+        {
+            complete (cqe);
+        }
+    };
+
+    std::size_t next = 0;
+    try
+    {
+        while (next < jobs.size () || busy > 0)
+        {
+            while (!idle.empty () && next < jobs.size ())
+            {
+                unsigned index = idle.back ();
+                idle.pop_back ();
+                ++busy;
+                Slot &s = slots[index];
+                s.job = next;
+                s.temp = temp_path (jobs[next].path);
+                s.fd = -1;
+                s.written = 0;
+                s.step = Step::open;
+                render (jobs[next++], options.format, s.data);
+                queue (index);
+                ring.submit (0);
+                reap ();
+            }
+            if (busy > 0)
+            {
+                ring.submit (1);
+                reap ();
+            }
+        }
+    }
+    catch (...)
+    {
+        // Let the operations in flight finish before the slots go.
+        abandon = true;
+        while (busy > 0)
+        {
+            ring.submit (1);
+            reap ();
+        }
+        throw;
+    }
+    return true;
+}
+#endif
+} // namespace
+
+bool
+io_uring_available ()
+{
+#if KEA_HAVE_IO_URING
+    static const bool available = [] {
+        try
+        {
+            return probe_io_uring ();
+        }
+        catch (const std::system_error &)
+        {
+            return false;
+        }
+    }();
+    return available;
+#else
+    return false;
+#endif
+}
+
+FleetWriteResult
+write_fleet (const std::vector<FleetJob> &jobs,
+             const FleetWriteOptions &options)
+{
+    for (const FleetJob &job : jobs)
+    {
+        if (job.config == nullptr)
+        {
+            throw std::invalid_argument ("no configuration for "
+                                         + job.path);
+        }
+    }
+
+    FleetWriteResult result;
+    result.backend = IoBackend::syscalls;
+    if (options.backend == IoBackend::io_uring
+        || (options.backend == IoBackend::automatic
+            && io_uring_available ()))
+    {
+        if (!io_uring_available ())
+        {
+            throw std::system_error (
+                std::make_error_code (
+                    std::errc::function_not_supported),
+                "io_uring");
+        }
+        result.backend = IoBackend::io_uring;
+    }
+
+    auto start = std::chrono::steady_clock::now ();
+    Outcome outcome;
+#if KEA_HAVE_IO_URING
+    if (result.backend == IoBackend::io_uring
+        && !write_with_io_uring (jobs, options, outcome))
+    {
+        // The ring could not be set up; nothing was written.
+        result.backend = IoBackend::syscalls;
+    }
+#endif
+    if (result.backend == IoBackend::syscalls)
+    {
+        write_with_syscalls (jobs, options, outcome);
+    }
+    if (options.sync)
+    {
+        sync_dirs (outcome.dirs);
+    }
+    std::chrono::duration<double> elapsed
+        = std::chrono::steady_clock::now () - start;
+
+    result.files = outcome.files;
+    result.bytes = outcome.bytes;
+    result.seconds = elapsed.count ();
+    if (result.seconds > 0)
+    {
+        result.files_per_second
+            = double (result.files) / result.seconds;
+    }
+    std::sort (outcome.failed.begin (), outcome.failed.end (),
+               [] (const auto &a, const auto &b) {
+                   return a.first < b.first;
+               });
+    for (const auto &f : outcome.failed)
+    {
+        result.failed.emplace_back (jobs[f.first].path, f.second);
+    }
+    return result;
+}
+} // namespace KeaGenerator
@@ -0,0 +1,83 @@
+// File: KeaFleetWriter.h
+#ifndef KEA_FLEET_WRITER_H
+#define KEA_FLEET_WRITER_H
+
+#include "KeaGenerator.h"
+#include "KeaStream.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace KeaGenerator
+{
+// --- Fleet output ---
+// Writes one configuration file per server. Every file goes to
+// "<path>.tmp", is flushed with fsync and then renamed over <path>,
+// so a reader sees either the old or the new file. The next files
+// are rendered while the I/O of earlier ones is in flight.
+//
+// The io_uring backend queues the open, write, fsync, close and
+// rename of many files at once and reaps them as they complete. The
+// syscall backend runs the same steps on a background thread.
+
+enum class IoBackend
+{
+    automatic, // io_uring if the kernel allows it, else syscalls.
+    io_uring,
+    syscalls,
+};
+
+// One file to write.
+struct FleetJob
+{
+    std::string path;
+    const KeaConfig *config = nullptr;
+};
+
+struct FleetWriteOptions
+{
+    IoBackend backend = IoBackend::automatic;
+    // Files rendered and in flight at once. io_uring lowers it to
+    // the largest ring the kernel accepts.
+    unsigned queue_depth = 32;
+    // fsync every file, and each directory once after the renames.
+    bool sync = true;
+    JsonFormat format;
+};
+
+struct FleetWriteResult
+{
+    IoBackend backend = IoBackend::syscalls; // The backend used.
+    std::size_t files = 0;                  // Files written.
+    uint64_t bytes = 0;                     // Bytes written.
+    double seconds = 0;                     // Rendering and I/O.
+    double files_per_second = 0;
+    // Files that could not be written, in job order. Their temporary
+    // file is removed and the previous file, if any, is kept.
+    std::vector<std::pair<std::string, std::error_code> > failed;
+
+    bool
+    ok () const
+    {
+        return failed.empty ();
+    }
+};
+
+// True if the kernel supports the io_uring operations the writer
+// needs. Containers often block io_uring with seccomp.
+bool io_uring_available ();
+
+// Writes every job. Failures of single files are reported in the
+// result; asking for IoBackend::io_uring where it is not available
+// throws std::system_error.
+FleetWriteResult write_fleet (const std::vector<FleetJob> &jobs,
+                              const FleetWriteOptions &options
+                              = FleetWriteOptions ());
+
+} // namespace KeaGenerator
+
+#endif // KEA_FLEET_WRITER_H
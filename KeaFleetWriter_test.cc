@@ -0,0 +1,176 @@
+#include "KeaFleetWriter.h"
+#include <gtest/gtest.h>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+using namespace KeaGenerator;
+
+static std::string
+Render (const KeaConfig &config)
+{
+    std::ostringstream out;
+    write_json (out, config, JsonFormat::kea ());
+    return out.str ();
+}
+
+static std::string
+Slurp (const std::string &path)
+{
+    std::ifstream in (path);
+    std::ostringstream out;
+    out << in.rdbuf ();
+    return out.str ();
+}
+
+class KeaFleetWriterTest : public ::testing::Test
+{
+  protected:
+    void
+    SetUp () override
+    {
+        char path[] = "/tmp/kea-fleet-XXXXXX";
+        ASSERT_NE (mkdtemp (path), nullptr);
+        dir = path;
+        configs.resize (200);
+        for (std::size_t i = 0; i < configs.size (); ++i)
+        {
+            Subnet4 &s = configs[i].dhcp4.subnet4;
+            // At least two subnets, as the second round drops one.
+            for (std::size_t j = 0; j < i % 7 + 2; ++j)
+            {
+                std::string net = "10." + std::to_string (i % 250)
+                                  + "." + std::to_string (j) + ".";
+                uint64_t id = s.add_config (net + "0/24");
+                s.add_pool_for_cfg (id, net + "10", net + "200");
+            }
+            jobs.push_back ({ dir + "/server-" + std::to_string (i)
+                                  + ".json",
+                              &configs[i] });
+        }
+        options.format = JsonFormat::kea ();
+        options.queue_depth = 8;
+    }
+
+    void
+    TearDown () override
+    {
+        for (const std::string &name : Entries ())
+        {
+            std::remove ((dir + "/" + name).c_str ());
+        }
+        rmdir (dir.c_str ());
+    }
+
+    std::vector<std::string>
+    Entries () const
+    {
+        std::vector<std::string> names;
+        if (DIR *d = opendir (dir.c_str ()))
+        {
+            while (dirent *e = readdir (d))
+            {
+                std::string name = e->d_name;
+                if (name != "." && name != "..")
+                {
+                    names.push_back (name);
+                }
+            }
+            closedir (d);
+        }
+        return names;
+    }
+
+    // Writes the fleet twice, the second time over the first files,
+    // and checks every file and that no temporary file is left.
+    void
+    WriteAndCheck ()
+    {
+        for (int round = 0; round < 2; ++round)
+        {
+            FleetWriteResult r = write_fleet (jobs, options);
+            EXPECT_EQ (r.backend, options.backend);
+            ASSERT_TRUE (r.ok ()) << r.failed[0].first << ": "
+                                  << r.failed[0].second.message ();
+            EXPECT_EQ (r.files, jobs.size ());
+            EXPECT_GT (r.files_per_second, 0);
+            uint64_t bytes = 0;
+            for (std::size_t i = 0; i < jobs.size (); ++i)
+            {
+                std::string expected = Render (configs[i]);
+                EXPECT_EQ (Slurp (jobs[i].path), expected);
+                bytes += expected.size ();
+            }
+            EXPECT_EQ (r.bytes, bytes);
+            EXPECT_EQ (Entries ().size (), jobs.size ());
+            // Shrinks every file for the second round.
+            for (KeaConfig &config : configs)
+            {
+                Subnet4 &s = config.dhcp4.subnet4;
+                s.cfgs.erase (s.cfgs.begin ());
+            }
+        }
+    }
+
+    std::string dir;
+    std::vector<KeaConfig> configs;
+    std::vector<FleetJob> jobs;
+    FleetWriteOptions options;
+};
+
+TEST_F (KeaFleetWriterTest, Syscalls)
+{
+    options.backend = IoBackend::syscalls;
+    WriteAndCheck ();
+}
+
+TEST_F (KeaFleetWriterTest, IoUring)
+{
+    if (!io_uring_available ())
+    {
+        GTEST_SKIP () << "io_uring is not available";
+    }
+    options.backend = IoBackend::io_uring;
+    WriteAndCheck ();
+}
+
+// Test that a queue depth above the kernel's limit is lowered
+TEST_F (KeaFleetWriterTest, IoUringDeepQueue)
+{
+    if (!io_uring_available ())
+    {
+        GTEST_SKIP () << "io_uring is not available";
+    }
+    options.backend = IoBackend::io_uring;
+    options.queue_depth = 1u << 30;
+    WriteAndCheck ();
+}
+
+TEST_F (KeaFleetWriterTest, FailedFiles)
+{
+    jobs[3].path = dir + "/missing/server-3.json";
+    jobs[150].path = dir + "/missing/server-150.json";
+    for (IoBackend backend :
+         { IoBackend::syscalls, IoBackend::io_uring })
+    {
+        if (backend == IoBackend::io_uring && !io_uring_available ())
+        {
+            continue;
+        }
+        options.backend = backend;
+        FleetWriteResult r = write_fleet (jobs, options);
+        EXPECT_FALSE (r.ok ());
+        EXPECT_EQ (r.files, jobs.size () - 2);
+        ASSERT_EQ (r.failed.size (), 2u);
+        EXPECT_EQ (r.failed[0].first, jobs[3].path);
+        EXPECT_EQ (r.failed[1].first, jobs[150].path);
+        EXPECT_EQ (r.failed[0].second,
+                   std::errc::no_such_file_or_directory);
+        EXPECT_EQ (Entries ().size (), jobs.size () - 2);
+    }
+
+    jobs[0].config = nullptr;
+    EXPECT_THROW (write_fleet (jobs, options), std::invalid_argument);
+}
@@ -1,7 +1,38 @@
 #include "KeaGenerator.h"
+#include "KeaJson.h"
+
+#include <iostream>
 
 namespace KeaGenerator
 {
+// Dhcp4 constructor, kept out of line so the model header does not
+// need <iostream>.
+Dhcp4::Dhcp4 (const uint64_t &lifetime,
+              std::initializer_list<std::string> interfaces_init_list,
+              std::string lease_type, bool lease_persist,
+              std::string lease_name)
+    : valid_lifetime (lifetime), // Set lease lifetime
+      interface_config (
+          interfaces_init_list), // Initialize interfaces
+      lease_database (
+          std::move (lease_type), // Initialize lease database
+          lease_persist, std::move (lease_name)),
+      subnet4 (),    // Initialize subnets (empty)
+      option_data () // Initialize options (empty)
+{
+    // Basic validation: Ensure interfaces are provided.
+    if (interface_config.empty ())
+    {
+        // Consider throwing an exception or logging a critical
+        // error instead of just printing to cerr in a library
+        // context. throw std::runtime_error("InterfacesConfig
+        // cannot be empty for Dhcp4");
+        std::cerr << "[Warning] Dhcp4 created with empty "
+                     "interfaces-config."
+                  << std::endl;
+    }
+}
+
 // Converts InterfacesConfig to JSON format.
 // Expected JSON: { "interfaces": ["if1", "if2", ...] }
 void
@@ -36,11 +67,12 @@ to_json (nlohmann::json &j, const OptionData::Option &o)
 // Converts the entire OptionData structure to JSON format.
 // Expected JSON: [ { Option1 }, { Option2 }, ... ] (Array of Option
 // objects)
+template <class Storage>
 void
-to_json (nlohmann::json &j, const OptionData &o)
+to_json (nlohmann::json &j, const BasicOptionData<Storage> &o)
 {
-    // nlohmann/json automatically handles serialization of
-    // std::set<Option>.
+    // nlohmann/json automatically handles serialization of the
+    // option set of any storage policy.
     j = o.options;
 }
 
@@ -52,27 +84,48 @@ to_json (nlohmann::json &j, const Subnet4::Pool &p)
     j = nlohmann::json{ { "pool", p.range } };
 }
 
+// Converts Subnet4::Reservation to JSON format.
+// Expected JSON: { "hw-address": "...", "ip-address": "...",
+// "hostname": "..." } (hostname only if set)
+void
+to_json (nlohmann::json &j, const Subnet4::Reservation &r)
+{
+    j = nlohmann::json{ { "hw-address", r.hw_address },
+                        { "ip-address", r.ip_address } };
+    if (!r.hostname.empty ())
+    {
+        j["hostname"] = r.hostname;
+    }
+}
+
 // Converts Subnet4::Cfg to JSON format.
 // Expected JSON: { "id": ..., "subnet": "...", "pools": [ { "pool":
-// "..." }, ... ] }
+// "..." }, ... ], "reservations": [ ... ] } (reservations only if
+// there are any)
+template <class Storage>
 void
-to_json (nlohmann::json &j, const Subnet4::Cfg &c)
+to_json (nlohmann::json &j, const BasicSubnet4Cfg<Storage> &c)
 {
     j = nlohmann::json{
         { "id", c.id }, { "subnet", c.subnet }, { "pools", c.pools }
     }; // nlohmann/json handles set<Pool> serialization
+    if (!c.reservations.empty ())
+    {
+        j["reservations"] = c.reservations;
+    }
 }
 
 // Converts the entire Subnet4 structure to JSON format.
 // Expected JSON: [ { Cfg1 }, { Cfg2 }, ... ] (Array of Cfg objects)
+template <class Storage>
 void
-to_json (nlohmann::json &j, const Subnet4 &s)
+to_json (nlohmann::json &j, const BasicSubnet4<Storage> &s)
 {
     // Create a temporary vector to hold Cfg objects for
     // serialization. The order in the final JSON array might not be
     // guaranteed due to unordered_map iteration. If consistent order
     // is needed, consider sorting by ID here or using std::map.
-    std::vector<Subnet4::Cfg> cfg_vector;
+    std::vector<typename BasicSubnet4<Storage>::Cfg> cfg_vector;
     cfg_vector.reserve (
         s.cfgs.size ()); // Reserve space for efficiency
     for (const auto &pair : s.cfgs)
@@ -157,4 +210,19 @@ to_json (nlohmann::json &j, const KeaConfig &k)
     // Create the top-level object with the "Dhcp4" key.
     j = nlohmann::json{ { "Dhcp4", k.dhcp4 } };
 }
+
+// Explicit instantiations for the shipped storage policies.
+#define KEA_INSTANTIATE_TO_JSON(Storage)                             \
+    template void to_json (nlohmann::json &,                         \
+                           const BasicOptionData<Storage> &);        \
+    template void to_json (nlohmann::json &,                         \
+                           const BasicSubnet4Cfg<Storage> &);        \
+    template void to_json (nlohmann::json &,                         \
+                           const BasicSubnet4<Storage> &);
+
+KEA_INSTANTIATE_TO_JSON (NodeStorage)
+KEA_INSTANTIATE_TO_JSON (FlatStorage)
+KEA_INSTANTIATE_TO_JSON (PmrStorage)
+
+#undef KEA_INSTANTIATE_TO_JSON
 }
\ No newline at end of file
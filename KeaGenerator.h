@@ -1,14 +1,18 @@
 // File: KeaGenerator.h
+// Configuration model. JSON serialization lives in KeaJson.h, so
+// code that only builds or inspects the model does not pull in
+// nlohmann/json.
 #ifndef KEA_GENERATOR_H
 #define KEA_GENERATOR_H
 
+#include "KeaAddress.h"
+#include "KeaStorage.h"
+
+#include <algorithm>
 #include <cstdint>
 #include <initializer_list>
-#include <iostream>
-#include <nlohmann/json.hpp>
-#include <set>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -37,9 +41,6 @@ struct InterfacesConfig
 
     // The list of interface names (e.g., "eth0", "ens192").
     std::vector<std::string> interfaces;
-
-    // JSON serialization support
-    friend void to_json (nlohmann::json &, const InterfacesConfig &);
 };
 
 // --- LeaseDatabase ---
@@ -66,24 +67,24 @@ struct LeaseDatabase
         return type.empty () || name.empty ();
     }
 
-    // JSON serialization support
-    friend void to_json (nlohmann::json &, const LeaseDatabase &);
-    operator nlohmann::json () const
-    {
-        nlohmann::json j;
-        to_json (j, *this);
-        return j;
-    }
-
     std::string type; // Type of database (e.g., "memfile", "mysql").
     bool persist;     // Should leases persist across restarts?
     std::string name; // Name/path/connection string for the database.
 };
 
 // --- Subnet4 ---
-// Manages IPv4 subnet configurations, including address pools.
-struct Subnet4
+// Policy-independent parts of Subnet4, shared by every storage
+// policy so pools can be moved between them unchanged.
+struct Subnet4Base
 {
+    // Lookup key for the pool "low - high", compared without building
+    // the range string.
+    struct PoolBounds
+    {
+        std::string_view low;
+        std::string_view high;
+    };
+
     // Represents a range of IP addresses available for lease within a
     // subnet.
     struct Pool
@@ -96,58 +97,240 @@ struct Subnet4
             return range < rhs.range;
         }
 
+        // Heterogeneous comparisons for the transparent std::less<>
+        // of the pool sets: by range string or by bounds.
+        friend bool
+        operator< (const Pool &p, std::string_view range)
+        {
+            return p.range < range;
+        }
+        friend bool
+        operator< (std::string_view range, const Pool &p)
+        {
+            return range < p.range;
+        }
+        friend bool
+        operator< (const Pool &p, const PoolBounds &b)
+        {
+            return compare_range (p.range, b) < 0;
+        }
+        friend bool
+        operator< (const PoolBounds &b, const Pool &p)
+        {
+            return compare_range (p.range, b) > 0;
+        }
+
         // The pool range string (e.g., "192.168.1.100 -
         // 192.168.1.200").
         std::string range;
+    };
+
+    // A host reservation: a fixed address handed to the client with
+    // the given hardware address.
+    struct Reservation
+    {
+        // Orders reservations by hardware address, the client key.
+        bool
+        operator< (const Reservation &rhs) const
+        {
+            return hw_address < rhs.hw_address;
+        }
+        friend bool
+        operator< (const Reservation &r, std::string_view hw_address)
+        {
+            return r.hw_address < hw_address;
+        }
+        friend bool
+        operator< (std::string_view hw_address, const Reservation &r)
+        {
+            return hw_address < r.hw_address;
+        }
 
-        // JSON serialization support
-        friend void to_json (nlohmann::json &, const Pool &);
+        std::string hw_address; // e.g. "1a:1b:1c:1d:1e:1f".
+        std::string ip_address; // e.g. "192.168.1.10".
+        std::string hostname;   // Optional; empty if not set.
     };
 
-    // Represents the configuration for a single IPv4 subnet.
-    struct Cfg
+    // What add_config does with a prefix that already has a
+    // configuration.
+    enum class OnDuplicate
     {
-        uint64_t
-            id; // Unique identifier for the subnet configuration.
-        std::string subnet; // Subnet address and mask (e.g.,
-                            // "192.168.1.0/24").
-        std::set<Pool>
-            pools; // Set of address pools within this subnet.
+        reject,         // Add nothing and return 0.
+        return_existing // Add nothing and return the existing id.
+    };
 
-        // JSON serialization support
-        friend void to_json (nlohmann::json &, const Cfg &);
-        operator nlohmann::json () const
+    // Key of a prefix in the prefix index; host bits are cleared by
+    // parse_cidr, so every spelling of a prefix has the same key.
+    static uint64_t
+    prefix_key (const Ipv4Prefix &prefix)
+    {
+        return uint64_t (prefix.base) << 6 | prefix.length;
+    }
+
+    // Compares `range` with "low - high" as std::string_view::compare
+    // would, piece by piece.
+    static int
+    compare_range (std::string_view range, const PoolBounds &b)
+    {
+        const std::string_view parts[3] = { b.low, " - ", b.high };
+        for (std::string_view part : parts)
         {
-            nlohmann::json j;
-            to_json (j, *this);
-            return j;
+            int c = range.substr (0, part.size ()).compare (part);
+            if (c != 0)
+            {
+                return c;
+            }
+            range.remove_prefix (part.size ());
         }
-    };
+        return range.empty () ? 0 : 1;
+    }
+};
+
+// Represents the configuration for a single IPv4 subnet. Available
+// as Subnet4::Cfg (or BasicSubnet4<Storage>::Cfg).
+template <class Storage> struct BasicSubnet4Cfg
+{
+    using Pool = Subnet4Base::Pool;
+    using Reservation = Subnet4Base::Reservation;
+
+    uint64_t
+        id; // Unique identifier for the subnet configuration.
+    std::string subnet; // Subnet address and mask (e.g.,
+                        // "192.168.1.0/24").
+    typename Storage::template set<Pool>
+        pools; // Set of address pools within this subnet.
+    typename Storage::template set<Reservation>
+        reservations; // Host reservations, keyed by hw address.
+};
+
+// Manages IPv4 subnet configurations, including address pools. The
+// containers are chosen by the Storage policy (see KeaStorage.h);
+// Subnet4 is the default, node-based variant.
+template <class Storage = NodeStorage>
+struct BasicSubnet4 : Subnet4Base
+{
+    using Cfg = BasicSubnet4Cfg<Storage>;
 
     // Default constructor, initializes the next available ID to 1.
-    Subnet4 () : max_id (1) {}
+    BasicSubnet4 () : max_id (1) {}
+
+    // Converts from a Subnet4 using another storage policy. Ids are
+    // preserved. Sorted sources (pool sets, flat maps) are taken over
+    // in linear time.
+    template <class Other>
+    explicit BasicSubnet4 (const BasicSubnet4<Other> &other)
+        : max_id (other.max_id)
+    {
+        for (const auto &pair : other.cfgs)
+        {
+            const auto &c = pair.second;
+            Ipv4Prefix prefix;
+            if (parse_cidr (c.subnet, prefix))
+            {
+                by_prefix.emplace (prefix_key (prefix), pair.first);
+            }
+            cfgs.emplace (
+                pair.first,
+                Cfg{ c.id,
+                     c.subnet,
+                     { c.pools.begin (), c.pools.end () },
+                     { c.reservations.begin (),
+                       c.reservations.end () } });
+        }
+    }
 
     // Adds a new subnet configuration.
     // Takes the subnet string (e.g., "192.168.1.0/24") as input.
-    // Returns the unique ID assigned to the new configuration.
+    // Returns the unique ID assigned to the new configuration, or 0
+    // if the subnet is not a valid "a.b.c.d/len" prefix. A prefix
+    // that already has a configuration, in any spelling, is handled
+    // as `on_duplicate` says.
     uint64_t
-    add_config (std::string subnet)
+    add_config (std::string subnet,
+                OnDuplicate on_duplicate = OnDuplicate::reject)
     {
+        Ipv4Prefix prefix;
+        if (!parse_cidr (subnet, prefix))
+        {
+            return 0;
+        }
+        auto ins = by_prefix.emplace (prefix_key (prefix), max_id);
+        if (!ins.second)
+        {
+            return on_duplicate == OnDuplicate::return_existing
+                       ? ins.first->second
+                       : 0;
+        }
         uint64_t current_id
             = max_id++; // Get current ID and increment for next use
         // Create and insert the new configuration into the map.
-        cfgs[current_id] = Cfg{ current_id, std::move (subnet), {} };
+        cfgs[current_id]
+            = Cfg{ current_id, std::move (subnet), {}, {} };
         return current_id; // Return the ID of the newly added config
     }
 
+    // Adds a subnet configuration under a caller-chosen id, as kept
+    // by a SubnetIdMap. Ids handed out by add_config afterwards are
+    // above it. Returns false if the id is 0 or taken, the subnet
+    // is not a valid prefix or the prefix already has a
+    // configuration.
+    bool
+    add_config_with_id (uint64_t id, std::string subnet)
+    {
+        Ipv4Prefix prefix;
+        if (id == 0 || !parse_cidr (subnet, prefix)
+            || cfgs.count (id) > 0
+            || !by_prefix.emplace (prefix_key (prefix), id).second)
+        {
+            return false;
+        }
+        cfgs[id] = Cfg{ id, std::move (subnet), {}, {} };
+        if (id >= max_id)
+        {
+            max_id = id + 1;
+        }
+        return true;
+    }
+
+    // Adds a configuration built elsewhere, pools and reservations
+    // included, for bulk loads that fill configurations on other
+    // threads. It gets cfg.id, or the next id if that is 0. Returns
+    // the id, or 0 if the subnet is not a valid prefix, the id is
+    // taken or the prefix already has a configuration.
+    uint64_t
+    insert_config (Cfg cfg)
+    {
+        Ipv4Prefix prefix;
+        uint64_t id = cfg.id != 0 ? cfg.id : max_id;
+        if (!parse_cidr (cfg.subnet, prefix) || cfgs.count (id) > 0
+            || !by_prefix.emplace (prefix_key (prefix), id).second)
+        {
+            return 0;
+        }
+        cfg.id = id;
+        cfgs[id] = std::move (cfg);
+        if (id >= max_id)
+        {
+            max_id = id + 1;
+        }
+        return id;
+    }
+
     // Adds an address pool to an existing subnet configuration.
     // Takes the target configuration ID, low IP, and high IP of the
     // range. Returns true if the pool was added successfully, false
-    // if the cfg_id was not found.
+    // if the cfg_id was not found, an address is malformed or low is
+    // above high.
     bool
     add_pool_for_cfg (uint64_t cfg_id, std::string low,
                       std::string high)
     {
+        uint32_t first, last;
+        if (!parse_ipv4_pair (low, high, first, last) || first > last)
+        {
+            return false;
+        }
+
         // Find the configuration with the given ID.
         auto it = cfgs.find (cfg_id);
         if (it == cfgs.end ())
@@ -165,6 +348,213 @@ struct Subnet4
         return true;
     }
 
+    // Adds a host reservation to an existing subnet configuration.
+    // Returns false if the cfg_id was not found or the hardware
+    // address is already reserved in that subnet.
+    bool
+    add_reservation_for_cfg (uint64_t cfg_id, std::string hw_address,
+                             std::string ip_address,
+                             std::string hostname = "")
+    {
+        auto it = cfgs.find (cfg_id);
+        if (it == cfgs.end ())
+        {
+            return false;
+        }
+        return it->second.reservations
+            .insert ({ std::move (hw_address), std::move (ip_address),
+                       std::move (hostname) })
+            .second;
+    }
+
+    // Removes a subnet configuration with its pools and reservations.
+    // Its id is not handed out again. Returns false if cfg_id was not
+    // found.
+    bool
+    remove_config (uint64_t cfg_id)
+    {
+        auto it = cfgs.find (cfg_id);
+        if (it == cfgs.end ())
+        {
+            return false;
+        }
+        unindex (it->second);
+        cfgs.erase (it);
+        return true;
+    }
+
+    // Changes the subnet address of an existing configuration in
+    // place, keeping its id, pools and reservations. Returns false if
+    // cfg_id was not found, the subnet is not a valid prefix or
+    // another configuration has that prefix.
+    bool
+    update_config (uint64_t cfg_id, std::string subnet)
+    {
+        Ipv4Prefix prefix;
+        if (!parse_cidr (subnet, prefix))
+        {
+            return false;
+        }
+        auto it = cfgs.find (cfg_id);
+        if (it == cfgs.end ())
+        {
+            return false;
+        }
+        auto ins = by_prefix.emplace (prefix_key (prefix), cfg_id);
+        if (!ins.second && ins.first->second != cfg_id)
+        {
+            return false;
+        }
+        if (ins.second)
+        {
+            unindex (it->second);
+        }
+        it->second.subnet = std::move (subnet);
+        return true;
+    }
+
+    // Id of the configuration for the prefix in `subnet`, in any
+    // spelling ("10.0.0.7/24" finds "10.0.0.0/24"), or 0 if there is
+    // none or the subnet is not a valid prefix.
+    uint64_t
+    find_by_prefix (std::string_view subnet) const
+    {
+        Ipv4Prefix prefix;
+        if (!parse_cidr (subnet, prefix))
+        {
+            return 0;
+        }
+        auto it = by_prefix.find (prefix_key (prefix));
+        return it == by_prefix.end () ? 0 : it->second;
+    }
+
+    // The configuration for the prefix in `subnet`, in any spelling,
+    // or nullptr if there is none. Allocates nothing.
+    const Cfg *
+    find_subnet (std::string_view subnet) const
+    {
+        auto it = cfgs.find (find_by_prefix (subnet));
+        return it == cfgs.end () ? nullptr : &it->second;
+    }
+
+    // Checks whether a subnet configuration has the pool "low -
+    // high", or the pool with the given range string. Allocates
+    // nothing.
+    bool
+    has_pool (uint64_t cfg_id, std::string_view low,
+              std::string_view high) const
+    {
+        auto it = cfgs.find (cfg_id);
+        return it != cfgs.end ()
+               && it->second.pools.count (PoolBounds{ low, high })
+                      > 0;
+    }
+    bool
+    has_pool (uint64_t cfg_id, std::string_view range) const
+    {
+        auto it = cfgs.find (cfg_id);
+        return it != cfgs.end ()
+               && it->second.pools.count (range) > 0;
+    }
+
+    // Rebuilds the prefix index after `cfgs` was edited directly.
+    // Where two configurations share a prefix the lower id is
+    // indexed; returns false if that happened.
+    bool
+    reindex ()
+    {
+        by_prefix.clear ();
+        bool unique = true;
+        for (const auto &pair : cfgs)
+        {
+            Ipv4Prefix prefix;
+            if (!parse_cidr (pair.second.subnet, prefix))
+            {
+                continue;
+            }
+            auto ins
+                = by_prefix.emplace (prefix_key (prefix), pair.first);
+            if (!ins.second)
+            {
+                unique = false;
+                ins.first->second
+                    = std::min (ins.first->second, pair.first);
+            }
+        }
+        return unique;
+    }
+
+    // Removes the pool "low - high" from a subnet configuration.
+    // Returns false if cfg_id or the pool was not found.
+    bool
+    remove_pool_for_cfg (uint64_t cfg_id, std::string_view low,
+                         std::string_view high)
+    {
+        auto it = cfgs.find (cfg_id);
+        if (it == cfgs.end ())
+        {
+            return false;
+        }
+        auto &pools = it->second.pools;
+        auto pos = pools.find (PoolBounds{ low, high });
+        if (pos == pools.end ())
+        {
+            return false;
+        }
+        pools.erase (pos);
+        return true;
+    }
+
+    // Removes the reservation for a hardware address from a subnet
+    // configuration. Returns false if cfg_id or the reservation was
+    // not found.
+    bool
+    remove_reservation_for_cfg (uint64_t cfg_id,
+                                std::string_view hw_address)
+    {
+        auto it = cfgs.find (cfg_id);
+        if (it == cfgs.end ())
+        {
+            return false;
+        }
+        auto &reservations = it->second.reservations;
+        auto pos = reservations.find (hw_address);
+        if (pos == reservations.end ())
+        {
+            return false;
+        }
+        reservations.erase (pos);
+        return true;
+    }
+
+    // Replaces the address and hostname reserved for a hardware
+    // address. Returns false if cfg_id or the reservation was not
+    // found; use add_reservation_for_cfg for new clients.
+    bool
+    update_reservation_for_cfg (uint64_t cfg_id,
+                                std::string hw_address,
+                                std::string ip_address,
+                                std::string hostname = "")
+    {
+        auto it = cfgs.find (cfg_id);
+        if (it == cfgs.end ())
+        {
+            return false;
+        }
+        auto &reservations = it->second.reservations;
+        Reservation r{ std::move (hw_address), std::move (ip_address),
+                       std::move (hostname) };
+        // Set elements are immutable; the entry is replaced.
+        auto pos = reservations.find (r);
+        if (pos == reservations.end ())
+        {
+            return false;
+        }
+        reservations.erase (pos);
+        reservations.insert (std::move (r));
+        return true;
+    }
+
     // Checks if there are any subnet configurations defined.
     // Returns true if no configurations exist, false otherwise.
     bool
@@ -173,19 +563,39 @@ struct Subnet4
         return cfgs.empty ();
     }
 
-    // JSON serialization support
-    friend void to_json (nlohmann::json &, const Subnet4 &);
-
     // Counter to generate unique IDs for subnet configurations.
     // Starts at 1.
     uint64_t max_id;
     // Map storing subnet configurations, keyed by their unique ID.
-    std::unordered_map<uint64_t, Cfg> cfgs;
+    typename Storage::template map<uint64_t, Cfg> cfgs;
+    // Prefix index: prefix_key () of each subnet to its id. Kept up
+    // to date by the member functions; code that edits `cfgs`
+    // directly calls reindex () afterwards.
+    typename Storage::template map<uint64_t, uint64_t> by_prefix;
+
+  private:
+    // Drops the index entry of `cfg`, if it is the indexed one.
+    void
+    unindex (const Cfg &cfg)
+    {
+        Ipv4Prefix prefix;
+        if (!parse_cidr (cfg.subnet, prefix))
+        {
+            return;
+        }
+        auto it = by_prefix.find (prefix_key (prefix));
+        if (it != by_prefix.end () && it->second == cfg.id)
+        {
+            by_prefix.erase (it);
+        }
+    }
 };
 
+using Subnet4 = BasicSubnet4<>;
+
 // --- OptionData ---
-// Manages DHCP options to be sent to clients.
-struct OptionData
+// Policy-independent parts of OptionData.
+struct OptionDataBase
 {
     // Represents a single DHCP option.
     struct Option
@@ -204,38 +614,110 @@ struct OptionData
         {
             return name < rhs.name;
         }
-
-        // JSON serialization support
-        friend void to_json (nlohmann::json &, const Option &);
-        operator nlohmann::json () const
+        friend bool
+        operator< (const Option &o, std::string_view name)
+        {
+            return o.name < name;
+        }
+        friend bool
+        operator< (std::string_view name, const Option &o)
         {
-            nlohmann::json j;
-            to_json (j, *this);
-            return j;
+            return name < o.name;
         }
     };
 
+    // What add_option does with a name that already has an option.
+    enum class OnDuplicate
+    {
+        keep,   // Leave the existing option as it is.
+        replace // Replace its data and always_send flag.
+    };
+};
+
+// Manages DHCP options to be sent to clients. The option set is
+// chosen by the Storage policy; OptionData is the default variant.
+template <class Storage = NodeStorage>
+struct BasicOptionData : OptionDataBase
+{
     // Default constructor.
-    OptionData () = default;
+    BasicOptionData () = default;
+
+    // Converts from an OptionData using another storage policy.
+    template <class Other>
+    explicit BasicOptionData (const BasicOptionData<Other> &other)
+        : options (other.options.begin (), other.options.end ())
+    {
+    }
 
     // Adds an option that should always be sent.
-    void
-    add_option_always (std::string name, std::string data)
+    bool
+    add_option_always (std::string name, std::string data,
+                       OnDuplicate on_duplicate = OnDuplicate::keep)
     {
         // Delegates to the main add_option method with always_send =
         // true.
-        add_option (std::move (name), std::move (data), true);
+        return add_option (std::move (name), std::move (data), true,
+                           on_duplicate);
     }
 
-    // Adds a DHCP option.
-    void
-    add_option (std::string name, std::string data, bool always_send)
+    // Adds a DHCP option. An option with the same name is kept by
+    // default, or replaced (an upsert) with OnDuplicate::replace.
+    // Returns false if an existing option was kept.
+    bool
+    add_option (std::string name, std::string data, bool always_send,
+                OnDuplicate on_duplicate = OnDuplicate::keep)
     {
-        // Insert the new option into the set. If an option with the
-        // same name already exists, it won't be replaced due to
-        // std::set properties.
+        auto pos = options.find (std::string_view (name));
+        if (pos != options.end ())
+        {
+            if (on_duplicate == OnDuplicate::keep)
+            {
+                return false;
+            }
+            // Set elements are immutable; the entry is replaced.
+            options.erase (pos);
+        }
         options.insert (
             { std::move (name), std::move (data), always_send });
+        return true;
+    }
+
+    // The option with the given name, or nullptr if there is none.
+    // Allocates nothing.
+    const Option *
+    find_option (std::string_view name) const
+    {
+        auto pos = options.find (name);
+        return pos == options.end () ? nullptr : &*pos;
+    }
+
+    // Removes the option with the given name. Returns false if there
+    // is none.
+    bool
+    remove_option (std::string_view name)
+    {
+        auto pos = options.find (name);
+        if (pos == options.end ())
+        {
+            return false;
+        }
+        options.erase (pos);
+        return true;
+    }
+
+    // Replaces the data and always_send flag of an existing option.
+    // Returns false if no option has that name; add_option with
+    // OnDuplicate::replace also adds missing ones.
+    bool
+    update_option (std::string name, std::string data,
+                   bool always_send)
+    {
+        if (options.count (std::string_view (name)) == 0)
+        {
+            return false;
+        }
+        return add_option (std::move (name), std::move (data),
+                           always_send, OnDuplicate::replace);
     }
 
     // Checks if any options have been defined.
@@ -246,13 +728,12 @@ struct OptionData
         return options.empty ();
     }
 
-    // JSON serialization support
-    friend void to_json (nlohmann::json &, const OptionData &);
-
     // Set storing the configured DHCP options, ordered by name.
-    std::set<Option> options;
+    typename Storage::template set<Option> options;
 };
 
+using OptionData = BasicOptionData<>;
+
 // --- Dhcp4 ---
 // Top-level structure representing the Kea DHCPv4 service
 // configuration.
@@ -265,28 +746,7 @@ struct Dhcp4
            std::initializer_list<std::string> interfaces_init_list,
            std::string lease_type = "memfile",
            bool lease_persist = true,
-           std::string lease_name = "/var/lib/kea/dhcp4.leases")
-        : valid_lifetime (lifetime), // Set lease lifetime
-          interface_config (
-              interfaces_init_list), // Initialize interfaces
-          lease_database (
-              std::move (lease_type), // Initialize lease database
-              lease_persist, std::move (lease_name)),
-          subnet4 (),    // Initialize subnets (empty)
-          option_data () // Initialize options (empty)
-    {
-        // Basic validation: Ensure interfaces are provided.
-        if (interface_config.empty ())
-        {
-            // Consider throwing an exception or logging a critical
-            // error instead of just printing to cerr in a library
-            // context. throw std::runtime_error("InterfacesConfig
-            // cannot be empty for Dhcp4");
-            std::cerr << "[Warning] Dhcp4 created with empty "
-                         "interfaces-config."
-                      << std::endl;
-        }
-    }
+           std::string lease_name = "/var/lib/kea/dhcp4.leases");
 
     // Default constructor (maybe less useful here as
     // lifetime/interfaces are key)
@@ -296,9 +756,6 @@ struct Dhcp4
     {
     }
 
-    // JSON serialization support
-    friend void to_json (nlohmann::json &, const Dhcp4 &);
-
     uint64_t valid_lifetime; // Default lease duration in seconds.
     InterfacesConfig
         interface_config;         // Network interface configuration.
@@ -325,23 +782,9 @@ struct KeaConfig
     {
     }
 
-    // JSON serialization support
-    friend void to_json (nlohmann::json &, const KeaConfig &);
-
     Dhcp4 dhcp4; // The DHCPv4 service configuration block.
 };
 
-// Function declarations for JSON serialization
-void to_json (nlohmann::json &j, const InterfacesConfig &i);
-void to_json (nlohmann::json &j, const LeaseDatabase &l);
-void to_json (nlohmann::json &j, const OptionData::Option &o);
-void to_json (nlohmann::json &j, const OptionData &o);
-void to_json (nlohmann::json &j, const Subnet4::Pool &p);
-void to_json (nlohmann::json &j, const Subnet4::Cfg &c);
-void to_json (nlohmann::json &j, const Subnet4 &s);
-void to_json (nlohmann::json &j, const Dhcp4 &d);
-void to_json (nlohmann::json &j, const KeaConfig &k);
-
 } // namespace KeaGenerator
 
 #endif // KEA_GENERATOR_H
\ No newline at end of file
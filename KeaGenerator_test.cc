@@ -1,4 +1,5 @@
 #include "KeaGenerator.h"
+#include "KeaJson.h"
 #include <gtest/gtest.h>
 #include <set>
 #include <string>
@@ -211,6 +212,15 @@ TEST_F (KeaGeneratorTest, Subnet4_Management)
     bool added_invalid
         = s4.add_pool_for_cfg (999, "1.1.1.1", "1.1.1.1");
     EXPECT_FALSE (added_invalid);
+
+    // Malformed input is rejected without using an id
+    EXPECT_EQ (s4.add_config ("192.168.1.0"), 0);
+    EXPECT_EQ (s4.add_config ("192.168.1.0/33"), 0);
+    EXPECT_EQ (s4.max_id, 3);
+    EXPECT_FALSE (s4.add_pool_for_cfg (id1, "192.168.1.7", "x"));
+    EXPECT_FALSE (
+        s4.add_pool_for_cfg (id1, "192.168.1.9", "192.168.1.8"));
+    EXPECT_EQ (s4.cfgs[id1].pools.size (), 2);
 }
 
 // Test JSON serialization of Subnet4 (including nested Cfg and Pool)
@@ -276,6 +286,179 @@ TEST_F (KeaGeneratorTest, Subnet4_Serialization)
     AssertJsonEq (j_empty, expected_empty);
 }
 
+// Test host reservations and their serialization
+TEST_F (KeaGeneratorTest, Subnet4_Reservations)
+{
+    Subnet4 s4;
+    uint64_t id = s4.add_config ("192.168.1.0/24");
+    EXPECT_TRUE (s4.add_reservation_for_cfg (
+        id, "1a:1b:1c:1d:1e:1f", "192.168.1.10", "host-a"));
+    EXPECT_TRUE (s4.add_reservation_for_cfg (id, "0a:0b:0c:0d:0e:0f",
+                                             "192.168.1.11"));
+    // Same hardware address again, and an unknown subnet
+    EXPECT_FALSE (s4.add_reservation_for_cfg (id, "1a:1b:1c:1d:1e:1f",
+                                              "192.168.1.12"));
+    EXPECT_FALSE (s4.add_reservation_for_cfg (
+        999, "00:00:00:00:00:01", "10.0.0.1"));
+    ASSERT_EQ (s4.cfgs[id].reservations.size (), 2);
+
+    json j = s4;
+    // clang-format off
+    json expected_json = R"(
+        [
+            {
+                "id": 1,
+                "subnet": "192.168.1.0/24",
+                "pools": [],
+                "reservations": [
+                    { "hw-address": "0a:0b:0c:0d:0e:0f",
+                      "ip-address": "192.168.1.11" },
+                    { "hw-address": "1a:1b:1c:1d:1e:1f",
+                      "ip-address": "192.168.1.10",
+                      "hostname": "host-a" }
+                ]
+            }
+        ]
+    )"_json;
+    // clang-format on
+    AssertJsonEq (j, expected_json);
+}
+
+// Test removing and updating subnets, pools and reservations
+TEST_F (KeaGeneratorTest, Subnet4_RemoveAndUpdate)
+{
+    Subnet4 s4;
+    uint64_t a = s4.add_config ("192.168.1.0/24");
+    uint64_t b = s4.add_config ("192.168.2.0/24");
+    ASSERT_TRUE (
+        s4.add_pool_for_cfg (a, "192.168.1.10", "192.168.1.20"));
+    ASSERT_TRUE (
+        s4.add_pool_for_cfg (a, "192.168.1.30", "192.168.1.40"));
+    ASSERT_TRUE (s4.add_reservation_for_cfg (
+        a, "1a:1b:1c:1d:1e:1f", "192.168.1.5", "host-a"));
+
+    // Pools are named by their bounds
+    EXPECT_FALSE (s4.remove_pool_for_cfg (a, "192.168.1.10",
+                                          "192.168.1.21"));
+    EXPECT_FALSE (s4.remove_pool_for_cfg (b, "192.168.1.10",
+                                          "192.168.1.20"));
+    EXPECT_TRUE (s4.remove_pool_for_cfg (a, "192.168.1.10",
+                                         "192.168.1.20"));
+    ASSERT_EQ (s4.cfgs[a].pools.size (), 1);
+    EXPECT_EQ (s4.cfgs[a].pools.begin ()->range,
+               "192.168.1.30 - 192.168.1.40");
+
+    // Reservations are updated in place, keyed by hardware address
+    EXPECT_FALSE (s4.update_reservation_for_cfg (
+        a, "00:00:00:00:00:01", "192.168.1.6"));
+    EXPECT_TRUE (s4.update_reservation_for_cfg (
+        a, "1a:1b:1c:1d:1e:1f", "192.168.1.6"));
+    ASSERT_EQ (s4.cfgs[a].reservations.size (), 1);
+    EXPECT_EQ (s4.cfgs[a].reservations.begin ()->ip_address,
+               "192.168.1.6");
+    EXPECT_TRUE (s4.cfgs[a].reservations.begin ()->hostname.empty ());
+    EXPECT_FALSE (
+        s4.remove_reservation_for_cfg (b, "1a:1b:1c:1d:1e:1f"));
+    EXPECT_TRUE (
+        s4.remove_reservation_for_cfg (a, "1a:1b:1c:1d:1e:1f"));
+    EXPECT_TRUE (s4.cfgs[a].reservations.empty ());
+
+    // A subnet keeps its id and contents when its address changes
+    EXPECT_FALSE (s4.update_config (a, "192.168.1.0/33"));
+    EXPECT_FALSE (s4.update_config (99, "192.168.9.0/24"));
+    EXPECT_TRUE (s4.update_config (a, "192.168.3.0/24"));
+    EXPECT_EQ (s4.cfgs[a].subnet, "192.168.3.0/24");
+    EXPECT_EQ (s4.cfgs[a].pools.size (), 1);
+
+    // Removed ids are not handed out again
+    EXPECT_TRUE (s4.remove_config (b));
+    EXPECT_FALSE (s4.remove_config (b));
+    EXPECT_EQ (s4.cfgs.count (b), 0);
+    EXPECT_EQ (s4.add_config ("192.168.2.0/24"), 3);
+}
+
+// Test the prefix index and duplicate handling
+TEST_F (KeaGeneratorTest, Subnet4_PrefixIndex)
+{
+    Subnet4 s4;
+    uint64_t a = s4.add_config ("10.0.0.0/24");
+    uint64_t b = s4.add_config ("10.0.1.0/24");
+    ASSERT_NE (a, 0);
+    ASSERT_NE (b, 0);
+
+    // Any spelling of a prefix finds, and collides with, its subnet
+    EXPECT_EQ (s4.find_by_prefix ("10.0.0.99/24"), a);
+    EXPECT_EQ (s4.find_by_prefix ("10.0.0.0/25"), 0);
+    EXPECT_EQ (s4.find_by_prefix ("10.0.0.0"), 0);
+    EXPECT_EQ (s4.add_config ("10.0.0.7/24"), 0);
+    EXPECT_EQ (s4.add_config ("10.0.1.0/24",
+                              Subnet4::OnDuplicate::return_existing),
+               b);
+    EXPECT_FALSE (s4.add_config_with_id (10, "10.0.1.0/24"));
+    EXPECT_EQ (s4.cfgs.size (), 2);
+    EXPECT_EQ (s4.max_id, 3);
+
+    // Updates move the index entry, and may respell the same prefix
+    EXPECT_FALSE (s4.update_config (a, "10.0.1.0/24"));
+    EXPECT_TRUE (s4.update_config (a, "10.0.0.1/24"));
+    EXPECT_EQ (s4.find_by_prefix ("10.0.0.0/24"), a);
+    EXPECT_TRUE (s4.update_config (a, "10.0.2.0/24"));
+    EXPECT_EQ (s4.find_by_prefix ("10.0.0.0/24"), 0);
+    EXPECT_EQ (s4.find_by_prefix ("10.0.2.0/24"), a);
+    uint64_t c = s4.add_config ("10.0.0.0/24");
+    EXPECT_NE (c, 0);
+
+    // Removal frees the prefix, not the id
+    EXPECT_TRUE (s4.remove_config (b));
+    EXPECT_EQ (s4.find_by_prefix ("10.0.1.0/24"), 0);
+    EXPECT_GT (s4.add_config ("10.0.1.0/24"), c);
+
+    // Direct edits of cfgs need a reindex
+    s4.cfgs[a].subnet = "10.0.0.0/24";
+    EXPECT_FALSE (s4.reindex ());
+    EXPECT_EQ (s4.find_by_prefix ("10.0.0.0/24"), a);
+    EXPECT_EQ (s4.find_by_prefix ("10.0.2.0/24"), 0);
+    EXPECT_EQ (s4.by_prefix.size (), 2);
+}
+
+// Test lookups by string_view
+TEST_F (KeaGeneratorTest, Subnet4_Lookups)
+{
+    Subnet4 s4;
+    uint64_t id = s4.add_config ("192.168.1.0/24");
+    s4.add_pool_for_cfg (id, "192.168.1.10", "192.168.1.20");
+    s4.add_pool_for_cfg (id, "192.168.1.100", "192.168.1.200");
+
+    const Subnet4::Cfg *cfg = s4.find_subnet ("192.168.1.1/24");
+    ASSERT_NE (cfg, nullptr);
+    EXPECT_EQ (cfg->id, id);
+    EXPECT_EQ (s4.find_subnet ("192.168.2.0/24"), nullptr);
+    EXPECT_EQ (s4.find_subnet ("not a subnet"), nullptr);
+
+    EXPECT_TRUE (s4.has_pool (id, "192.168.1.10", "192.168.1.20"));
+    EXPECT_TRUE (s4.has_pool (id, "192.168.1.10 - 192.168.1.20"));
+    EXPECT_TRUE (s4.has_pool (id, "192.168.1.100", "192.168.1.200"));
+    // Bounds that are a prefix of, or extend, a stored range
+    EXPECT_FALSE (s4.has_pool (id, "192.168.1.10", "192.168.1.2"));
+    EXPECT_FALSE (s4.has_pool (id, "192.168.1.10", "192.168.1.200"));
+    EXPECT_FALSE (s4.has_pool (id, "192.168.1.1", "192.168.1.20"));
+    EXPECT_FALSE (s4.has_pool (id + 1, "192.168.1.10",
+                               "192.168.1.20"));
+
+    // Bounds order exactly like the range strings they spell
+    using Bounds = Subnet4::PoolBounds;
+    Subnet4::Pool p{ "10.0.0.1 - 10.0.0.9" };
+    Bounds same{ "10.0.0.1", "10.0.0.9" };
+    Bounds longer{ "10.0.0.1", "10.0.0.90" };
+    Bounds shorter{ "10.0.0.1", "10.0.0.1" };
+    Bounds empty{ "10.0.0.1", "" };
+    EXPECT_TRUE (p < longer);
+    EXPECT_TRUE (shorter < p);
+    EXPECT_TRUE (empty < p);
+    EXPECT_FALSE (p < same);
+    EXPECT_FALSE (same < p);
+}
+
 // --- OptionData Tests ---
 
 // Test Option comparison operator (used by std::set)
@@ -329,6 +512,53 @@ TEST_F (KeaGeneratorTest, OptionData_Management)
     EXPECT_FALSE (it_router->always_send); // Original always_send
 }
 
+// Test removing and updating options
+TEST_F (KeaGeneratorTest, OptionData_RemoveAndUpdate)
+{
+    OptionData od;
+    od.add_option ("routers", "192.168.1.1", false);
+    od.add_option_always ("domain-name", "example.com");
+
+    // Only existing options are updated
+    EXPECT_FALSE (od.update_option ("time-offset", "3600", false));
+    EXPECT_TRUE (od.update_option ("routers", "192.168.2.1", true));
+    ASSERT_EQ (od.options.size (), 2);
+    auto it = od.options.find ({ "routers", "", false });
+    ASSERT_NE (it, od.options.end ());
+    EXPECT_EQ (it->data, "192.168.2.1");
+    EXPECT_TRUE (it->always_send);
+
+    EXPECT_FALSE (od.remove_option ("time-offset"));
+    EXPECT_TRUE (od.remove_option ("domain-name"));
+    EXPECT_TRUE (od.remove_option ("routers"));
+    EXPECT_TRUE (od.empty ());
+}
+
+// Test lookups by name and the replacing upsert
+TEST_F (KeaGeneratorTest, OptionData_LookupAndUpsert)
+{
+    OptionData od;
+    EXPECT_TRUE (od.add_option ("routers", "192.168.1.1", false));
+    EXPECT_EQ (od.find_option ("domain-name"), nullptr);
+    const OptionData::Option *o = od.find_option ("routers");
+    ASSERT_NE (o, nullptr);
+    EXPECT_EQ (o->data, "192.168.1.1");
+
+    // The existing option is kept unless replacing is asked for
+    EXPECT_FALSE (od.add_option ("routers", "192.168.2.1", true));
+    EXPECT_EQ (od.find_option ("routers")->data, "192.168.1.1");
+    EXPECT_TRUE (od.add_option ("routers", "192.168.2.1", true,
+                                OptionData::OnDuplicate::replace));
+    o = od.find_option ("routers");
+    ASSERT_NE (o, nullptr);
+    EXPECT_EQ (o->data, "192.168.2.1");
+    EXPECT_TRUE (o->always_send);
+    EXPECT_TRUE (od.add_option_always (
+        "domain-name", "example.com",
+        OptionData::OnDuplicate::replace));
+    EXPECT_EQ (od.options.size (), 2);
+}
+
 // Test JSON serialization of OptionData
 TEST_F (KeaGeneratorTest, OptionData_Serialization)
 {
@@ -0,0 +1,1059 @@
+#include "KeaImport.h"
+#include "KeaAddress.h"
+#include "KeaParallel.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace KeaGenerator
+{
+namespace
+{
+struct StagedSubnet
+{
+    std::size_t line; // Chunk-local until the merge.
+    uint64_t key;     // Subnet4::prefix_key.
+    Subnet4::Cfg cfg;
+};
+
+// What one worker makes of its slice of the input.
+struct Chunk
+{
+    std::vector<StagedSubnet> subnets;
+    std::size_t lines = 0;           // Lines, blank ones included.
+    std::size_t records = 0;         // Non-blank lines.
+    std::size_t skipped_options = 0; // option-data entries.
+    std::size_t error_line = 0; // Chunk-local; the chunk stops there.
+    std::string error;
+};
+
+// Reads one JSON document and hands its events to a handler with the
+// event methods of SchemaValidator, each returning false to stop.
+// Strings without escapes are passed as views into the input;
+// escaped ones are decoded into a scratch buffer first. Only what an
+// export line needs is kept: no DOM, no copies, one pass.
+template <class Handler>
+class JsonReader
+{
+  public:
+    JsonReader (std::string_view text, Handler &handler)
+        : text_ (text), h_ (handler)
+    {
+    }
+
+    // Reads the document. Returns false if the input is not JSON,
+    // with error() set, or if the handler stopped.
+    bool
+    read ()
+    {
+        skip_space ();
+        if (!value (0))
+        {
+            return false;
+        }
+        skip_space ();
+        return pos_ == text_.size () || fail ("trailing characters");
+    }
+
+    const std::string &
+    error () const
+    {
+        return error_;
+    }
+
+  private:
+    static constexpr int kMaxDepth = 64;
+
+    void
+    skip_space ()
+    {
+        while (pos_ < text_.size ()
+               && (text_[pos_] == ' ' || text_[pos_] == '\t'
+                   || text_[pos_] == '\r' || text_[pos_] == '\n'))
+        {
+            ++pos_;
+        }
+    }
+
+    bool
+    fail (const char *what)
+    {
+        error_ = "parse error at column " + std::to_string (pos_ + 1)
+                 + ": " + what;
+        return false;
+    }
+
+    bool
+    literal (std::string_view word)
+    {
+        if (text_.substr (pos_, word.size ()) != word)
+        {
+            return fail ("invalid literal");
+        }
+        pos_ += word.size ();
+        return true;
+    }
+
+    bool
+    value (int depth)
+    {
+        if (pos_ == text_.size ())
+        {
+            return fail ("unexpected end of input");
+        }
+        std::string_view s;
+        switch (text_[pos_])
+        {
+        case '{':
+            return depth < kMaxDepth ? object (depth)
+                                     : fail ("nested too deeply");
+        case '[':
+            return depth < kMaxDepth ? array (depth)
+                                     : fail ("nested too deeply");
+        case '"':
+            return string (s) && h_.string (s);
+        case 't':
+            return literal ("true") && h_.boolean (true);
+        case 'f':
+            return literal ("false") && h_.boolean (false);
+        case 'n':
+            return literal ("null") && h_.null ();
+        default:
+            return number ();
+        }
+    }
+
+    bool
+    object (int depth)
+    {
+        ++pos_;
+        if (!h_.begin_object ())
+        {
+            return false;
+        }
+        skip_space ();
+        if (pos_ < text_.size () && text_[pos_] == '}')
+        {
+            ++pos_;
+            return h_.end_object ();
+        }
+        for (;;)
+        {
+            std::string_view k;
+            skip_space ();
+            if (pos_ == text_.size () || text_[pos_] != '"')
+            {
+                return fail ("expected a member name");
+            }
+            if (!string (k) || !h_.key (k))
+            {
+                return false;
+            }
+            skip_space ();
+            if (pos_ == text_.size () || text_[pos_] != ':')
+            {
+                return fail ("expected ':'");
+            }
+            ++pos_;
+            skip_space ();
+            if (!value (depth + 1))
+            {
+                return false;
+            }
+            skip_space ();
+            if (pos_ < text_.size () && text_[pos_] == ',')
+            {
+                ++pos_;
+                continue;
+            }
+            if (pos_ < text_.size () && text_[pos_] == '}')
+            {
+                ++pos_;
+                return h_.end_object ();
+            }
+            return fail ("expected ',' or '}'");
+        }
+    }
+
+    bool
+    array (int depth)
+    {
+        ++pos_;
+        if (!h_.begin_array ())
+        {
+            return false;
+        }
+        skip_space ();
+        if (pos_ < text_.size () && text_[pos_] == ']')
+        {
+            ++pos_;
+            return h_.end_array ();
+        }
+        for (;;)
+        {
+            skip_space ();
+            if (!value (depth + 1))
+            {
+                return false;
+            }
+            skip_space ();
+            if (pos_ < text_.size () && text_[pos_] == ',')
+            {
+                ++pos_;
+                continue;
+            }
+            if (pos_ < text_.size () && text_[pos_] == ']')
+            {
+                ++pos_;
+                return h_.end_array ();
+            }
+            return fail ("expected ',' or ']'");
+        }
+    }
+
+    bool
+    hex4 (uint32_t &u)
+    {
+        if (text_.size () - pos_ < 4)
+        {
+            return fail ("truncated \\u escape");
+        }
+        u = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            char c = text_[pos_++];
+            u <<= 4;
+            if (c >= '0' && c <= '9')
+            {
+                u |= uint32_t (c - '0');
+            }
+            else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+            {
+                u |= uint32_t ((c | 0x20) - 'a' + 10);
+            }
+            else
+            {
+                return fail ("invalid \\u escape");
+            }
+        }
+        return true;
+    }
+
+    void
+    put_utf8 (uint32_t u)
+    {
+        if (u < 0x80)
+        {
+            scratch_ += char (u);
+            return;
+        }
+        if (u < 0x800)
+        {
+            scratch_ += char (0xc0 | u >> 6);
+        }
+        else
+        {
+            if (u < 0x10000)
+            {
+                scratch_ += char (0xe0 | u >> 12);
+            }
+            else
+            {
+                scratch_ += char (0xf0 | u >> 18);
+                scratch_ += char (0x80 | (u >> 12 & 0x3f));
+            }
+            scratch_ += char (0x80 | (u >> 6 & 0x3f));
+        }
+        scratch_ += char (0x80 | (u & 0x3f));
+    }
+
+    // Reads the string at pos_, the opening quote included.
+    bool
+    string (std::string_view &out)
+    {
+        std::size_t begin = ++pos_;
+        while (pos_ < text_.size () && text_[pos_] != '"'
+               && text_[pos_] != '\\'
+               && static_cast<unsigned char> (text_[pos_]) >= 0x20)
+        {
+            ++pos_;
+        }
+        if (pos_ < text_.size () && text_[pos_] == '"')
+        {
+            out = text_.substr (begin, pos_++ - begin);
+            return true;
+        }
+
+        scratch_.assign (text_.data () + begin, pos_ - begin);
+        while (pos_ < text_.size () && text_[pos_] != '"')
+        {
+            char c = text_[pos_++];
+            if (static_cast<unsigned char> (c) < 0x20)
+            {
+                --pos_;
+                return fail ("control character in string");
+            }
+            if (c != '\\')
+            {
+                scratch_ += c;
+                continue;
+            }
+            if (pos_ == text_.size ())
+            {
+                break;
+            }
+            uint32_t u;
+            switch (text_[pos_++])
+            {
+            case '"':
+                scratch_ += '"';
+                break;
+            case '\\':
+                scratch_ += '\\';
+                break;
+            case '/':
+                scratch_ += '/';
+                break;
+            case 'b':
+                scratch_ += '\b';
+                break;
+            case 'f':
+                scratch_ += '\f';
+                break;
+            case 'n':
+                scratch_ += '\n';
+                break;
+            case 'r':
+                scratch_ += '\r';
+                break;
+            case 't':
+                scratch_ += '\t';
+                break;
+            case 'u':
+                if (!hex4 (u))
+                {
+                    return false;
+                }
+                if (u >= 0xd800 && u < 0xdc00)
+                {
+                    uint32_t low;
+                    if (text_.substr (pos_, 2) != "\\u")
+                    {
+                        return fail ("unpaired surrogate");
+                    }
+                    pos_ += 2;
+                    if (!hex4 (low) || low < 0xdc00 || low >= 0xe000)
+                    {
+                        return fail ("unpaired surrogate");
+                    }
+                    u = 0x10000 + ((u - 0xd800) << 10)
+                        + (low - 0xdc00);
+                }
+                else if (u >= 0xdc00 && u < 0xe000)
+                {
+                    return fail ("unpaired surrogate");
+                }
+                put_utf8 (u);
+                break;
+            default:
+                return fail ("invalid escape");
+            }
+        }
+        if (pos_ == text_.size ())
+        {
+            return fail ("unterminated string");
+        }
+        ++pos_;
+        out = scratch_;
+        return true;
+    }
+
+    bool
+    digits ()
+    {
+        std::size_t begin = pos_;
+        while (pos_ < text_.size () && text_[pos_] >= '0'
+               && text_[pos_] <= '9')
+        {
+            ++pos_;
+        }
+        return pos_ > begin;
+    }
+
+    bool
+    number ()
+    {
+        bool negative = text_[pos_] == '-';
+        pos_ += negative;
+        std::size_t begin = pos_;
+        if (!digits ()
+            || (text_[begin] == '0' && pos_ - begin > 1))
+        {
+            return fail ("invalid number");
+        }
+        std::string_view integer = text_.substr (begin, pos_ - begin);
+        bool fraction = false;
+        if (pos_ < text_.size () && text_[pos_] == '.')
+        {
+            ++pos_;
+            fraction = true;
+            if (!digits ())
+            {
+                return fail ("invalid number");
+            }
+        }
+        if (pos_ < text_.size () && (text_[pos_] | 0x20) == 'e')
+        {
+            ++pos_;
+            fraction = true;
+            if (pos_ < text_.size ()
+                && (text_[pos_] == '+' || text_[pos_] == '-'))
+            {
+                ++pos_;
+            }
+            if (!digits ())
+            {
+                return fail ("invalid number");
+            }
+        }
+        if (fraction)
+        {
+            return h_.fractional_number ();
+        }
+        if (negative)
+        {
+            return h_.negative_number ();
+        }
+        uint64_t n = 0;
+        for (char c : integer)
+        {
+            unsigned d = unsigned (c - '0');
+            if (n > (UINT64_MAX - d) / 10)
+            {
+                return h_.fractional_number (); // Beyond 64 bits.
+            }
+            n = n * 10 + d;
+        }
+        return h_.number (n);
+    }
+
+    std::string_view text_;
+    std::size_t pos_ = 0;
+    Handler &h_;
+    std::string scratch_; // Decoded escaped string.
+    std::string error_;
+};
+
+// Builds the staged subnet and options of one line from JsonReader
+// events.
+class LineParser
+{
+  public:
+    // Parses `line` into `staged` and counts its option-data entries
+    // in `options`. Returns false, with error() set, if the line is
+    // rejected.
+    bool
+    parse (std::string_view line, StagedSubnet &staged,
+           std::size_t &options)
+    {
+        Subnet4::Cfg &cfg = staged.cfg;
+        cfg_ = &cfg;
+        options_ = &options;
+        stack_.clear ();
+        have_subnet_ = false;
+        error_.clear ();
+        JsonReader<LineParser> reader (line, *this);
+        if (!reader.read ())
+        {
+            return fail (reader.error ());
+        }
+        Ipv4Prefix prefix;
+        if (!have_subnet_)
+        {
+            return fail ("missing \"subnet\"");
+        }
+        if (!parse_cidr (cfg.subnet, prefix))
+        {
+            return fail ("malformed subnet \"" + cfg.subnet + "\"");
+        }
+        staged.key = Subnet4::prefix_key (prefix);
+        return true;
+    }
+
+    const std::string &
+    error () const
+    {
+        return error_;
+    }
+
+    bool
+    null ()
+    {
+        return scalar (Type::none) != Use::fail;
+    }
+    bool
+    boolean (bool)
+    {
+        // always-send is the only boolean, and options are skipped.
+        return scalar (Type::boolean) != Use::fail;
+    }
+    bool
+    number (uint64_t n)
+    {
+        Use use = scalar (Type::number);
+        if (use == Use::value)
+        {
+            // "id" is the only number; Kea subnet ids are 32-bit.
+            if (n == 0 || n > 0xffffffffu)
+            {
+                return fail ("id " + std::to_string (n)
+                             + " is out of range");
+            }
+            cfg_->id = n;
+        }
+        return use != Use::fail;
+    }
+    bool
+    negative_number ()
+    {
+        Use use = scalar (Type::number);
+        if (use == Use::value)
+        {
+            return fail ("negative id");
+        }
+        return use != Use::fail;
+    }
+    bool
+    fractional_number ()
+    {
+        return scalar (Type::none) != Use::fail;
+    }
+    bool
+    string (std::string_view s)
+    {
+        Use use = scalar (Type::string);
+        if (use != Use::value)
+        {
+            return use != Use::fail;
+        }
+        switch (stack_.back ())
+        {
+        case Ctx::subnet:
+            cfg_->subnet.assign (s);
+            have_subnet_ = true;
+            return true;
+        case Ctx::pool:
+            have_pool_ = true;
+            return add_pool (s);
+        case Ctx::pools:
+            return add_pool (s);
+        case Ctx::reservation:
+            (key_ == "hw-address"   ? hw_address_
+             : key_ == "ip-address" ? ip_address_
+                                    : hostname_)
+                .assign (s);
+            return true;
+        case Ctx::option:
+            have_name_ = have_name_ || key_ == "name";
+            return true;
+        default:
+            return true;
+        }
+    }
+    bool
+    begin_object ()
+    {
+        if (stack_.empty ())
+        {
+            stack_.push_back (Ctx::subnet);
+            return true;
+        }
+        switch (stack_.back ())
+        {
+        case Ctx::pools:
+            have_pool_ = false;
+            stack_.push_back (Ctx::pool);
+            return true;
+        case Ctx::reservations:
+            hw_address_.clear ();
+            ip_address_.clear ();
+            hostname_.clear ();
+            stack_.push_back (Ctx::reservation);
+            return true;
+        case Ctx::options:
+            have_name_ = false;
+            stack_.push_back (Ctx::option);
+            return true;
+        default:
+            return open (Type::object, Ctx::skip);
+        }
+    }
+    bool
+    key (std::string_view k)
+    {
+        key_.assign (k);
+        return true;
+    }
+    bool
+    end_object ()
+    {
+        Ctx ctx = stack_.back ();
+        stack_.pop_back ();
+        if (ctx == Ctx::pool && !have_pool_)
+        {
+            return fail ("pool without \"pool\"");
+        }
+        if (ctx == Ctx::reservation)
+        {
+            uint32_t addr;
+            if (hw_address_.empty ())
+            {
+                return fail ("reservation without \"hw-address\"");
+            }
+            if (!parse_ipv4 (ip_address_, addr))
+            {
+                return fail ("malformed ip-address \"" + ip_address_
+                             + "\"");
+            }
+            if (!cfg_->reservations
+                     .insert ({ hw_address_, ip_address_, hostname_ })
+                     .second)
+            {
+                return fail ("hw-address " + hw_address_
+                             + " is reserved twice");
+            }
+        }
+        else if (ctx == Ctx::option)
+        {
+            if (!have_name_)
+            {
+                return fail ("option without \"name\"");
+            }
+            ++*options_;
+        }
+        return true;
+    }
+    bool
+    begin_array ()
+    {
+        if (stack_.empty ())
+        {
+            return fail ("line is not an object");
+        }
+        Ctx ctx = Ctx::skip;
+        if (stack_.back () == Ctx::subnet)
+        {
+            ctx = key_ == "pools"          ? Ctx::pools
+                  : key_ == "reservations" ? Ctx::reservations
+                  : key_ == "option-data"  ? Ctx::options
+                                           : Ctx::skip;
+        }
+        return open (Type::array, ctx);
+    }
+    bool
+    end_array ()
+    {
+        stack_.pop_back ();
+        return true;
+    }
+
+  private:
+    enum class Ctx
+    {
+        subnet, // The line's object.
+        pools,
+        pool,
+        reservations,
+        reservation,
+        options,
+        option,
+        skip, // Inside an ignored member.
+    };
+    enum class Type
+    {
+        none, // Ignored, or a value no member may have.
+        string,
+        number,
+        boolean,
+        array,
+        object,
+    };
+    // What to do with a scalar.
+    enum class Use
+    {
+        fail,
+        ignore,
+        value,
+    };
+
+    // Type of member `key_` of the current object; none for members
+    // that are ignored.
+    Type
+    member_type () const
+    {
+        switch (stack_.back ())
+        {
+        case Ctx::subnet:
+            return key_ == "subnet" ? Type::string
+                   : key_ == "id"   ? Type::number
+                   : key_ == "pools" || key_ == "reservations"
+                           || key_ == "option-data"
+                       ? Type::array
+                       : Type::none;
+        case Ctx::pool:
+            return key_ == "pool" ? Type::string : Type::none;
+        case Ctx::reservation:
+            return key_ == "hw-address" || key_ == "ip-address"
+                           || key_ == "hostname"
+                       ? Type::string
+                       : Type::none;
+        case Ctx::option:
+            return key_ == "name" || key_ == "data" ? Type::string
+                   : key_ == "always-send"          ? Type::boolean
+                                                    : Type::none;
+        default:
+            return Type::none;
+        }
+    }
+
+    static const char *
+    type_name (Type t)
+    {
+        switch (t)
+        {
+        case Type::string:
+            return "a string";
+        case Type::number:
+            return "a number";
+        case Type::boolean:
+            return "a boolean";
+        default:
+            return "an array";
+        }
+    }
+
+    // Checks a value of type `t` at the current position.
+    Use
+    check (Type t)
+    {
+        switch (stack_.back ())
+        {
+        case Ctx::skip:
+            return Use::ignore;
+        case Ctx::pools:
+            if (t == Type::string || t == Type::object)
+            {
+                return Use::value;
+            }
+            fail ("pools must hold ranges or objects");
+            return Use::fail;
+        case Ctx::reservations:
+        case Ctx::options:
+            if (t == Type::object)
+            {
+                return Use::value;
+            }
+            fail (std::string (stack_.back () == Ctx::options
+                                   ? "option-data"
+                                   : "reservations")
+                  + " must hold objects");
+            return Use::fail;
+        default:
+            break;
+        }
+        Type want = member_type ();
+        if (want == Type::none)
+        {
+            return Use::ignore;
+        }
+        if (want != t)
+        {
+            fail ("\"" + key_ + "\" must be " + type_name (want));
+            return Use::fail;
+        }
+        return Use::value;
+    }
+
+    Use
+    scalar (Type t)
+    {
+        if (stack_.empty ())
+        {
+            fail ("line is not an object");
+            return Use::fail;
+        }
+        return check (t);
+    }
+
+    // Enters a container of type `t`, as `ctx` if it is used.
+    bool
+    open (Type t, Ctx ctx)
+    {
+        Use use = check (t);
+        if (use == Use::fail)
+        {
+            return false;
+        }
+        stack_.push_back (use == Use::value ? ctx : Ctx::skip);
+        return true;
+    }
+
+    bool
+    add_pool (std::string_view text)
+    {
+        uint32_t low, high;
+        Ipv4Prefix prefix;
+        if (!parse_pool_range (text, low, high))
+        {
+            if (!parse_cidr (text, prefix))
+            {
+                return fail ("malformed pool \"" + std::string (text)
+                             + "\"");
+            }
+            low = prefix.base;
+            high = prefix.length == 0
+                       ? 0xffffffffu
+                       : prefix.base | (0xffffffffu >> prefix.length);
+        }
+        cfg_->pools.insert ({ format_pool_range (low, high) });
+        return true;
+    }
+
+    bool
+    fail (std::string error)
+    {
+        if (error_.empty ())
+        {
+            error_ = std::move (error);
+        }
+        return false;
+    }
+
+    std::vector<Ctx> stack_;
+    std::string key_;
+    Subnet4::Cfg *cfg_ = nullptr;
+    std::size_t *options_ = nullptr;
+    bool have_subnet_ = false;
+    bool have_pool_ = false;
+    bool have_name_ = false; // The option being read has a name.
+    // The reservation being read.
+    std::string hw_address_, ip_address_, hostname_;
+    std::string error_;
+};
+void
+parse_chunk (std::string_view data, Chunk &chunk)
+{
+    LineParser parser;
+    chunk.subnets.reserve (
+        std::count (data.begin (), data.end (), '\n') + 1);
+    std::size_t pos = 0;
+    while (pos < data.size ())
+    {
+        std::size_t eol = data.find ('\n', pos);
+        if (eol == std::string_view::npos)
+        {
+            eol = data.size ();
+        }
+        std::string_view line = data.substr (pos, eol - pos);
+        pos = eol + 1;
+        ++chunk.lines;
+        if (line.find_first_not_of (" \t\r")
+            == std::string_view::npos)
+        {
+            continue;
+        }
+        ++chunk.records;
+
+        StagedSubnet staged{ chunk.lines, 0, Subnet4::Cfg{} };
+        if (!parser.parse (line, staged, chunk.skipped_options))
+        {
+            chunk.error_line = chunk.lines;
+            chunk.error = parser.error ();
+            return;
+        }
+        chunk.subnets.push_back (std::move (staged));
+    }
+}
+
+bool
+fail (ImportResult &result, std::size_t line, std::string error)
+{
+    result.error_line = line;
+    result.error = std::move (error);
+    return false;
+}
+
+// Checks the staged lines against each other and `config`, then
+// applies them. Line numbers are global.
+bool
+merge (KeaConfig &config, std::vector<Chunk> &chunks,
+       ImportResult &result)
+{
+    Subnet4 &s = config.dhcp4.subnet4;
+    std::size_t staged = 0;
+    for (const Chunk &c : chunks)
+    {
+        staged += c.subnets.size ();
+    }
+    std::unordered_map<uint64_t, std::size_t> prefixes, ids;
+    prefixes.reserve (staged);
+    ids.reserve (staged);
+    for (const Chunk &c : chunks)
+    {
+        for (const StagedSubnet &sub : c.subnets)
+        {
+            const Subnet4::Cfg &cfg = sub.cfg;
+            if (s.by_prefix.count (sub.key) > 0)
+            {
+                return fail (result, sub.line,
+                             "subnet " + cfg.subnet
+                                 + " is already configured");
+            }
+            auto p = prefixes.emplace (sub.key, sub.line);
+            if (!p.second)
+            {
+                return fail (result, sub.line,
+                             "subnet " + cfg.subnet + " repeats line "
+                                 + std::to_string (p.first->second));
+            }
+            if (cfg.id == 0)
+            {
+                continue;
+            }
+            if (s.cfgs.count (cfg.id) > 0)
+            {
+                return fail (result, sub.line,
+                             "id " + std::to_string (cfg.id)
+                                 + " is already in use");
+            }
+            auto i = ids.emplace (cfg.id, sub.line);
+            if (!i.second)
+            {
+                return fail (result, sub.line,
+                             "id " + std::to_string (cfg.id)
+                                 + " repeats line "
+                                 + std::to_string (i.first->second));
+            }
+        }
+    }
+
+    // Subnets with an id first, so that add_config numbering starts
+    // above all of them.
+    s.cfgs.reserve (s.cfgs.size () + staged);
+    s.by_prefix.reserve (s.by_prefix.size () + staged);
+    for (bool with_id : { true, false })
+    {
+        for (Chunk &c : chunks)
+        {
+            for (StagedSubnet &sub : c.subnets)
+            {
+                if ((sub.cfg.id != 0) == with_id)
+                {
+                    s.insert_config (std::move (sub.cfg));
+                }
+            }
+        }
+    }
+    result.subnets = prefixes.size ();
+    return true;
+}
+} // namespace
+
+ImportResult
+import_jsonl (KeaConfig &config, std::string_view data,
+              unsigned threads)
+{
+    auto start = std::chrono::steady_clock::now ();
+    ImportResult result;
+    std::vector<std::string_view> slices
+        = split_lines (data, worker_count (threads));
+    std::vector<Chunk> chunks (slices.size ());
+    run_parallel (static_cast<unsigned> (slices.size ()),
+                  [&] (unsigned i) {
+                      parse_chunk (slices[i], chunks[i]);
+                  });
+
+    // Make line numbers global; the first failed chunk holds the
+    // first error.
+    bool parsed = true;
+    std::size_t offset = 0;
+    for (Chunk &c : chunks)
+    {
+        result.lines += c.records;
+        if (!c.error.empty ())
+        {
+            parsed = fail (result, offset + c.error_line, c.error);
+            break;
+        }
+        result.skipped_options += c.skipped_options;
+        for (StagedSubnet &staged : c.subnets)
+        {
+            staged.line += offset;
+        }
+        offset += c.lines;
+    }
+    result.applied = parsed && merge (config, chunks, result);
+
+    std::chrono::duration<double> elapsed
+        = std::chrono::steady_clock::now () - start;
+    result.seconds = elapsed.count ();
+    if (result.seconds > 0)
+    {
+        result.lines_per_second
+            = double (result.lines) / result.seconds;
+    }
+    return result;
+}
+
+ImportResult
+import_jsonl_file (KeaConfig &config, const std::string &path,
+                   unsigned threads)
+{
+    ImportResult result;
+    int fd = ::open (path.c_str (), O_RDONLY);
+    if (fd < 0)
+    {
+        result.error = path + ": " + std::strerror (errno);
+        return result;
+    }
+    struct stat st;
+    if (::fstat (fd, &st) != 0)
+    {
+        result.error = path + ": " + std::strerror (errno);
+        ::close (fd);
+        return result;
+    }
+    if (st.st_size == 0)
+    {
+        ::close (fd);
+        return import_jsonl (config, std::string_view (), threads);
+    }
+
+    std::size_t size = static_cast<std::size_t> (st.st_size);
+    void *data
+        = ::mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close (fd);
+    if (data == MAP_FAILED)
+    {
+        result.error = path + ": " + std::strerror (errno);
+        return result;
+    }
+    ::madvise (data, size, MADV_SEQUENTIAL);
+    result = import_jsonl (
+        config, std::string_view (static_cast<char *> (data), size),
+        threads);
+    ::munmap (data, size);
+    return result;
+}
+} // namespace KeaGenerator
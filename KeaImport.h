@@ -0,0 +1,66 @@
+// File: KeaImport.h
+#ifndef KEA_IMPORT_H
+#define KEA_IMPORT_H
+
+#include "KeaGenerator.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace KeaGenerator
+{
+// --- JSON Lines import ---
+// Loads an IPAM export holding one JSON object per line, one subnet
+// per object, in the form of a Kea subnet4 entry:
+//
+//   {"subnet": "10.0.0.0/24", "id": 7,
+//    "pools": [{"pool": "10.0.0.10 - 10.0.0.99"}, "10.0.0.128/26"],
+//    "reservations": [{"hw-address": "1a:1b:1c:1d:1e:1f",
+//                      "ip-address": "10.0.0.5", "hostname": "pc"}],
+//    "option-data": [{"name": "routers", "data": "10.0.0.1",
+//                     "always-send": true}]}
+//
+// "subnet" is required. Without an "id" the subnet is numbered by
+// Subnet4::add_config, in line order, after every line with an id.
+// A pool is a "low - high" range or a prefix, with or without the
+// {"pool": ...} wrapper. KeaConfig has no per-subnet options, so
+// option-data entries are checked and counted as skipped, leaving the
+// global option-data alone. Other members are ignored, and blank
+// lines are skipped.
+//
+// The input is split on line boundaries and every slice is parsed on
+// its own thread by a streaming JSON reader, which hands strings over
+// as views into the input, straight into staged subnet
+// configurations, pools and reservations included. The staged
+// subnets are then checked against each other and the configuration
+// and moved in with Subnet4::insert_config. Like apply_batch, the
+// import is a transaction: if any line is rejected, nothing is
+// applied.
+
+struct ImportResult
+{
+    bool applied = false;            // Every line was applied.
+    std::size_t lines = 0;           // Non-blank lines read.
+    std::size_t subnets = 0;         // Subnets added.
+    std::size_t skipped_options = 0; // option-data entries skipped.
+    std::size_t error_line = 0; // 1-based line of the first error.
+    std::string error;          // Description of the first error.
+    double seconds = 0;         // Parsing and merging.
+    double lines_per_second = 0;
+};
+
+// Imports JSON Lines held in memory into `config`, with `threads`
+// workers (0 uses one per hardware thread).
+ImportResult import_jsonl (KeaConfig &config, std::string_view data,
+                           unsigned threads = 0);
+
+// Imports a JSON Lines file, which is memory-mapped. If the file
+// cannot be read, error names it and error_line is 0.
+ImportResult import_jsonl_file (KeaConfig &config,
+                                const std::string &path,
+                                unsigned threads = 0);
+
+} // namespace KeaGenerator
+
+#endif // KEA_IMPORT_H
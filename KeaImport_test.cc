@@ -0,0 +1,213 @@
+#include "KeaImport.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace KeaGenerator;
+
+namespace
+{
+const char *kExport
+    = "{\"subnet\": \"10.0.0.0/24\", \"id\": 7, \"vlan\": [1, {}],\n"
+      "  \"pools\": [{\"pool\": \"10.0.0.10 - 10.0.0.99\"},"
+      " \"10.0.0.128/26\"],\n"
+      "  \"reservations\": [{\"hw-address\": \"1a:1b:1c:1d:1e:1f\","
+      " \"ip-address\": \"10.0.0.5\", \"hostname\": \"pc\"}],\n"
+      "  \"option-data\": [{\"name\": \"routers\","
+      " \"data\": \"10.0.0.1\", \"always-send\": true}]}\n"
+      "\n"
+      "{\"subnet\": \"10.0.1.0/24\", \"option-data\": [{\"name\":"
+      " \"routers\", \"data\": \"10.0.0.1\","
+      " \"always-send\": true}]}\n"
+      "{\"subnet\": \"10.0.2.9/24\", \"id\": 3}";
+} // namespace
+
+// Test an import with every kind of member
+TEST (KeaImportTest, Import)
+{
+    // The object spans lines here; make it one line per subnet
+    std::string data = kExport;
+    for (std::size_t i = 0; i + 1 < data.size (); ++i)
+    {
+        if (data[i] == '\n' && data[i + 1] == ' ')
+        {
+            data[i] = ' ';
+        }
+    }
+
+    for (unsigned threads : { 1u, 2u, 8u })
+    {
+        KeaConfig k;
+        ImportResult r = import_jsonl (k, data, threads);
+        ASSERT_TRUE (r.applied) << r.error_line << ": " << r.error;
+        EXPECT_EQ (r.lines, 3u);
+        EXPECT_EQ (r.subnets, 3u);
+        EXPECT_EQ (r.skipped_options, 2u);
+
+        const Subnet4 &s = k.dhcp4.subnet4;
+        ASSERT_EQ (s.cfgs.size (), 3u);
+        EXPECT_EQ (s.find_by_prefix ("10.0.0.0/24"), 7u);
+        EXPECT_EQ (s.find_by_prefix ("10.0.2.0/24"), 3u);
+        // Numbered after the explicit ids
+        EXPECT_EQ (s.find_by_prefix ("10.0.1.0/24"), 8u);
+        EXPECT_EQ (s.max_id, 9u);
+        EXPECT_EQ (s.cfgs.at (3).subnet, "10.0.2.9/24");
+
+        const Subnet4::Cfg &c = s.cfgs.at (7);
+        EXPECT_TRUE (s.has_pool (7, "10.0.0.10 - 10.0.0.99"));
+        EXPECT_TRUE (s.has_pool (7, "10.0.0.128 - 10.0.0.191"));
+        ASSERT_EQ (c.reservations.size (), 1u);
+        EXPECT_EQ (c.reservations.begin ()->hostname, "pc");
+        EXPECT_TRUE (k.dhcp4.option_data.empty ());
+    }
+}
+
+// Test that per-subnet options are skipped, not merged into the
+// global option-data
+TEST (KeaImportTest, SubnetOptions)
+{
+    KeaConfig k;
+    k.dhcp4.option_data.add_option ("routers", "192.168.0.1", false);
+    ImportResult r = import_jsonl (
+        k,
+        "{\"subnet\": \"10.0.0.0/24\", \"option-data\": [{\"name\":"
+        " \"routers\", \"data\": \"10.0.0.1\"}]}\n"
+        "{\"subnet\": \"10.0.1.0/24\", \"option-data\": [{\"name\":"
+        " \"routers\", \"data\": \"10.0.1.1\"},"
+        " {\"name\": \"domain-name\", \"data\": \"lab\"}]}",
+        2);
+    ASSERT_TRUE (r.applied) << r.error_line << ": " << r.error;
+    EXPECT_EQ (r.subnets, 2u);
+    EXPECT_EQ (r.skipped_options, 3u);
+    ASSERT_EQ (k.dhcp4.option_data.options.size (), 1u);
+    EXPECT_EQ (k.dhcp4.option_data.find_option ("routers")->data,
+               "192.168.0.1");
+}
+
+// Test JSON escapes, numbers and nesting in the reader
+TEST (KeaImportTest, Reader)
+{
+    KeaConfig k;
+    ImportResult r = import_jsonl (
+        k,
+        "{\"sub\\u006eet\": \"10.0.0.0/24\", \"x\": [-1.5e3, null,"
+        " 18446744073709551616, {\"a\": [true, false]}],"
+        " \"reservations\": [{\"hw-address\": \"aa\","
+        " \"ip-address\": \"10.0.0.5\","
+        " \"hostname\": \"caf\\u00e9 \\\"\\ud83d\\ude00\\\"\"}]}",
+        1);
+    ASSERT_TRUE (r.applied) << r.error;
+    const Subnet4::Cfg &c = k.dhcp4.subnet4.cfgs.at (1);
+    EXPECT_EQ (c.reservations.begin ()->hostname,
+               "caf\xc3\xa9 \"\xf0\x9f\x98\x80\"");
+
+    const char *bad[] = {
+        "{\"subnet\": \"10.0.0.0/24\"} x",
+        "{\"subnet\": \"10.0.0.0/24\", \"x\": 01}",
+        "{\"subnet\": \"10.0.0.0/24\", \"x\": \"\\ud83d\"}",
+        "{\"subnet\": \"10.0.0.0/24\", \"x\": \"\\q\"}",
+        "{\"subnet\": \"10.0.0.0/24\", \"x\": [1,]}",
+        "{\"subnet\": \"10.0.0.0/24\", \"x\": tru}",
+        "{\"subnet\": \"10.0.0.0/24\"",
+    };
+    for (const char *line : bad)
+    {
+        r = import_jsonl (k, line, 1);
+        EXPECT_FALSE (r.applied) << line;
+        EXPECT_EQ (r.error.find ("parse error at column "), 0u)
+            << line << ": " << r.error;
+    }
+}
+
+// Test that a rejected line leaves the configuration unchanged
+TEST (KeaImportTest, Errors)
+{
+    struct Case
+    {
+        const char *data;
+        std::size_t line;
+        const char *error;
+    };
+    const Case cases[] = {
+        { "{\"subnet\": \"10.0.0.0/24\"}\n[]", 2,
+          "line is not an object" },
+        { "{\"id\": 1}", 1, "missing \"subnet\"" },
+        { "{\"subnet\": \"10.0.0.0/33\"}", 1,
+          "malformed subnet \"10.0.0.0/33\"" },
+        { "{\"subnet\": \"10.0.0.0/24\", \"id\": \"1\"}", 1,
+          "\"id\" must be a number" },
+        { "{\"subnet\": \"10.0.0.0/24\", \"id\": 4294967296}", 1,
+          "id 4294967296 is out of range" },
+        { "{\"subnet\": \"10.0.0.0/24\", \"pools\": [\"x\"]}", 1,
+          "malformed pool \"x\"" },
+        { "{\"subnet\": \"10.0.0.0/24\", \"pools\": [{}]}", 1,
+          "pool without \"pool\"" },
+        { "{\"subnet\": \"10.0.0.0/24\", \"reservations\": "
+          "[{\"hw-address\": \"aa\", \"ip-address\": \"10.0.0.1\"},"
+          " {\"hw-address\": \"aa\", \"ip-address\": \"10.0.0.2\"}]}",
+          1, "hw-address aa is reserved twice" },
+        { "{\"subnet\": \"10.0.0.0/24\", \"option-data\": "
+          "[{\"data\": \"1\"}]}",
+          1, "option without \"name\"" },
+        { "{\"subnet\": \"10.0.0.0/24\"}\n\n"
+          "{\"subnet\": \"10.0.0.1/24\"}",
+          3, "subnet 10.0.0.1/24 repeats line 1" },
+        { "{\"subnet\": \"10.0.0.0/24\", \"id\": 2}\n"
+          "{\"subnet\": \"10.0.1.0/24\", \"id\": 2}",
+          2, "id 2 repeats line 1" },
+        { "{\"subnet\": \"10.9.0.0/16\"}", 1,
+          "subnet 10.9.0.0/16 is already configured" },
+        { "{\"subnet\": \"10.0.0.0/24\", \"id\": 1}", 1,
+          "id 1 is already in use" },
+    };
+    for (const Case &c : cases)
+    {
+        for (unsigned threads : { 1u, 3u })
+        {
+            KeaConfig k;
+            k.dhcp4.subnet4.add_config ("10.9.0.0/16");
+            ImportResult r = import_jsonl (k, c.data, threads);
+            EXPECT_FALSE (r.applied) << c.data;
+            EXPECT_EQ (r.error_line, c.line) << c.data;
+            EXPECT_EQ (r.error, c.error) << c.data;
+            EXPECT_EQ (k.dhcp4.subnet4.cfgs.size (), 1u);
+        }
+    }
+
+    // Parse errors carry the parser's message
+    KeaConfig k;
+    ImportResult r = import_jsonl (k, "{\"subnet\": }", 1);
+    EXPECT_EQ (r.error_line, 1u);
+    EXPECT_NE (r.error.find ("parse error"), std::string::npos);
+}
+
+// Test importing from a file
+TEST (KeaImportTest, File)
+{
+    std::string path = ::testing::TempDir () + "kea_import.jsonl";
+    {
+        std::ofstream out (path);
+        for (int i = 0; i < 1000; ++i)
+        {
+            out << "{\"subnet\": \"10." << i / 256 << '.' << i % 256
+                << ".0/24\", \"pools\": [\"10." << i / 256 << '.'
+                << i % 256 << ".0/25\"]}\n";
+        }
+    }
+    KeaConfig k;
+    ImportResult r = import_jsonl_file (k, path, 4);
+    EXPECT_TRUE (r.applied) << r.error_line << ": " << r.error;
+    EXPECT_EQ (r.lines, 1000u);
+    EXPECT_EQ (k.dhcp4.subnet4.cfgs.size (), 1000u);
+    // Ids follow line order
+    EXPECT_EQ (k.dhcp4.subnet4.find_by_prefix ("10.3.231.0/24"),
+               1000u);
+    EXPECT_GT (r.lines_per_second, 0);
+    std::remove (path.c_str ());
+
+    r = import_jsonl_file (k, path, 4);
+    EXPECT_FALSE (r.applied);
+    EXPECT_EQ (r.error_line, 0u);
+    EXPECT_EQ (r.error.find (path), 0u);
+}
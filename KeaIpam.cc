@@ -0,0 +1,222 @@
+#include "KeaIpam.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace KeaGenerator
+{
+// Bit that tells the two halves of a /length block apart; it is also
+// the distance between a /length block and its buddy. length >= 1.
+static uint32_t
+half_bit (unsigned length)
+{
+    return uint32_t (1) << (32 - length);
+}
+
+bool
+SubnetPlanner::add_supernet (std::string_view cidr)
+{
+    Ipv4Prefix p;
+    if (!parse_cidr (cidr, p))
+    {
+        return false;
+    }
+    for (const Ipv4Prefix &s : supernets_)
+    {
+        if (p.base <= s.last () && s.base <= p.last ())
+        {
+            return false;
+        }
+    }
+    supernets_.push_back (p);
+    release (p.base, p.length);
+    return true;
+}
+
+void
+SubnetPlanner::release (uint32_t base, unsigned length)
+{
+    while (length > 0)
+    {
+        uint32_t bit = half_bit (length);
+        auto buddy = free_[length].find (base ^ bit);
+        if (buddy == free_[length].end ())
+        {
+            break;
+        }
+        free_[length].erase (buddy);
+        base &= ~bit;
+        --length;
+    }
+    free_[length].insert (base);
+}
+
+bool
+SubnetPlanner::reserve (const Ipv4Prefix &prefix)
+{
+    if (prefix.length > 32)
+    {
+        return false;
+    }
+
+    // A free block containing the prefix: split it down, keeping the
+    // halves that do not contain the prefix on the free lists.
+    for (int l = static_cast<int> (prefix.length); l >= 0; --l)
+    {
+        unsigned len = static_cast<unsigned> (l);
+        uint32_t base = prefix.base & prefix_mask (len);
+        if (free_[len].erase (base) == 0)
+        {
+            continue;
+        }
+        while (len < prefix.length)
+        {
+            ++len;
+            uint32_t bit = half_bit (len);
+            if (prefix.base & bit)
+            {
+                free_[len].insert (base);
+                base |= bit;
+            }
+            else
+            {
+                free_[len].insert (base | bit);
+            }
+        }
+        used_.emplace (key (prefix), std::vector<Ipv4Prefix> ());
+        return true;
+    }
+
+    // Otherwise take the smaller free blocks inside the prefix, and
+    // remember them: the rest of the prefix belongs to someone else.
+    std::vector<Ipv4Prefix> taken;
+    for (unsigned len = prefix.length + 1; len <= 32; ++len)
+    {
+        auto first = free_[len].lower_bound (prefix.base);
+        auto last = free_[len].upper_bound (prefix.last ());
+        for (auto it = first; it != last; ++it)
+        {
+            taken.push_back ({ *it, len });
+        }
+        free_[len].erase (first, last);
+    }
+    if (taken.empty ())
+    {
+        return false;
+    }
+    std::vector<Ipv4Prefix> &blocks = used_[key (prefix)];
+    blocks.insert (blocks.end (), taken.begin (), taken.end ());
+    return true;
+}
+
+std::size_t
+SubnetPlanner::reserve_existing (const Subnet4 &s)
+{
+    std::size_t reserved = 0;
+    for (const auto &entry : s.cfgs)
+    {
+        Ipv4Prefix p;
+        if (parse_cidr (entry.second.subnet, p) && reserve (p))
+        {
+            ++reserved;
+        }
+    }
+    return reserved;
+}
+
+std::optional<Ipv4Prefix>
+SubnetPlanner::allocate (unsigned length)
+{
+    if (length > 32)
+    {
+        return std::nullopt;
+    }
+
+    // Best fit: the smallest free block that is large enough.
+    for (int l = static_cast<int> (length); l >= 0; --l)
+    {
+        unsigned len = static_cast<unsigned> (l);
+        if (free_[len].empty ())
+        {
+            continue;
+        }
+        uint32_t base = *free_[len].begin ();
+        free_[len].erase (free_[len].begin ());
+        while (len < length)
+        {
+            ++len;
+            free_[len].insert (base | half_bit (len));
+        }
+        Ipv4Prefix p{ base, length };
+        used_.emplace (key (p), std::vector<Ipv4Prefix> ());
+        return p;
+    }
+    return std::nullopt;
+}
+
+std::vector<std::optional<Ipv4Prefix> >
+SubnetPlanner::allocate_all (const std::vector<unsigned> &lengths)
+{
+    std::vector<std::size_t> order (lengths.size ());
+    std::iota (order.begin (), order.end (), 0);
+    std::stable_sort (order.begin (), order.end (),
+                      [&lengths] (std::size_t a, std::size_t b) {
+                          return lengths[a] < lengths[b];
+                      });
+
+    std::vector<std::optional<Ipv4Prefix> > result (lengths.size ());
+    for (std::size_t i : order)
+    {
+        result[i] = allocate (lengths[i]);
+    }
+    return result;
+}
+
+uint64_t
+SubnetPlanner::allocate_config (Subnet4 &s, unsigned length)
+{
+    std::optional<Ipv4Prefix> p = allocate (length);
+    if (!p)
+    {
+        return 0;
+    }
+    uint64_t id = s.add_config (format_cidr (*p));
+    if (id == 0)
+    {
+        free (*p);
+    }
+    return id;
+}
+
+bool
+SubnetPlanner::free (const Ipv4Prefix &prefix)
+{
+    auto it = prefix.length > 32 ? used_.end ()
+                                 : used_.find (key (prefix));
+    if (it == used_.end ())
+    {
+        return false;
+    }
+    if (it->second.empty ())
+    {
+        release (prefix.base, prefix.length);
+    }
+    for (const Ipv4Prefix &block : it->second)
+    {
+        release (block.base, block.length);
+    }
+    used_.erase (it);
+    return true;
+}
+
+uint64_t
+SubnetPlanner::free_addresses () const
+{
+    uint64_t total = 0;
+    for (unsigned len = 0; len <= 32; ++len)
+    {
+        total += free_[len].size () * (uint64_t (1) << (32 - len));
+    }
+    return total;
+}
+} // namespace KeaGenerator
@@ -0,0 +1,101 @@
+// File: KeaIpam.h
+#ifndef KEA_IPAM_H
+#define KEA_IPAM_H
+
+#include "KeaAddress.h"
+#include "KeaGenerator.h"
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <string_view>
+#include <vector>
+
+namespace KeaGenerator
+{
+// --- SubnetPlanner ---
+// Carves subnets out of one or more supernets with a buddy
+// allocator. Free space is kept as aligned power-of-two blocks, one
+// ordered free list per prefix length. Allocating a /len takes the
+// lowest free block of the longest prefix <= len and splits it down;
+// freeing a block merges it with its buddy for as long as the buddy
+// is free. Both are O(log n) in the number of free blocks (times the
+// 33 prefix lengths, a constant).
+//
+//   SubnetPlanner p;
+//   p.add_supernet ("10.0.0.0/8");
+//   p.reserve_existing (config.dhcp4.subnet4);
+//   uint64_t id = p.allocate_config (config.dhcp4.subnet4, 24);
+class SubnetPlanner
+{
+  public:
+    // Adds a supernet to carve from. Returns false if `cidr` is
+    // malformed or overlaps space the planner already knows about.
+    bool add_supernet (std::string_view cidr);
+
+    // Marks `prefix` as in use. Free blocks it covers are taken and
+    // a free block containing it is split around it. Returns false if
+    // no part of `prefix` was free.
+    bool reserve (const Ipv4Prefix &prefix);
+
+    // Reserves the subnets of the existing configurations of `s`.
+    // Subnets outside every supernet are ignored. Returns the number
+    // of subnets reserved. Call this after the supernets were added.
+    std::size_t reserve_existing (const Subnet4 &s);
+
+    // Allocates the lowest free /length. Returns nothing if no block
+    // of that size is left.
+    std::optional<Ipv4Prefix> allocate (unsigned length);
+
+    // Allocates one subnet per requested prefix length. Larger blocks
+    // are placed first so that small requests do not fragment the
+    // space the large ones need; results are in request order.
+    std::vector<std::optional<Ipv4Prefix> >
+    allocate_all (const std::vector<unsigned> &lengths);
+
+    // Allocates a /length and adds it to `s` with add_config. Returns
+    // the new configuration id, or 0 if no block was left or `s`
+    // already has that subnet, in which case the block is freed.
+    uint64_t allocate_config (Subnet4 &s, unsigned length);
+
+    // Returns a prefix obtained from allocate() or reserve() to the
+    // free space. Of a prefix that was only partly free when it was
+    // reserved, only the blocks reserve() took are released. Returns
+    // false if it is not currently handed out.
+    bool free (const Ipv4Prefix &prefix);
+
+    // Number of addresses that are still free.
+    uint64_t free_addresses () const;
+
+    // Number of free blocks of the given prefix length; 0 for a
+    // length above 32.
+    std::size_t
+    free_blocks (unsigned length) const
+    {
+        return length > 32 ? 0 : free_[length].size ();
+    }
+
+  private:
+    // Puts a block on its free list, merging it with its buddy.
+    void release (uint32_t base, unsigned length);
+
+    static uint64_t
+    key (const Ipv4Prefix &p)
+    {
+        return (uint64_t (p.base) << 6) | p.length;
+    }
+
+    // Free block base addresses, indexed by prefix length.
+    std::set<uint32_t> free_[33];
+    // Prefixes handed out by allocate() or reserve(), see key(), with
+    // the free blocks a partial reservation took; empty if the whole
+    // prefix was taken.
+    std::map<uint64_t, std::vector<Ipv4Prefix> > used_;
+    // Supernets added so far; used to reject overlapping ones.
+    std::vector<Ipv4Prefix> supernets_;
+};
+
+} // namespace KeaGenerator
+
+#endif // KEA_IPAM_H
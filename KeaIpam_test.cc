@@ -0,0 +1,136 @@
+#include "KeaIpam.h"
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace KeaGenerator;
+
+// Test allocation, splitting and buddy merging
+TEST (KeaIpamTest, AllocateAndFree)
+{
+    SubnetPlanner p;
+    ASSERT_TRUE (p.add_supernet ("10.0.0.0/16"));
+    EXPECT_FALSE (p.add_supernet ("10.0.128.0/17"));
+    EXPECT_FALSE (p.add_supernet ("bogus"));
+    EXPECT_EQ (p.free_addresses (), 65536u);
+
+    auto a = p.allocate (24);
+    auto b = p.allocate (24);
+    auto c = p.allocate (22);
+    ASSERT_TRUE (a && b && c);
+    EXPECT_EQ (format_cidr (*a), "10.0.0.0/24");
+    EXPECT_EQ (format_cidr (*b), "10.0.1.0/24");
+    EXPECT_EQ (format_cidr (*c), "10.0.4.0/22");
+    EXPECT_EQ (p.free_addresses (), 65536u - 256 - 256 - 1024);
+
+    // Freeing everything merges back into the single /16
+    EXPECT_TRUE (p.free (*b));
+    EXPECT_FALSE (p.free (*b));
+    EXPECT_TRUE (p.free (*a));
+    EXPECT_TRUE (p.free (*c));
+    EXPECT_EQ (p.free_blocks (16), 1u);
+    EXPECT_EQ (p.free_addresses (), 65536u);
+    EXPECT_EQ (p.free_blocks (33), 0u);
+
+    EXPECT_FALSE (p.allocate (15));
+}
+
+// Test that existing configurations are never handed out again
+TEST (KeaIpamTest, RespectsExistingConfigs)
+{
+    Subnet4 s;
+    s.add_config ("10.0.0.0/24");
+    s.add_config ("10.0.2.0/23");
+    s.add_config ("192.168.0.0/24");
+
+    SubnetPlanner p;
+    ASSERT_TRUE (p.add_supernet ("10.0.0.0/22"));
+    EXPECT_EQ (p.reserve_existing (s), 2u);
+
+    uint64_t id = p.allocate_config (s, 24);
+    ASSERT_NE (id, 0u);
+    EXPECT_EQ (s.cfgs[id].subnet, "10.0.1.0/24");
+    EXPECT_EQ (p.allocate_config (s, 24), 0u);
+    EXPECT_EQ (p.free_addresses (), 0u);
+
+    // A reservation covering smaller free blocks drops all of them
+    SubnetPlanner q;
+    ASSERT_TRUE (q.add_supernet ("10.0.0.0/22"));
+    auto small = q.allocate (26);
+    ASSERT_TRUE (small);
+    EXPECT_TRUE (q.reserve (Ipv4Prefix{ 0x0a000000u, 23 }));
+    EXPECT_EQ (q.free_addresses (), 512u);
+}
+
+// Test that freeing a partial reservation keeps the blocks that were
+// already handed out
+TEST (KeaIpamTest, FreePartialReservation)
+{
+    SubnetPlanner p;
+    ASSERT_TRUE (p.add_supernet ("10.0.0.0/24"));
+    auto live = p.allocate (26);
+    ASSERT_TRUE (live);
+    EXPECT_EQ (format_cidr (*live), "10.0.0.0/26");
+    Ipv4Prefix all{ 0x0a000000u, 24 };
+    EXPECT_TRUE (p.reserve (all));
+    EXPECT_EQ (p.free_addresses (), 0u);
+    EXPECT_TRUE (p.free (all));
+    EXPECT_FALSE (p.free (all));
+    EXPECT_EQ (p.free_addresses (), 192u);
+
+    // The live /26 is not handed out again
+    EXPECT_FALSE (p.allocate (24));
+    auto next = p.allocate (26);
+    ASSERT_TRUE (next);
+    EXPECT_EQ (format_cidr (*next), "10.0.0.64/26");
+
+    // Once it is freed too, the whole supernet merges back
+    EXPECT_TRUE (p.free (*live));
+    EXPECT_TRUE (p.free (*next));
+    EXPECT_EQ (p.free_blocks (24), 1u);
+}
+
+// Test that a block add_config rejects is returned to the free space
+TEST (KeaIpamTest, AllocateConfigDuplicate)
+{
+    Subnet4 s;
+    s.add_config ("10.0.0.0/25");
+    SubnetPlanner p;
+    ASSERT_TRUE (p.add_supernet ("10.0.0.0/24"));
+    EXPECT_EQ (p.allocate_config (s, 25), 0u);
+    EXPECT_EQ (p.free_addresses (), 256u);
+    EXPECT_EQ (p.free_blocks (24), 1u);
+    EXPECT_EQ (s.cfgs.size (), 1u);
+}
+
+// Test that large requests are placed before small ones
+TEST (KeaIpamTest, AllocateAll)
+{
+    SubnetPlanner p;
+    ASSERT_TRUE (p.add_supernet ("172.16.0.0/23"));
+    auto r = p.allocate_all ({ 26, 24, 26, 25 });
+    ASSERT_TRUE (r[0] && r[1] && r[2] && r[3]);
+    EXPECT_EQ (format_cidr (*r[1]), "172.16.0.0/24");
+    EXPECT_EQ (format_cidr (*r[3]), "172.16.1.0/25");
+    EXPECT_EQ (format_cidr (*r[0]), "172.16.1.128/26");
+    EXPECT_EQ (format_cidr (*r[2]), "172.16.1.192/26");
+}
+
+// Test provisioning a large number of site subnets
+TEST (KeaIpamTest, ManySites)
+{
+    SubnetPlanner p;
+    ASSERT_TRUE (p.add_supernet ("10.0.0.0/8"));
+    ASSERT_TRUE (p.add_supernet ("100.64.0.0/10"));
+
+    Subnet4 s;
+    for (int i = 0; i < 100000; ++i)
+    {
+        ASSERT_NE (p.allocate_config (s, 28), 0u);
+    }
+    EXPECT_EQ (s.cfgs.size (), 100000u);
+    // Best fit carves the smaller supernet first
+    EXPECT_EQ (s.cfgs[1].subnet, "100.64.0.0/28");
+    EXPECT_EQ (s.cfgs[100000].subnet, "100.88.105.240/28");
+    EXPECT_EQ (p.free_addresses (),
+               (uint64_t (1) << 24) + (uint64_t (1) << 22) - 1600000);
+}
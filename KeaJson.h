@@ -0,0 +1,35 @@
+// File: KeaJson.h
+// nlohmann/json serialization of the configuration model. Include
+// this header only in translation units that convert the model to
+// nlohmann::json; the model itself is in KeaGenerator.h.
+#ifndef KEA_JSON_H
+#define KEA_JSON_H
+
+#include "KeaGenerator.h"
+
+#include <nlohmann/json.hpp>
+
+namespace KeaGenerator
+{
+// Function declarations for JSON serialization. They are found by
+// argument-dependent lookup, so `nlohmann::json j = config;` works
+// for every model type. The templates are defined in KeaGenerator.cc
+// and explicitly instantiated there for the storage policies of
+// KeaStorage.h.
+void to_json (nlohmann::json &j, const InterfacesConfig &i);
+void to_json (nlohmann::json &j, const LeaseDatabase &l);
+void to_json (nlohmann::json &j, const OptionData::Option &o);
+template <class Storage>
+void to_json (nlohmann::json &j, const BasicOptionData<Storage> &o);
+void to_json (nlohmann::json &j, const Subnet4::Pool &p);
+void to_json (nlohmann::json &j, const Subnet4::Reservation &r);
+template <class Storage>
+void to_json (nlohmann::json &j, const BasicSubnet4Cfg<Storage> &c);
+template <class Storage>
+void to_json (nlohmann::json &j, const BasicSubnet4<Storage> &s);
+void to_json (nlohmann::json &j, const Dhcp4 &d);
+void to_json (nlohmann::json &j, const KeaConfig &k);
+
+} // namespace KeaGenerator
+
+#endif // KEA_JSON_H
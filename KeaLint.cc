@@ -0,0 +1,130 @@
+#include "KeaLint.h"
+#include "KeaAddress.h"
+#include "KeaStream.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace KeaGenerator
+{
+namespace
+{
+std::string
+rounded (double v)
+{
+    return std::to_string (static_cast<uint64_t> (std::llround (v)));
+}
+} // namespace
+
+std::vector<LintFinding>
+lint_config (const KeaConfig &k, const LintOptions &options)
+{
+    std::vector<LintFinding> findings;
+    const Subnet4 &s = k.dhcp4.subnet4;
+
+    // Subnets and pools in the order write_json writes them.
+    std::vector<LintFinding> pools;
+    uint64_t addresses = 0;
+    std::size_t idle = 0;
+    std::size_t index = 0;
+    for (const Subnet4::Cfg *cfg : sorted_cfgs (s))
+    {
+        AddressRanges ranges;
+        std::size_t pool = 0;
+        for (const Subnet4::Pool &p : cfg->pools)
+        {
+            uint32_t low, high;
+            if (parse_pool_range (p.range, low, high))
+            {
+                ranges.emplace_back (low, high);
+                uint64_t size = uint64_t (high) - low + 1;
+                if (size > options.max_pool_addresses)
+                {
+                    LintFinding f;
+                    f.rule = LintRule::large_pool;
+                    f.path = "/Dhcp4/subnet4/"
+                             + std::to_string (index) + "/pools/"
+                             + std::to_string (pool);
+                    f.message = "pool " + p.range + " has "
+                                + std::to_string (size)
+                                + " addresses; a nearly full pool "
+                                  "may be walked end to end per "
+                                  "allocation";
+                    f.estimate = double (size);
+                    pools.push_back (std::move (f));
+                }
+            }
+            ++pool;
+        }
+        normalize_ranges (ranges);
+        addresses
+            += count_addresses (ranges) + cfg->reservations.size ();
+        if (cfg->reservations.empty ())
+        {
+            ++idle;
+        }
+        ++index;
+    }
+
+    uint64_t lifetime = k.dhcp4.valid_lifetime;
+    uint64_t period = std::max<uint64_t> (lifetime, 1);
+    double renewals = 2.0 * double (addresses) / double (period);
+    if (lifetime < options.min_lifetime
+        || renewals > options.max_renewals_per_second)
+    {
+        LintFinding f;
+        f.rule = LintRule::short_lifetime;
+        f.path = "/Dhcp4/valid-lifetime";
+        f.message = "valid-lifetime " + std::to_string (lifetime)
+                    + " s: clients renew every "
+                    + std::to_string (lifetime / 2) + " s, about "
+                    + rounded (renewals) + " renewals/s with all "
+                    + std::to_string (addresses)
+                    + " addresses leased";
+        f.estimate = renewals;
+        findings.push_back (std::move (f));
+    }
+
+    findings.insert (findings.end (), pools.begin (), pools.end ());
+
+    if (idle > 0)
+    {
+        LintFinding f;
+        f.rule = LintRule::idle_host_lookup;
+        f.path = "/Dhcp4/subnet4";
+        f.message = std::to_string (idle) + " of "
+                    + std::to_string (s.cfgs.size ())
+                    + " subnets have no reservations but still cost "
+                      "a reservation lookup per packet";
+        f.estimate = double (idle);
+        findings.push_back (std::move (f));
+    }
+    return findings;
+}
+
+const char *
+to_string (LintRule rule)
+{
+    switch (rule)
+    {
+    case LintRule::short_lifetime:
+        return "short-lifetime";
+    case LintRule::large_pool:
+        return "large-pool";
+    case LintRule::idle_host_lookup:
+        return "idle-host-lookup";
+    }
+    return "unknown";
+}
+
+void
+write_lint_report (std::ostream &out,
+                   const std::vector<LintFinding> &findings)
+{
+    for (const LintFinding &f : findings)
+    {
+        out << f.path << ": " << to_string (f.rule) << ": "
+            << f.message << '\n';
+    }
+}
+} // namespace KeaGenerator
@@ -0,0 +1,77 @@
+// File: KeaLint.h
+#ifndef KEA_LINT_H
+#define KEA_LINT_H
+
+#include "KeaGenerator.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace KeaGenerator
+{
+// --- Performance lint ---
+// Flags configuration shapes that are valid but make Kea itself
+// slow, each with an estimate of the cost:
+//
+//   short-lifetime   a valid-lifetime so short that renewals flood
+//                    the server once the pools are in use;
+//                    estimate: renewals per second.
+//   large-pool       a pool so large that Kea's default iterative
+//                    allocator may walk most of it to find a free
+//                    address once it fills up; estimate: addresses.
+//   idle-host-lookup subnets without reservations, on which Kea
+//                    still looks up reservations for every packet
+//                    (reservations-in-subnet is on by default);
+//                    estimate: number of such subnets.
+//
+// Client classes are not part of KeaConfig, so their per-packet
+// evaluation cannot be checked here. write_validated_json runs the
+// lint with the default limits on every configuration it writes.
+
+enum class LintRule
+{
+    short_lifetime,
+    large_pool,
+    idle_host_lookup,
+};
+
+struct LintFinding
+{
+    LintRule rule = LintRule::short_lifetime;
+    std::string path;    // JSON pointer into the written document.
+    std::string message; // What was found and what it costs.
+    double estimate = 0; // Cost, in the rule's unit.
+};
+
+struct LintOptions
+{
+    // Lifetimes below this many seconds are flagged whatever the
+    // pool sizes.
+    uint64_t min_lifetime = 600;
+    // Renewal rate, at full pools, above which the lifetime is
+    // flagged. Clients renew at half the lifetime (T1).
+    double max_renewals_per_second = 500;
+    // Pools with more addresses than this are flagged.
+    uint64_t max_pool_addresses = 65536;
+};
+
+// Lints `k`. Findings are ordered by rule, pools in the order they
+// are written.
+std::vector<LintFinding> lint_config (const KeaConfig &k,
+                                      const LintOptions &options
+                                      = LintOptions ());
+
+// Name of a rule, e.g. "large-pool".
+const char *to_string (LintRule rule);
+
+// Writes one line per finding:
+//
+//   /Dhcp4/valid-lifetime: short-lifetime: valid-lifetime 60 s ...
+void write_lint_report (std::ostream &out,
+                        const std::vector<LintFinding> &findings);
+
+} // namespace KeaGenerator
+
+#endif // KEA_LINT_H
@@ -0,0 +1,76 @@
+#include "KeaLint.h"
+#include "KeaSchema.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+using namespace KeaGenerator;
+
+namespace
+{
+KeaConfig
+Sample ()
+{
+    KeaConfig k (Dhcp4 (3600, { "eth0" }));
+    Subnet4 &s = k.dhcp4.subnet4;
+    uint64_t id = s.add_config ("10.0.0.0/24");
+    s.add_pool_for_cfg (id, "10.0.0.10", "10.0.0.109");
+    s.add_reservation_for_cfg (id, "1a:1b:1c:1d:1e:1f", "10.0.0.5");
+    return k;
+}
+} // namespace
+
+// Test that a sensible configuration has no findings
+TEST (KeaLintTest, Clean)
+{
+    EXPECT_TRUE (lint_config (Sample ()).empty ());
+}
+
+// Test every rule and the report
+TEST (KeaLintTest, Findings)
+{
+    KeaConfig k = Sample ();
+    k.dhcp4.valid_lifetime = 120;
+    Subnet4 &s = k.dhcp4.subnet4;
+    uint64_t wide = s.add_config ("10.128.0.0/9");
+    s.add_pool_for_cfg (wide, "10.128.0.0", "10.129.255.255");
+    s.add_pool_for_cfg (wide, "10.130.0.0", "10.130.0.255");
+    s.add_config ("10.1.0.0/24");
+
+    std::vector<LintFinding> findings = lint_config (k);
+    ASSERT_EQ (findings.size (), 3u);
+    // 131,072 + 256 + 100 pooled addresses and one reservation.
+    EXPECT_EQ (findings[0].rule, LintRule::short_lifetime);
+    EXPECT_DOUBLE_EQ (findings[0].estimate, 2.0 * 131429 / 120);
+    EXPECT_EQ (findings[1].rule, LintRule::large_pool);
+    EXPECT_DOUBLE_EQ (findings[1].estimate, 131072.0);
+    EXPECT_EQ (findings[2].rule, LintRule::idle_host_lookup);
+    EXPECT_DOUBLE_EQ (findings[2].estimate, 2.0);
+
+    std::ostringstream out;
+    write_lint_report (out, findings);
+    EXPECT_EQ (out.str (),
+               "/Dhcp4/valid-lifetime: short-lifetime: "
+               "valid-lifetime 120 s: clients renew every 60 s, "
+               "about 2190 renewals/s with all 131429 addresses "
+               "leased\n"
+               "/Dhcp4/subnet4/1/pools/0: large-pool: pool "
+               "10.128.0.0 - 10.129.255.255 has 131072 addresses; a "
+               "nearly full pool may be walked end to end per "
+               "allocation\n"
+               "/Dhcp4/subnet4: idle-host-lookup: 2 of 3 subnets "
+               "have no reservations but still cost a reservation "
+               "lookup per packet\n");
+}
+
+// Test that validation carries the findings
+TEST (KeaLintTest, RunsWithValidation)
+{
+    KeaConfig k = Sample ();
+    k.dhcp4.valid_lifetime = 60;
+    std::ostringstream out;
+    SchemaResult r = write_validated_json (out, k);
+    EXPECT_TRUE (r.valid);
+    ASSERT_EQ (r.findings.size (), 1u);
+    EXPECT_EQ (r.findings[0].rule, LintRule::short_lifetime);
+}
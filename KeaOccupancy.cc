@@ -0,0 +1,539 @@
+#include "KeaOccupancy.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace KeaGenerator
+{
+// --- Chunk ---
+
+void
+AddressBitmap::Chunk::to_bitmap ()
+{
+    bits.assign (kWords, 0);
+    for (uint16_t v : array)
+    {
+        bits[v >> 6] |= uint64_t (1) << (v & 63);
+    }
+    std::vector<uint16_t> ().swap (array);
+}
+
+void
+AddressBitmap::Chunk::add_range (uint16_t low, uint16_t high)
+{
+    // A chunk is an array exactly while it holds at most kArrayMax
+    // values, so equal sets always have equal representations.
+    uint32_t width = uint32_t (high) - low + 1;
+    if (!is_bitmap ()
+        && cardinality + width - count (low, high) > kArrayMax)
+    {
+        to_bitmap ();
+    }
+
+    if (!is_bitmap () && (array.empty () || array.back () < low))
+    {
+        // Appending, as when building from sorted ranges.
+        for (uint32_t v = low; v <= high; ++v)
+        {
+            array.push_back (static_cast<uint16_t> (v));
+        }
+        cardinality = static_cast<uint32_t> (array.size ());
+        return;
+    }
+    if (!is_bitmap ())
+    {
+        // Merge the (small) range into the sorted array.
+        auto first
+            = std::lower_bound (array.begin (), array.end (), low);
+        auto last = std::upper_bound (first, array.end (), high);
+        std::vector<uint16_t> merged;
+        merged.reserve (array.size () + width);
+        merged.insert (merged.end (), array.begin (), first);
+        for (uint32_t v = low; v <= high; ++v)
+        {
+            merged.push_back (static_cast<uint16_t> (v));
+        }
+        merged.insert (merged.end (), last, array.end ());
+        array.swap (merged);
+        cardinality = static_cast<uint32_t> (array.size ());
+        return;
+    }
+
+    uint32_t wlo = low >> 6;
+    uint32_t whi = high >> 6;
+    for (uint32_t w = wlo; w <= whi; ++w)
+    {
+        uint64_t mask = ~uint64_t (0);
+        if (w == wlo)
+        {
+            mask &= ~uint64_t (0) << (low & 63);
+        }
+        if (w == whi)
+        {
+            mask &= ~uint64_t (0) >> (63 - (high & 63));
+        }
+        cardinality += __builtin_popcountll (mask & ~bits[w]);
+        bits[w] |= mask;
+    }
+}
+
+bool
+AddressBitmap::Chunk::contains (uint16_t v) const
+{
+    if (is_bitmap ())
+    {
+        return (bits[v >> 6] >> (v & 63)) & 1;
+    }
+    return std::binary_search (array.begin (), array.end (), v);
+}
+
+uint32_t
+AddressBitmap::Chunk::count (uint16_t low, uint16_t high) const
+{
+    if (!is_bitmap ())
+    {
+        auto first
+            = std::lower_bound (array.begin (), array.end (), low);
+        auto last = std::upper_bound (first, array.end (), high);
+        return static_cast<uint32_t> (last - first);
+    }
+
+    uint32_t n = 0;
+    uint32_t wlo = low >> 6;
+    uint32_t whi = high >> 6;
+    for (uint32_t w = wlo; w <= whi; ++w)
+    {
+        uint64_t mask = ~uint64_t (0);
+        if (w == wlo)
+        {
+            mask &= ~uint64_t (0) << (low & 63);
+        }
+        if (w == whi)
+        {
+            mask &= ~uint64_t (0) >> (63 - (high & 63));
+        }
+        n += __builtin_popcountll (bits[w] & mask);
+    }
+    return n;
+}
+
+// --- AddressBitmap ---
+
+AddressBitmap::Chunk &
+AddressBitmap::chunk (uint16_t key)
+{
+    auto it = std::lower_bound (
+        chunks_.begin (), chunks_.end (), key,
+        [] (const Chunk &c, uint16_t k) { return c.key < k; });
+    if (it == chunks_.end () || it->key != key)
+    {
+        it = chunks_.insert (it, Chunk ());
+        it->key = key;
+    }
+    return *it;
+}
+
+std::vector<AddressBitmap::Chunk>::const_iterator
+AddressBitmap::lower (uint16_t key) const
+{
+    return std::lower_bound (
+        chunks_.begin (), chunks_.end (), key,
+        [] (const Chunk &c, uint16_t k) { return c.key < k; });
+}
+
+void
+AddressBitmap::add (uint32_t address)
+{
+    add_range (address, address);
+}
+
+void
+AddressBitmap::add_range (uint32_t low, uint32_t high)
+{
+    if (low > high)
+    {
+        return;
+    }
+    for (uint32_t key = low >> 16; key <= (high >> 16); ++key)
+    {
+        auto part = clip (key, low, high);
+        chunk (static_cast<uint16_t> (key))
+            .add_range (part.first, part.second);
+        if (key == 0xffff)
+        {
+            break;
+        }
+    }
+}
+
+bool
+AddressBitmap::contains (uint32_t address) const
+{
+    auto it = lower (static_cast<uint16_t> (address >> 16));
+    return it != chunks_.end () && it->key == (address >> 16)
+           && it->contains (static_cast<uint16_t> (address));
+}
+
+uint64_t
+AddressBitmap::cardinality () const
+{
+    uint64_t n = 0;
+    for (const Chunk &c : chunks_)
+    {
+        n += c.cardinality;
+    }
+    return n;
+}
+
+uint64_t
+AddressBitmap::count (uint32_t low, uint32_t high) const
+{
+    uint64_t n = 0;
+    for (auto it = lower (static_cast<uint16_t> (low >> 16));
+         it != chunks_.end () && it->key <= (high >> 16); ++it)
+    {
+        auto part = clip (it->key, low, high);
+        n += part.first == 0 && part.second == 0xffff
+                 ? it->cardinality
+                 : it->count (part.first, part.second);
+    }
+    return n;
+}
+
+AddressBitmap
+AddressBitmap::from_ranges (std::vector<Range> ranges)
+{
+    std::sort (ranges.begin (), ranges.end ());
+    AddressBitmap bitmap;
+    // Chunks are created in key order, so they are always appended.
+    for (const Range &r : ranges)
+    {
+        if (r.first > r.second)
+        {
+            continue;
+        }
+        std::vector<Chunk> &chunks = bitmap.chunks_;
+        for (uint32_t key = r.first >> 16; key <= (r.second >> 16);
+             ++key)
+        {
+            if (chunks.empty () || chunks.back ().key != key)
+            {
+                chunks.emplace_back ();
+                chunks.back ().key = static_cast<uint16_t> (key);
+            }
+            auto part = clip (key, r.first, r.second);
+            chunks.back ().add_range (part.first, part.second);
+            if (key == 0xffff)
+            {
+                break;
+            }
+        }
+    }
+    return bitmap;
+}
+
+AddressBitmap
+AddressBitmap::from_subnet4 (const Subnet4 &s)
+{
+    std::vector<Range> ranges;
+    for (const auto &entry : s.cfgs)
+    {
+        const Subnet4::Cfg &cfg = entry.second;
+        for (const Subnet4::Pool &pool : cfg.pools)
+        {
+            uint32_t low, high;
+            if (parse_pool_range (pool.range, low, high))
+            {
+                ranges.emplace_back (low, high);
+            }
+        }
+        for (const Subnet4::Reservation &r : cfg.reservations)
+        {
+            uint32_t a;
+            if (parse_ipv4 (r.ip_address, a))
+            {
+                ranges.emplace_back (a, a);
+            }
+        }
+    }
+    return from_ranges (std::move (ranges));
+}
+
+std::optional<AddressBitmap::Range>
+AddressBitmap::largest_free_run (const Ipv4Prefix &within) const
+{
+    std::optional<Range> best;
+    auto gap = [&best] (uint32_t a, uint32_t b) {
+        if (!best || b - a > best->second - best->first)
+        {
+            best = Range (a, b);
+        }
+    };
+    for_each_gap (within.base, within.last (), gap);
+    return best;
+}
+
+std::vector<uint32_t>
+AddressBitmap::utilization_by_24 (const Ipv4Prefix &within) const
+{
+    bool wide = within.length <= 24;
+    std::vector<uint32_t> used (
+        wide ? std::size_t (1) << (24 - within.length) : 1);
+    uint32_t first = within.base & prefix_mask (24);
+    uint32_t last = wide ? within.last () : first | 0xff;
+
+    for (auto it = lower (static_cast<uint16_t> (first >> 16));
+         it != chunks_.end () && it->key <= (last >> 16); ++it)
+    {
+        uint32_t base = uint32_t (it->key) << 16;
+        uint32_t from = std::max (base, first);
+        uint32_t to = std::min (base | 0xffff, last);
+        if (it->is_bitmap ())
+        {
+            // Four words per /24.
+            for (uint64_t b = from; b <= to; b += 256)
+            {
+                const uint64_t *w = &it->bits[(b & 0xffff) >> 6];
+                used[(b - first) >> 8]
+                    = __builtin_popcountll (w[0])
+                      + __builtin_popcountll (w[1])
+                      + __builtin_popcountll (w[2])
+                      + __builtin_popcountll (w[3]);
+            }
+            continue;
+        }
+        const std::vector<uint16_t> &values = it->array;
+        auto v = std::lower_bound (values.begin (), values.end (),
+                                   static_cast<uint16_t> (from));
+        for (; v != values.end () && (base | *v) <= to; ++v)
+        {
+            ++used[((base | *v) - first) >> 8];
+        }
+    }
+    return used;
+}
+
+std::optional<Ipv4Prefix>
+AddressBitmap::first_free_block (const Ipv4Prefix &within,
+                                 unsigned length) const
+{
+    if (length > 32 || length < within.length)
+    {
+        return std::nullopt;
+    }
+    uint64_t size = uint64_t (1) << (32 - length);
+    std::optional<Ipv4Prefix> found;
+    auto gap = [&] (uint32_t a, uint32_t b) {
+        if (found)
+        {
+            return;
+        }
+        uint64_t start = (uint64_t (a) + size - 1) & ~(size - 1);
+        if (start + size - 1 <= b)
+        {
+            found = Ipv4Prefix{ static_cast<uint32_t> (start),
+                                length };
+        }
+    };
+    for_each_gap (within.base, within.last (), gap);
+    return found;
+}
+
+// --- Serialization ---
+// "KAB1", chunk count (u32), then per chunk: key (u16), kind (u8) and
+// a payload. Integers are little endian.
+//   kind 0: array   count (u16, minus one), values (u16 each)
+//   kind 1: bitmap  1024 words (u64 each)
+//   kind 2: runs    count (u16, minus one), (start, length - 1) pairs
+
+namespace
+{
+void
+put (std::ostream &out, uint64_t v, int bytes)
+{
+    char buf[8];
+    for (int i = 0; i < bytes; ++i)
+    {
+        buf[i] = static_cast<char> (v >> (8 * i));
+    }
+    out.write (buf, bytes);
+}
+
+bool
+get (std::istream &in, uint64_t &v, int bytes)
+{
+    unsigned char buf[8];
+    if (!in.read (reinterpret_cast<char *> (buf), bytes))
+    {
+        return false;
+    }
+    v = 0;
+    for (int i = 0; i < bytes; ++i)
+    {
+        v |= uint64_t (buf[i]) << (8 * i);
+    }
+    return true;
+}
+} // namespace
+
+void
+AddressBitmap::serialize (std::ostream &out) const
+{
+    out.write ("KAB1", 4);
+    put (out, chunks_.size (), 4);
+    for (const Chunk &c : chunks_)
+    {
+        std::vector<std::pair<uint16_t, uint16_t> > runs;
+        c.runs (0, 0xffff, [&runs] (uint16_t lo, uint16_t hi) {
+            runs.emplace_back (lo, static_cast<uint16_t> (hi - lo));
+        });
+
+        std::size_t array_bytes = 2 + 2 * std::size_t (c.cardinality);
+        std::size_t bitmap_bytes = 8 * kWords;
+        std::size_t run_bytes = 2 + 4 * runs.size ();
+
+        put (out, c.key, 2);
+        if (run_bytes <= array_bytes && run_bytes <= bitmap_bytes)
+        {
+            put (out, 2, 1);
+            put (out, runs.size () - 1, 2);
+            for (const auto &r : runs)
+            {
+                put (out, r.first, 2);
+                put (out, r.second, 2);
+            }
+        }
+        else if (array_bytes <= bitmap_bytes)
+        {
+            put (out, 0, 1);
+            put (out, c.cardinality - 1, 2);
+            c.runs (0, 0xffff, [&out] (uint16_t lo, uint16_t hi) {
+                for (uint32_t v = lo; v <= hi; ++v)
+                {
+                    put (out, v, 2);
+                }
+            });
+        }
+        else
+        {
+            // A full array (kArrayMax values) is one word smaller as
+            // a bitmap, so the words may have to be built here.
+            std::vector<uint64_t> words;
+            if (!c.is_bitmap ())
+            {
+                words.assign (kWords, 0);
+                for (uint16_t v : c.array)
+                {
+                    words[v >> 6] |= uint64_t (1) << (v & 63);
+                }
+            }
+            put (out, 1, 1);
+            for (uint64_t word : c.is_bitmap () ? c.bits : words)
+            {
+                put (out, word, 8);
+            }
+        }
+    }
+}
+
+bool
+AddressBitmap::deserialize (std::istream &in, AddressBitmap &bitmap)
+{
+    char magic[4];
+    uint64_t chunks;
+    if (!in.read (magic, 4) || std::string (magic, 4) != "KAB1"
+        || !get (in, chunks, 4) || chunks > 65536)
+    {
+        return false;
+    }
+
+    AddressBitmap result;
+    result.chunks_.reserve (chunks);
+    for (uint64_t i = 0; i < chunks; ++i)
+    {
+        uint64_t key, kind, n;
+        if (!get (in, key, 2) || !get (in, kind, 1)
+            || (!result.chunks_.empty ()
+                && key <= result.chunks_.back ().key))
+        {
+            return false;
+        }
+        result.chunks_.emplace_back ();
+        Chunk &c = result.chunks_.back ();
+        c.key = static_cast<uint16_t> (key);
+
+        if (kind == 1)
+        {
+            c.bits.resize (kWords);
+            for (uint64_t &word : c.bits)
+            {
+                if (!get (in, word, 8))
+                {
+                    return false;
+                }
+                c.cardinality += __builtin_popcountll (word);
+            }
+            if (c.cardinality == 0)
+            {
+                // Empty chunks are never stored.
+                return false;
+            }
+            if (c.cardinality <= kArrayMax)
+            {
+                // Keep the in-memory form canonical.
+                for (uint32_t w = 0; w < kWords; ++w)
+                {
+                    for (uint64_t word = c.bits[w]; word != 0;
+                         word &= word - 1)
+                    {
+                        c.array.push_back (static_cast<uint16_t> (
+                            (w << 6) + __builtin_ctzll (word)));
+                    }
+                }
+                std::vector<uint64_t> ().swap (c.bits);
+            }
+            continue;
+        }
+        if (kind > 2 || !get (in, n, 2))
+        {
+            return false;
+        }
+
+        // Values and runs must be ascending and disjoint.
+        std::vector<std::pair<uint16_t, uint16_t> > runs;
+        int64_t previous = -1;
+        for (uint64_t j = 0; j <= n; ++j)
+        {
+            uint64_t a, b = 0;
+            if (!get (in, a, 2) || (kind == 2 && !get (in, b, 2))
+                || int64_t (a) <= previous || a + b > 0xffff)
+            {
+                return false;
+            }
+            previous = int64_t (a + b);
+            runs.emplace_back (a, a + b);
+            c.cardinality += static_cast<uint32_t> (b + 1);
+        }
+        if (c.cardinality > kArrayMax)
+        {
+            c.bits.assign (kWords, 0);
+        }
+        uint32_t cardinality = c.cardinality;
+        for (const auto &r : runs)
+        {
+            if (c.is_bitmap ())
+            {
+                c.add_range (r.first, r.second);
+                continue;
+            }
+            for (uint32_t v = r.first; v <= r.second; ++v)
+            {
+                c.array.push_back (static_cast<uint16_t> (v));
+            }
+        }
+        c.cardinality = cardinality;
+    }
+    bitmap = std::move (result);
+    return true;
+}
+} // namespace KeaGenerator
@@ -0,0 +1,251 @@
+// File: KeaOccupancy.h
+#ifndef KEA_OCCUPANCY_H
+#define KEA_OCCUPANCY_H
+
+#include "KeaAddress.h"
+#include "KeaGenerator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace KeaGenerator
+{
+// --- AddressBitmap ---
+// Compressed set of IPv4 addresses in the style of a Roaring bitmap.
+// The address space is cut into 65536-address chunks keyed by the
+// upper 16 bits. A chunk holding at most 4096 addresses is a sorted
+// array of the lower 16 bits; a denser chunk is a 65536-bit bitmap.
+// Chunks without addresses are not stored.
+//
+// Range queries walk the runs of set addresses with find-first-set
+// (count trailing zeros) on the bitmap words, and counts use
+// popcount, so a sparse /8 costs no more than the chunks present.
+class AddressBitmap
+{
+  public:
+    // Inclusive address range.
+    using Range = AddressRange;
+
+    // Builds the bitmap of all addresses covered by pools and
+    // reservations of `s`. Entries that cannot be parsed are skipped.
+    static AddressBitmap from_subnet4 (const Subnet4 &s);
+
+    // Builds the bitmap from ranges in a single pass over the sorted
+    // ranges; `ranges` may be unsorted and overlapping.
+    static AddressBitmap from_ranges (std::vector<Range> ranges);
+
+    void add (uint32_t address);
+    void add_range (uint32_t low, uint32_t high);
+    bool contains (uint32_t address) const;
+
+    // Number of addresses in the set, overall and in [low, high].
+    uint64_t cardinality () const;
+    uint64_t count (uint32_t low, uint32_t high) const;
+
+    // Longest run of addresses not in the set within `within`.
+    // Returns nothing if every address is in the set.
+    std::optional<Range>
+    largest_free_run (const Ipv4Prefix &within) const;
+
+    // Number of used addresses in each /24 of `within` (length at
+    // most 24); entry i covers within.base + 256 * i.
+    std::vector<uint32_t>
+    utilization_by_24 (const Ipv4Prefix &within) const;
+
+    // Lowest aligned /length inside `within` without used addresses.
+    std::optional<Ipv4Prefix>
+    first_free_block (const Ipv4Prefix &within,
+                      unsigned length) const;
+
+    // Calls fn (low, high) for each maximal run of addresses in the
+    // set that intersects [low, high], clipped to it, in order.
+    template <class Fn>
+    void for_each_run (uint32_t low, uint32_t high, Fn fn) const;
+
+    // Compact binary form. Each chunk is stored as an array, bitmap
+    // or run list, whichever is smallest; pools are mostly runs, so
+    // a typical configuration takes a few bytes per pool.
+    void serialize (std::ostream &out) const;
+    // Reads what serialize() wrote. Returns false on malformed input.
+    static bool deserialize (std::istream &in, AddressBitmap &bitmap);
+
+    bool
+    operator== (const AddressBitmap &rhs) const
+    {
+        return chunks_ == rhs.chunks_;
+    }
+
+  private:
+    static const uint32_t kArrayMax = 4096;
+    static const uint32_t kWords = 1024;
+
+    struct Chunk
+    {
+        uint16_t key = 0;
+        uint32_t cardinality = 0;
+        std::vector<uint16_t> array; // Used while not a bitmap.
+        std::vector<uint64_t> bits;  // kWords words once dense.
+
+        bool
+        is_bitmap () const
+        {
+            return !bits.empty ();
+        }
+
+        bool
+        operator== (const Chunk &rhs) const
+        {
+            return key == rhs.key && cardinality == rhs.cardinality
+                   && array == rhs.array && bits == rhs.bits;
+        }
+
+        void add_range (uint16_t low, uint16_t high);
+        bool contains (uint16_t v) const;
+        uint32_t count (uint16_t low, uint16_t high) const;
+        void to_bitmap ();
+        // Runs of set values within [low, high], as fn (lo, hi).
+        template <class Fn>
+        void runs (uint16_t low, uint16_t high, Fn fn) const;
+    };
+
+    // The part of [low, high] inside chunk `key`, as lower 16 bits.
+    static std::pair<uint16_t, uint16_t>
+    clip (uint32_t key, uint32_t low, uint32_t high)
+    {
+        return { key == (low >> 16) ? uint16_t (low) : uint16_t (0),
+                 key == (high >> 16) ? uint16_t (high)
+                                     : uint16_t (0xffff) };
+    }
+
+    // Returns the chunk for `key`, creating it if needed.
+    Chunk &chunk (uint16_t key);
+    // First chunk whose key is >= key.
+    std::vector<Chunk>::const_iterator lower (uint16_t key) const;
+
+    // Calls fn (low, high) for each maximal run of addresses not in
+    // the set within [low, high], in order.
+    template <class Fn>
+    void for_each_gap (uint32_t low, uint32_t high, Fn fn) const;
+
+    std::vector<Chunk> chunks_; // Sorted by key.
+};
+
+template <class Fn>
+void
+AddressBitmap::Chunk::runs (uint16_t low, uint16_t high, Fn fn) const
+{
+    if (!is_bitmap ())
+    {
+        auto it
+            = std::lower_bound (array.begin (), array.end (), low);
+        while (it != array.end () && *it <= high)
+        {
+            uint16_t first = *it;
+            uint16_t last = first;
+            for (++it; it != array.end () && *it <= high
+                       && uint32_t (*it) == uint32_t (last) + 1;
+                 ++it)
+            {
+                last = *it;
+            }
+            fn (first, last);
+        }
+        return;
+    }
+
+    // Alternate between the next set and the next clear bit.
+    uint32_t x = low;
+    uint32_t end = uint32_t (high) + 1;
+    while (x < end)
+    {
+        uint32_t w = x >> 6;
+        uint64_t word = bits[w] & (~uint64_t (0) << (x & 63));
+        while (word == 0 && ++w < kWords)
+        {
+            word = bits[w];
+        }
+        if (word == 0)
+        {
+            return;
+        }
+        uint32_t first = (w << 6) + __builtin_ctzll (word);
+        if (first >= end)
+        {
+            return;
+        }
+
+        word = ~bits[w] & (~uint64_t (0) << (first & 63));
+        while (word == 0 && ++w < kWords)
+        {
+            word = ~bits[w];
+        }
+        uint32_t next
+            = word == 0 ? 65536 : (w << 6) + __builtin_ctzll (word);
+        next = std::min (next, end);
+        fn (static_cast<uint16_t> (first),
+            static_cast<uint16_t> (next - 1));
+        x = next;
+    }
+}
+
+template <class Fn>
+void
+AddressBitmap::for_each_run (uint32_t low, uint32_t high, Fn fn) const
+{
+    // Runs crossing a chunk boundary are joined before reporting.
+    bool pending = false;
+    Range run{ 0, 0 };
+    for (auto it = lower (static_cast<uint16_t> (low >> 16));
+         it != chunks_.end () && it->key <= (high >> 16); ++it)
+    {
+        uint32_t base = uint32_t (it->key) << 16;
+        auto part = clip (it->key, low, high);
+        it->runs (part.first, part.second, [&] (uint16_t lo,
+                                                uint16_t hi) {
+            uint32_t a = base | lo;
+            uint32_t b = base | hi;
+            if (pending && uint64_t (run.second) + 1 == a)
+            {
+                run.second = b;
+                return;
+            }
+            if (pending)
+            {
+                fn (run.first, run.second);
+            }
+            run = { a, b };
+            pending = true;
+        });
+    }
+    if (pending)
+    {
+        fn (run.first, run.second);
+    }
+}
+
+template <class Fn>
+void
+AddressBitmap::for_each_gap (uint32_t low, uint32_t high, Fn fn) const
+{
+    uint64_t next = low;
+    for_each_run (low, high, [&] (uint32_t a, uint32_t b) {
+        if (a > next)
+        {
+            fn (static_cast<uint32_t> (next), a - 1);
+        }
+        next = uint64_t (b) + 1;
+    });
+    if (next <= high)
+    {
+        fn (static_cast<uint32_t> (next), high);
+    }
+}
+
+} // namespace KeaGenerator
+
+#endif // KEA_OCCUPANCY_H
@@ -0,0 +1,160 @@
+#include "KeaOccupancy.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+using namespace KeaGenerator;
+
+static uint32_t
+Ip (const char *text)
+{
+    uint32_t a = 0;
+    EXPECT_TRUE (parse_ipv4 (text, a)) << text;
+    return a;
+}
+
+static Ipv4Prefix
+Net (const char *text)
+{
+    Ipv4Prefix p{};
+    EXPECT_TRUE (parse_cidr (text, p)) << text;
+    return p;
+}
+
+// Test membership and counts across array and bitmap chunks
+TEST (KeaOccupancyTest, Membership)
+{
+    AddressBitmap b;
+    b.add (Ip ("10.0.0.5"));
+    b.add_range (Ip ("10.0.1.0"), Ip ("10.0.1.255"));
+    // Dense enough to turn the 10.1.0.0/16 chunk into a bitmap, and
+    // crossing into the next chunk
+    b.add_range (Ip ("10.1.0.0"), Ip ("10.2.0.9"));
+
+    EXPECT_TRUE (b.contains (Ip ("10.0.0.5")));
+    EXPECT_FALSE (b.contains (Ip ("10.0.0.6")));
+    EXPECT_TRUE (b.contains (Ip ("10.1.200.1")));
+    EXPECT_FALSE (b.contains (Ip ("10.2.0.10")));
+    EXPECT_EQ (b.cardinality (), 1u + 256 + 65536 + 10);
+    EXPECT_EQ (b.count (Ip ("10.0.0.0"), Ip ("10.0.1.9")), 11u);
+    EXPECT_EQ (b.count (Ip ("10.1.255.250"), Ip ("10.2.0.1")), 8u);
+
+    // Adding what is already there changes nothing
+    AddressBitmap c = b;
+    c.add_range (Ip ("10.0.1.10"), Ip ("10.0.1.20"));
+    EXPECT_EQ (c, b);
+}
+
+// Test the planning queries
+TEST (KeaOccupancyTest, Queries)
+{
+    AddressBitmap b = AddressBitmap::from_ranges ({
+        { Ip ("10.0.0.0"), Ip ("10.0.0.99") },
+        { Ip ("10.0.0.120"), Ip ("10.0.0.255") },
+        { Ip ("10.0.2.0"), Ip ("10.0.2.15") },
+        { Ip ("10.0.2.20"), Ip ("10.0.255.255") },
+        { Ip ("10.0.0.50"), Ip ("10.0.0.60") }, // overlaps
+    });
+
+    auto run = b.largest_free_run (Net ("10.0.0.0/16"));
+    ASSERT_TRUE (run);
+    EXPECT_EQ (run->first, Ip ("10.0.1.0"));
+    EXPECT_EQ (run->second, Ip ("10.0.1.255"));
+    EXPECT_FALSE (b.largest_free_run (Net ("10.0.3.0/24")));
+
+    auto block = b.first_free_block (Net ("10.0.0.0/16"), 28);
+    ASSERT_TRUE (block);
+    EXPECT_EQ (format_cidr (*block), "10.0.1.0/28");
+    auto small = b.first_free_block (Net ("10.0.0.0/16"), 30);
+    ASSERT_TRUE (small);
+    EXPECT_EQ (format_cidr (*small), "10.0.0.100/30");
+    EXPECT_FALSE (b.first_free_block (Net ("10.0.3.0/24"), 28));
+
+    std::vector<uint32_t> used
+        = b.utilization_by_24 (Net ("10.0.0.0/22"));
+    ASSERT_EQ (used.size (), 4u);
+    EXPECT_EQ (used[0], 236u);
+    EXPECT_EQ (used[1], 0u);
+    EXPECT_EQ (used[2], 252u);
+    EXPECT_EQ (used[3], 256u);
+}
+
+// Test building from a Subnet4
+TEST (KeaOccupancyTest, FromSubnet4)
+{
+    Subnet4 s;
+    uint64_t id = s.add_config ("192.168.1.0/24");
+    s.add_pool_for_cfg (id, "192.168.1.100", "192.168.1.199");
+    s.add_pool_for_cfg (id, "192.168.1.10", "192.168.1.19");
+    s.add_reservation_for_cfg (id, "1a:1b:1c:1d:1e:1f",
+                               "192.168.1.5");
+    s.add_pool_for_cfg (s.add_config ("10.0.0.0/8"), "10.0.0.1",
+                        "10.0.255.254");
+
+    AddressBitmap b = AddressBitmap::from_subnet4 (s);
+    EXPECT_EQ (b.cardinality (), 100u + 10 + 1 + 65534);
+    EXPECT_TRUE (b.contains (Ip ("192.168.1.5")));
+    std::vector<uint32_t> used
+        = b.utilization_by_24 (Net ("192.168.1.0/24"));
+    ASSERT_EQ (used.size (), 1u);
+    EXPECT_EQ (used[0], 111u);
+}
+
+// Test that serialization round-trips and is compact
+TEST (KeaOccupancyTest, Serialization)
+{
+    AddressBitmap b;
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        // 1000 pools of 100 addresses: runs
+        uint32_t base = Ip ("10.0.0.0") + i * 256;
+        b.add_range (base + 10, base + 109);
+    }
+    for (uint32_t i = 0; i < 3000; ++i)
+    {
+        // Scattered reservations: arrays
+        b.add (Ip ("172.16.0.0") + i * 7);
+    }
+    // A checkerboard: only a bitmap is small
+    for (uint32_t i = 0; i < 65536; i += 2)
+    {
+        b.add (Ip ("192.168.0.0") + i);
+    }
+
+    std::stringstream data;
+    b.serialize (data);
+    std::string bytes = data.str ();
+    // Runs, arrays and the bitmap add up to about 18 KiB, against
+    // 530 KiB as plain 32-bit addresses
+    EXPECT_LT (bytes.size (), 20000u);
+
+    AddressBitmap back;
+    ASSERT_TRUE (AddressBitmap::deserialize (data, back));
+    EXPECT_EQ (back, b);
+    EXPECT_EQ (back.cardinality (), b.cardinality ());
+
+    std::stringstream bad (bytes.substr (0, bytes.size () / 2));
+    EXPECT_FALSE (AddressBitmap::deserialize (bad, back));
+    std::stringstream junk ("KAB2");
+    EXPECT_FALSE (AddressBitmap::deserialize (junk, back));
+
+    // A full array is stored as a bitmap; the chunk after it must
+    // still be read back.
+    AddressBitmap full;
+    for (uint32_t i = 0; i < 4096; ++i)
+    {
+        full.add (Ip ("10.1.0.0") + i * 2);
+    }
+    full.add (Ip ("10.2.0.1"));
+    std::stringstream full_data;
+    full.serialize (full_data);
+    ASSERT_TRUE (AddressBitmap::deserialize (full_data, back));
+    EXPECT_EQ (back, full);
+    EXPECT_EQ (back.cardinality (), 4097u);
+
+    // A bitmap chunk without addresses
+    std::string empty ("KAB1\x01\0\0\0\0\0\x01", 11);
+    empty.append (8 * 1024, '\0');
+    std::stringstream empty_data (empty);
+    EXPECT_FALSE (AddressBitmap::deserialize (empty_data, back));
+}
@@ -0,0 +1,91 @@
+// File: KeaParallel.h
+#ifndef KEA_PARALLEL_H
+#define KEA_PARALLEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace KeaGenerator
+{
+// --- Worker threads ---
+// Helpers for the bulk passes (lease analysis, fleet checks, ...).
+// Work is split up front, so workers share nothing but their input.
+
+// Number of workers to use: `requested`, or one per hardware thread
+// if it is 0.
+inline unsigned
+worker_count (unsigned requested)
+{
+    if (requested != 0)
+    {
+        return requested;
+    }
+    return std::max (1u, std::thread::hardware_concurrency ());
+}
+
+// Runs fn (0) .. fn (n - 1) on n threads and waits for them. With a
+// single worker, fn runs on the calling thread.
+template <class Fn>
+void
+run_parallel (unsigned n, Fn fn)
+{
+    if (n <= 1)
+    {
+        fn (0u);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve (n);
+    for (unsigned i = 0; i < n; ++i)
+    {
+        workers.emplace_back (fn, i);
+    }
+    for (std::thread &t : workers)
+    {
+        t.join ();
+    }
+}
+
+// Splits [0, items) into up to `workers` contiguous slices and runs
+// fn (slice, begin, end) for each slice on its own thread. Slices are
+// numbered in order, so per-slice results concatenate in item order.
+template <class Fn>
+void
+parallel_slices (std::size_t items, unsigned workers, Fn fn)
+{
+    std::size_t slices = std::min<std::size_t> (workers, items);
+    unsigned n = slices == 0 ? 1 : static_cast<unsigned> (slices);
+    run_parallel (n, [&] (unsigned i) {
+        fn (i, items * i / n, items * (i + 1) / n);
+    });
+}
+
+// Splits `data` into up to n chunks ending on line boundaries, for
+// parsing line-oriented input in parallel slices.
+inline std::vector<std::string_view>
+split_lines (std::string_view data, unsigned n)
+{
+    std::vector<std::string_view> chunks;
+    std::size_t begin = 0;
+    for (unsigned i = 1; i <= n; ++i)
+    {
+        std::size_t end = data.size () * i / n;
+        if (i < n && end > begin)
+        {
+            std::size_t eol = data.find ('\n', end);
+            end = eol == std::string_view::npos ? data.size ()
+                                                : eol + 1;
+        }
+        end = std::max (end, begin);
+        chunks.push_back (data.substr (begin, end - begin));
+        begin = end;
+    }
+    return chunks;
+}
+
+} // namespace KeaGenerator
+
+#endif // KEA_PARALLEL_H
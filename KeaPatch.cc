@@ -0,0 +1,469 @@
+#include "KeaPatch.h"
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace KeaGenerator
+{
+namespace
+{
+// 64-bit FNV-1a over the fields of a section. Strings carry their
+// length, so ("ab", "c") and ("a", "bc") hash differently.
+class Hasher
+{
+  public:
+    void
+    bytes (const void *data, std::size_t n)
+    {
+        auto p = static_cast<const unsigned char *> (data);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            h_ = (h_ ^ p[i]) * 1099511628211ull;
+        }
+    }
+
+    void
+    number (uint64_t n)
+    {
+        bytes (&n, sizeof (n));
+    }
+
+    void
+    string (std::string_view s)
+    {
+        number (s.size ());
+        bytes (s.data (), s.size ());
+    }
+
+    uint64_t
+    value () const
+    {
+        return h_;
+    }
+
+  private:
+    uint64_t h_ = 14695981039346656037ull;
+};
+
+uint64_t
+hash_subnet (const Subnet4::Cfg &c)
+{
+    Hasher h;
+    h.number (c.id);
+    h.string (c.subnet);
+    h.number (c.pools.size ());
+    for (const Subnet4::Pool &p : c.pools)
+    {
+        h.string (p.range);
+    }
+    h.number (c.reservations.size ());
+    for (const Subnet4::Reservation &r : c.reservations)
+    {
+        h.string (r.hw_address);
+        h.string (r.ip_address);
+        h.string (r.hostname);
+    }
+    return h.value ();
+}
+
+uint64_t
+hash_option (const OptionData::Option &o)
+{
+    Hasher h;
+    h.string (o.name);
+    h.string (o.data);
+    h.number (o.always_send);
+    return h.value ();
+}
+
+// Writes the operations of one patch and counts them.
+class PatchWriter
+{
+  public:
+    explicit PatchWriter (JsonWriter &w) : w_ (w) {}
+
+    void
+    remove (const std::string &path)
+    {
+        begin ("remove", path);
+        w_.end_object ();
+    }
+
+    // `value` writes the value of the operation to the JsonWriter.
+    template <class Value>
+    void
+    add (const std::string &path, Value value)
+    {
+        with_value ("add", path, value);
+    }
+
+    template <class Value>
+    void
+    replace (const std::string &path, Value value)
+    {
+        with_value ("replace", path, value);
+    }
+
+    std::size_t
+    count () const
+    {
+        return count_;
+    }
+
+  private:
+    void
+    begin (const char *op, const std::string &path)
+    {
+        ++count_;
+        w_.begin_object ();
+        w_.key ("op");
+        w_.string (op);
+        w_.key ("path");
+        w_.string (path);
+    }
+
+    template <class Value>
+    void
+    with_value (const char *op, const std::string &path, Value &value)
+    {
+        begin (op, path);
+        w_.key ("value");
+        value (w_);
+        w_.end_object ();
+    }
+
+    JsonWriter &w_;
+    std::size_t count_ = 0;
+};
+
+// Value writer for anything write_json handles.
+template <class T>
+auto
+json_of (const T &t)
+{
+    return [&t] (JsonWriter &w) { write_json (w, t); };
+}
+
+std::string
+element (const std::string &array, std::size_t index)
+{
+    return array + '/' + std::to_string (index);
+}
+
+// Patches the array at `path` from the sorted range [a, a_end) to
+// the sorted range [b, b_end), matching elements by key (). An
+// element in both is replaced if changed (x, y, ia, ib) says so,
+// where ia and ib are the positions of x and y in their ranges.
+template <class It, class Key, class Changed>
+void
+diff_array (PatchWriter &p, const std::string &path, It a, It a_end,
+            It b, It b_end, Key key, Changed changed)
+{
+    std::size_t index = 0; // Position in the array being patched.
+    std::size_t ia = 0, ib = 0;
+    while (a != a_end || b != b_end)
+    {
+        if (b == b_end || (a != a_end && key (*a) < key (*b)))
+        {
+            p.remove (element (path, index));
+            ++a, ++ia;
+        }
+        else if (a == a_end || key (*b) < key (*a))
+        {
+            p.add (element (path, index++), json_of (*b));
+            ++b, ++ib;
+        }
+        else
+        {
+            if (changed (*a, *b, ia, ib))
+            {
+                p.replace (element (path, index), json_of (*b));
+            }
+            ++index;
+            ++a, ++ia;
+            ++b, ++ib;
+        }
+    }
+}
+
+// Edits one subnet in place: its address, pools and reservations.
+// The id is the same on both sides.
+void
+diff_subnet (PatchWriter &p, const std::string &path,
+             const Subnet4::Cfg &a, const Subnet4::Cfg &b)
+{
+    if (a.subnet != b.subnet)
+    {
+        p.replace (path + "/subnet", [&b] (JsonWriter &w) {
+            w.string (b.subnet);
+        });
+    }
+
+    auto range = [] (const Subnet4::Pool &x) {
+        return std::string_view (x.range);
+    };
+    auto never = [] (const auto &, const auto &, std::size_t,
+                     std::size_t) { return false; };
+    diff_array (p, path + "/pools", a.pools.begin (), a.pools.end (),
+                b.pools.begin (), b.pools.end (), range, never);
+
+    // The key is only written for a non-empty set.
+    std::string reservations = path + "/reservations";
+    auto write_reservations = [&b] (JsonWriter &w) {
+        w.begin_array ();
+        for (const Subnet4::Reservation &r : b.reservations)
+        {
+            write_json (w, r);
+        }
+        w.end_array ();
+    };
+    if (a.reservations.empty () && !b.reservations.empty ())
+    {
+        p.add (reservations, write_reservations);
+    }
+    else if (!a.reservations.empty () && b.reservations.empty ())
+    {
+        p.remove (reservations);
+    }
+    else
+    {
+        using Reservation = Subnet4::Reservation;
+        auto hw_address = [] (const Reservation &r) {
+            return std::string_view (r.hw_address);
+        };
+        auto changed = [] (const Reservation &x, const Reservation &y,
+                           std::size_t, std::size_t) {
+            return x.ip_address != y.ip_address
+                   || x.hostname != y.hostname;
+        };
+        diff_array (p, reservations, a.reservations.begin (),
+                    a.reservations.end (), b.reservations.begin (),
+                    b.reservations.end (), hw_address, changed);
+    }
+}
+
+// The sections of the Dhcp4 object write_json gives a
+// configuration: like write_dhcp4_head, it stops at the first empty
+// required section, and option-data is only written if non-empty.
+struct Sections
+{
+    explicit Sections (const Dhcp4 &d)
+        : interfaces (!d.interface_config.empty ()),
+          lease_database (interfaces && !d.lease_database.empty ()),
+          subnets (lease_database && !d.subnet4.empty ()),
+          options (subnets && !d.option_data.empty ())
+    {
+    }
+
+    bool interfaces;
+    bool lease_database;
+    bool subnets;
+    bool options;
+};
+
+// Adds or removes a whole section that is in only one of the
+// documents. Returns true if it is in both, for the caller to diff.
+template <class Value>
+bool
+add_or_remove (PatchWriter &p, const std::string &path, bool in_from,
+               bool in_to, Value value)
+{
+    if (in_from && !in_to)
+    {
+        p.remove (path);
+    }
+    else if (!in_from && in_to)
+    {
+        p.add (path, value);
+    }
+    return in_from && in_to;
+}
+
+// The subnet with an id taken from a digest.
+const Subnet4::Cfg &
+cfg_of (const Subnet4 &subnets, uint64_t id)
+{
+    auto it = subnets.cfgs.find (id);
+    if (it == subnets.cfgs.end ())
+    {
+        throw std::invalid_argument (
+            "configuration digest does not match its configuration");
+    }
+    return it->second;
+}
+
+// Walks the ids of the digests, which are already in serialization
+// order; only subnets that are added or whose hashes differ are
+// looked up.
+void
+diff_subnets (PatchWriter &p, const Subnet4 &from,
+              const ConfigDigest &fd, const Subnet4 &to,
+              const ConfigDigest &td)
+{
+    const std::string path = "/Dhcp4/subnet4";
+    const auto &a = fd.subnets;
+    const auto &b = td.subnets;
+    if (a == b)
+    {
+        return;
+    }
+
+    std::size_t index = 0, i = 0, j = 0;
+    while (i < a.size () || j < b.size ())
+    {
+        if (j == b.size ()
+            || (i < a.size () && a[i].first < b[j].first))
+        {
+            p.remove (element (path, index));
+            ++i;
+        }
+        else if (i == a.size () || b[j].first < a[i].first)
+        {
+            p.add (element (path, index++),
+                   json_of (cfg_of (to, b[j].first)));
+            ++j;
+        }
+        else
+        {
+            if (a[i].second != b[j].second)
+            {
+                diff_subnet (p, element (path, index),
+                             cfg_of (from, a[i].first),
+                             cfg_of (to, b[j].first));
+            }
+            ++index, ++i, ++j;
+        }
+    }
+}
+
+void
+diff_options (PatchWriter &p, const OptionData &from,
+              const ConfigDigest &fd, const OptionData &to,
+              const ConfigDigest &td)
+{
+    const std::string path = "/Dhcp4/option-data";
+    if (fd.options == td.options)
+    {
+        return;
+    }
+    using Option = OptionData::Option;
+    auto name = [] (const Option &o) {
+        return std::string_view (o.name);
+    };
+    // Compared by their digests.
+    auto changed = [&] (const Option &, const Option &,
+                        std::size_t ia, std::size_t ib) {
+        return fd.options[ia] != td.options[ib];
+    };
+    diff_array (p, path, from.options.begin (), from.options.end (),
+                to.options.begin (), to.options.end (), name,
+                changed);
+}
+} // namespace
+
+ConfigDigest
+digest_config (const KeaConfig &config)
+{
+    const Dhcp4 &d = config.dhcp4;
+    ConfigDigest digest;
+
+    Hasher lifetime;
+    lifetime.number (d.valid_lifetime);
+    digest.valid_lifetime = lifetime.value ();
+
+    Hasher interfaces;
+    interfaces.number (d.interface_config.interfaces.size ());
+    for (const std::string &name : d.interface_config.interfaces)
+    {
+        interfaces.string (name);
+    }
+    digest.interfaces = interfaces.value ();
+
+    Hasher lease;
+    lease.string (d.lease_database.type);
+    lease.number (d.lease_database.persist);
+    lease.string (d.lease_database.name);
+    digest.lease_database = lease.value ();
+
+    digest.subnets.reserve (d.subnet4.cfgs.size ());
+    for (const Subnet4::Cfg *cfg : sorted_cfgs (d.subnet4))
+    {
+        digest.subnets.emplace_back (cfg->id, hash_subnet (*cfg));
+    }
+    digest.options.reserve (d.option_data.options.size ());
+    for (const OptionData::Option &o : d.option_data.options)
+    {
+        digest.options.push_back (hash_option (o));
+    }
+    return digest;
+}
+
+std::size_t
+write_json_patch (JsonWriter &w, const KeaConfig &from,
+                  const ConfigDigest &from_digest,
+                  const KeaConfig &to, const ConfigDigest &to_digest)
+{
+    const Dhcp4 &a = from.dhcp4;
+    const Dhcp4 &b = to.dhcp4;
+    auto matches = [] (const ConfigDigest &digest, const Dhcp4 &d) {
+        return digest.subnets.size () == d.subnet4.cfgs.size ()
+               && digest.options.size ()
+                      == d.option_data.options.size ();
+    };
+    if (!matches (from_digest, a) || !matches (to_digest, b))
+    {
+        throw std::invalid_argument (
+            "configuration digest does not match its configuration");
+    }
+
+    // A section that is written on one side only is added or
+    // removed as a whole.
+    Sections sa (a), sb (b);
+    PatchWriter p (w);
+    w.begin_array ();
+    if (from_digest.valid_lifetime != to_digest.valid_lifetime)
+    {
+        p.replace ("/Dhcp4/valid-lifetime", [&b] (JsonWriter &jw) {
+            jw.number (b.valid_lifetime);
+        });
+    }
+    if (add_or_remove (p, "/Dhcp4/interfaces-config", sa.interfaces,
+                       sb.interfaces, json_of (b.interface_config))
+        && from_digest.interfaces != to_digest.interfaces)
+    {
+        p.replace ("/Dhcp4/interfaces-config",
+                   json_of (b.interface_config));
+    }
+    if (add_or_remove (p, "/Dhcp4/lease-database", sa.lease_database,
+                       sb.lease_database, json_of (b.lease_database))
+        && from_digest.lease_database != to_digest.lease_database)
+    {
+        p.replace ("/Dhcp4/lease-database",
+                   json_of (b.lease_database));
+    }
+    if (add_or_remove (p, "/Dhcp4/subnet4", sa.subnets, sb.subnets,
+                       json_of (b.subnet4)))
+    {
+        diff_subnets (p, a.subnet4, from_digest, b.subnet4,
+                      to_digest);
+    }
+    if (add_or_remove (p, "/Dhcp4/option-data", sa.options,
+                       sb.options, json_of (b.option_data)))
+    {
+        diff_options (p, a.option_data, from_digest, b.option_data,
+                      to_digest);
+    }
+    w.end_array ();
+    return p.count ();
+}
+
+std::size_t
+write_json_patch (std::ostream &out, const KeaConfig &from,
+                  const KeaConfig &to)
+{
+    JsonWriter w (out);
+    return write_json_patch (w, from, digest_config (from), to,
+                             digest_config (to));
+}
+} // namespace KeaGenerator
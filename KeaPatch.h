@@ -0,0 +1,67 @@
+// File: KeaPatch.h
+#ifndef KEA_PATCH_H
+#define KEA_PATCH_H
+
+#include "KeaGenerator.h"
+#include "KeaStream.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace KeaGenerator
+{
+// --- JSON Patch ---
+// RFC 6902 patches between two versions of a KeaConfig, for
+// consumers that keep the document written by write_json and apply
+// updates to it. Paths follow that document, arrays included:
+// subnets in ascending id order, pools, reservations and options in
+// set order, so an index in a path is the position the serializer
+// gives the element.
+//
+// Operations are applied in sequence, so indices account for the
+// operations before them. Sections follow the rules of
+// write_dhcp4_head: one that is written for only one of the two
+// versions, such as subnet4 when the other has no subnets, is added
+// or removed as a whole. Sections are compared by hash first; only
+// those that differ are walked, and a changed subnet becomes edits
+// of its fields and pools rather than a replacement of the subnet.
+
+// Hashes of the sections of one configuration version. Keep the
+// digest of the version last published to diff the next one
+// against it without hashing it again.
+struct ConfigDigest
+{
+    uint64_t valid_lifetime = 0;
+    uint64_t interfaces = 0;
+    uint64_t lease_database = 0;
+    // (id, hash) per subnet, in ascending id order.
+    std::vector<std::pair<uint64_t, uint64_t> > subnets;
+    // One hash per option, in name order.
+    std::vector<uint64_t> options;
+};
+
+ConfigDigest digest_config (const KeaConfig &config);
+
+// Writes the patch turning `from` into `to` as a JSON array of
+// operations. The digests must be those of the two configurations.
+// Beyond comparing the digests, the work is proportional to the
+// subnets and options that changed. A digest is only checked against
+// its configuration for its counts and the ids of changed subnets, so
+// a stale digest that passes those checks gives a wrong patch.
+// Returns the number of operations.
+std::size_t write_json_patch (JsonWriter &w, const KeaConfig &from,
+                              const ConfigDigest &from_digest,
+                              const KeaConfig &to,
+                              const ConfigDigest &to_digest);
+
+// Same, digesting both configurations first.
+std::size_t write_json_patch (std::ostream &out,
+                              const KeaConfig &from,
+                              const KeaConfig &to);
+
+} // namespace KeaGenerator
+
+#endif // KEA_PATCH_H
@@ -0,0 +1,179 @@
+#include "KeaPatch.h"
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <string>
+
+using namespace KeaGenerator;
+using json = nlohmann::json;
+
+static json
+Document (const KeaConfig &config)
+{
+    std::ostringstream out;
+    write_json (out, config);
+    return json::parse (out.str ());
+}
+
+// Writes the patch from `a` to `b` and checks that applying it to the
+// document of `a` gives the document of `b`.
+static json
+Patch (const KeaConfig &a, const KeaConfig &b)
+{
+    std::ostringstream out;
+    std::size_t ops = write_json_patch (out, a, b);
+    json patch = json::parse (out.str ());
+    EXPECT_EQ (patch.size (), ops);
+    EXPECT_EQ (Document (a).patch (patch), Document (b));
+    return patch;
+}
+
+class KeaPatchTest : public ::testing::Test
+{
+  protected:
+    void
+    SetUp () override
+    {
+        Subnet4 &s = before.dhcp4.subnet4;
+        for (int i = 0; i < 5; ++i)
+        {
+            std::string net = "10.0." + std::to_string (i) + ".";
+            uint64_t id = s.add_config (net + "0/24");
+            s.add_pool_for_cfg (id, net + "10", net + "99");
+            s.add_pool_for_cfg (id, net + "100", net + "199");
+        }
+        s.add_reservation_for_cfg (2, "1a:1b:1c:1d:1e:1f",
+                                   "10.0.1.5");
+        before.dhcp4.option_data.add_option ("routers", "10.0.0.1",
+                                             false);
+        after = before;
+    }
+
+    KeaConfig before;
+    KeaConfig after;
+};
+
+// Test that identical configurations give an empty patch
+TEST_F (KeaPatchTest, NoChanges)
+{
+    EXPECT_TRUE (Patch (before, after).empty ());
+}
+
+// Test edits inside one subnet
+TEST_F (KeaPatchTest, SubnetEdits)
+{
+    Subnet4 &s = after.dhcp4.subnet4;
+    s.cfgs[3].pools.erase ({ "10.0.2.10 - 10.0.2.99" });
+    s.add_pool_for_cfg (3, "10.0.2.200", "10.0.2.250");
+    s.cfgs[2].reservations.clear ();
+    s.add_reservation_for_cfg (4, "2a:2b:2c:2d:2e:2f", "10.0.3.7");
+
+    json patch = Patch (before, after);
+    ASSERT_EQ (patch.size (), 4u);
+    EXPECT_EQ (patch[0]["op"], "remove");
+    EXPECT_EQ (patch[0]["path"], "/Dhcp4/subnet4/1/reservations");
+    EXPECT_EQ (patch[1]["path"], "/Dhcp4/subnet4/2/pools/0");
+    EXPECT_EQ (patch[2]["op"], "add");
+    EXPECT_EQ (patch[2]["path"], "/Dhcp4/subnet4/2/pools/1");
+    EXPECT_EQ (patch[2]["value"]["pool"], "10.0.2.200 - 10.0.2.250");
+    EXPECT_EQ (patch[3]["path"], "/Dhcp4/subnet4/3/reservations");
+}
+
+// Test that indices account for earlier removals and additions
+TEST_F (KeaPatchTest, SubnetsAddedAndRemoved)
+{
+    Subnet4 &s = after.dhcp4.subnet4;
+    s.cfgs.erase (1);
+    s.cfgs.erase (4);
+    s.add_config ("192.168.0.0/24");
+    s.cfgs[5].subnet = "10.0.40.0/24";
+
+    json patch = Patch (before, after);
+    ASSERT_EQ (patch.size (), 4u);
+    EXPECT_EQ (patch[0]["path"], "/Dhcp4/subnet4/0");
+    EXPECT_EQ (patch[1]["path"], "/Dhcp4/subnet4/2");
+    EXPECT_EQ (patch[2]["path"], "/Dhcp4/subnet4/2/subnet");
+    EXPECT_EQ (patch[3]["op"], "add");
+    EXPECT_EQ (patch[3]["path"], "/Dhcp4/subnet4/3");
+}
+
+// Test the global sections and option data
+TEST_F (KeaPatchTest, GlobalSections)
+{
+    after.dhcp4.valid_lifetime = 7200;
+    after.dhcp4.lease_database.persist = false;
+    after.dhcp4.option_data.options.clear ();
+    after.dhcp4.option_data.add_option ("routers", "10.0.0.254",
+                                        false);
+    after.dhcp4.option_data.add_option_always ("domain-name", "lab");
+    EXPECT_EQ (Patch (before, after).size (), 4u);
+
+    KeaConfig bare = before;
+    bare.dhcp4.option_data.options.clear ();
+    json patch = Patch (bare, after);
+    EXPECT_EQ (patch.back ()["path"], "/Dhcp4/option-data");
+    Patch (after, bare);
+}
+
+// Test sections that are written for only one of the versions
+TEST_F (KeaPatchTest, SectionsAddedAndRemoved)
+{
+    KeaConfig empty = before;
+    empty.dhcp4.subnet4 = Subnet4 ();
+    KeaConfig one = empty;
+    one.dhcp4.subnet4.add_config ("10.0.0.0/24");
+
+    // Without subnets, neither subnet4 nor option-data is written
+    json patch = Patch (empty, one);
+    ASSERT_EQ (patch.size (), 2u);
+    EXPECT_EQ (patch[0]["op"], "add");
+    EXPECT_EQ (patch[0]["path"], "/Dhcp4/subnet4");
+    EXPECT_EQ (patch[1]["path"], "/Dhcp4/option-data");
+    patch = Patch (one, empty);
+    ASSERT_EQ (patch.size (), 2u);
+    EXPECT_EQ (patch[0]["op"], "remove");
+    Patch (empty, before);
+    Patch (before, empty);
+
+    // An empty lease database hides everything after it
+    KeaConfig no_lease = before;
+    no_lease.dhcp4.lease_database.name.clear ();
+    patch = Patch (before, no_lease);
+    EXPECT_EQ (patch.size (), 3u);
+    Patch (no_lease, after);
+}
+
+// Test that a patch against a large configuration stays small
+TEST_F (KeaPatchTest, LargeConfig)
+{
+    KeaConfig a;
+    for (int i = 0; i < 20000; ++i)
+    {
+        std::string net = "10." + std::to_string (i / 256) + "."
+                          + std::to_string (i % 256) + ".";
+        uint64_t id = a.dhcp4.subnet4.add_config (net + "0/24");
+        a.dhcp4.subnet4.add_pool_for_cfg (id, net + "10", net + "99");
+    }
+    KeaConfig b = a;
+    b.dhcp4.subnet4.add_pool_for_cfg (12345, "10.48.56.100",
+                                      "10.48.56.199");
+
+    ConfigDigest da = digest_config (a);
+    ConfigDigest db = digest_config (b);
+    std::ostringstream out;
+    JsonWriter w (out);
+    EXPECT_EQ (write_json_patch (w, a, da, b, db), 1u);
+    EXPECT_EQ (json::parse (out.str ())[0]["path"],
+               "/Dhcp4/subnet4/12344/pools/1");
+
+    EXPECT_THROW (write_json_patch (w, a, db, b, ConfigDigest ()),
+                  std::invalid_argument);
+
+    // A stale digest with the right counts but an unknown subnet
+    ConfigDigest stale = db;
+    stale.subnets.back () = { 99999, 0 };
+    std::ostringstream out2;
+    JsonWriter w2 (out2);
+    EXPECT_THROW (write_json_patch (w2, a, da, b, stale),
+                  std::invalid_argument);
+}
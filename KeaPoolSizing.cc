@@ -0,0 +1,508 @@
+#include "KeaPoolSizing.h"
+#include "KeaAddress.h"
+#include "KeaParallel.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace KeaGenerator
+{
+namespace
+{
+// One lease row: `address` is occupied in `subnet` from `start` up
+// to, but not including, `end`.
+struct LeaseRow
+{
+    uint64_t subnet;
+    uint32_t address;
+    int64_t start;
+    int64_t end;
+};
+
+// The rows of one input chunk, split by destination partition.
+struct ChunkRows
+{
+    std::vector<std::vector<LeaseRow> > parts;
+    uint64_t rows = 0;
+    uint64_t malformed = 0;
+    int64_t last_start = std::numeric_limits<int64_t>::min ();
+};
+
+// Usage of one subnet, computed by the partition owning it.
+struct SubnetStats
+{
+    uint64_t rows = 0;
+    uint64_t peak = 0;
+    std::vector<uint32_t> active; // Sorted leased addresses.
+};
+
+template <class Int>
+bool
+parse_int (std::string_view text, Int &value)
+{
+    const char *end = text.data () + text.size ();
+    auto r = std::from_chars (text.data (), end, value);
+    return r.ec == std::errc () && r.ptr == end && !text.empty ();
+}
+
+// Parses address, valid_lifetime, expire and subnet_id out of a
+// memfile row; the remaining columns are ignored.
+bool
+parse_row (std::string_view line, LeaseRow &row)
+{
+    std::string_view fields[6];
+    std::size_t pos = 0;
+    for (int i = 0; i < 6; ++i)
+    {
+        std::size_t comma = line.find (',', pos);
+        if (comma == std::string_view::npos)
+        {
+            if (i < 5)
+            {
+                return false;
+            }
+            comma = line.size ();
+        }
+        fields[i] = line.substr (pos, comma - pos);
+        pos = comma + 1;
+    }
+
+    uint32_t lifetime;
+    int64_t expire;
+    if (!parse_ipv4 (fields[0], row.address)
+        || !parse_int (fields[3], lifetime)
+        || !parse_int (fields[4], expire)
+        || !parse_int (fields[5], row.subnet))
+    {
+        return false;
+    }
+    row.start = expire - static_cast<int64_t> (lifetime);
+    row.end = expire;
+    return true;
+}
+
+ChunkRows
+parse_chunk (std::string_view chunk, std::size_t partitions)
+{
+    ChunkRows out;
+    out.parts.resize (partitions);
+    std::size_t pos = 0;
+    while (pos < chunk.size ())
+    {
+        std::size_t eol = chunk.find ('\n', pos);
+        if (eol == std::string_view::npos)
+        {
+            eol = chunk.size ();
+        }
+        std::string_view line = chunk.substr (pos, eol - pos);
+        pos = eol + 1;
+        if (!line.empty () && line.back () == '\r')
+        {
+            line.remove_suffix (1);
+        }
+        if (line.empty () || line.compare (0, 8, "address,") == 0)
+        {
+            continue;
+        }
+
+        LeaseRow row;
+        if (!parse_row (line, row))
+        {
+            ++out.malformed;
+            continue;
+        }
+        ++out.rows;
+        out.last_start = std::max (out.last_start, row.start);
+        out.parts[row.subnet % partitions].push_back (row);
+    }
+    return out;
+}
+
+// Turns the rows of one partition into per-subnet statistics. Rows of
+// an address are taken in file order: each row redefines when the
+// lease ends, extending the current interval if it starts before the
+// interval ended.
+void
+analyze_partition (std::vector<LeaseRow> &rows, int64_t now,
+                   std::unordered_map<uint64_t, SubnetStats> &stats)
+{
+    std::stable_sort (rows.begin (), rows.end (),
+                      [] (const LeaseRow &a, const LeaseRow &b) {
+                          return a.subnet != b.subnet
+                                     ? a.subnet < b.subnet
+                                     : a.address < b.address;
+                      });
+
+    std::vector<std::pair<int64_t, int> > events;
+    std::size_t i = 0;
+    while (i < rows.size ())
+    {
+        uint64_t subnet = rows[i].subnet;
+        SubnetStats &s = stats[subnet];
+        events.clear ();
+
+        while (i < rows.size () && rows[i].subnet == subnet)
+        {
+            uint32_t address = rows[i].address;
+            int64_t start = rows[i].start;
+            int64_t end = rows[i].end;
+            for (++i; i < rows.size () && rows[i].subnet == subnet
+                      && rows[i].address == address;
+                 ++i)
+            {
+                const LeaseRow &r = rows[i];
+                if (r.start <= end)
+                {
+                    start = std::min (start, r.start);
+                    end = r.end;
+                    continue;
+                }
+                if (end > start)
+                {
+                    events.emplace_back (start, 1);
+                    events.emplace_back (end, -1);
+                }
+                start = r.start;
+                end = r.end;
+            }
+            if (end > start)
+            {
+                events.emplace_back (start, 1);
+                events.emplace_back (end, -1);
+                if (start <= now && end > now)
+                {
+                    s.active.push_back (address);
+                }
+            }
+        }
+
+        // Ends sort before starts at the same time.
+        std::sort (events.begin (), events.end ());
+        int64_t current = 0;
+        for (const auto &e : events)
+        {
+            current += e.second;
+            s.peak
+                = std::max (s.peak, static_cast<uint64_t> (current));
+        }
+    }
+
+    for (const LeaseRow &r : rows)
+    {
+        ++stats[r.subnet].rows;
+    }
+}
+
+// Computes the new pools of one subnet. Returns false to leave the
+// subnet unchanged.
+bool
+resize (Subnet4::Cfg &cfg, const SubnetStats &stats,
+        const PoolSizingOptions &options, SubnetUsage &usage)
+{
+    Ipv4Prefix net;
+    if (!parse_cidr (cfg.subnet, net))
+    {
+        return false;
+    }
+    uint32_t lo = net.base;
+    uint32_t hi = net.last ();
+    if (net.length <= 30)
+    {
+        // Skip the network and broadcast addresses.
+        ++lo;
+        --hi;
+    }
+
+    AddressRanges pools;
+    for (const Subnet4::Pool &p : cfg.pools)
+    {
+        uint32_t low, high;
+        if (!parse_pool_range (p.range, low, high))
+        {
+            return false;
+        }
+        low = std::max (low, lo);
+        high = std::min (high, hi);
+        if (low <= high)
+        {
+            pools.emplace_back (low, high);
+        }
+    }
+    normalize_ranges (pools);
+
+    auto in_pools = [&pools] (uint32_t a) {
+        auto it = std::upper_bound (pools.begin (), pools.end (),
+                                    AddressRange (a, ~uint32_t (0)));
+        return it != pools.begin () && std::prev (it)->second >= a;
+    };
+
+    // Addresses the new pools must contain, and those they must not.
+    std::vector<uint32_t> keep;
+    AddressRanges blocked;
+    for (const Subnet4::Reservation &r : cfg.reservations)
+    {
+        uint32_t a;
+        if (parse_ipv4 (r.ip_address, a) && a >= lo && a <= hi)
+        {
+            if (in_pools (a))
+            {
+                keep.push_back (a);
+            }
+            else
+            {
+                blocked.emplace_back (a, a);
+            }
+        }
+    }
+    normalize_ranges (blocked);
+    for (uint32_t a : stats.active)
+    {
+        auto it = std::upper_bound (blocked.begin (), blocked.end (),
+                                    AddressRange (a, ~uint32_t (0)));
+        bool is_blocked
+            = it != blocked.begin () && std::prev (it)->second >= a;
+        if (a >= lo && a <= hi && !is_blocked)
+        {
+            keep.push_back (a);
+        }
+    }
+    std::sort (keep.begin (), keep.end ());
+    keep.erase (std::unique (keep.begin (), keep.end ()),
+                keep.end ());
+
+    // Clamped so that the conversion is defined: a negative headroom
+    // counts as none, and no subnet needs more than 2^32 addresses.
+    double headroom = std::max (0.0, options.headroom);
+    uint64_t wanted = static_cast<uint64_t> (
+        std::min (std::ceil (double (stats.peak) * (1.0 + headroom)),
+                  4294967296.0));
+    uint64_t target = std::max (
+        { wanted, options.min_pool_size, uint64_t (keep.size ()) });
+
+    AddressRanges result;
+    for (uint32_t a : keep)
+    {
+        result.emplace_back (a, a);
+    }
+    uint64_t before = count_addresses (pools);
+    if (before >= target)
+    {
+        // Shrink: the kept addresses plus the lowest other addresses
+        // of the current pools.
+        uint64_t extra = target - keep.size ();
+        auto k = keep.begin ();
+        for (const AddressRange &p : pools)
+        {
+            uint64_t next = p.first;
+            while (extra > 0 && next <= p.second)
+            {
+                k = std::lower_bound (k, keep.end (), next);
+                uint64_t stop = k != keep.end () && *k <= p.second
+                                    ? uint64_t (*k)
+                                    : uint64_t (p.second) + 1;
+                uint64_t take = std::min (extra, stop - next);
+                if (take > 0)
+                {
+                    result.emplace_back (
+                        static_cast<uint32_t> (next),
+                        static_cast<uint32_t> (next + take - 1));
+                    extra -= take;
+                }
+                next = stop + 1;
+            }
+        }
+    }
+    else
+    {
+        // Grow: extend the current pools upwards into the free space
+        // after them, then downwards into the space before the first.
+        for (const AddressRange &p : pools)
+        {
+            result.push_back (p);
+        }
+        normalize_ranges (result);
+        AddressRanges used = result;
+        used.insert (used.end (), blocked.begin (), blocked.end ());
+        normalize_ranges (used);
+
+        uint64_t extra = target - count_addresses (result);
+        AddressRanges gaps = complement_ranges (used, lo, hi);
+        bool leading
+            = !result.empty () && !gaps.empty ()
+              && gaps.front ().second < result.front ().first;
+        for (std::size_t g = leading ? 1 : 0;
+             g < gaps.size () && extra > 0; ++g)
+        {
+            uint64_t take = std::min<uint64_t> (
+                extra, uint64_t (gaps[g].second) - gaps[g].first + 1);
+            result.emplace_back (gaps[g].first,
+                                 gaps[g].first + (take - 1));
+            extra -= take;
+        }
+        if (leading && extra > 0)
+        {
+            const AddressRange &gap = gaps.front ();
+            uint64_t take = std::min<uint64_t> (
+                extra, uint64_t (gap.second) - gap.first + 1);
+            result.emplace_back (gap.second - (take - 1), gap.second);
+        }
+    }
+    normalize_ranges (result);
+
+    cfg.pools.clear ();
+    for (const AddressRange &r : result)
+    {
+        cfg.pools.insert ({ format_pool_range (r.first, r.second) });
+    }
+    usage.pool_before = before;
+    usage.pool_after = count_addresses (result);
+    usage.target_met = usage.pool_after >= target;
+    return true;
+}
+
+PoolSizingResult
+plan (const Subnet4 &current,
+      const std::vector<std::string_view> &chunks,
+      const PoolSizingOptions &options, unsigned threads)
+{
+    PoolSizingResult result;
+    result.subnet4 = current;
+
+    // Parse the chunks; each worker sorts its rows by partition.
+    std::vector<ChunkRows> parsed (chunks.size ());
+    run_parallel (threads, [&] (unsigned t) {
+        parsed[t] = parse_chunk (chunks[t], threads);
+    });
+    int64_t now = std::numeric_limits<int64_t>::min ();
+    for (const ChunkRows &c : parsed)
+    {
+        result.rows += c.rows;
+        result.malformed += c.malformed;
+        now = std::max (now, c.last_start);
+    }
+
+    // Analyze the partitions; a subnet lives in exactly one.
+    std::vector<std::unordered_map<uint64_t, SubnetStats> > stats (
+        threads);
+    run_parallel (threads, [&] (unsigned p) {
+        std::vector<LeaseRow> rows;
+        for (ChunkRows &c : parsed)
+        {
+            rows.insert (rows.end (), c.parts[p].begin (),
+                         c.parts[p].end ());
+            std::vector<LeaseRow> ().swap (c.parts[p]);
+        }
+        analyze_partition (rows, now, stats[p]);
+    });
+
+    std::vector<uint64_t> ids;
+    for (auto &partition : stats)
+    {
+        for (auto &entry : partition)
+        {
+            auto cfg = result.subnet4.cfgs.find (entry.first);
+            if (cfg == result.subnet4.cfgs.end ())
+            {
+                result.unknown_subnet += entry.second.rows;
+                continue;
+            }
+            ids.push_back (entry.first);
+        }
+    }
+    std::sort (ids.begin (), ids.end ());
+
+    for (uint64_t id : ids)
+    {
+        const SubnetStats &s = stats[id % threads][id];
+        SubnetUsage usage;
+        usage.id = id;
+        usage.rows = s.rows;
+        usage.peak = s.peak;
+        usage.active = s.active.size ();
+        if (resize (result.subnet4.cfgs[id], s, options, usage))
+        {
+            result.usage.push_back (usage);
+        }
+    }
+    result.ok = true;
+    return result;
+}
+} // namespace
+
+PoolSizingResult
+plan_pool_sizes (const Subnet4 &current, std::string_view leases,
+                 const PoolSizingOptions &options)
+{
+    unsigned threads = worker_count (options.threads);
+    return plan (current, split_lines (leases, threads), options,
+                 threads);
+}
+
+PoolSizingResult
+plan_pool_sizes_from_file (const Subnet4 &current,
+                           const std::string &path,
+                           const PoolSizingOptions &options)
+{
+    PoolSizingResult result;
+    int fd = ::open (path.c_str (), O_RDONLY);
+    if (fd < 0)
+    {
+        result.error = path + ": " + std::strerror (errno);
+        return result;
+    }
+    struct stat st;
+    if (::fstat (fd, &st) != 0)
+    {
+        result.error = path + ": " + std::strerror (errno);
+        ::close (fd);
+        return result;
+    }
+    if (st.st_size == 0)
+    {
+        ::close (fd);
+        return plan_pool_sizes (current, std::string_view (),
+                                options);
+    }
+
+    std::size_t size = static_cast<std::size_t> (st.st_size);
+    void *data
+        = ::mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close (fd);
+    if (data == MAP_FAILED)
+    {
+        result.error = path + ": " + std::strerror (errno);
+        return result;
+    }
+    ::madvise (data, size, MADV_SEQUENTIAL);
+    result = plan_pool_sizes (
+        current, std::string_view (static_cast<char *> (data), size),
+        options);
+    ::munmap (data, size);
+    return result;
+}
+
+PoolSizingResult
+plan_pool_sizes (const Dhcp4 &d, const PoolSizingOptions &options)
+{
+    if (d.lease_database.type != "memfile"
+        || d.lease_database.empty ())
+    {
+        PoolSizingResult result;
+        result.error = "lease database is not a memfile";
+        return result;
+    }
+    return plan_pool_sizes_from_file (d.subnet4,
+                                      d.lease_database.name, options);
+}
+} // namespace KeaGenerator
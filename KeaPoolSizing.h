@@ -0,0 +1,90 @@
+// File: KeaPoolSizing.h
+#ifndef KEA_POOL_SIZING_H
+#define KEA_POOL_SIZING_H
+
+#include "KeaGenerator.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace KeaGenerator
+{
+// --- Pool sizing ---
+// Resizes the pools of a Subnet4 from the lease history in a Kea
+// memfile lease file (CSV, one row per lease update):
+//
+//   address,hwaddr,client_id,valid_lifetime,expire,subnet_id,...
+//
+// A row starts or renews the lease on `address` at
+// expire - valid_lifetime and makes it end at `expire`; a row with a
+// valid_lifetime of 0 ends it. The rows of one address are merged
+// into occupancy intervals, and a sweep over the intervals of each
+// subnet yields its peak number of concurrent leases.
+//
+// Each subnet then gets pools holding peak * (1 + headroom) addresses
+// (at least min_pool_size). Shrinking keeps the lowest addresses of
+// the current pools; growing extends the current pools into the free
+// space next to them. The pools always keep the addresses leased at
+// the end of the history and the reservations that were inside them;
+// reservations outside the pools stay outside. Because leases and
+// reservations are kept, a pool may be split into several ranges.
+
+struct PoolSizingOptions
+{
+    // Free fraction on top of the peak, e.g. 0.25 for 25%. A negative
+    // value counts as 0.
+    double headroom = 0.25;
+    // Lower bound for the total pool size of a subnet.
+    uint64_t min_pool_size = 16;
+    // Worker threads; 0 uses std::thread::hardware_concurrency.
+    unsigned threads = 0;
+};
+
+// Per subnet outcome, in ascending id order.
+struct SubnetUsage
+{
+    uint64_t id = 0;
+    uint64_t rows = 0;         // Lease rows for this subnet.
+    uint64_t peak = 0;         // Peak concurrent leases.
+    uint64_t active = 0;       // Leases active at the end.
+    uint64_t pool_before = 0;  // Addresses in the old pools.
+    uint64_t pool_after = 0;   // Addresses in the new pools.
+    bool target_met = true;    // False if the subnet was too small.
+};
+
+struct PoolSizingResult
+{
+    bool ok = false;
+    std::string error;          // Set if ok is false.
+    Subnet4 subnet4;            // Copy of the input, pools resized.
+    std::vector<SubnetUsage> usage;
+    uint64_t rows = 0;          // Lease rows read.
+    uint64_t malformed = 0;     // Rows that could not be parsed.
+    uint64_t unknown_subnet = 0; // Rows for ids not in the input.
+};
+
+// Plans from lease rows held in memory (the lease file contents).
+// Subnets without lease rows, or whose subnet or pools cannot be
+// parsed, are copied unchanged.
+PoolSizingResult plan_pool_sizes (const Subnet4 &current,
+                                  std::string_view leases,
+                                  const PoolSizingOptions &options
+                                  = PoolSizingOptions ());
+
+// Plans from a lease file, which is memory-mapped and parsed in
+// parallel chunks. Fails if the file cannot be read.
+PoolSizingResult plan_pool_sizes_from_file (
+    const Subnet4 &current, const std::string &path,
+    const PoolSizingOptions &options = PoolSizingOptions ());
+
+// Plans for d.subnet4 from the memfile named by d.lease_database.
+// Fails if the lease database is not a memfile.
+PoolSizingResult plan_pool_sizes (const Dhcp4 &d,
+                                  const PoolSizingOptions &options
+                                  = PoolSizingOptions ());
+
+} // namespace KeaGenerator
+
+#endif // KEA_POOL_SIZING_H
@@ -0,0 +1,180 @@
+#include "KeaPoolSizing.h"
+#include "KeaStream.h"
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+using namespace KeaGenerator;
+
+static const char *const kHeader
+    = "address,hwaddr,client_id,valid_lifetime,expire,subnet_id,"
+      "fqdn_fwd,fqdn_rev,hostname,state,user_context,pool_id\n";
+
+// Formats one memfile lease row.
+static std::string
+Row (const std::string &address, uint64_t lifetime, uint64_t expire,
+     uint64_t subnet)
+{
+    return address + ",00:00:00:00:00:01,,"
+           + std::to_string (lifetime) + ","
+           + std::to_string (expire) + "," + std::to_string (subnet)
+           + ",0,0,,0,,0\n";
+}
+
+// Returns the pools of a subnet as "a - b|c - d|...".
+static std::string
+Pools (const Subnet4 &s, uint64_t id)
+{
+    std::string out;
+    for (const auto &p : s.cfgs.at (id).pools)
+    {
+        out += (out.empty () ? "" : "|") + p.range;
+    }
+    return out;
+}
+
+static std::string
+Render (const Subnet4 &s)
+{
+    std::ostringstream out;
+    JsonWriter w (out);
+    write_json (w, s);
+    return out.str ();
+}
+
+// Test shrinking an oversized pool around active leases
+TEST (KeaPoolSizingTest, ShrinksAroundLeasesAndReservations)
+{
+    Subnet4 s;
+    uint64_t id = s.add_config ("10.0.0.0/24");
+    s.add_pool_for_cfg (id, "10.0.0.10", "10.0.0.250");
+    s.add_reservation_for_cfg (id, "1a:1b:1c:1d:1e:1f", "10.0.0.200");
+
+    std::string leases = kHeader;
+    for (int i = 10; i < 20; ++i)
+    {
+        std::string a = "10.0.0." + std::to_string (i);
+        // A lease and a renewal of it: one interval, not two
+        leases += Row (a, 100, 1000, id);
+        leases += Row (a, 100, 1050, id);
+    }
+    leases += "not,a,lease\n";
+    leases += Row ("10.9.9.9", 100, 1000, 99);
+
+    PoolSizingOptions options;
+    options.headroom = 0.5;
+    options.min_pool_size = 4;
+    PoolSizingResult r = plan_pool_sizes (s, leases, options);
+    ASSERT_TRUE (r.ok) << r.error;
+    EXPECT_EQ (r.rows, 21u);
+    EXPECT_EQ (r.malformed, 1u);
+    EXPECT_EQ (r.unknown_subnet, 1u);
+
+    ASSERT_EQ (r.usage.size (), 1u);
+    EXPECT_EQ (r.usage[0].peak, 10u);
+    EXPECT_EQ (r.usage[0].active, 10u);
+    EXPECT_EQ (r.usage[0].pool_before, 241u);
+    EXPECT_EQ (r.usage[0].pool_after, 15u);
+    // The in-pool reservation stays inside a pool
+    EXPECT_EQ (Pools (r.subnet4, id),
+               "10.0.0.10 - 10.0.0.23|10.0.0.200 - 10.0.0.200");
+    EXPECT_EQ (r.subnet4.cfgs[id].reservations.size (), 1);
+    // The input is left alone
+    EXPECT_EQ (Pools (s, id), "10.0.0.10 - 10.0.0.250");
+
+    // A negative headroom counts as none
+    options.headroom = -2;
+    r = plan_pool_sizes (s, leases, options);
+    ASSERT_TRUE (r.ok) << r.error;
+    EXPECT_EQ (r.usage[0].pool_after, 11u);
+}
+
+// Test growing a pool past an out-of-pool reservation
+TEST (KeaPoolSizingTest, GrowsAroundOutOfPoolReservations)
+{
+    Subnet4 s;
+    uint64_t id = s.add_config ("10.1.0.0/24");
+    uint64_t quiet = s.add_config ("10.2.0.0/24");
+    s.add_pool_for_cfg (id, "10.1.0.100", "10.1.0.109");
+    s.add_pool_for_cfg (quiet, "10.2.0.100", "10.2.0.109");
+    s.add_reservation_for_cfg (id, "1a:1b:1c:1d:1e:1f", "10.1.0.110");
+
+    std::string leases;
+    for (int i = 100; i < 110; ++i)
+    {
+        std::string a = "10.1.0." + std::to_string (i);
+        leases += Row (a, 3600, 5000, id);
+    }
+    // A release ends the lease on .109 early
+    leases += Row ("10.1.0.109", 0, 2000, id);
+
+    PoolSizingOptions options;
+    options.headroom = 1.0;
+    PoolSizingResult r = plan_pool_sizes (s, leases, options);
+    ASSERT_TRUE (r.ok) << r.error;
+    ASSERT_EQ (r.usage.size (), 1u);
+    EXPECT_EQ (r.usage[0].peak, 10u);
+    EXPECT_EQ (r.usage[0].active, 9u);
+    EXPECT_EQ (Pools (r.subnet4, id),
+               "10.1.0.100 - 10.1.0.109|10.1.0.111 - 10.1.0.120");
+    // Subnets without lease rows are copied unchanged
+    EXPECT_EQ (Pools (r.subnet4, quiet), "10.2.0.100 - 10.2.0.109");
+}
+
+// Test that the result does not depend on the thread count, and that
+// the Dhcp4 entry point reads the memfile
+TEST (KeaPoolSizingTest, ParallelFileInput)
+{
+    Dhcp4 d (4000, { "eth0" });
+    for (int n = 0; n < 50; ++n)
+    {
+        std::string net = "10." + std::to_string (n) + ".0.";
+        uint64_t id = d.subnet4.add_config (net + "0/24");
+        d.subnet4.add_pool_for_cfg (id, net + "1", net + "254");
+    }
+
+    std::string leases = kHeader;
+    for (int t = 0; t < 2000; ++t)
+    {
+        for (int n = 0; n < 50; ++n)
+        {
+            int host = 1 + (t * 7 + n) % (20 + n);
+            std::string a = "10." + std::to_string (n) + ".0."
+                            + std::to_string (host);
+            leases += Row (a, 60, 1000 + t * 10, n + 1);
+        }
+    }
+
+    char path[] = "/tmp/kea-leases-XXXXXX";
+    int fd = mkstemp (path);
+    ASSERT_GE (fd, 0);
+    close (fd);
+    std::ofstream (path) << leases;
+    d.lease_database.name = path;
+
+    PoolSizingOptions serial;
+    serial.threads = 1;
+    PoolSizingOptions parallel;
+    parallel.threads = 8;
+    PoolSizingResult a = plan_pool_sizes (d.subnet4, leases, serial);
+    PoolSizingResult b = plan_pool_sizes (d, parallel);
+    std::remove (path);
+
+    ASSERT_TRUE (a.ok) << a.error;
+    ASSERT_TRUE (b.ok) << b.error;
+    EXPECT_EQ (a.rows, 100000u);
+    EXPECT_EQ (b.rows, a.rows);
+    ASSERT_EQ (b.usage.size (), 50u);
+    for (std::size_t i = 0; i < a.usage.size (); ++i)
+    {
+        EXPECT_EQ (b.usage[i].peak, a.usage[i].peak);
+        EXPECT_LT (b.usage[i].pool_after, b.usage[i].pool_before);
+    }
+    EXPECT_EQ (Render (b.subnet4), Render (a.subnet4));
+
+    d.lease_database.type = "mysql";
+    EXPECT_FALSE (plan_pool_sizes (d).ok);
+}
@@ -0,0 +1,645 @@
+#include "KeaSchema.h"
+#include "KeaAddress.h"
+#include "KeaStream.h"
+
+#include <nlohmann/json.hpp>
+
+#include <utility>
+
+namespace KeaGenerator
+{
+namespace
+{
+// --- The compiled schema ---
+// A node describes one value: its type and, for objects, a run of
+// entries in kMembers; for arrays, the node of the elements; for
+// strings, a format; for numbers, a range. Node 0 stands for "no
+// node".
+
+enum : uint8_t
+{
+    kObject,
+    kArray,
+    kString,
+    kNumber,
+    kBoolean,
+};
+
+enum : uint8_t
+{
+    kAny,
+    kNonEmpty,
+    kCidr,
+    kPoolRange, // "low - high" or a prefix.
+    kIpv4,
+    kHwAddress,
+    kDbType,
+};
+
+struct Node
+{
+    uint8_t type;
+    uint8_t format;   // Strings.
+    uint16_t first;   // Objects: first member; arrays: element node.
+    uint16_t members; // Objects: member count.
+    uint64_t min;     // Numbers.
+    uint64_t max;
+};
+
+struct Member
+{
+    std::string_view key;
+    uint16_t node;
+    bool required;
+};
+
+enum : uint16_t
+{
+    kNone,
+    kRoot,
+    kDhcp4,
+    kInterfacesConfig,
+    kInterfaces,
+    kInterfaceName,
+    kLeaseDatabase,
+    kDbTypeName,
+    kText,
+    kFlag,
+    kLifetime,
+    kSubnets,
+    kSubnet,
+    kSubnetId,
+    kPrefix,
+    kPools,
+    kPool,
+    kPoolText,
+    kReservations,
+    kReservation,
+    kHwAddressText,
+    kAddress,
+    kOptions,
+    kOption,
+    kOptionCode,
+    kNodeCount
+};
+
+const uint16_t kNoMember = 0xffff;
+
+const Member kMembers[] = {
+    // kRoot: 0
+    { "Dhcp4", kDhcp4, true },
+    // kDhcp4: 1
+    { "interfaces-config", kInterfacesConfig, true },
+    { "lease-database", kLeaseDatabase, true },
+    { "option-data", kOptions, false },
+    { "subnet4", kSubnets, true },
+    { "valid-lifetime", kLifetime, true },
+    // kInterfacesConfig: 6
+    { "interfaces", kInterfaces, true },
+    // kLeaseDatabase: 7
+    { "name", kText, false },
+    { "persist", kFlag, false },
+    { "type", kDbTypeName, true },
+    // kSubnet: 10
+    { "id", kSubnetId, true },
+    { "pools", kPools, false },
+    { "reservations", kReservations, false },
+    { "subnet", kPrefix, true },
+    // kPool: 14
+    { "pool", kPoolText, true },
+    // kReservation: 15
+    { "hostname", kText, false },
+    { "hw-address", kHwAddressText, true },
+    { "ip-address", kAddress, true },
+    // kOption: 18
+    { "always-send", kFlag, false },
+    { "code", kOptionCode, false },
+    { "csv-format", kFlag, false },
+    { "data", kText, false },
+    { "name", kText, true },
+    { "space", kText, false },
+};
+
+const uint64_t kU32 = 0xffffffffull;
+
+const Node kNodes[kNodeCount] = {
+    /* kNone */ { kObject, kAny, 0, 0, 0, 0 },
+    /* kRoot */ { kObject, kAny, 0, 1, 0, 0 },
+    /* kDhcp4 */ { kObject, kAny, 1, 5, 0, 0 },
+    /* kInterfacesConfig */ { kObject, kAny, 6, 1, 0, 0 },
+    /* kInterfaces */ { kArray, kAny, kInterfaceName, 0, 0, 0 },
+    /* kInterfaceName */ { kString, kNonEmpty, 0, 0, 0, 0 },
+    /* kLeaseDatabase */ { kObject, kAny, 7, 3, 0, 0 },
+    /* kDbTypeName */ { kString, kDbType, 0, 0, 0, 0 },
+    /* kText */ { kString, kAny, 0, 0, 0, 0 },
+    /* kFlag */ { kBoolean, kAny, 0, 0, 0, 0 },
+    /* kLifetime */ { kNumber, kAny, 0, 0, 0, kU32 },
+    /* kSubnets */ { kArray, kAny, kSubnet, 0, 0, 0 },
+    /* kSubnet */ { kObject, kAny, 10, 4, 0, 0 },
+    // Kea reserves 0 and 2^32 - 1.
+    /* kSubnetId */ { kNumber, kAny, 0, 0, 1, kU32 - 1 },
+    /* kPrefix */ { kString, kCidr, 0, 0, 0, 0 },
+    /* kPools */ { kArray, kAny, kPool, 0, 0, 0 },
+    /* kPool */ { kObject, kAny, 14, 1, 0, 0 },
+    /* kPoolText */ { kString, kPoolRange, 0, 0, 0, 0 },
+    /* kReservations */ { kArray, kAny, kReservation, 0, 0, 0 },
+    /* kReservation */ { kObject, kAny, 15, 3, 0, 0 },
+    /* kHwAddressText */ { kString, kHwAddress, 0, 0, 0, 0 },
+    /* kAddress */ { kString, kIpv4, 0, 0, 0, 0 },
+    /* kOptions */ { kArray, kAny, kOption, 0, 0, 0 },
+    /* kOption */ { kObject, kAny, 18, 6, 0, 0 },
+    /* kOptionCode */ { kNumber, kAny, 0, 0, 1, 254 },
+};
+
+const char *const kTypeNames[] = { "an object", "an array",
+                                   "a string", "a number",
+                                   "a boolean" };
+
+// 1 to 20 bytes (Kea's limit) of one or two hex digits each,
+// separated by colons.
+bool
+is_hw_address (std::string_view s)
+{
+    std::size_t bytes = 0, digits = 0;
+    for (char c : s)
+    {
+        bool hex = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')
+                   || (c >= 'A' && c <= 'F');
+        if (hex && digits < 2)
+        {
+            ++digits;
+        }
+        else if (c == ':' && digits > 0)
+        {
+            ++bytes;
+            digits = 0;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return digits > 0 && bytes + 1 <= 20;
+}
+
+bool
+matches (uint8_t format, std::string_view s)
+{
+    Ipv4Prefix prefix;
+    uint32_t a, b;
+    switch (format)
+    {
+    case kNonEmpty:
+        return !s.empty ();
+    case kCidr:
+        return parse_cidr (s, prefix);
+    case kPoolRange:
+        return parse_pool_range (s, a, b) || parse_cidr (s, prefix);
+    case kIpv4:
+        return parse_ipv4 (s, a);
+    case kHwAddress:
+        return is_hw_address (s);
+    case kDbType:
+        return s == "memfile" || s == "mysql" || s == "postgresql";
+    default:
+        return true;
+    }
+}
+
+const char *
+format_name (uint8_t format)
+{
+    switch (format)
+    {
+    case kNonEmpty:
+        return "a non-empty string";
+    case kCidr:
+        return "an IPv4 prefix";
+    case kPoolRange:
+        return "a pool range";
+    case kIpv4:
+        return "an IPv4 address";
+    case kHwAddress:
+        return "a hardware address";
+    case kDbType:
+        return "memfile, mysql or postgresql";
+    default:
+        return "a string";
+    }
+}
+
+// Appends a JSON pointer reference token.
+void
+append_token (std::string &path, std::string_view token)
+{
+    path.push_back ('/');
+    for (char c : token)
+    {
+        if (c == '~')
+        {
+            path += "~0";
+        }
+        else if (c == '/')
+        {
+            path += "~1";
+        }
+        else
+        {
+            path.push_back (c);
+        }
+    }
+}
+} // namespace
+
+// --- SchemaValidator ---
+
+SchemaValidator::SchemaValidator ()
+{
+    stack_.reserve (8);
+}
+
+void
+SchemaValidator::reset ()
+{
+    stack_.clear ();
+    done_ = false;
+    path_.clear ();
+    error_.clear ();
+}
+
+void
+SchemaValidator::fail (std::string error)
+{
+    path_.clear ();
+    for (const Frame &f : stack_)
+    {
+        const Node &n = kNodes[f.node];
+        if (n.type == kObject && f.member != kNoMember)
+        {
+            append_token (path_, kMembers[f.member].key);
+        }
+        else if (n.type == kArray && f.index > 0)
+        {
+            append_token (path_, std::to_string (f.index - 1));
+        }
+    }
+    error_ = std::move (error);
+}
+
+uint16_t
+SchemaValidator::expected ()
+{
+    if (stack_.empty ())
+    {
+        if (done_)
+        {
+            fail ("content after the document");
+            return kNone;
+        }
+        return kRoot;
+    }
+    Frame &top = stack_.back ();
+    const Node &n = kNodes[top.node];
+    if (n.type == kArray)
+    {
+        ++top.index;
+        return n.first;
+    }
+    if (top.member == kNoMember)
+    {
+        fail ("value without a key");
+        return kNone;
+    }
+    return kMembers[top.member].node;
+}
+
+bool
+SchemaValidator::value (unsigned type)
+{
+    if (!ok ())
+    {
+        return false;
+    }
+    uint16_t node = expected ();
+    if (node == kNone)
+    {
+        return false;
+    }
+    if (kNodes[node].type != type)
+    {
+        fail (std::string ("expected ")
+              + kTypeNames[kNodes[node].type] + ", found "
+              + kTypeNames[type]);
+        return false;
+    }
+    if (type == kObject || type == kArray)
+    {
+        stack_.push_back ({ node, kNoMember, 0, 0 });
+    }
+    return true;
+}
+
+void
+SchemaValidator::begin_object ()
+{
+    value (kObject);
+}
+
+void
+SchemaValidator::begin_array ()
+{
+    value (kArray);
+}
+
+void
+SchemaValidator::end_object ()
+{
+    if (!ok () || stack_.empty ())
+    {
+        return;
+    }
+    Frame &top = stack_.back ();
+    top.member = kNoMember;
+    const Node &n = kNodes[top.node];
+    for (uint16_t i = 0; i < n.members; ++i)
+    {
+        const Member &m = kMembers[n.first + i];
+        if (m.required && (top.seen & (uint32_t (1) << i)) == 0)
+        {
+            fail ("missing member \"" + std::string (m.key) + "\"");
+            return;
+        }
+    }
+    stack_.pop_back ();
+    done_ = stack_.empty ();
+}
+
+void
+SchemaValidator::end_array ()
+{
+    if (!ok () || stack_.empty ())
+    {
+        return;
+    }
+    stack_.pop_back ();
+}
+
+void
+SchemaValidator::key (std::string_view k)
+{
+    if (!ok () || stack_.empty ())
+    {
+        return;
+    }
+    Frame &top = stack_.back ();
+    const Node &n = kNodes[top.node];
+    top.member = kNoMember;
+    for (uint16_t i = 0; i < n.members; ++i)
+    {
+        if (kMembers[n.first + i].key != k)
+        {
+            continue;
+        }
+        uint32_t bit = uint32_t (1) << i;
+        if ((top.seen & bit) != 0)
+        {
+            top.member = n.first + i;
+            fail ("duplicate key");
+            return;
+        }
+        top.seen |= bit;
+        top.member = n.first + i;
+        return;
+    }
+    fail ("unknown key");
+    append_token (path_, k);
+}
+
+void
+SchemaValidator::string (std::string_view s)
+{
+    if (!value (kString))
+    {
+        return;
+    }
+    const Frame &top = stack_.back ();
+    const Node &parent = kNodes[top.node];
+    uint16_t node = parent.type == kArray ? parent.first
+                                          : kMembers[top.member].node;
+    uint8_t format = kNodes[node].format;
+    if (!matches (format, s))
+    {
+        fail (std::string ("expected ") + format_name (format)
+              + ", found \"" + std::string (s) + "\"");
+    }
+}
+
+void
+SchemaValidator::number (uint64_t v)
+{
+    if (!value (kNumber))
+    {
+        return;
+    }
+    const Frame &top = stack_.back ();
+    const Node &parent = kNodes[top.node];
+    const Node &n = kNodes[parent.type == kArray
+                               ? parent.first
+                               : kMembers[top.member].node];
+    if (v < n.min || v > n.max)
+    {
+        fail (std::to_string (v) + " is outside "
+              + std::to_string (n.min) + ".."
+              + std::to_string (n.max));
+    }
+}
+
+void
+SchemaValidator::boolean (bool)
+{
+    value (kBoolean);
+}
+
+void
+SchemaValidator::negative_number ()
+{
+    if (value (kNumber))
+    {
+        fail ("expected a non-negative integer");
+    }
+}
+
+void
+SchemaValidator::fractional_number ()
+{
+    if (value (kNumber))
+    {
+        fail ("expected an integer");
+    }
+}
+
+void
+SchemaValidator::null ()
+{
+    if (!ok ())
+    {
+        return;
+    }
+    uint16_t node = expected ();
+    if (node != kNone)
+    {
+        fail (std::string ("expected ")
+              + kTypeNames[kNodes[node].type] + ", found null");
+    }
+}
+
+SchemaResult
+SchemaValidator::finish () const
+{
+    SchemaResult result;
+    result.path = path_;
+    result.error = error_;
+    if (result.error.empty () && !done_)
+    {
+        result.error = "incomplete document";
+    }
+    result.valid = result.error.empty ();
+    return result;
+}
+
+// --- Drivers ---
+
+namespace
+{
+// Feeds nlohmann's SAX events to a validator and stops the parse at
+// the first schema error.
+struct SaxAdapter : nlohmann::json::json_sax_t
+{
+    explicit SaxAdapter (SchemaValidator &v) : v (v) {}
+
+    bool
+    null () override
+    {
+        v.null ();
+        return v.ok ();
+    }
+    bool
+    boolean (bool b) override
+    {
+        v.boolean (b);
+        return v.ok ();
+    }
+    bool
+    number_integer (number_integer_t n) override
+    {
+        if (n < 0)
+        {
+            v.negative_number ();
+        }
+        else
+        {
+            v.number (static_cast<uint64_t> (n));
+        }
+        return v.ok ();
+    }
+    bool
+    number_unsigned (number_unsigned_t n) override
+    {
+        v.number (n);
+        return v.ok ();
+    }
+    bool
+    number_float (number_float_t, const string_t &) override
+    {
+        v.fractional_number ();
+        return v.ok ();
+    }
+    bool
+    string (string_t &s) override
+    {
+        v.string (s);
+        return v.ok ();
+    }
+    bool
+    binary (binary_t &) override
+    {
+        v.null ();
+        return v.ok ();
+    }
+    bool
+    start_object (std::size_t) override
+    {
+        v.begin_object ();
+        return v.ok ();
+    }
+    bool
+    key (string_t &k) override
+    {
+        v.key (k);
+        return v.ok ();
+    }
+    bool
+    end_object () override
+    {
+        v.end_object ();
+        return v.ok ();
+    }
+    bool
+    start_array (std::size_t) override
+    {
+        v.begin_array ();
+        return v.ok ();
+    }
+    bool
+    end_array () override
+    {
+        v.end_array ();
+        return v.ok ();
+    }
+    bool
+    parse_error (std::size_t, const std::string &,
+                 const nlohmann::json::exception &e) override
+    {
+        error = e.what ();
+        return false;
+    }
+
+    SchemaValidator &v;
+    std::string error;
+};
+} // namespace
+
+SchemaResult
+validate_json (std::istream &in)
+{
+    SchemaValidator v;
+    SaxAdapter sax (v);
+    nlohmann::json::sax_parse (in, &sax);
+    if (!sax.error.empty ())
+    {
+        SchemaResult result;
+        result.error = sax.error;
+        return result;
+    }
+    return v.finish ();
+}
+
+SchemaResult
+write_validated_json (std::ostream &out, const KeaConfig &k)
+{
+    return write_validated_json (out, k, JsonFormat ());
+}
+
+SchemaResult
+write_validated_json (std::ostream &out, const KeaConfig &k,
+                      const JsonFormat &format)
+{
+    SchemaValidator v;
+    JsonWriter w (out, format);
+    w.validate_with (&v);
+    write_json (w, k);
+    SchemaResult result = v.finish ();
+    result.findings = lint_config (k);
+    return result;
+}
+} // namespace KeaGenerator
@@ -0,0 +1,119 @@
+// File: KeaSchema.h
+#ifndef KEA_SCHEMA_H
+#define KEA_SCHEMA_H
+
+#include "KeaGenerator.h"
+#include "KeaLint.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace KeaGenerator
+{
+struct JsonFormat;
+
+// --- Schema validation ---
+// Checks documents against the Kea DHCPv4 configuration schema, as
+// far as this generator writes it:
+//
+//   { "Dhcp4": { "valid-lifetime", "interfaces-config",
+//                "lease-database", "subnet4", ["option-data"] } }
+//
+// down to every pool, reservation and option. Member types, unknown
+// and duplicate keys, missing required members (a Dhcp4 object cut
+// short after an empty section, for instance), number ranges (Kea
+// subnet ids are 32-bit) and the form of addresses, prefixes, pool
+// ranges and hardware addresses are all checked.
+//
+// The schema is compiled into constant tables of nodes and members;
+// the validator is a state machine over JSON events with one frame
+// per open container and does not allocate after its first
+// document. It can be fed by a JsonWriter as the output is written
+// (JsonWriter::validate_with) or by a parser (validate_json).
+
+// Outcome of a validation.
+struct SchemaResult
+{
+    bool valid = false;
+    std::string path;  // JSON pointer to the offending value.
+    std::string error; // Description of the first error.
+    // Performance findings (see lint_config); they do not make the
+    // document invalid. Only filled by write_validated_json.
+    std::vector<LintFinding> findings;
+};
+
+class SchemaValidator
+{
+  public:
+    SchemaValidator ();
+
+    // Starts a new document.
+    void reset ();
+
+    // JSON events, in document order. After the first error further
+    // events are ignored.
+    void begin_object ();
+    void end_object ();
+    void begin_array ();
+    void end_array ();
+    void key (std::string_view k);
+    void string (std::string_view s);
+    void number (uint64_t n);
+    void boolean (bool b);
+    // Values the schema has no place for; they always fail.
+    void negative_number ();
+    void fractional_number ();
+    void null ();
+
+    // True while no error has been found.
+    bool
+    ok () const
+    {
+        return error_.empty ();
+    }
+
+    // Ends the document and returns the result. A document that is
+    // not complete is invalid.
+    SchemaResult finish () const;
+
+  private:
+    struct Frame
+    {
+        uint16_t node;
+        uint16_t member;  // Object: member of the pending value.
+        uint32_t seen;    // Object: bit per member already present.
+        uint64_t index;   // Array: index of the next element.
+    };
+
+    // Node the next value must match, or 0 if there is none.
+    uint16_t expected ();
+    // Checks the start of a value of the given type.
+    bool value (unsigned type);
+    void fail (std::string error);
+
+    std::vector<Frame> stack_;
+    bool done_ = false;
+    std::string path_;
+    std::string error_;
+};
+
+// Checks a JSON document read from `in`.
+SchemaResult validate_json (std::istream &in);
+
+// Serializes `k` to `out` as write_json does and validates the
+// output in the same pass. The result also carries the lint of `k`
+// with the default LintOptions.
+SchemaResult write_validated_json (std::ostream &out,
+                                   const KeaConfig &k);
+SchemaResult write_validated_json (std::ostream &out,
+                                   const KeaConfig &k,
+                                   const JsonFormat &format);
+
+} // namespace KeaGenerator
+
+#endif // KEA_SCHEMA_H
@@ -0,0 +1,185 @@
+#include "KeaSchema.h"
+#include "KeaStream.h"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace KeaGenerator;
+
+static KeaConfig
+Sample ()
+{
+    KeaConfig config;
+    Subnet4 &s = config.dhcp4.subnet4;
+    for (int i = 0; i < 3; ++i)
+    {
+        std::string net = "10.0." + std::to_string (i) + ".";
+        uint64_t id = s.add_config (net + "0/24");
+        s.add_pool_for_cfg (id, net + "10", net + "99");
+        s.add_reservation_for_cfg (
+            id, "1a:1b:1c:1d:1e:0" + std::to_string (i), net + "5",
+            i == 1 ? "printer" : "");
+    }
+    config.dhcp4.option_data.add_option ("routers", "10.0.0.1",
+                                         false);
+    config.dhcp4.option_data.add_option_always ("domain-name",
+                                                "example.org");
+    return config;
+}
+
+static SchemaResult
+Check (const std::string &text)
+{
+    std::istringstream in (text);
+    return validate_json (in);
+}
+
+// A minimal valid document with `dhcp4` spliced into Dhcp4.
+static std::string
+Doc (const std::string &dhcp4)
+{
+    return R"({"Dhcp4":{"valid-lifetime":4000,)"
+           R"("interfaces-config":{"interfaces":["eth0"]},)"
+           R"("lease-database":{"type":"memfile"},)"
+           + dhcp4 + "}}";
+}
+
+static std::string
+Subnet (const std::string &members)
+{
+    return R"("subnet4":[{"id":1,"subnet":"10.0.0.0/24")" + members
+           + "}]";
+}
+
+TEST (KeaSchemaTest, GeneratedOutputIsValid)
+{
+    KeaConfig config = Sample ();
+    for (const JsonFormat &format :
+         { JsonFormat (), JsonFormat::kea (), JsonFormat::jcs () })
+    {
+        std::ostringstream out;
+        SchemaResult r = write_validated_json (out, config, format);
+        EXPECT_TRUE (r.valid) << r.path << ": " << r.error;
+
+        std::ostringstream plain;
+        write_json (plain, config, format);
+        EXPECT_EQ (out.str (), plain.str ());
+        r = Check (out.str ());
+        EXPECT_TRUE (r.valid) << r.path << ": " << r.error;
+    }
+}
+
+TEST (KeaSchemaTest, PartialObjectsAreInvalid)
+{
+    // The serializers print a diagnostic and cut Dhcp4 short
+    std::ostringstream log;
+    std::streambuf *cerr = std::cerr.rdbuf (log.rdbuf ());
+
+    KeaConfig no_subnets;
+    std::ostringstream out;
+    SchemaResult r = write_validated_json (out, no_subnets);
+    EXPECT_FALSE (r.valid);
+    EXPECT_EQ (r.path, "/Dhcp4");
+    EXPECT_EQ (r.error, "missing member \"subnet4\"");
+
+    KeaConfig no_interfaces = Sample ();
+    no_interfaces.dhcp4.interface_config.interfaces.clear ();
+    r = write_validated_json (out, no_interfaces, JsonFormat::jcs ());
+    EXPECT_FALSE (r.valid);
+    EXPECT_EQ (r.error, "missing member \"interfaces-config\"");
+
+    std::cerr.rdbuf (cerr);
+    EXPECT_FALSE (log.str ().empty ());
+}
+
+TEST (KeaSchemaTest, Errors)
+{
+    EXPECT_TRUE (Check (Doc (Subnet (""))).valid);
+    EXPECT_TRUE (
+        Check (Doc (Subnet (R"(,"pools":[{"pool":"10.0.0.0/28"}])")))
+            .valid);
+
+    struct Case
+    {
+        std::string text;
+        std::string path;
+        std::string error;
+    };
+    const Case cases[] = {
+        { Doc (Subnet (R"(,"mtu":1500)")), "/Dhcp4/subnet4/0/mtu",
+          "unknown key" },
+        { Doc (Subnet (R"(,"id":2)")), "/Dhcp4/subnet4/0/id",
+          "duplicate key" },
+        { Doc (R"("subnet4":[{"subnet":"10.0.0.0/24"}])"),
+          "/Dhcp4/subnet4/0", "missing member \"id\"" },
+        { Doc (R"("subnet4":[{"id":0,"subnet":"10.0.0.0/24"}])"),
+          "/Dhcp4/subnet4/0/id", "0 is outside 1..4294967294" },
+        { Doc (R"("subnet4":[{"id":1,"subnet":"10.0.0.0/33"}])"),
+          "/Dhcp4/subnet4/0/subnet",
+          "expected an IPv4 prefix, found \"10.0.0.0/33\"" },
+        { Doc (Subnet (R"(,"pools":[{"pool":"10.0.0.1 - 10.0.0.9"},)"
+                       R"({"pool":"10.0.0.9 - 10.0.0.1"}])")),
+          "/Dhcp4/subnet4/0/pools/1/pool",
+          "expected a pool range, found \"10.0.0.9 - 10.0.0.1\"" },
+        { Doc (Subnet (R"(,"reservations":[{"hw-address":"1a:1bc",)"
+                       R"("ip-address":"10.0.0.5"}])")),
+          "/Dhcp4/subnet4/0/reservations/0/hw-address",
+          "expected a hardware address, found \"1a:1bc\"" },
+        { Doc (Subnet ("") + R"(,"option-data":[{"name":"x",)"
+                             R"("always-send":"yes"}])"),
+          "/Dhcp4/option-data/0/always-send",
+          "expected a boolean, found a string" },
+        { R"({"Dhcp4":{"valid-lifetime":-1}})",
+          "/Dhcp4/valid-lifetime",
+          "expected a non-negative integer" },
+        { R"({"Dhcp4":{"valid-lifetime":1.5}})",
+          "/Dhcp4/valid-lifetime", "expected an integer" },
+        { R"({"Dhcp4":null})", "/Dhcp4",
+          "expected an object, found null" },
+        { R"({"Dhcp4":{"lease-database":{"type":"sqlite"}}})",
+          "/Dhcp4/lease-database/type",
+          "expected memfile, mysql or postgresql, found \"sqlite\"" },
+        { R"({"Dhcp4":{"interfaces-config":{"interfaces":[""]}}})",
+          "/Dhcp4/interfaces-config/interfaces/0",
+          "expected a non-empty string, found \"\"" },
+        { R"({"Dhc/p~4":{}})", "/Dhc~1p~04", "unknown key" },
+        { R"([])", "", "expected an object, found an array" },
+    };
+    for (const Case &c : cases)
+    {
+        SchemaResult r = Check (c.text);
+        EXPECT_FALSE (r.valid) << c.text;
+        EXPECT_EQ (r.path, c.path) << c.text;
+        EXPECT_EQ (r.error, c.error) << c.text;
+    }
+
+    // Malformed JSON is reported by the parser
+    SchemaResult r = Check (R"({"Dhcp4":)");
+    EXPECT_FALSE (r.valid);
+    EXPECT_NE (r.error.find ("parse error"), std::string::npos);
+}
+
+TEST (KeaSchemaTest, ValidatorEvents)
+{
+    SchemaValidator v;
+    EXPECT_FALSE (v.finish ().valid);
+    EXPECT_EQ (v.finish ().error, "incomplete document");
+
+    // A validator can be reused after reset
+    v.begin_object ();
+    v.key ("Dhcp4");
+    v.number (1);
+    EXPECT_FALSE (v.ok ());
+    v.reset ();
+    EXPECT_TRUE (v.ok ());
+
+    std::ostringstream out;
+    JsonWriter w (out);
+    w.validate_with (&v);
+    write_json (w, Sample ());
+    EXPECT_TRUE (v.finish ().valid);
+    // Nothing may follow the document
+    v.begin_object ();
+    EXPECT_EQ (v.finish ().error, "content after the document");
+}
@@ -0,0 +1,386 @@
+// File: KeaStorage.h
+#ifndef KEA_STORAGE_H
+#define KEA_STORAGE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory_resource>
+#include <set>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace KeaGenerator
+{
+// --- Storage policies ---
+// A storage policy tells the model which containers to use. It
+// provides two member alias templates:
+//
+//   set<K>     ordered unique collection of K (pools, options)
+//   map<K, V>  unique-key associative container (subnet configs)
+//
+// The containers must offer the std::set / std::unordered_map
+// operations the model uses: insert/emplace, find, count, erase,
+// operator[] (map), begin/end, size, empty and clear. Sets order by
+// the transparent std::less<>, so find and count also take the
+// lookup keys the element types compare with (a name as a
+// std::string_view, for instance) without building an element.
+
+// --- flat_set ---
+// Ordered set stored in a sorted std::vector. Lookups are binary
+// searches over contiguous memory and iteration is a linear scan,
+// which suits build-once, render-many workloads. Inserting in the
+// middle is O(n); appending in order is amortized O(1).
+template <class K, class Compare = std::less<K> > class flat_set
+{
+  public:
+    using key_type = K;
+    using value_type = K;
+    using size_type = std::size_t;
+    using iterator = typename std::vector<K>::const_iterator;
+    using const_iterator = iterator;
+
+    flat_set () = default;
+
+    // Builds the set from any range; already sorted input (e.g. the
+    // contents of another ordered set) is taken over in linear time.
+    template <class It>
+    flat_set (It first, It last) : data_ (first, last)
+    {
+        if (!std::is_sorted (data_.begin (), data_.end (), comp_))
+        {
+            std::sort (data_.begin (), data_.end (), comp_);
+        }
+        data_.erase (std::unique (data_.begin (), data_.end (),
+                                  [this] (const K &a, const K &b) {
+                                      return !comp_ (a, b)
+                                             && !comp_ (b, a);
+                                  }),
+                     data_.end ());
+    }
+
+    std::pair<iterator, bool>
+    insert (K value)
+    {
+        auto it = std::lower_bound (data_.begin (), data_.end (),
+                                    value, comp_);
+        if (it != data_.end () && !comp_ (value, *it))
+        {
+            return { it, false };
+        }
+        it = data_.insert (it, std::move (value));
+        return { it, true };
+    }
+
+    template <class Key>
+    iterator
+    find (const Key &key) const
+    {
+        auto it = std::lower_bound (data_.begin (), data_.end (), key,
+                                    comp_);
+        if (it != data_.end () && !comp_ (key, *it))
+        {
+            return it;
+        }
+        return data_.end ();
+    }
+
+    iterator
+    find (const K &key) const
+    {
+        return find<K> (key);
+    }
+
+    template <class Key>
+    size_type
+    count (const Key &key) const
+    {
+        return find (key) != end () ? 1 : 0;
+    }
+
+    template <class Key>
+    size_type
+    erase (const Key &key)
+    {
+        auto it = find (key);
+        if (it == end ())
+        {
+            return 0;
+        }
+        data_.erase (it);
+        return 1;
+    }
+
+    iterator
+    erase (iterator it)
+    {
+        return data_.erase (it);
+    }
+
+    iterator
+    begin () const
+    {
+        return data_.begin ();
+    }
+
+    iterator
+    end () const
+    {
+        return data_.end ();
+    }
+
+    size_type
+    size () const
+    {
+        return data_.size ();
+    }
+
+    bool
+    empty () const
+    {
+        return data_.empty ();
+    }
+
+    void
+    clear ()
+    {
+        data_.clear ();
+    }
+
+    void
+    reserve (size_type n)
+    {
+        data_.reserve (n);
+    }
+
+  private:
+    std::vector<K> data_;
+    Compare comp_;
+};
+
+// --- flat_map ---
+// Map stored as a vector of pairs sorted by key. Iteration is in key
+// order, so serializers walk it without sorting.
+template <class K, class V> class flat_map
+{
+  public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<K, V>;
+    using size_type = std::size_t;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator =
+        typename std::vector<value_type>::const_iterator;
+
+    flat_map () = default;
+
+    // Builds the map from any range of key/value pairs. Keys must be
+    // unique; sorted input is taken over in linear time.
+    template <class It> flat_map (It first, It last)
+    {
+        for (; first != last; ++first)
+        {
+            data_.emplace_back (first->first, first->second);
+        }
+        if (!std::is_sorted (data_.begin (), data_.end (), less))
+        {
+            std::sort (data_.begin (), data_.end (), less);
+        }
+    }
+
+    template <class... Args>
+    std::pair<iterator, bool>
+    emplace (const K &key, Args &&...args)
+    {
+        auto it = lower (key);
+        if (it != data_.end () && !(key < it->first))
+        {
+            return { it, false };
+        }
+        it = data_.emplace (it, std::piecewise_construct,
+                            std::forward_as_tuple (key),
+                            std::forward_as_tuple (
+                                std::forward<Args> (args)...));
+        return { it, true };
+    }
+
+    std::pair<iterator, bool>
+    insert (value_type value)
+    {
+        return emplace (value.first, std::move (value.second));
+    }
+
+    V &
+    operator[] (const K &key)
+    {
+        return emplace (key).first->second;
+    }
+
+    V &
+    at (const K &key)
+    {
+        auto it = find (key);
+        if (it == data_.end ())
+        {
+            throw std::out_of_range ("flat_map::at");
+        }
+        return it->second;
+    }
+
+    const V &
+    at (const K &key) const
+    {
+        auto it = find (key);
+        if (it == data_.end ())
+        {
+            throw std::out_of_range ("flat_map::at");
+        }
+        return it->second;
+    }
+
+    iterator
+    find (const K &key)
+    {
+        auto it = lower (key);
+        if (it != data_.end () && !(key < it->first))
+        {
+            return it;
+        }
+        return data_.end ();
+    }
+
+    const_iterator
+    find (const K &key) const
+    {
+        return const_cast<flat_map *> (this)->find (key);
+    }
+
+    size_type
+    count (const K &key) const
+    {
+        return find (key) != end () ? 1 : 0;
+    }
+
+    size_type
+    erase (const K &key)
+    {
+        auto it = find (key);
+        if (it == data_.end ())
+        {
+            return 0;
+        }
+        data_.erase (it);
+        return 1;
+    }
+
+    iterator
+    erase (const_iterator it)
+    {
+        return data_.erase (it);
+    }
+
+    iterator
+    begin ()
+    {
+        return data_.begin ();
+    }
+
+    iterator
+    end ()
+    {
+        return data_.end ();
+    }
+
+    const_iterator
+    begin () const
+    {
+        return data_.begin ();
+    }
+
+    const_iterator
+    end () const
+    {
+        return data_.end ();
+    }
+
+    size_type
+    size () const
+    {
+        return data_.size ();
+    }
+
+    bool
+    empty () const
+    {
+        return data_.empty ();
+    }
+
+    void
+    clear ()
+    {
+        data_.clear ();
+    }
+
+    void
+    reserve (size_type n)
+    {
+        data_.reserve (n);
+    }
+
+  private:
+    static bool
+    less (const value_type &a, const value_type &b)
+    {
+        return a.first < b.first;
+    }
+
+    iterator
+    lower (const K &key)
+    {
+        return std::lower_bound (
+            data_.begin (), data_.end (), key,
+            [] (const value_type &v, const K &k) {
+                return v.first < k;
+            });
+    }
+
+    std::vector<value_type> data_;
+};
+
+// Node-based containers: cheap insertion and removal anywhere and
+// stable references. This is the default policy.
+struct NodeStorage
+{
+    template <class K> using set = std::set<K, std::less<> >;
+    template <class K, class V> using map = std::unordered_map<K, V>;
+};
+
+// Sorted vectors: compact, cache friendly and iterated in key order.
+// Best for configurations that are built once and rendered often.
+struct FlatStorage
+{
+    template <class K> using set = flat_set<K, std::less<> >;
+    template <class K, class V> using map = flat_map<K, V>;
+};
+
+// Node-based containers drawing from a std::pmr memory resource.
+// Container nodes come from std::pmr::get_default_resource () at the
+// time the container is created; install a resource with
+// std::pmr::set_default_resource to place them in an arena. Only the
+// nodes are covered: the strings inside them (subnet, pool range,
+// reservation and option fields) are std::string and still use the
+// global heap. A monotonic arena never reclaims erased nodes, so it
+// suits models that are built once and then only read.
+struct PmrStorage
+{
+    template <class K> using set = std::pmr::set<K, std::less<> >;
+    template <class K, class V>
+    using map = std::pmr::unordered_map<K, V>;
+};
+
+} // namespace KeaGenerator
+
+#endif // KEA_STORAGE_H
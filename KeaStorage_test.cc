@@ -0,0 +1,186 @@
+#include "KeaGenerator.h"
+#include "KeaJson.h"
+#include "KeaStorage.h"
+#include "KeaStream.h"
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+
+using namespace KeaGenerator;
+using json = nlohmann::json;
+
+// Serializes a Subnet4 of any policy with the streaming writer.
+template <class Storage>
+static std::string
+Render (const BasicSubnet4<Storage> &s)
+{
+    std::ostringstream out;
+    JsonWriter w (out);
+    write_json (w, s);
+    return out.str ();
+}
+
+// Fills a Subnet4 of any policy with the same content.
+template <class Storage>
+static void
+Fill (BasicSubnet4<Storage> &s)
+{
+    for (int i = 0; i < 20; ++i)
+    {
+        uint64_t id
+            = s.add_config ("10.0." + std::to_string (i) + ".0/24");
+        std::string net = "10.0." + std::to_string (i) + ".";
+        s.add_pool_for_cfg (id, net + "100", net + "199");
+        s.add_pool_for_cfg (id, net + "10", net + "19");
+    }
+}
+
+// Test the flat_set container on its own
+TEST (KeaStorageTest, FlatSet)
+{
+    flat_set<int> s;
+    EXPECT_TRUE (s.insert (5).second);
+    EXPECT_TRUE (s.insert (1).second);
+    EXPECT_TRUE (s.insert (3).second);
+    EXPECT_FALSE (s.insert (3).second);
+    ASSERT_EQ (s.size (), 3);
+    EXPECT_EQ (*s.begin (), 1);
+    EXPECT_NE (s.find (5), s.end ());
+    EXPECT_EQ (s.find (4), s.end ());
+    EXPECT_EQ (s.erase (1), 1);
+    EXPECT_EQ (s.erase (1), 0);
+    EXPECT_EQ (*s.begin (), 3);
+
+    int unsorted[] = { 4, 2, 4, 1 };
+    flat_set<int> r (std::begin (unsorted), std::end (unsorted));
+    ASSERT_EQ (r.size (), 3);
+    EXPECT_EQ (*r.begin (), 1);
+}
+
+// Test the flat_map container on its own
+TEST (KeaStorageTest, FlatMap)
+{
+    flat_map<uint64_t, std::string> m;
+    m[3] = "c";
+    m[1] = "a";
+    EXPECT_TRUE (m.emplace (2, "b").second);
+    EXPECT_FALSE (m.emplace (2, "x").second);
+    ASSERT_EQ (m.size (), 3);
+    EXPECT_EQ (m.begin ()->first, 1);
+    EXPECT_EQ (m.at (2), "b");
+    EXPECT_THROW (m.at (9), std::out_of_range);
+    EXPECT_EQ (m.erase (1), 1);
+    EXPECT_EQ (m.count (1), 0);
+}
+
+// Test that every policy serializes to the same document
+TEST (KeaStorageTest, PoliciesSerializeIdentically)
+{
+    BasicSubnet4<NodeStorage> node;
+    BasicSubnet4<FlatStorage> flat;
+    BasicSubnet4<PmrStorage> pmr;
+    Fill (node);
+    Fill (flat);
+    Fill (pmr);
+
+    EXPECT_EQ (Render (flat), Render (node));
+    EXPECT_EQ (Render (pmr), Render (node));
+
+    // to_json is generic as well; flat storage keeps id order
+    json j = flat;
+    ASSERT_EQ (j.size (), 20);
+    EXPECT_EQ (j[0]["id"], 1);
+    EXPECT_EQ (j[19]["id"], 20);
+}
+
+// Test conversions between policies
+TEST (KeaStorageTest, Conversions)
+{
+    Subnet4 node;
+    Fill (node);
+    node.add_config ("192.168.0.0/16");
+
+    BasicSubnet4<FlatStorage> flat (node);
+    EXPECT_EQ (flat.max_id, node.max_id);
+    EXPECT_EQ (Render (flat), Render (node));
+
+    Subnet4 back (flat);
+    EXPECT_EQ (Render (back), Render (node));
+    // The default policy keeps working with the converted data
+    EXPECT_TRUE (back.add_pool_for_cfg (1, "10.0.0.50", "10.0.0.60"));
+    EXPECT_EQ (back.cfgs[1].pools.size (), 3);
+
+    OptionData od;
+    od.add_option ("routers", "10.0.0.1", false);
+    od.add_option_always ("domain-name", "example.com");
+    BasicOptionData<FlatStorage> flat_od (od);
+    EXPECT_EQ (json (flat_od), json (od));
+}
+
+// Removes and edits the content Fill() added.
+template <class Storage>
+static void
+Edit (BasicSubnet4<Storage> &s)
+{
+    for (uint64_t id = 1; id <= 20; id += 2)
+    {
+        EXPECT_TRUE (s.remove_config (id));
+    }
+    for (uint64_t id = 2; id <= 20; id += 4)
+    {
+        std::string net = "10.0." + std::to_string (id - 1) + ".";
+        EXPECT_TRUE (
+            s.remove_pool_for_cfg (id, net + "10", net + "19"));
+        EXPECT_TRUE (s.update_config (
+            id, "10.1." + std::to_string (id) + ".0/24"));
+    }
+}
+
+// Test that removal and updates behave the same under every policy
+TEST (KeaStorageTest, PoliciesEditIdentically)
+{
+    BasicSubnet4<NodeStorage> node;
+    BasicSubnet4<FlatStorage> flat;
+    BasicSubnet4<PmrStorage> pmr;
+    Fill (node);
+    Fill (flat);
+    Fill (pmr);
+    Edit (node);
+    Edit (flat);
+    Edit (pmr);
+
+    EXPECT_EQ (node.cfgs.size (), 10);
+    EXPECT_EQ (Render (flat), Render (node));
+    EXPECT_EQ (Render (pmr), Render (node));
+
+    // Heterogeneous lookups work on every policy
+    EXPECT_TRUE (flat.has_pool (2, "10.0.1.100", "10.0.1.199"));
+    EXPECT_TRUE (pmr.has_pool (2, "10.0.1.100", "10.0.1.199"));
+    EXPECT_FALSE (flat.has_pool (2, "10.0.1.10", "10.0.1.19"));
+    ASSERT_NE (flat.find_subnet ("10.1.2.0/24"), nullptr);
+    EXPECT_EQ (flat.find_subnet ("10.1.2.0/24")->id, 2);
+
+    BasicOptionData<FlatStorage> od;
+    od.add_option ("routers", "10.0.0.1", false);
+    EXPECT_NE (od.find_option ("routers"), nullptr);
+    EXPECT_TRUE (od.update_option ("routers", "10.0.0.2", false));
+    EXPECT_EQ (od.options.begin ()->data, "10.0.0.2");
+    EXPECT_TRUE (od.remove_option ("routers"));
+    EXPECT_TRUE (od.empty ());
+}
+
+// Test that the pmr policy allocates from the default resource
+TEST (KeaStorageTest, PmrUsesDefaultResource)
+{
+    std::pmr::monotonic_buffer_resource arena;
+    std::pmr::memory_resource *previous
+        = std::pmr::set_default_resource (&arena);
+
+    BasicSubnet4<PmrStorage> s;
+    Fill (s);
+    EXPECT_EQ (s.cfgs.get_allocator ().resource (), &arena);
+    EXPECT_EQ (s.cfgs[1].pools.get_allocator ().resource (), &arena);
+
+    std::pmr::set_default_resource (previous);
+}
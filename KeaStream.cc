@@ -0,0 +1,761 @@
+#include "KeaStream.h"
+#include "KeaSchema.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+namespace KeaGenerator
+{
+namespace
+{
+// Decodes the code point at s[i] and moves i past it. A byte that
+// does not start a complete UTF-8 sequence stands for itself.
+uint32_t
+code_point (std::string_view s, std::size_t &i)
+{
+    auto c = static_cast<unsigned char> (s[i++]);
+    std::size_t n = c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : c >= 0xc0 ? 1 : 0;
+    if (n == 0 || s.size () - i < n)
+    {
+        return c;
+    }
+    uint32_t cp = c & (0x3f >> n);
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        cp = cp << 6 | (static_cast<unsigned char> (s[i + k]) & 0x3f);
+    }
+    i += n;
+    return cp;
+}
+
+// RFC 8785 sorts keys by their UTF-16 code units, which puts code
+// points above U+FFFF (surrogate pairs) before U+E000..U+FFFF.
+bool
+jcs_less (std::string_view a, std::string_view b)
+{
+    auto unit = [] (uint32_t cp) {
+        return cp < 0x10000 ? cp : 0xd800 + ((cp - 0x10000) >> 10);
+    };
+    std::size_t i = 0, j = 0;
+    while (i < a.size () && j < b.size ())
+    {
+        uint32_t x = code_point (a, i);
+        uint32_t y = code_point (b, j);
+        if (x != y)
+        {
+            return unit (x) != unit (y) ? unit (x) < unit (y) : x < y;
+        }
+    }
+    return i == a.size () && j < b.size ();
+}
+} // namespace
+
+JsonWriter::JsonWriter (std::ostream &out, const JsonFormat &format)
+    : out_ (out), buf_ (out.rdbuf ()), format_ (format),
+      pretty_ (format.indent > 0 && !format.canonical)
+{
+    if (pretty_)
+    {
+        // A separator, a line break and 16 levels of indentation;
+        // deeper levels copy it in several pieces.
+        std::size_t levels = 16;
+        whitespace_.assign (2 + levels * format_.indent, ' ');
+        whitespace_[0] = ',';
+        whitespace_[1] = '\n';
+    }
+}
+
+JsonWriter::~JsonWriter ()
+{
+    drain ();
+}
+
+void
+JsonWriter::newline (std::size_t depth, bool comma)
+{
+    std::size_t spaces = depth * format_.indent;
+    std::size_t max = whitespace_.size () - 2;
+    std::size_t n = std::min (spaces, max);
+    write (whitespace_.data () + !comma, comma + 1 + n);
+    for (spaces -= n; spaces > 0; spaces -= n)
+    {
+        n = std::min (spaces, max);
+        write (whitespace_.data () + 2, n);
+    }
+}
+
+void
+JsonWriter::separator ()
+{
+    if (after_key_)
+    {
+        // The value belongs to the key just written.
+        after_key_ = false;
+        return;
+    }
+    if (first_.empty ())
+    {
+        return;
+    }
+    bool first = first_.back ();
+    first_.back () = false;
+    if (held_)
+    {
+        // Separators are added when the container is written out.
+        held_elems_.push_back (held_buf_.size ());
+        return;
+    }
+    if (pretty_)
+    {
+        newline (first_.size (), !first);
+    }
+    else if (!first)
+    {
+        put (',');
+    }
+}
+
+void
+JsonWriter::expand ()
+{
+    held_ = false;
+    std::size_t depth = first_.size ();
+    for (std::size_t i = 0; i < held_elems_.size (); ++i)
+    {
+        std::size_t begin = held_elems_[i];
+        std::size_t end = i + 1 < held_elems_.size ()
+                              ? held_elems_[i + 1]
+                              : held_buf_.size ();
+        newline (depth, i > 0);
+        write (held_buf_.data () + begin, end - begin);
+    }
+    held_buf_.clear ();
+    held_elems_.clear ();
+}
+
+void
+JsonWriter::open (char c)
+{
+    // A nested container: the enclosing one cannot stay inline.
+    if (held_)
+    {
+        expand ();
+    }
+    separator ();
+    put (c);
+    first_.push_back (true);
+    if (format_.canonical)
+    {
+        keys_.emplace_back ();
+    }
+    if (pretty_ && format_.compact_short)
+    {
+        held_ = true;
+    }
+}
+
+void
+JsonWriter::close (char c)
+{
+    bool empty = first_.back ();
+    first_.pop_back ();
+    if (format_.canonical)
+    {
+        keys_.pop_back ();
+    }
+    if (held_)
+    {
+        // Short enough: { "a": 1, "b": 2 }
+        held_ = false;
+        if (!held_elems_.empty ())
+        {
+            put (' ');
+            for (std::size_t i = 0; i < held_elems_.size (); ++i)
+            {
+                std::size_t begin = held_elems_[i];
+                std::size_t end = i + 1 < held_elems_.size ()
+                                      ? held_elems_[i + 1]
+                                      : held_buf_.size ();
+                if (i > 0)
+                {
+                    write (", ", 2);
+                }
+                write (held_buf_.data () + begin, end - begin);
+            }
+            put (' ');
+        }
+        held_buf_.clear ();
+        held_elems_.clear ();
+    }
+    else if (pretty_ && !empty)
+    {
+        newline (first_.size ());
+    }
+    put (c);
+    if (first_.empty ())
+    {
+        drain (); // The document is complete.
+    }
+}
+
+void
+JsonWriter::quoted (std::string_view s)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    put ('"');
+    // Copy runs of characters that need no escaping in one call.
+    std::size_t run = 0;
+    for (std::size_t i = 0; i < s.size (); ++i)
+    {
+        unsigned char c = static_cast<unsigned char> (s[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+        write (s.data () + run, i - run);
+        run = i + 1;
+        switch (c)
+        {
+        case '"':
+            write ("\\\"", 2);
+            break;
+        case '\\':
+            write ("\\\\", 2);
+            break;
+        case '\b':
+            write ("\\b", 2);
+            break;
+        case '\f':
+            write ("\\f", 2);
+            break;
+        case '\n':
+            write ("\\n", 2);
+            break;
+        case '\r':
+            write ("\\r", 2);
+            break;
+        case '\t':
+            write ("\\t", 2);
+            break;
+        default:
+        {
+            char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4],
+                            hex[c & 0xf] };
+            write (esc, sizeof (esc));
+        }
+        }
+    }
+    write (s.data () + run, s.size () - run);
+    put ('"');
+}
+
+void
+JsonWriter::begin_object ()
+{
+    if (validator_ != nullptr)
+    {
+        validator_->begin_object ();
+    }
+    open ('{');
+}
+
+void
+JsonWriter::end_object ()
+{
+    if (validator_ != nullptr)
+    {
+        validator_->end_object ();
+    }
+    close ('}');
+}
+
+void
+JsonWriter::begin_array ()
+{
+    if (validator_ != nullptr)
+    {
+        validator_->begin_array ();
+    }
+    open ('[');
+}
+
+void
+JsonWriter::end_array ()
+{
+    if (validator_ != nullptr)
+    {
+        validator_->end_array ();
+    }
+    close (']');
+}
+
+void
+JsonWriter::key (std::string_view k)
+{
+    if (validator_ != nullptr)
+    {
+        validator_->key (k);
+    }
+    if (format_.canonical)
+    {
+        // first_ is still set for the first member.
+        if (!first_.back () && !jcs_less (keys_.back (), k))
+        {
+            throw std::logic_error ("JSON key \"" + std::string (k)
+                                    + "\" is out of canonical order");
+        }
+        keys_.back ().assign (k.data (), k.size ());
+    }
+    separator ();
+    quoted (k);
+    if (pretty_)
+    {
+        write (": ", 2);
+    }
+    else
+    {
+        put (':');
+    }
+    after_key_ = true;
+}
+
+void
+JsonWriter::string (std::string_view s)
+{
+    if (validator_ != nullptr)
+    {
+        validator_->string (s);
+    }
+    separator ();
+    quoted (s);
+    if (first_.empty ())
+    {
+        drain ();
+    }
+}
+
+void
+JsonWriter::number (uint64_t n)
+{
+    if (validator_ != nullptr)
+    {
+        validator_->number (n);
+    }
+    separator ();
+    if (format_.canonical && n > (uint64_t (1) << 53))
+    {
+        // ECMAScript prints the shortest digits that identify the
+        // double, padded with zeros up to the decimal point.
+        char sci[32];
+        auto r = std::to_chars (sci, sci + sizeof (sci), double (n),
+                                std::chars_format::scientific);
+        char *e = std::find (sci, r.ptr, 'e');
+        std::size_t width = 1 + std::strtoul (e + 1, nullptr, 10);
+        char digits[24];
+        std::size_t len = 0;
+        for (const char *p = sci; p != e; ++p)
+        {
+            if (*p != '.')
+            {
+                digits[len++] = *p;
+            }
+        }
+        std::fill (digits + len, digits + width, '0');
+        write (digits, width);
+    }
+    else
+    {
+        char buf[20];
+        char *end = buf + sizeof (buf);
+        char *p = end;
+        do
+        {
+            *--p = static_cast<char> ('0' + n % 10);
+            n /= 10;
+        }
+        while (n != 0);
+        write (p, end - p);
+    }
+    if (first_.empty ())
+    {
+        drain ();
+    }
+}
+
+void
+JsonWriter::boolean (bool b)
+{
+    if (validator_ != nullptr)
+    {
+        validator_->boolean (b);
+    }
+    separator ();
+    if (b)
+    {
+        write ("true", 4);
+    }
+    else
+    {
+        write ("false", 5);
+    }
+    if (first_.empty ())
+    {
+        drain ();
+    }
+}
+
+template <class Storage>
+std::vector<const BasicSubnet4Cfg<Storage> *>
+sorted_cfgs (const BasicSubnet4<Storage> &s)
+{
+    using Cfg = BasicSubnet4Cfg<Storage>;
+    std::vector<const Cfg *> cfgs;
+    cfgs.reserve (s.cfgs.size ());
+    for (const auto &pair : s.cfgs)
+    {
+        cfgs.push_back (&pair.second);
+    }
+    // Policies with ordered maps already iterate by id.
+    if (!std::is_sorted (cfgs.begin (), cfgs.end (),
+                         [] (const Cfg *a, const Cfg *b) {
+                             return a->id < b->id;
+                         }))
+    {
+        std::sort (cfgs.begin (), cfgs.end (),
+                   [] (const Cfg *a, const Cfg *b) {
+                       return a->id < b->id;
+                   });
+    }
+    return cfgs;
+}
+
+// { "interfaces": ["if1", "if2", ...] }
+void
+write_json (JsonWriter &w, const InterfacesConfig &i)
+{
+    w.begin_object ();
+    w.key ("interfaces");
+    w.begin_array ();
+    for (const auto &name : i.interfaces)
+    {
+        w.string (name);
+    }
+    w.end_array ();
+    w.end_object ();
+}
+
+// { "type": "...", "persist": ..., "name": "..." }
+void
+write_json (JsonWriter &w, const LeaseDatabase &l)
+{
+    w.begin_object ();
+    if (w.canonical ())
+    {
+        w.key ("name");
+        w.string (l.name);
+        w.key ("persist");
+        w.boolean (l.persist);
+        w.key ("type");
+        w.string (l.type);
+    }
+    else
+    {
+        w.key ("type");
+        w.string (l.type);
+        w.key ("persist");
+        w.boolean (l.persist);
+        w.key ("name");
+        w.string (l.name);
+    }
+    w.end_object ();
+}
+
+// { "name": "...", "data": "...", "always-send": ... }
+void
+write_json (JsonWriter &w, const OptionData::Option &o)
+{
+    w.begin_object ();
+    if (w.canonical ())
+    {
+        w.key ("always-send");
+        w.boolean (o.always_send);
+        w.key ("data");
+        w.string (o.data);
+        w.key ("name");
+        w.string (o.name);
+    }
+    else
+    {
+        w.key ("name");
+        w.string (o.name);
+        w.key ("data");
+        w.string (o.data);
+        w.key ("always-send");
+        w.boolean (o.always_send);
+    }
+    w.end_object ();
+}
+
+// [ { Option1 }, { Option2 }, ... ] in name order.
+template <class Storage>
+void
+write_json (JsonWriter &w, const BasicOptionData<Storage> &o)
+{
+    w.begin_array ();
+    for (const auto &option : o.options)
+    {
+        write_json (w, option);
+    }
+    w.end_array ();
+}
+
+// { "pool": "low_ip - high_ip" }
+void
+write_json (JsonWriter &w, const Subnet4::Pool &p)
+{
+    w.begin_object ();
+    w.key ("pool");
+    w.string (p.range);
+    w.end_object ();
+}
+
+// { "hw-address": "...", "ip-address": "...", "hostname": "..." }
+void
+write_json (JsonWriter &w, const Subnet4::Reservation &r)
+{
+    w.begin_object ();
+    if (w.canonical () && !r.hostname.empty ())
+    {
+        w.key ("hostname");
+        w.string (r.hostname);
+    }
+    w.key ("hw-address");
+    w.string (r.hw_address);
+    w.key ("ip-address");
+    w.string (r.ip_address);
+    if (!w.canonical () && !r.hostname.empty ())
+    {
+        w.key ("hostname");
+        w.string (r.hostname);
+    }
+    w.end_object ();
+}
+
+// { "id": ..., "subnet": "...", "pools": [ ... ],
+//   "reservations": [ ... ] }
+template <class Storage>
+void
+write_json (JsonWriter &w, const BasicSubnet4Cfg<Storage> &c)
+{
+    w.begin_object ();
+    w.key ("id");
+    w.number (c.id);
+    if (!w.canonical ())
+    {
+        w.key ("subnet");
+        w.string (c.subnet);
+    }
+    w.key ("pools");
+    w.begin_array ();
+    for (const auto &pool : c.pools)
+    {
+        write_json (w, pool);
+    }
+    w.end_array ();
+    if (!c.reservations.empty ())
+    {
+        w.key ("reservations");
+        w.begin_array ();
+        for (const auto &reservation : c.reservations)
+        {
+            write_json (w, reservation);
+        }
+        w.end_array ();
+    }
+    if (w.canonical ())
+    {
+        w.key ("subnet");
+        w.string (c.subnet);
+    }
+    w.end_object ();
+}
+
+// [ { Cfg1 }, { Cfg2 }, ... ] in ascending id order.
+template <class Storage>
+void
+write_json (JsonWriter &w, const BasicSubnet4<Storage> &s)
+{
+    w.begin_array ();
+    for (const auto *cfg : sorted_cfgs (s))
+    {
+        write_json (w, *cfg);
+    }
+    w.end_array ();
+}
+
+// Mirrors the checks of to_json (Dhcp4): sections are written in
+// order and serialization stops at the first empty required section.
+bool
+write_dhcp4_head (JsonWriter &w, const Dhcp4 &d)
+{
+    w.key ("valid-lifetime");
+    w.number (d.valid_lifetime);
+
+    if (d.interface_config.empty ())
+    {
+        std::cerr
+            << "interfaces-config is empty during JSON serialization"
+            << std::endl;
+        return false;
+    }
+    w.key ("interfaces-config");
+    write_json (w, d.interface_config);
+
+    if (d.lease_database.empty ())
+    {
+        std::cerr
+            << "lease database is empty during JSON serialization"
+            << std::endl;
+        return false;
+    }
+    w.key ("lease-database");
+    write_json (w, d.lease_database);
+
+    if (d.subnet4.empty ())
+    {
+        std::cerr << "subnet4 is empty during JSON serialization"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+namespace
+{
+// Canonical key order: interfaces-config, lease-database,
+// option-data, subnet4, valid-lifetime. The required sections are
+// checked, with the diagnostics of write_dhcp4_head, before anything
+// is written.
+void
+write_dhcp4_canonical (JsonWriter &w, const Dhcp4 &d)
+{
+    const char *empty = d.interface_config.empty ()
+                            ? "interfaces-config"
+                        : d.lease_database.empty () ? "lease database"
+                        : d.subnet4.empty ()        ? "subnet4"
+                                                    : nullptr;
+    if (empty != nullptr)
+    {
+        std::cerr << empty << " is empty during JSON serialization"
+                  << std::endl;
+        return;
+    }
+    w.key ("interfaces-config");
+    write_json (w, d.interface_config);
+    w.key ("lease-database");
+    write_json (w, d.lease_database);
+    if (!d.option_data.empty ())
+    {
+        w.key ("option-data");
+        write_json (w, d.option_data);
+    }
+    w.key ("subnet4");
+    write_json (w, d.subnet4);
+    w.key ("valid-lifetime");
+    w.number (d.valid_lifetime);
+}
+} // namespace
+
+void
+write_json (JsonWriter &w, const Dhcp4 &d)
+{
+    w.begin_object ();
+    if (w.canonical ())
+    {
+        write_dhcp4_canonical (w, d);
+    }
+    else if (write_dhcp4_head (w, d))
+    {
+        w.key ("subnet4");
+        write_json (w, d.subnet4);
+
+        if (!d.option_data.empty ())
+        {
+            w.key ("option-data");
+            write_json (w, d.option_data);
+        }
+    }
+    w.end_object ();
+}
+
+// { "Dhcp4": { ... } }
+void
+write_json (JsonWriter &w, const KeaConfig &k)
+{
+    w.begin_object ();
+    w.key ("Dhcp4");
+    write_json (w, k.dhcp4);
+    w.end_object ();
+}
+
+void
+write_json (std::ostream &out, const KeaConfig &k)
+{
+    JsonWriter w (out);
+    write_json (w, k);
+}
+
+void
+write_json (std::ostream &out, const KeaConfig &k,
+            const JsonFormat &format)
+{
+    JsonWriter w (out, format);
+    write_json (w, k);
+}
+
+Sha256::Digest
+write_canonical_json (std::ostream &out, const KeaConfig &k)
+{
+    DigestStreambuf buf (out.rdbuf ());
+    std::ostream os (&buf);
+    JsonWriter w (os, JsonFormat::jcs ());
+    write_json (w, k);
+    Sha256::Digest digest = buf.finish ();
+    if (!os || !buf.good ())
+    {
+        out.setstate (std::ios::badbit);
+    }
+    return digest;
+}
+
+Sha256::Digest
+canonical_digest (const KeaConfig &k)
+{
+    DigestStreambuf buf;
+    std::ostream os (&buf);
+    JsonWriter w (os, JsonFormat::jcs ());
+    write_json (w, k);
+    return buf.finish ();
+}
+
+// Explicit instantiations for the shipped storage policies.
+#define KEA_INSTANTIATE_WRITE_JSON(Storage)                          \
+    template std::vector<const BasicSubnet4Cfg<Storage> *>           \
+    sorted_cfgs (const BasicSubnet4<Storage> &);                     \
+    template void write_json (JsonWriter &,                          \
+                              const BasicOptionData<Storage> &);     \
+    template void write_json (JsonWriter &,                          \
+                              const BasicSubnet4Cfg<Storage> &);     \
+    template void write_json (JsonWriter &,                          \
+                              const BasicSubnet4<Storage> &);
+
+KEA_INSTANTIATE_WRITE_JSON (NodeStorage)
+KEA_INSTANTIATE_WRITE_JSON (FlatStorage)
+KEA_INSTANTIATE_WRITE_JSON (PmrStorage)
+
+#undef KEA_INSTANTIATE_WRITE_JSON
+} // namespace KeaGenerator
@@ -0,0 +1,273 @@
+// File: KeaStream.h
+#ifndef KEA_STREAM_H
+#define KEA_STREAM_H
+
+#include "KeaDigest.h"
+#include "KeaGenerator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace KeaGenerator
+{
+class SchemaValidator;
+
+// --- JsonFormat ---
+// Layout of the JsonWriter output. The default is compact output.
+struct JsonFormat
+{
+    // Spaces per nesting level; 0 writes everything on one line.
+    unsigned indent = 0;
+    // With indent > 0: write objects and arrays that hold only
+    // scalars on one line if that line takes at most short_width
+    // characters, e.g. { "pool": "10.0.0.1 - 10.0.0.9" }.
+    bool compact_short = false;
+    std::size_t short_width = 72;
+    // RFC 8785 (JCS) canonical form: compact, the members of every
+    // object in ascending key order and numbers written the way
+    // ECMAScript prints them. Logically equal configurations then
+    // give the same bytes, and the same hash. indent is ignored.
+    bool canonical = false;
+
+    // Kea's own layout: four spaces, short containers kept inline.
+    static JsonFormat
+    kea ()
+    {
+        JsonFormat f;
+        f.indent = 4;
+        f.compact_short = true;
+        return f;
+    }
+
+    static JsonFormat
+    jcs ()
+    {
+        JsonFormat f;
+        f.canonical = true;
+        return f;
+    }
+};
+
+// --- JsonWriter ---
+// Minimal streaming JSON writer. Values are written to the output
+// stream as they are produced; no intermediate document or string is
+// built, so the output can go straight to a file or socket.
+//
+// In pretty mode, line breaks and indentation are copied from a
+// precomputed run of whitespace. A container that may stay on one
+// line is held back in a small buffer until it either closes, and is
+// written inline, or turns out to be too long or nested, and is
+// written out expanded.
+//
+// In canonical mode the writer does not reorder anything, which
+// would mean holding back whole objects. The caller writes members
+// in key order (the write_json functions below do) and key() throws
+// std::logic_error for a key that does not follow the one before.
+class JsonWriter
+{
+  public:
+    explicit JsonWriter (std::ostream &out,
+                         const JsonFormat &format = JsonFormat ());
+    ~JsonWriter ();
+
+    JsonWriter (const JsonWriter &) = delete;
+    JsonWriter &operator= (const JsonWriter &) = delete;
+
+    void begin_object ();
+    void end_object ();
+    void begin_array ();
+    void end_array ();
+
+    // Writes an object key. Must be followed by exactly one value.
+    void key (std::string_view k);
+
+    void string (std::string_view s);
+    // In canonical mode, numbers above 2^53 are written as the
+    // nearest double, the only value JCS consumers can hold.
+    void number (uint64_t n);
+    void boolean (bool b);
+
+    // True if members must be written in canonical key order.
+    bool
+    canonical () const
+    {
+        return format_.canonical;
+    }
+
+    // Output is passed to the stream in blocks, and whenever a
+    // document is complete. Passes on what was written of an
+    // unfinished one.
+    void
+    flush ()
+    {
+        drain ();
+    }
+
+    // The stream the writer emits into, flushed.
+    std::ostream &
+    stream ()
+    {
+        drain ();
+        return out_;
+    }
+
+    // Passes every value written from now on to `validator` too (see
+    // KeaSchema.h); null stops it.
+    void
+    validate_with (SchemaValidator *validator)
+    {
+        validator_ = validator;
+    }
+
+  private:
+    // Emits the ',' separating this value from the previous sibling,
+    // and in pretty mode the line break and indentation before it.
+    void separator ();
+    // Writes a quoted, escaped JSON string.
+    void quoted (std::string_view s);
+
+    void open (char c);
+    void close (char c);
+    // Writes a line break and the indentation for `depth` levels,
+    // after a ',' if `comma` is set.
+    void newline (std::size_t depth, bool comma = false);
+    // Writes the held back container in expanded form.
+    void expand ();
+
+    // All output goes through put and write, which divert it into
+    // the buffer while a container is held back. Otherwise they
+    // collect it in pending_, which is passed to the stream buffer
+    // when it fills up and when a document is complete: a JSON
+    // document is thousands of small pieces, more so with line
+    // breaks and indentation, and every streambuf call is virtual.
+    void
+    put (char c)
+    {
+        if (held_)
+        {
+            held_buf_.push_back (c);
+            return;
+        }
+        if (pending_len_ == sizeof (pending_))
+        {
+            drain ();
+        }
+        pending_[pending_len_++] = c;
+    }
+
+    void
+    write (const char *s, std::size_t n)
+    {
+        if (held_)
+        {
+            held_buf_.append (s, n);
+            if (held_buf_.size () > format_.short_width)
+            {
+                expand ();
+            }
+            return;
+        }
+        if (n > sizeof (pending_) - pending_len_)
+        {
+            drain ();
+            if (n >= sizeof (pending_))
+            {
+                sputn (s, n);
+                return;
+            }
+        }
+        std::memcpy (pending_ + pending_len_, s, n);
+        pending_len_ += n;
+    }
+
+    // Passes pending_ to the stream buffer.
+    void
+    drain ()
+    {
+        sputn (pending_, pending_len_);
+        pending_len_ = 0;
+    }
+
+    void
+    sputn (const char *s, std::size_t n)
+    {
+        std::streamsize len = static_cast<std::streamsize> (n);
+        if (len > 0 && buf_->sputn (s, len) != len)
+        {
+            out_.setstate (std::ios::badbit);
+        }
+    }
+
+    std::ostream &out_;
+    std::streambuf *buf_;
+    char pending_[4096];
+    std::size_t pending_len_ = 0;
+    JsonFormat format_;
+    bool pretty_;
+    // One entry per open container: true until its first element.
+    std::vector<bool> first_;
+    // Set between key() and the value that follows it.
+    bool after_key_ = false;
+    // Canonical mode: the last key of each open container.
+    std::vector<std::string> keys_;
+    SchemaValidator *validator_ = nullptr;
+
+    // ",\n" followed by the indentation of several levels.
+    std::string whitespace_;
+    // Set while the innermost container is held back; its elements
+    // are in held_buf_, each starting at an offset in held_elems_.
+    bool held_ = false;
+    std::string held_buf_;
+    std::vector<std::size_t> held_elems_;
+};
+
+// Streaming counterparts of the to_json functions. They produce the
+// same documents, except that subnets are always written in ascending
+// id order. Like to_json, the templates are instantiated for the
+// storage policies of KeaStorage.h.
+void write_json (JsonWriter &w, const InterfacesConfig &i);
+void write_json (JsonWriter &w, const LeaseDatabase &l);
+void write_json (JsonWriter &w, const OptionData::Option &o);
+template <class Storage>
+void write_json (JsonWriter &w, const BasicOptionData<Storage> &o);
+void write_json (JsonWriter &w, const Subnet4::Pool &p);
+void write_json (JsonWriter &w, const Subnet4::Reservation &r);
+template <class Storage>
+void write_json (JsonWriter &w, const BasicSubnet4Cfg<Storage> &c);
+template <class Storage>
+void write_json (JsonWriter &w, const BasicSubnet4<Storage> &s);
+void write_json (JsonWriter &w, const Dhcp4 &d);
+void write_json (JsonWriter &w, const KeaConfig &k);
+
+// Writes the members of an open Dhcp4 object that precede
+// "subnet4". Returns false, after printing the same diagnostic as
+// to_json (Dhcp4), if a required section is empty; the caller must
+// then close the object without writing anything else.
+bool write_dhcp4_head (JsonWriter &w, const Dhcp4 &d);
+
+// Serializes the whole configuration to `out` in compact form, or
+// laid out as `format` says.
+void write_json (std::ostream &out, const KeaConfig &k);
+void write_json (std::ostream &out, const KeaConfig &k,
+                 const JsonFormat &format);
+
+// Writes the canonical form (JsonFormat::jcs) to `out` and returns
+// its SHA-256, hashed as the bytes pass to the stream.
+Sha256::Digest write_canonical_json (std::ostream &out,
+                                     const KeaConfig &k);
+// The SHA-256 of the canonical form, which is not kept.
+Sha256::Digest canonical_digest (const KeaConfig &k);
+
+// Returns the configurations of `s` ordered by ascending id.
+template <class Storage>
+std::vector<const BasicSubnet4Cfg<Storage> *>
+sorted_cfgs (const BasicSubnet4<Storage> &s);
+
+} // namespace KeaGenerator
+
+#endif // KEA_STREAM_H
@@ -0,0 +1,232 @@
+#include "KeaJson.h"
+#include "KeaStream.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+using namespace KeaGenerator;
+using json = nlohmann::json;
+
+// Builds a small but complete configuration.
+static KeaConfig
+MakeConfig ()
+{
+    KeaConfig config;
+    uint64_t id = config.dhcp4.subnet4.add_config ("192.168.1.0/24");
+    config.dhcp4.subnet4.add_pool_for_cfg (id, "192.168.1.100",
+                                           "192.168.1.200");
+    config.dhcp4.subnet4.add_pool_for_cfg (id, "192.168.1.50",
+                                           "192.168.1.60");
+    config.dhcp4.subnet4.add_reservation_for_cfg (
+        id, "1a:1b:1c:1d:1e:1f", "192.168.1.5", "printer");
+    config.dhcp4.subnet4.add_reservation_for_cfg (
+        id, "0a:0b:0c:0d:0e:0f", "192.168.1.6");
+    config.dhcp4.option_data.add_option_always (
+        "domain-name-servers", "8.8.8.8, 1.1.1.1");
+    config.dhcp4.option_data.add_option ("routers", "192.168.1.1",
+                                         false);
+    return config;
+}
+
+// Test that the streaming writer matches to_json
+TEST (KeaStreamTest, MatchesToJson)
+{
+    KeaConfig config = MakeConfig ();
+    std::ostringstream out;
+    write_json (out, config);
+
+    EXPECT_EQ (json::parse (out.str ()), json (config));
+}
+
+// Test that subnets are written in ascending id order
+TEST (KeaStreamTest, SubnetsInIdOrder)
+{
+    Subnet4 s4;
+    for (int i = 0; i < 50; ++i)
+    {
+        s4.add_config ("10.0." + std::to_string (i) + ".0/24");
+    }
+
+    std::ostringstream out;
+    JsonWriter w (out);
+    write_json (w, s4);
+
+    json j = json::parse (out.str ());
+    ASSERT_EQ (j.size (), 50);
+    for (std::size_t i = 0; i < j.size (); ++i)
+    {
+        EXPECT_EQ (j[i]["id"], i + 1);
+    }
+}
+
+// Test string escaping and separators of the raw writer
+TEST (KeaStreamTest, WriterEscaping)
+{
+    std::ostringstream out;
+    JsonWriter w (out);
+    w.begin_object ();
+    w.key ("s");
+    w.string ("a\"b\\c\n\x01");
+    w.key ("list");
+    w.begin_array ();
+    w.number (0);
+    w.number (18446744073709551615ULL);
+    w.boolean (true);
+    w.begin_object ();
+    w.end_object ();
+    w.end_array ();
+    w.end_object ();
+
+    EXPECT_EQ (out.str (),
+               "{\"s\":\"a\\\"b\\\\c\\n\\u0001\","
+               "\"list\":[0,18446744073709551615,true,{}]}");
+}
+
+// Test the indented layout, with and without inline short containers
+TEST (KeaStreamTest, PrettyPrinting)
+{
+    auto render = [] (const JsonFormat &format) {
+        std::ostringstream out;
+        JsonWriter w (out, format);
+        w.begin_object ();
+        w.key ("pools");
+        w.begin_array ();
+        w.begin_object ();
+        w.key ("pool");
+        w.string ("10.0.0.10 - 10.0.0.20");
+        w.end_object ();
+        w.end_array ();
+        w.key ("empty");
+        w.begin_array ();
+        w.end_array ();
+        w.key ("id");
+        w.number (uint64_t (7));
+        w.end_object ();
+        return out.str ();
+    };
+
+    JsonFormat indented;
+    indented.indent = 2;
+    EXPECT_EQ (render (indented), "{\n"
+                                  "  \"pools\": [\n"
+                                  "    {\n"
+                                  "      \"pool\": \"10.0.0.10 - "
+                                  "10.0.0.20\"\n"
+                                  "    }\n"
+                                  "  ],\n"
+                                  "  \"empty\": [],\n"
+                                  "  \"id\": 7\n"
+                                  "}");
+
+    EXPECT_EQ (render (JsonFormat::kea ()),
+               "{\n"
+               "    \"pools\": [\n"
+               "        { \"pool\": \"10.0.0.10 - 10.0.0.20\" }\n"
+               "    ],\n"
+               "    \"empty\": [],\n"
+               "    \"id\": 7\n"
+               "}");
+
+    // Too wide to stay on one line
+    JsonFormat narrow = JsonFormat::kea ();
+    narrow.short_width = 10;
+    JsonFormat plain;
+    plain.indent = 4;
+    EXPECT_EQ (render (narrow), render (plain));
+}
+
+// Test that pretty output holds the same document as compact output
+TEST (KeaStreamTest, PrettyMatchesCompact)
+{
+    KeaConfig config = MakeConfig ();
+    std::ostringstream compact, pretty;
+    write_json (compact, config);
+    write_json (pretty, config, JsonFormat::kea ());
+
+    EXPECT_NE (pretty.str (), compact.str ());
+    EXPECT_EQ (json::parse (pretty.str ()),
+               json::parse (compact.str ()));
+    EXPECT_NE (pretty.str ().find ("{ \"hw-address\""),
+               std::string::npos);
+}
+
+TEST (KeaStreamTest, Canonical)
+{
+    KeaConfig config = MakeConfig ();
+    config.dhcp4.lease_database.persist = false;
+    std::ostringstream out;
+    Sha256::Digest digest = write_canonical_json (out, config);
+    std::string text = out.str ();
+
+    // Every object in key order, no whitespace.
+    std::string head
+        = "{\"Dhcp4\":{\"interfaces-config\":{\"interfaces\":"
+          "[\"aaa\",\"bbb\"]},\"lease-database\":{\"name\":"
+          "\"/var/lib/kea/dhcp4.leases\",\"persist\":false,";
+    EXPECT_EQ (text.substr (0, head.size ()), head);
+    EXPECT_NE (text.find ("{\"hostname\":\"printer\",\"hw-address\":"
+                          "\"1a:1b:1c:1d:1e:1f\",\"ip-address\":"
+                          "\"192.168.1.5\"}"),
+               std::string::npos);
+    EXPECT_NE (text.find ("\"subnet\":\"192.168.1.0/24\"}],"
+                          "\"valid-lifetime\":4000}}"),
+               std::string::npos);
+    // nlohmann sorts keys by bytes, which for these keys is the JCS
+    // order.
+    std::ostringstream compact;
+    write_json (compact, config);
+    EXPECT_EQ (json::parse (compact.str ()).dump (), text);
+
+    Sha256 sha;
+    sha.update (text.data (), text.size ());
+    EXPECT_EQ (digest, sha.finish ());
+    EXPECT_EQ (canonical_digest (config), digest);
+
+    // The same configuration built in another order.
+    KeaConfig other;
+    Subnet4 &s = other.dhcp4.subnet4;
+    uint64_t id = s.add_config ("192.168.1.0/24");
+    s.add_reservation_for_cfg (id, "0a:0b:0c:0d:0e:0f",
+                               "192.168.1.6");
+    s.add_pool_for_cfg (id, "192.168.1.50", "192.168.1.60");
+    s.add_reservation_for_cfg (id, "1a:1b:1c:1d:1e:1f", "192.168.1.5",
+                               "printer");
+    s.add_pool_for_cfg (id, "192.168.1.100", "192.168.1.200");
+    other.dhcp4.option_data.add_option ("routers", "192.168.1.1",
+                                        false);
+    other.dhcp4.option_data.add_option_always ("domain-name-servers",
+                                               "8.8.8.8, 1.1.1.1");
+    other.dhcp4.lease_database.persist = false;
+    EXPECT_EQ (canonical_digest (other), digest);
+    other.dhcp4.valid_lifetime = 4001;
+    EXPECT_NE (canonical_digest (other), digest);
+}
+
+TEST (KeaStreamTest, CanonicalWriter)
+{
+    std::ostringstream out;
+    JsonWriter w (out, JsonFormat::jcs ());
+    w.begin_object ();
+    w.key ("a");
+    w.begin_object ();
+    w.key ("z");
+    w.number (9007199254740992ull);
+    w.end_object ();
+    w.key ("b");
+    w.begin_array ();
+    w.number (9007199254740993ull);
+    w.number (18446744073709551615ull);
+    w.end_array ();
+    // Keys are ordered by UTF-16 code units: U+1F600 (a surrogate
+    // pair) sorts before U+FB01.
+    w.key ("\xf0\x9f\x98\x80");
+    w.boolean (true);
+    w.key ("\xef\xac\x81");
+    w.boolean (false);
+    EXPECT_THROW (w.key ("c"), std::logic_error);
+    w.flush ();
+    EXPECT_EQ (out.str (),
+               "{\"a\":{\"z\":9007199254740992},\"b\":"
+               "[9007199254740992,18446744073709552000],"
+               "\"\xf0\x9f\x98\x80\":true,\"\xef\xac\x81\":false");
+}
@@ -0,0 +1,293 @@
+#include "KeaSubnetIds.h"
+
+#include <algorithm>
+
+namespace KeaGenerator
+{
+namespace
+{
+const std::size_t kMinSlots = 16;
+const std::size_t kMaxSlots = std::size_t (1) << 30;
+
+void
+put_le (std::ostream &out, uint64_t v, int bytes)
+{
+    char buf[8];
+    for (int i = 0; i < bytes; ++i)
+    {
+        buf[i] = static_cast<char> (v >> (8 * i));
+    }
+    out.write (buf, bytes);
+}
+
+bool
+get_le (std::istream &in, uint64_t &v, int bytes)
+{
+    unsigned char buf[8];
+    if (!in.read (reinterpret_cast<char *> (buf), bytes))
+    {
+        return false;
+    }
+    v = 0;
+    for (int i = 0; i < bytes; ++i)
+    {
+        v |= uint64_t (buf[i]) << (8 * i);
+    }
+    return true;
+}
+
+// Fibonacci hashing; the product's upper half mixes every key bit.
+std::size_t
+home (uint64_t key, std::size_t mask)
+{
+    return static_cast<std::size_t> (
+               (key * 0x9e3779b97f4a7c15ull) >> 32)
+           & mask;
+}
+} // namespace
+
+SubnetIdMap::SubnetIdMap () : slots_ (kMinSlots) {}
+
+std::size_t
+SubnetIdMap::probe (Key key) const
+{
+    std::size_t mask = slots_.size () - 1;
+    std::size_t i = home (key, mask);
+    while (slots_[i].key != 0 && slots_[i].key != key)
+    {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+void
+SubnetIdMap::grow (std::size_t entries)
+{
+    std::size_t capacity = slots_.size () * 2;
+    while (capacity < 2 * entries)
+    {
+        capacity *= 2;
+    }
+    std::vector<Slot> old (capacity);
+    old.swap (slots_);
+    for (const Slot &s : old)
+    {
+        if (s.key != 0)
+        {
+            slots_[probe (s.key)] = s;
+        }
+    }
+}
+
+uint64_t
+SubnetIdMap::assign (std::string_view subnet)
+{
+    Ipv4Prefix prefix;
+    if (!parse_cidr (subnet, prefix))
+    {
+        return 0;
+    }
+    Key key = pack (prefix);
+    std::size_t i = probe (key);
+    if (slots_[i].key == 0)
+    {
+        if (2 * (count_ + 1) > slots_.size ())
+        {
+            grow (count_ + 1);
+            i = probe (key);
+        }
+        slots_[i].key = key;
+        slots_[i].id = next_id_++;
+        ++count_;
+    }
+    slots_[i].seen = run_;
+    return slots_[i].id;
+}
+
+uint64_t
+SubnetIdMap::find (std::string_view subnet) const
+{
+    Ipv4Prefix prefix;
+    if (!parse_cidr (subnet, prefix))
+    {
+        return 0;
+    }
+    return slots_[probe (pack (prefix))].id;
+}
+
+bool
+SubnetIdMap::adopt (const std::vector<Entry> &entries,
+                    uint64_t max_id)
+{
+    std::vector<uint64_t> ids;
+    ids.reserve (count_);
+    for (const Slot &s : slots_)
+    {
+        if (s.key != 0)
+        {
+            ids.push_back (s.id);
+        }
+    }
+    std::sort (ids.begin (), ids.end ());
+
+    // Check everything first so a conflict leaves the map unchanged.
+    std::vector<Entry> fresh;
+    std::vector<Key> keys;
+    for (const Entry &e : entries)
+    {
+        keys.push_back (e.key);
+        const Slot &s = slots_[probe (e.key)];
+        if (s.key != 0)
+        {
+            if (s.id != e.id)
+            {
+                return false;
+            }
+            continue;
+        }
+        if (std::binary_search (ids.begin (), ids.end (), e.id))
+        {
+            return false;
+        }
+        fresh.push_back (e);
+    }
+    std::sort (keys.begin (), keys.end ());
+    if (std::adjacent_find (keys.begin (), keys.end ())
+        != keys.end ())
+    {
+        return false;
+    }
+
+    if (2 * (count_ + fresh.size ()) > slots_.size ())
+    {
+        grow (count_ + fresh.size ());
+    }
+    for (const Entry &e : entries)
+    {
+        Slot &s = slots_[probe (e.key)];
+        if (s.key == 0)
+        {
+            s.key = e.key;
+            s.id = e.id;
+            ++count_;
+        }
+        s.seen = run_;
+        next_id_ = std::max (next_id_, e.id + 1);
+    }
+    next_id_ = std::max (next_id_, max_id);
+    return true;
+}
+
+std::size_t
+SubnetIdMap::prune (uint32_t max_age)
+{
+    std::vector<Slot> old (slots_.size ());
+    old.swap (slots_);
+    std::size_t dropped = 0;
+    for (const Slot &s : old)
+    {
+        if (s.key == 0)
+        {
+            continue;
+        }
+        if (run_ - s.seen >= max_age)
+        {
+            ++dropped;
+            continue;
+        }
+        slots_[probe (s.key)] = s;
+    }
+    count_ -= dropped;
+    return dropped;
+}
+
+// --- Binary form ---
+//   "KSI1"
+//   next id (u64), run (u32), capacity (u32), count (u32)
+//   capacity slots: key (u64), id (u64), seen (u32)
+
+void
+SubnetIdMap::serialize (std::ostream &out) const
+{
+    out.write ("KSI1", 4);
+    put_le (out, next_id_, 8);
+    put_le (out, run_, 4);
+    put_le (out, slots_.size (), 4);
+    put_le (out, count_, 4);
+    for (const Slot &s : slots_)
+    {
+        put_le (out, s.key, 8);
+        put_le (out, s.id, 8);
+        put_le (out, s.seen, 4);
+    }
+}
+
+bool
+SubnetIdMap::deserialize (std::istream &in, SubnetIdMap &map)
+{
+    char magic[4];
+    uint64_t next_id, run, capacity, count;
+    if (!in.read (magic, 4) || std::string (magic, 4) != "KSI1"
+        || !get_le (in, next_id, 8) || !get_le (in, run, 4)
+        || !get_le (in, capacity, 4) || !get_le (in, count, 4)
+        || next_id == 0 || capacity < kMinSlots
+        || capacity > kMaxSlots || (capacity & (capacity - 1)) != 0
+        || 2 * count > capacity)
+    {
+        return false;
+    }
+
+    SubnetIdMap loaded;
+    loaded.slots_.resize (capacity);
+    loaded.next_id_ = next_id;
+    loaded.run_ = static_cast<uint32_t> (run);
+    std::vector<uint64_t> ids;
+    for (Slot &s : loaded.slots_)
+    {
+        uint64_t key, id, seen;
+        if (!get_le (in, key, 8) || !get_le (in, id, 8)
+            || !get_le (in, seen, 4))
+        {
+            return false;
+        }
+        if (key == 0)
+        {
+            continue;
+        }
+        uint64_t base = (key - 1) >> 6;
+        unsigned length = static_cast<unsigned> ((key - 1) & 63);
+        // Host bits must be clear, as parse_cidr leaves them.
+        uint64_t host
+            = (uint64_t (1) << (32 - std::min (length, 32u))) - 1;
+        if (base >> 32 != 0 || length > 32 || (base & host) != 0
+            || id == 0 || id >= next_id || seen > run)
+        {
+            return false;
+        }
+        s = { key, id, static_cast<uint32_t> (seen) };
+        ids.push_back (id);
+    }
+    if (ids.size () != count)
+    {
+        return false;
+    }
+    std::sort (ids.begin (), ids.end ());
+    if (std::adjacent_find (ids.begin (), ids.end ()) != ids.end ())
+    {
+        return false;
+    }
+    // Every key must be where a lookup finds it, which also rules
+    // out duplicate keys.
+    for (std::size_t i = 0; i < capacity; ++i)
+    {
+        Key key = loaded.slots_[i].key;
+        if (key != 0 && loaded.probe (key) != i)
+        {
+            return false;
+        }
+    }
+    loaded.count_ = count;
+    map = std::move (loaded);
+    return true;
+}
+} // namespace KeaGenerator
@@ -0,0 +1,155 @@
+// File: KeaSubnetIds.h
+#ifndef KEA_SUBNET_IDS_H
+#define KEA_SUBNET_IDS_H
+
+#include "KeaAddress.h"
+#include "KeaGenerator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace KeaGenerator
+{
+// --- Stable subnet ids ---
+// Remembers the id given to each subnet prefix so that a prefix keeps
+// its id from one run to the next, whatever order the subnets arrive
+// in. Prefixes are compared after clearing host bits, so
+// "10.0.0.7/24" and "10.0.0.0/24" share an id.
+//
+// Unknown prefixes get fresh ids from a counter that only grows, so
+// an id is never given to a second prefix: a removed subnet's leases
+// cannot be attached to whatever comes after it. A prefix that comes
+// back keeps its old id until prune() forgets it.
+//
+// The map is an open-addressing hash table with linear probing, and
+// it is stored on disk as that table, so loading it is one read and
+// no rehashing.
+class SubnetIdMap
+{
+  public:
+    SubnetIdMap ();
+
+    // Returns the id of the prefix in `subnet`, giving it the next
+    // fresh id if it has none. Either way the prefix is marked as
+    // seen in the current run. Returns 0 if `subnet` is not a valid
+    // "a.b.c.d/len" prefix.
+    uint64_t assign (std::string_view subnet);
+
+    // Id of the prefix in `subnet`, or 0 if it has none.
+    uint64_t find (std::string_view subnet) const;
+
+    // Adds `subnet` to `s` under its stable id. Returns the id, or 0
+    // if the subnet is invalid or its id is already in use in `s`.
+    template <class Storage>
+    uint64_t
+    add_config (BasicSubnet4<Storage> &s, std::string subnet)
+    {
+        uint64_t id = assign (subnet);
+        if (id == 0 || !s.add_config_with_id (id, std::move (subnet)))
+        {
+            return 0;
+        }
+        return id;
+    }
+
+    // Takes over the ids of an existing configuration, for adopting
+    // the map on a tree that was numbered by Subnet4::add_config.
+    // Returns false, leaving the map unchanged, if two subnets share
+    // a prefix, a subnet is invalid, or a prefix or id is already
+    // mapped differently.
+    template <class Storage>
+    bool
+    adopt (const BasicSubnet4<Storage> &s)
+    {
+        std::vector<Entry> entries;
+        entries.reserve (s.cfgs.size ());
+        for (const auto &pair : s.cfgs)
+        {
+            Ipv4Prefix prefix;
+            if (!parse_cidr (pair.second.subnet, prefix))
+            {
+                return false;
+            }
+            entries.push_back ({ pack (prefix), pair.first });
+        }
+        return adopt (entries, s.max_id);
+    }
+
+    // Starts the next run. Entries not seen since are candidates for
+    // prune().
+    void
+    begin_run ()
+    {
+        ++run_;
+    }
+
+    // Forgets prefixes not seen in the last `max_age` runs, the
+    // current one included, and returns how many were dropped. Their
+    // ids are still never handed out again.
+    std::size_t prune (uint32_t max_age);
+
+    // Number of prefixes with an id.
+    std::size_t
+    size () const
+    {
+        return count_;
+    }
+
+    // The id the next new prefix will get.
+    uint64_t
+    next_id () const
+    {
+        return next_id_;
+    }
+
+    // Binary form: "KSI1", the next id, the current run, the table
+    // capacity and entry count, then every slot of the table, empty
+    // ones included (key u64, id u64, last run seen u32).
+    void serialize (std::ostream &out) const;
+    // Reads what serialize() wrote. Returns false on malformed input.
+    static bool deserialize (std::istream &in, SubnetIdMap &map);
+
+  private:
+    // A prefix packed as (base << 6 | length) + 1; 0 marks an empty
+    // slot.
+    using Key = uint64_t;
+
+    struct Entry
+    {
+        Key key;
+        uint64_t id;
+    };
+
+    struct Slot
+    {
+        Key key = 0;
+        uint64_t id = 0;
+        uint32_t seen = 0; // Last run the prefix was assigned in.
+    };
+
+    static Key
+    pack (const Ipv4Prefix &prefix)
+    {
+        return (uint64_t (prefix.base) << 6 | prefix.length) + 1;
+    }
+
+    // Slot holding `key`, or the empty slot where it would go.
+    std::size_t probe (Key key) const;
+    // Doubles the table, or sizes it for `entries` if that is more.
+    void grow (std::size_t entries);
+    bool adopt (const std::vector<Entry> &entries, uint64_t max_id);
+
+    std::vector<Slot> slots_; // Power of two, at most half full.
+    std::size_t count_ = 0;
+    uint64_t next_id_ = 1;
+    uint32_t run_ = 0;
+};
+
+} // namespace KeaGenerator
+
+#endif // KEA_SUBNET_IDS_H
@@ -0,0 +1,178 @@
+#include "KeaSubnetIds.h"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace KeaGenerator;
+
+static std::string
+Net (int n)
+{
+    return "10." + std::to_string (n / 256) + "."
+           + std::to_string (n % 256) + ".0/24";
+}
+
+// Builds a Subnet4 from the feed in the given order.
+static Subnet4
+Build (SubnetIdMap &ids, const std::vector<std::string> &feed)
+{
+    Subnet4 s;
+    for (const std::string &subnet : feed)
+    {
+        EXPECT_NE (ids.add_config (s, subnet), 0u) << subnet;
+    }
+    return s;
+}
+
+TEST (KeaSubnetIdsTest, StableAcrossOrder)
+{
+    std::vector<std::string> feed;
+    for (int i = 0; i < 1000; ++i)
+    {
+        feed.push_back (Net (i));
+    }
+    SubnetIdMap ids;
+    Subnet4 first = Build (ids, feed);
+    EXPECT_EQ (ids.size (), 1000u);
+    EXPECT_EQ (ids.next_id (), 1001u);
+
+    // The same prefixes in another order, one dropped and one new:
+    // every surviving subnet keeps its id.
+    std::mt19937 rng (3);
+    std::shuffle (feed.begin (), feed.end (), rng);
+    std::string dropped = feed.back ();
+    feed.pop_back ();
+    feed.push_back (Net (2000));
+    ids.begin_run ();
+    Subnet4 second = Build (ids, feed);
+    for (const auto &pair : second.cfgs)
+    {
+        const std::string &subnet = pair.second.subnet;
+        if (subnet == Net (2000))
+        {
+            EXPECT_EQ (pair.first, 1001u);
+            continue;
+        }
+        EXPECT_EQ (pair.first, ids.find (subnet));
+        EXPECT_EQ (first.cfgs.at (pair.first).subnet, subnet);
+    }
+    // Fresh ids continue above everything assigned
+    EXPECT_EQ (second.max_id, 1002u);
+    EXPECT_EQ (second.add_config ("192.168.0.0/24"), 1002u);
+
+    // Host bits do not make a new prefix, malformed input has no id
+    EXPECT_EQ (ids.assign ("10.0.5.77/24"), ids.find (Net (5)));
+    EXPECT_EQ (ids.assign ("10.0.5.0/33"), 0u);
+    EXPECT_EQ (ids.find ("192.168.0.0/24"), 0u);
+
+    // A prefix the config already has cannot be added twice
+    EXPECT_EQ (ids.add_config (second, Net (5)), 0u);
+}
+
+TEST (KeaSubnetIdsTest, PruneNeverReusesIds)
+{
+    SubnetIdMap ids;
+    uint64_t a = ids.assign (Net (1));
+    uint64_t b = ids.assign (Net (2));
+    ids.begin_run ();
+    ids.assign (Net (2));
+    ids.begin_run ();
+
+    // Net (1) was last seen two runs ago, Net (2) one run ago
+    EXPECT_EQ (ids.prune (3), 0u);
+    EXPECT_EQ (ids.prune (2), 1u);
+    EXPECT_EQ (ids.find (Net (1)), 0u);
+    EXPECT_EQ (ids.find (Net (2)), b);
+
+    // A forgotten prefix comes back under a new id
+    uint64_t again = ids.assign (Net (1));
+    EXPECT_NE (again, a);
+    EXPECT_GT (again, b);
+    EXPECT_EQ (ids.prune (0), 2u);
+    EXPECT_EQ (ids.size (), 0u);
+    EXPECT_GT (ids.assign (Net (3)), again);
+}
+
+TEST (KeaSubnetIdsTest, AdoptExistingIds)
+{
+    Subnet4 s;
+    s.add_config (Net (1));
+    s.add_config (Net (2));
+    s.remove_config (2);
+    s.add_config (Net (3));
+
+    SubnetIdMap ids;
+    ASSERT_TRUE (ids.adopt (s));
+    EXPECT_EQ (ids.find (Net (1)), 1u);
+    EXPECT_EQ (ids.find (Net (3)), 3u);
+    EXPECT_EQ (ids.find (Net (2)), 0u);
+    // Ids the tree handed out are not handed out again
+    EXPECT_EQ (ids.next_id (), 4u);
+    EXPECT_EQ (ids.assign (Net (2)), 4u);
+
+    // Conflicting numbering is refused as a whole
+    Subnet4 other;
+    other.add_config (Net (5));
+    other.add_config (Net (1));
+    EXPECT_FALSE (ids.adopt (other));
+    EXPECT_EQ (ids.find (Net (5)), 0u);
+    Subnet4 twice;
+    twice.add_config (Net (7));
+    twice.add_config ("10.0.7.1/24");
+    EXPECT_FALSE (ids.adopt (twice));
+}
+
+TEST (KeaSubnetIdsTest, Persistence)
+{
+    SubnetIdMap ids;
+    for (int i = 0; i < 300; ++i)
+    {
+        ids.assign (Net (i * 7));
+    }
+    ids.begin_run ();
+    ids.assign (Net (7));
+
+    std::stringstream stored;
+    ids.serialize (stored);
+    std::string data = stored.str ();
+    SubnetIdMap loaded;
+    ASSERT_TRUE (SubnetIdMap::deserialize (stored, loaded));
+    EXPECT_EQ (loaded.size (), ids.size ());
+    EXPECT_EQ (loaded.next_id (), ids.next_id ());
+    for (int i = 0; i < 300; ++i)
+    {
+        EXPECT_EQ (loaded.find (Net (i * 7)), ids.find (Net (i * 7)));
+    }
+    // The run counters came along
+    EXPECT_EQ (loaded.prune (1), 299u);
+    EXPECT_EQ (loaded.assign (Net (1)), 301u);
+
+    SubnetIdMap bad;
+    std::istringstream empty ("");
+    EXPECT_FALSE (SubnetIdMap::deserialize (empty, bad));
+    std::istringstream truncated (data.substr (0, data.size () - 1));
+    EXPECT_FALSE (SubnetIdMap::deserialize (truncated, bad));
+    // An entry moved out of its probe sequence
+    std::string moved = data;
+    std::size_t header = 24, slot = 20;
+    std::size_t used = header, free = header;
+    while (moved.substr (used, 8) == std::string (8, '\0'))
+    {
+        used += slot;
+    }
+    while (moved.substr (free, 8) != std::string (8, '\0')
+           || free < used)
+    {
+        free += slot;
+    }
+    for (std::size_t i = 0; i < slot; ++i)
+    {
+        std::swap (moved[used + i], moved[free + i]);
+    }
+    std::istringstream misplaced (moved);
+    EXPECT_FALSE (SubnetIdMap::deserialize (misplaced, bad));
+    EXPECT_EQ (bad.size (), 0u);
+}
@@ -0,0 +1,406 @@
+#include "KeaVisitor.h"
+
+#include <iomanip>
+
+namespace KeaGenerator
+{
+void
+traverse (const KeaConfig &config, ConfigVisitor &visitor)
+{
+    const Dhcp4 &d = config.dhcp4;
+
+    visitor.on_begin (config);
+    visitor.on_dhcp4 (d);
+
+    visitor.on_subnets_begin (d.subnet4);
+    for (const Subnet4::Cfg *cfg : sorted_cfgs (d.subnet4))
+    {
+        visitor.on_subnet (*cfg);
+        for (const auto &pool : cfg->pools)
+        {
+            visitor.on_pool (*cfg, pool);
+        }
+        for (const auto &reservation : cfg->reservations)
+        {
+            visitor.on_reservation (*cfg, reservation);
+        }
+        visitor.on_subnet_end (*cfg);
+    }
+    visitor.on_subnets_end (d.subnet4);
+
+    visitor.on_options_begin (d.option_data);
+    for (const auto &option : d.option_data.options)
+    {
+        visitor.on_option (option);
+    }
+    visitor.on_options_end (d.option_data);
+
+    visitor.on_end (config);
+}
+
+// --- FanOut ---
+
+void
+FanOut::on_begin (const KeaConfig &k)
+{
+    for (ConfigVisitor *v : visitors_)
+    {
+        v->on_begin (k);
+    }
+}
+
+void
+FanOut::on_dhcp4 (const Dhcp4 &d)
+{
+    for (ConfigVisitor *v : visitors_)
+    {
+        v->on_dhcp4 (d);
+    }
+}
+
+void
+FanOut::on_subnets_begin (const Subnet4 &s)
+{
+    for (ConfigVisitor *v : visitors_)
+    {
+        v->on_subnets_begin (s);
+    }
+}
+
+void
+FanOut::on_subnet (const Subnet4::Cfg &c)
+{
+    for (ConfigVisitor *v : visitors_)
+    {
+        v->on_subnet (c);
+    }
+}
+
+void
+FanOut::on_pool (const Subnet4::Cfg &c, const Subnet4::Pool &p)
+{
+    for (ConfigVisitor *v : visitors_)
+    {
+        v->on_pool (c, p);
+    }
+}
+
+void
+FanOut::on_reservation (const Subnet4::Cfg &c,
+                        const Subnet4::Reservation &r)
+{
+    for (ConfigVisitor *v : visitors_)
+    {
+        v->on_reservation (c, r);
+    }
+}
+
+void
+FanOut::on_subnet_end (const Subnet4::Cfg &c)
+{
+    for (ConfigVisitor *v : visitors_)
+    {
+        v->on_subnet_end (c);
+    }
+}
+
+void
+FanOut::on_subnets_end (const Subnet4 &s)
+{
+    for (ConfigVisitor *v : visitors_)
+    {
+        v->on_subnets_end (s);
+    }
+}
+
+void
+FanOut::on_options_begin (const OptionData &o)
+{
+    for (ConfigVisitor *v : visitors_)
+    {
+        v->on_options_begin (o);
+    }
+}
+
+void
+FanOut::on_option (const OptionData::Option &o)
+{
+    for (ConfigVisitor *v : visitors_)
+    {
+        v->on_option (o);
+    }
+}
+
+void
+FanOut::on_options_end (const OptionData &o)
+{
+    for (ConfigVisitor *v : visitors_)
+    {
+        v->on_options_end (o);
+    }
+}
+
+void
+FanOut::on_end (const KeaConfig &k)
+{
+    for (ConfigVisitor *v : visitors_)
+    {
+        v->on_end (k);
+    }
+}
+
+// --- JsonOutput ---
+
+void
+JsonOutput::on_begin (const KeaConfig &)
+{
+    writer_.begin_object ();
+    writer_.key ("Dhcp4");
+}
+
+void
+JsonOutput::on_dhcp4 (const Dhcp4 &d)
+{
+    writer_.begin_object ();
+    complete_ = write_dhcp4_head (writer_, d);
+}
+
+void
+JsonOutput::on_subnets_begin (const Subnet4 &)
+{
+    if (complete_)
+    {
+        writer_.key ("subnet4");
+        writer_.begin_array ();
+    }
+}
+
+void
+JsonOutput::on_subnet (const Subnet4::Cfg &c)
+{
+    if (complete_)
+    {
+        writer_.begin_object ();
+        writer_.key ("id");
+        writer_.number (c.id);
+        writer_.key ("subnet");
+        writer_.string (c.subnet);
+        writer_.key ("pools");
+        writer_.begin_array ();
+    }
+}
+
+void
+JsonOutput::on_pool (const Subnet4::Cfg &, const Subnet4::Pool &p)
+{
+    if (complete_)
+    {
+        write_json (writer_, p);
+    }
+}
+
+void
+JsonOutput::on_reservation (const Subnet4::Cfg &,
+                            const Subnet4::Reservation &r)
+{
+    if (complete_)
+    {
+        // reservations is only written when there is at least one,
+        // and follows pools.
+        if (!reservations_open_)
+        {
+            writer_.end_array (); // pools
+            writer_.key ("reservations");
+            writer_.begin_array ();
+            reservations_open_ = true;
+        }
+        write_json (writer_, r);
+    }
+}
+
+void
+JsonOutput::on_subnet_end (const Subnet4::Cfg &)
+{
+    if (complete_)
+    {
+        writer_.end_array (); // pools or reservations
+        writer_.end_object ();
+        reservations_open_ = false;
+    }
+}
+
+void
+JsonOutput::on_subnets_end (const Subnet4 &)
+{
+    if (complete_)
+    {
+        writer_.end_array ();
+    }
+}
+
+void
+JsonOutput::on_options_begin (const OptionData &o)
+{
+    // option-data is only written when there is at least one option.
+    options_open_ = complete_ && !o.empty ();
+    if (options_open_)
+    {
+        writer_.key ("option-data");
+        writer_.begin_array ();
+    }
+}
+
+void
+JsonOutput::on_option (const OptionData::Option &o)
+{
+    if (options_open_)
+    {
+        write_json (writer_, o);
+    }
+}
+
+void
+JsonOutput::on_options_end (const OptionData &)
+{
+    if (options_open_)
+    {
+        writer_.end_array ();
+        options_open_ = false;
+    }
+}
+
+void
+JsonOutput::on_end (const KeaConfig &)
+{
+    writer_.end_object (); // Dhcp4
+    writer_.end_object (); // root
+}
+
+// --- SummaryOutput ---
+
+void
+SummaryOutput::on_begin (const KeaConfig &k)
+{
+    subnets_ = pools_ = reservations_ = options_ = 0;
+    out_ << "valid-lifetime: " << k.dhcp4.valid_lifetime << "\n"
+         << std::left << std::setw (10) << "ID" << std::setw (20)
+         << "SUBNET" << std::setw (10) << "POOLS"
+         << "RESERVATIONS\n";
+}
+
+void
+SummaryOutput::on_subnet (const Subnet4::Cfg &)
+{
+    subnet_pools_ = subnet_reservations_ = 0;
+}
+
+void
+SummaryOutput::on_pool (const Subnet4::Cfg &, const Subnet4::Pool &)
+{
+    ++subnet_pools_;
+}
+
+void
+SummaryOutput::on_reservation (const Subnet4::Cfg &,
+                               const Subnet4::Reservation &)
+{
+    ++subnet_reservations_;
+}
+
+void
+SummaryOutput::on_subnet_end (const Subnet4::Cfg &c)
+{
+    ++subnets_;
+    pools_ += subnet_pools_;
+    reservations_ += subnet_reservations_;
+    out_ << std::left << std::setw (10) << c.id << std::setw (20)
+         << c.subnet << std::setw (10) << subnet_pools_
+         << subnet_reservations_ << "\n";
+}
+
+void
+SummaryOutput::on_option (const OptionData::Option &)
+{
+    ++options_;
+}
+
+void
+SummaryOutput::on_end (const KeaConfig &)
+{
+    out_ << "subnets: " << subnets_ << ", pools: " << pools_
+         << ", reservations: " << reservations_
+         << ", options: " << options_ << "\n";
+}
+
+// --- CsvOutput ---
+
+void
+CsvOutput::field (const std::string &value)
+{
+    if (value.find_first_of (",\"\n\r") == std::string::npos)
+    {
+        out_ << value;
+        return;
+    }
+    // RFC 4180 quoting: wrap in quotes and double embedded quotes.
+    out_.put ('"');
+    for (char c : value)
+    {
+        if (c == '"')
+        {
+            out_.put ('"');
+        }
+        out_.put (c);
+    }
+    out_.put ('"');
+}
+
+void
+CsvOutput::on_begin (const KeaConfig &)
+{
+    out_ << "type,id,subnet,name,value,always_send,hostname\n";
+}
+
+void
+CsvOutput::on_subnet (const Subnet4::Cfg &c)
+{
+    out_ << "subnet," << c.id << ',';
+    field (c.subnet);
+    out_ << ",,,,\n";
+}
+
+void
+CsvOutput::on_pool (const Subnet4::Cfg &c, const Subnet4::Pool &p)
+{
+    out_ << "pool," << c.id << ',';
+    field (c.subnet);
+    out_ << ",,";
+    field (p.range);
+    out_ << ",,\n";
+}
+
+void
+CsvOutput::on_reservation (const Subnet4::Cfg &c,
+                           const Subnet4::Reservation &r)
+{
+    out_ << "reservation," << c.id << ',';
+    field (c.subnet);
+    out_ << ',';
+    field (r.hw_address);
+    out_ << ',';
+    field (r.ip_address);
+    out_ << ",,";
+    field (r.hostname);
+    out_ << '\n';
+}
+
+void
+CsvOutput::on_option (const OptionData::Option &o)
+{
+    out_ << "option,,,";
+    field (o.name);
+    out_ << ',';
+    field (o.data);
+    out_ << ',' << (o.always_send ? "true" : "false") << ",\n";
+}
+} // namespace KeaGenerator
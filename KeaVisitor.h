@@ -0,0 +1,190 @@
+// File: KeaVisitor.h
+#ifndef KEA_VISITOR_H
+#define KEA_VISITOR_H
+
+#include "KeaGenerator.h"
+#include "KeaStream.h"
+
+#include <cstddef>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace KeaGenerator
+{
+// --- ConfigVisitor ---
+// Receives the elements of a KeaConfig in serialization order:
+//
+//   on_begin
+//     on_dhcp4
+//     on_subnets_begin
+//       on_subnet                              (ascending id)
+//         on_pool...
+//         on_reservation...                    (hw-address order)
+//       on_subnet_end
+//     on_subnets_end
+//     on_options_begin
+//       on_option...                           (name order)
+//     on_options_end
+//   on_end
+//
+// All callbacks default to doing nothing, so a visitor only overrides
+// what it needs.
+class ConfigVisitor
+{
+  public:
+    virtual ~ConfigVisitor () = default;
+
+    virtual void on_begin (const KeaConfig &) {}
+    virtual void on_dhcp4 (const Dhcp4 &) {}
+    virtual void on_subnets_begin (const Subnet4 &) {}
+    virtual void on_subnet (const Subnet4::Cfg &) {}
+    virtual void on_pool (const Subnet4::Cfg &, const Subnet4::Pool &)
+    {
+    }
+    virtual void on_reservation (const Subnet4::Cfg &,
+                                 const Subnet4::Reservation &)
+    {
+    }
+    virtual void on_subnet_end (const Subnet4::Cfg &) {}
+    virtual void on_subnets_end (const Subnet4 &) {}
+    virtual void on_options_begin (const OptionData &) {}
+    virtual void on_option (const OptionData::Option &) {}
+    virtual void on_options_end (const OptionData &) {}
+    virtual void on_end (const KeaConfig &) {}
+};
+
+// Walks the configuration once, calling the visitor for each element.
+void traverse (const KeaConfig &config, ConfigVisitor &visitor);
+
+// --- FanOut ---
+// Forwards every callback to a list of visitors, so several outputs
+// can be produced from a single traversal. Visitors are called in the
+// order they were added and are not owned.
+class FanOut : public ConfigVisitor
+{
+  public:
+    FanOut () = default;
+    FanOut (std::initializer_list<ConfigVisitor *> visitors)
+        : visitors_ (visitors)
+    {
+    }
+
+    void
+    add (ConfigVisitor &visitor)
+    {
+        visitors_.push_back (&visitor);
+    }
+
+    void on_begin (const KeaConfig &k) override;
+    void on_dhcp4 (const Dhcp4 &d) override;
+    void on_subnets_begin (const Subnet4 &s) override;
+    void on_subnet (const Subnet4::Cfg &c) override;
+    void on_pool (const Subnet4::Cfg &c,
+                  const Subnet4::Pool &p) override;
+    void on_reservation (const Subnet4::Cfg &c,
+                         const Subnet4::Reservation &r) override;
+    void on_subnet_end (const Subnet4::Cfg &c) override;
+    void on_subnets_end (const Subnet4 &s) override;
+    void on_options_begin (const OptionData &o) override;
+    void on_option (const OptionData::Option &o) override;
+    void on_options_end (const OptionData &o) override;
+    void on_end (const KeaConfig &k) override;
+
+  private:
+    std::vector<ConfigVisitor *> visitors_;
+};
+
+// --- JsonOutput ---
+// Output plugin producing the Kea JSON document, identical to
+// write_json (std::ostream &, const KeaConfig &).
+class JsonOutput : public ConfigVisitor
+{
+  public:
+    explicit JsonOutput (std::ostream &out) : writer_ (out) {}
+
+    void on_begin (const KeaConfig &k) override;
+    void on_dhcp4 (const Dhcp4 &d) override;
+    void on_subnets_begin (const Subnet4 &s) override;
+    void on_subnet (const Subnet4::Cfg &c) override;
+    void on_pool (const Subnet4::Cfg &c,
+                  const Subnet4::Pool &p) override;
+    void on_reservation (const Subnet4::Cfg &c,
+                         const Subnet4::Reservation &r) override;
+    void on_subnet_end (const Subnet4::Cfg &c) override;
+    void on_subnets_end (const Subnet4 &s) override;
+    void on_options_begin (const OptionData &o) override;
+    void on_option (const OptionData::Option &o) override;
+    void on_options_end (const OptionData &o) override;
+    void on_end (const KeaConfig &k) override;
+
+  private:
+    JsonWriter writer_;
+    // Cleared when a required Dhcp4 section is empty; the rest of the
+    // document is then skipped, as in to_json (Dhcp4).
+    bool complete_ = true;
+    // Set once the current subnet's reservations array is open, in
+    // place of its pools array.
+    bool reservations_open_ = false;
+    // Set while the option-data array is open.
+    bool options_open_ = false;
+};
+
+// --- SummaryOutput ---
+// Output plugin producing a human-readable table with one row per
+// subnet, followed by totals.
+class SummaryOutput : public ConfigVisitor
+{
+  public:
+    explicit SummaryOutput (std::ostream &out) : out_ (out) {}
+
+    void on_begin (const KeaConfig &k) override;
+    void on_subnet (const Subnet4::Cfg &c) override;
+    void on_pool (const Subnet4::Cfg &c,
+                  const Subnet4::Pool &p) override;
+    void on_reservation (const Subnet4::Cfg &c,
+                         const Subnet4::Reservation &r) override;
+    void on_subnet_end (const Subnet4::Cfg &c) override;
+    void on_option (const OptionData::Option &o) override;
+    void on_end (const KeaConfig &k) override;
+
+  private:
+    std::ostream &out_;
+    std::size_t subnet_pools_ = 0;
+    std::size_t subnet_reservations_ = 0;
+    std::size_t subnets_ = 0;
+    std::size_t pools_ = 0;
+    std::size_t reservations_ = 0;
+    std::size_t options_ = 0;
+};
+
+// --- CsvOutput ---
+// Output plugin producing an inventory in CSV form with the columns
+// type,id,subnet,name,value,always_send,hostname. There is one row
+// per subnet, pool, reservation and option; columns that do not
+// apply are left empty. A reservation row has the hardware address
+// as name, the IP address as value and the hostname, if any.
+class CsvOutput : public ConfigVisitor
+{
+  public:
+    explicit CsvOutput (std::ostream &out) : out_ (out) {}
+
+    void on_begin (const KeaConfig &k) override;
+    void on_subnet (const Subnet4::Cfg &c) override;
+    void on_pool (const Subnet4::Cfg &c,
+                  const Subnet4::Pool &p) override;
+    void on_reservation (const Subnet4::Cfg &c,
+                         const Subnet4::Reservation &r) override;
+    void on_option (const OptionData::Option &o) override;
+
+  private:
+    // Writes a field, quoting it if it contains a separator.
+    void field (const std::string &value);
+
+    std::ostream &out_;
+};
+
+} // namespace KeaGenerator
+
+#endif // KEA_VISITOR_H
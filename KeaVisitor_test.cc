@@ -0,0 +1,150 @@
+#include "KeaVisitor.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+using namespace KeaGenerator;
+
+// Counts how often each element is visited.
+class CountingVisitor : public ConfigVisitor
+{
+  public:
+    void
+    on_subnet (const Subnet4::Cfg &) override
+    {
+        ++subnets;
+    }
+
+    void
+    on_pool (const Subnet4::Cfg &, const Subnet4::Pool &) override
+    {
+        ++pools;
+    }
+
+    void
+    on_reservation (const Subnet4::Cfg &,
+                    const Subnet4::Reservation &) override
+    {
+        ++reservations;
+    }
+
+    void
+    on_option (const OptionData::Option &) override
+    {
+        ++options;
+    }
+
+    int subnets = 0;
+    int pools = 0;
+    int reservations = 0;
+    int options = 0;
+};
+
+class KeaVisitorTest : public ::testing::Test
+{
+  protected:
+    void
+    SetUp () override
+    {
+        Subnet4 &s4 = config.dhcp4.subnet4;
+        uint64_t id1 = s4.add_config ("192.168.1.0/24");
+        s4.add_pool_for_cfg (id1, "192.168.1.10", "192.168.1.20");
+        s4.add_pool_for_cfg (id1, "192.168.1.50", "192.168.1.60");
+        s4.add_reservation_for_cfg (id1, "1a:1b:1c:1d:1e:1f",
+                                    "192.168.1.5", "printer");
+        uint64_t id2 = s4.add_config ("10.0.0.0/8");
+        s4.add_pool_for_cfg (id2, "10.0.0.1", "10.0.0.9");
+        config.dhcp4.option_data.add_option_always (
+            "domain-name-servers", "8.8.8.8, 1.1.1.1");
+    }
+
+    KeaConfig config;
+};
+
+// Test that every element is visited exactly once per plugin
+TEST_F (KeaVisitorTest, TraverseVisitsEachElementOnce)
+{
+    CountingVisitor a, b;
+    FanOut fan{ &a, &b };
+    traverse (config, fan);
+
+    for (const CountingVisitor *v : { &a, &b })
+    {
+        EXPECT_EQ (v->subnets, 2);
+        EXPECT_EQ (v->pools, 3);
+        EXPECT_EQ (v->reservations, 1);
+        EXPECT_EQ (v->options, 1);
+    }
+}
+
+// Test that the JSON plugin matches the streaming serializer
+TEST_F (KeaVisitorTest, JsonOutputMatchesWriteJson)
+{
+    std::ostringstream expected;
+    write_json (expected, config);
+
+    std::ostringstream actual;
+    JsonOutput json_out (actual);
+    traverse (config, json_out);
+    EXPECT_EQ (actual.str (), expected.str ());
+
+    // Also without options and with a partial document
+    KeaConfig bare;
+    bare.dhcp4.subnet4.add_config ("10.1.0.0/16");
+    std::ostringstream e2, a2;
+    write_json (e2, bare);
+    JsonOutput j2 (a2);
+    traverse (bare, j2);
+    EXPECT_EQ (a2.str (), e2.str ());
+
+    KeaConfig partial;
+    std::ostringstream e3, a3;
+    write_json (e3, partial);
+    JsonOutput j3 (a3);
+    traverse (partial, j3);
+    EXPECT_EQ (a3.str (), e3.str ());
+}
+
+// Test producing all three formats from a single traversal
+TEST_F (KeaVisitorTest, FanOutProducesAllFormats)
+{
+    std::ostringstream json_text, summary_text, csv_text;
+    JsonOutput json_out (json_text);
+    SummaryOutput summary (summary_text);
+    CsvOutput csv (csv_text);
+
+    FanOut fan;
+    fan.add (json_out);
+    fan.add (summary);
+    fan.add (csv);
+    traverse (config, fan);
+
+    std::ostringstream expected_json;
+    write_json (expected_json, config);
+    EXPECT_EQ (json_text.str (), expected_json.str ());
+
+    std::string table = summary_text.str ();
+    EXPECT_NE (table.find ("1         192.168.1.0/24      2         "
+                           "1\n"),
+               std::string::npos);
+    EXPECT_NE (table.find ("2         10.0.0.0/8          1         "
+                           "0\n"),
+               std::string::npos);
+    EXPECT_NE (table.find ("subnets: 2, pools: 3, reservations: 1,"
+                           " options: 1"),
+               std::string::npos);
+
+    EXPECT_EQ (csv_text.str (),
+               "type,id,subnet,name,value,always_send,hostname\n"
+               "subnet,1,192.168.1.0/24,,,,\n"
+               "pool,1,192.168.1.0/24,,"
+               "192.168.1.10 - 192.168.1.20,,\n"
+               "pool,1,192.168.1.0/24,,"
+               "192.168.1.50 - 192.168.1.60,,\n"
+               "reservation,1,192.168.1.0/24,1a:1b:1c:1d:1e:1f,"
+               "192.168.1.5,,printer\n"
+               "subnet,2,10.0.0.0/8,,,,\n"
+               "pool,2,10.0.0.0/8,,10.0.0.1 - 10.0.0.9,,\n"
+               "option,,,domain-name-servers,\"8.8.8.8, 1.1.1.1\","
+               "true,\n");
+}